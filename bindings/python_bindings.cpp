@@ -1,4 +1,6 @@
 #include <iostream>
+#include <pybind11/chrono.h>
+#include <pybind11/functional.h>
 #include <pybind11/operators.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
@@ -6,10 +8,12 @@
 #include <string>
 
 #include "capiocl.hpp"
+#include "capiocl/builder.h"
 #include "capiocl/engine.h"
 #include "capiocl/monitor.h"
 #include "capiocl/parser.h"
 #include "capiocl/serializer.h"
+#include "capiocl/snapshot.h"
 
 namespace py = pybind11;
 
@@ -20,6 +24,7 @@ PYBIND11_MODULE(_py_capio_cl, m) {
     py::register_exception<capiocl::parser::ParserException>(m, "ParserException");
     py::register_exception<capiocl::serializer::SerializerException>(m, "SerializerException");
     py::register_exception<capiocl::monitor::MonitorException>(m, "MonitorException");
+    py::register_exception<capiocl::snapshot::SnapshotException>(m, "SnapshotException");
 
     m.attr("CAPIO_CL_DEFAULT_WF_NAME") = py::str(capiocl::CAPIO_CL_DEFAULT_WF_NAME);
     m.attr("DEFAULT_MCAST_GROUP") =
@@ -39,6 +44,114 @@ PYBIND11_MODULE(_py_capio_cl, m) {
     py::module_ VERSION = m.def_submodule("VERSION", "CAPIO-CL version");
     VERSION.attr("V1")  = py::str(capiocl::CAPIO_CL_VERSION::V1);
 
+    py::class_<capiocl::engine::EntryHandle>(m, "EntryHandle",
+                                             "A resolved entry of the CAPIO-CL engine.")
+        .def("path", &capiocl::engine::EntryHandle::path)
+        .def("empty", &capiocl::engine::EntryHandle::empty);
+
+    py::class_<capiocl::engine::EntryAttributes>(m, "EntryAttributes",
+                                                 "Rule attributes of a path, from queryBatch.")
+        .def_readonly("commit_on_close_count",
+                      &capiocl::engine::EntryAttributes::commit_on_close_count)
+        .def_readonly("file_dependencies_count",
+                      &capiocl::engine::EntryAttributes::file_dependencies_count)
+        .def_property_readonly(
+            "commit_rule",
+            [](const capiocl::engine::EntryAttributes &a) {
+                return std::string(capiocl::commitRules::toString(a.commit_rule));
+            })
+        .def_property_readonly(
+            "fire_rule",
+            [](const capiocl::engine::EntryAttributes &a) {
+                return std::string(capiocl::fireRules::toString(a.fire_rule));
+            })
+        .def_readonly("permanent", &capiocl::engine::EntryAttributes::permanent)
+        .def_readonly("excluded", &capiocl::engine::EntryAttributes::excluded)
+        .def_readonly("is_file", &capiocl::engine::EntryAttributes::is_file)
+        .def_readonly("store_in_memory", &capiocl::engine::EntryAttributes::store_in_memory);
+
+    py::class_<capiocl::engine::LatencyHistogram>(
+        m, "LatencyHistogram", "Latencies of an Engine method, on a logarithmic scale.")
+        .def_readonly("buckets", &capiocl::engine::LatencyHistogram::buckets)
+        .def_readonly("count", &capiocl::engine::LatencyHistogram::count)
+        .def_readonly("total_ns", &capiocl::engine::LatencyHistogram::total_ns)
+        .def("mean", &capiocl::engine::LatencyHistogram::mean)
+        .def("percentile", &capiocl::engine::LatencyHistogram::percentile, py::arg("p"));
+
+    py::class_<capiocl::engine::EngineStats>(m, "EngineStats",
+                                             "Statistics of an Engine, from stats.")
+        .def_readonly("enabled", &capiocl::engine::EngineStats::enabled)
+        .def_readonly("entries", &capiocl::engine::EngineStats::entries)
+        .def_readonly("patterns", &capiocl::engine::EngineStats::patterns)
+        .def_readonly("materializations", &capiocl::engine::EngineStats::materializations)
+        .def_readonly("glob_comparisons", &capiocl::engine::EngineStats::glob_comparisons)
+        .def_readonly("lookup_hits", &capiocl::engine::EngineStats::lookup_hits)
+        .def_readonly("lookup_misses", &capiocl::engine::EngineStats::lookup_misses)
+        .def_readonly("exclusive_locks", &capiocl::engine::EngineStats::exclusive_locks)
+        .def_readonly("shared_locks", &capiocl::engine::EngineStats::shared_locks)
+        .def_readonly("lock_wait_ns", &capiocl::engine::EngineStats::lock_wait_ns)
+        .def_readonly("latencies", &capiocl::engine::EngineStats::latencies)
+        .def_readonly("messages_sent", &capiocl::engine::EngineStats::messages_sent)
+        .def_readonly("datagrams_sent", &capiocl::engine::EngineStats::datagrams_sent)
+        .def_readonly("batches_flushed", &capiocl::engine::EngineStats::batches_flushed)
+        .def("hitRatio", &capiocl::engine::EngineStats::hitRatio);
+
+    py::class_<capiocl::engine::MerkleTree>(
+        m, "MerkleTree", "Merkle tree over the content of an Engine, from fingerprint.")
+        .def_readonly_static("FANOUT", &capiocl::engine::MerkleTree::FANOUT)
+        .def_readonly_static("DEPTH", &capiocl::engine::MerkleTree::DEPTH)
+        .def_readonly_static("LEAVES", &capiocl::engine::MerkleTree::LEAVES)
+        .def_static("bucket", &capiocl::engine::MerkleTree::bucket, py::arg("path"))
+        .def("root", &capiocl::engine::MerkleTree::root)
+        .def("node", &capiocl::engine::MerkleTree::node, py::arg("level"), py::arg("index"))
+        .def("diff", &capiocl::engine::MerkleTree::diff, py::arg("other"))
+        .def(py::self == py::self)
+        .def(py::self != py::self);
+
+    py::class_<capiocl::engine::Delta> delta(m, "Delta",
+                                             "A single change to an entry, applied by apply.");
+    py::enum_<capiocl::engine::Delta::OPERATION>(delta, "OPERATION")
+        .value("SET", capiocl::engine::Delta::SET)
+        .value("UNSET", capiocl::engine::Delta::UNSET)
+        .value("ADD", capiocl::engine::Delta::ADD)
+        .value("REMOVE", capiocl::engine::Delta::REMOVE)
+        .value("ERASE", capiocl::engine::Delta::ERASE);
+    py::enum_<capiocl::engine::Delta::FIELD>(delta, "FIELD")
+        .value("COMMIT_RULE", capiocl::engine::Delta::COMMIT_RULE)
+        .value("FIRE_RULE", capiocl::engine::Delta::FIRE_RULE)
+        .value("COMMIT_ON_CLOSE_COUNT", capiocl::engine::Delta::COMMIT_ON_CLOSE_COUNT)
+        .value("DIRECTORY_FILE_COUNT", capiocl::engine::Delta::DIRECTORY_FILE_COUNT)
+        .value("PERMANENT", capiocl::engine::Delta::PERMANENT)
+        .value("EXCLUDED", capiocl::engine::Delta::EXCLUDED)
+        .value("STORE_IN_MEMORY", capiocl::engine::Delta::STORE_IN_MEMORY)
+        .value("IS_FILE", capiocl::engine::Delta::IS_FILE)
+        .value("PRODUCER", capiocl::engine::Delta::PRODUCER)
+        .value("CONSUMER", capiocl::engine::Delta::CONSUMER)
+        .value("DEPENDENCY", capiocl::engine::Delta::DEPENDENCY);
+    delta.def_readonly("version", &capiocl::engine::Delta::version)
+        .def_readonly("path", &capiocl::engine::Delta::path)
+        .def_readonly("operation", &capiocl::engine::Delta::operation)
+        .def_readonly("field", &capiocl::engine::Delta::field)
+        .def_readonly("value", &capiocl::engine::Delta::value)
+        .def_readonly("number", &capiocl::engine::Delta::number)
+        .def_static("set",
+                    py::overload_cast<const std::string &, capiocl::engine::Delta::FIELD,
+                                      const std::string &>(&capiocl::engine::Delta::set),
+                    py::arg("path"), py::arg("field"), py::arg("keyword"))
+        .def_static("set",
+                    py::overload_cast<const std::string &, capiocl::engine::Delta::FIELD, long>(
+                        &capiocl::engine::Delta::set),
+                    py::arg("path"), py::arg("field"), py::arg("number"))
+        .def_static("unset", &capiocl::engine::Delta::unset, py::arg("path"), py::arg("field"))
+        .def_static("add", &capiocl::engine::Delta::add, py::arg("path"), py::arg("field"),
+                    py::arg("value"))
+        .def_static("remove", &capiocl::engine::Delta::remove, py::arg("path"), py::arg("field"),
+                    py::arg("value"))
+        .def_static("erase", &capiocl::engine::Delta::erase, py::arg("path"))
+        .def_static("fromJson", &capiocl::engine::Delta::fromJson, py::arg("json"))
+        .def("toJson", &capiocl::engine::Delta::toJson)
+        .def("__repr__", &capiocl::engine::Delta::toJson);
+
     py::class_<capiocl::engine::Engine>(
         m, "Engine", "The main CAPIO-CL engine for managing data communication and I/O operations.")
         .def(py::init<>())
@@ -61,10 +174,26 @@ PYBIND11_MODULE(_py_capio_cl, m) {
         .def("addFileDependency", &capiocl::engine::Engine::addFileDependency, py::arg("path"),
              py::arg("file_dependency"))
         .def("remove", &capiocl::engine::Engine::remove, py::arg("path"))
-        .def("setCommitRule", &capiocl::engine::Engine::setCommitRule, py::arg("path"),
-             py::arg("commit_rule"))
-        .def("setFireRule", &capiocl::engine::Engine::setFireRule, py::arg("path"),
-             py::arg("fire_rule"))
+        .def("resolve", &capiocl::engine::Engine::resolve, py::arg("path"))
+        .def("isValid", &capiocl::engine::Engine::isValid, py::arg("handle"))
+        .def("queryBatch", &capiocl::engine::Engine::queryBatch, py::arg("paths"))
+        .def("getAvoidedEntries", &capiocl::engine::Engine::getAvoidedEntries)
+        .def("stats", &capiocl::engine::Engine::stats)
+        .def("apply", &capiocl::engine::Engine::apply, py::arg("delta"))
+        .def("changesSince", &capiocl::engine::Engine::changesSince, py::arg("version"))
+        .def("getVersion", &capiocl::engine::Engine::getVersion)
+        .def("fingerprint", &capiocl::engine::Engine::fingerprint)
+        .def("getBucketPaths", &capiocl::engine::Engine::getBucketPaths, py::arg("bucket"))
+        .def("saveSnapshot", &capiocl::engine::Engine::saveSnapshot, py::arg("path"))
+        .def("openSnapshot", &capiocl::engine::Engine::openSnapshot, py::arg("path"))
+        .def("setCommitRule",
+             py::overload_cast<const std::filesystem::path &, const std::string &>(
+                 &capiocl::engine::Engine::setCommitRule),
+             py::arg("path"), py::arg("commit_rule"))
+        .def("setFireRule",
+             py::overload_cast<const std::filesystem::path &, const std::string &>(
+                 &capiocl::engine::Engine::setFireRule),
+             py::arg("path"), py::arg("fire_rule"))
         .def("setPermanent", &capiocl::engine::Engine::setPermanent, py::arg("path"),
              py::arg("permanent"))
         .def("setExclude", &capiocl::engine::Engine::setExclude, py::arg("path"),
@@ -75,38 +204,151 @@ PYBIND11_MODULE(_py_capio_cl, m) {
              py::arg("path"), py::arg("num"))
         .def("setDirectoryFileCount", &capiocl::engine::Engine::setDirectoryFileCount,
              py::arg("path"), py::arg("num"))
+        .def("getChildren", &capiocl::engine::Engine::getChildren, py::arg("path"))
+        .def("getFileDependents", &capiocl::engine::Engine::getFileDependents, py::arg("path"))
         .def("setFileDeps", &capiocl::engine::Engine::setFileDeps, py::arg("path"),
              py::arg("dependencies"))
         .def("setStoreFileInMemory", &capiocl::engine::Engine::setStoreFileInMemory,
              py::arg("path"))
         .def("setStoreFileInFileSystem", &capiocl::engine::Engine::setStoreFileInFileSystem,
              py::arg("path"))
-        .def("getDirectoryFileCount", &capiocl::engine::Engine::getDirectoryFileCount,
+        .def("getDirectoryFileCount",
+             py::overload_cast<const std::filesystem::path &>(
+                 &capiocl::engine::Engine::getDirectoryFileCount, py::const_),
+             py::arg("path"))
+        .def("getDirectoryFileCount",
+             py::overload_cast<const capiocl::engine::EntryHandle &>(
+                 &capiocl::engine::Engine::getDirectoryFileCount, py::const_),
+             py::arg("handle"))
+        .def("getCommitRule",
+             py::overload_cast<const std::filesystem::path &>(
+                 &capiocl::engine::Engine::getCommitRule, py::const_),
              py::arg("path"))
-        .def("getCommitRule", &capiocl::engine::Engine::getCommitRule, py::arg("path"))
-        .def("getFireRule", &capiocl::engine::Engine::getFireRule, py::arg("path"))
-        .def("getProducers", &capiocl::engine::Engine::getProducers, py::arg("path"))
-        .def("getConsumers", &capiocl::engine::Engine::getConsumers, py::arg("path"))
-        .def("getCommitCloseCount", &capiocl::engine::Engine::getCommitCloseCount, py::arg("path"))
-        .def("getCommitOnFileDependencies", &capiocl::engine::Engine::getCommitOnFileDependencies,
+        .def("getCommitRule",
+             py::overload_cast<const capiocl::engine::EntryHandle &>(
+                 &capiocl::engine::Engine::getCommitRule, py::const_),
+             py::arg("handle"))
+        .def("getFireRule",
+             py::overload_cast<const std::filesystem::path &>(
+                 &capiocl::engine::Engine::getFireRule, py::const_),
              py::arg("path"))
+        .def("getFireRule",
+             py::overload_cast<const capiocl::engine::EntryHandle &>(
+                 &capiocl::engine::Engine::getFireRule, py::const_),
+             py::arg("handle"))
+        .def("getProducers",
+             py::overload_cast<const std::filesystem::path &>(
+                 &capiocl::engine::Engine::getProducers, py::const_),
+             py::arg("path"))
+        .def("getProducers",
+             py::overload_cast<const capiocl::engine::EntryHandle &>(
+                 &capiocl::engine::Engine::getProducers, py::const_),
+             py::arg("handle"))
+        .def("getConsumers",
+             py::overload_cast<const std::filesystem::path &>(
+                 &capiocl::engine::Engine::getConsumers, py::const_),
+             py::arg("path"))
+        .def("getConsumers",
+             py::overload_cast<const capiocl::engine::EntryHandle &>(
+                 &capiocl::engine::Engine::getConsumers, py::const_),
+             py::arg("handle"))
+        .def("getCommitCloseCount",
+             py::overload_cast<const std::filesystem::path &>(
+                 &capiocl::engine::Engine::getCommitCloseCount, py::const_),
+             py::arg("path"))
+        .def("getCommitCloseCount",
+             py::overload_cast<const capiocl::engine::EntryHandle &>(
+                 &capiocl::engine::Engine::getCommitCloseCount, py::const_),
+             py::arg("handle"))
+        .def("getCommitOnFileDependencies",
+             py::overload_cast<const std::filesystem::path &>(
+                 &capiocl::engine::Engine::getCommitOnFileDependencies, py::const_),
+             py::arg("path"))
+        .def("getCommitOnFileDependencies",
+             py::overload_cast<const capiocl::engine::EntryHandle &>(
+                 &capiocl::engine::Engine::getCommitOnFileDependencies, py::const_),
+             py::arg("handle"))
         .def("getFileToStoreInMemory", &capiocl::engine::Engine::getFileToStoreInMemory)
         .def("getHomeNode", &capiocl::engine::Engine::getHomeNode, py::arg("path"))
-        .def("isProducer", &capiocl::engine::Engine::isProducer, py::arg("path"),
-             py::arg("app_name"))
-        .def("isConsumer", &capiocl::engine::Engine::isConsumer, py::arg("path"),
-             py::arg("app_name"))
-        .def("isFirable", &capiocl::engine::Engine::isFirable, py::arg("path"))
-        .def("isFile", &capiocl::engine::Engine::isFile, py::arg("path"))
-        .def("isExcluded", &capiocl::engine::Engine::isExcluded, py::arg("path"))
-        .def("isDirectory", &capiocl::engine::Engine::isDirectory, py::arg("path"))
-        .def("isStoredInMemory", &capiocl::engine::Engine::isStoredInMemory, py::arg("path"))
-        .def("isPermanent", &capiocl::engine::Engine::isPermanent, py::arg("path"))
+        .def("isProducer",
+             py::overload_cast<const std::filesystem::path &, const std::string &>(
+                 &capiocl::engine::Engine::isProducer, py::const_),
+             py::arg("path"), py::arg("app_name"))
+        .def("isProducer",
+             py::overload_cast<const capiocl::engine::EntryHandle &, const std::string &>(
+                 &capiocl::engine::Engine::isProducer, py::const_),
+             py::arg("handle"), py::arg("app_name"))
+        .def("isConsumer",
+             py::overload_cast<const std::filesystem::path &, const std::string &>(
+                 &capiocl::engine::Engine::isConsumer, py::const_),
+             py::arg("path"), py::arg("app_name"))
+        .def("isConsumer",
+             py::overload_cast<const capiocl::engine::EntryHandle &, const std::string &>(
+                 &capiocl::engine::Engine::isConsumer, py::const_),
+             py::arg("handle"), py::arg("app_name"))
+        .def("isFirable",
+             py::overload_cast<const std::filesystem::path &>(
+                 &capiocl::engine::Engine::isFirable, py::const_),
+             py::arg("path"))
+        .def("isFirable",
+             py::overload_cast<const capiocl::engine::EntryHandle &>(
+                 &capiocl::engine::Engine::isFirable, py::const_),
+             py::arg("handle"))
+        .def("isFile",
+             py::overload_cast<const std::filesystem::path &>(
+                 &capiocl::engine::Engine::isFile, py::const_),
+             py::arg("path"))
+        .def("isFile",
+             py::overload_cast<const capiocl::engine::EntryHandle &>(
+                 &capiocl::engine::Engine::isFile, py::const_),
+             py::arg("handle"))
+        .def("isExcluded",
+             py::overload_cast<const std::filesystem::path &>(
+                 &capiocl::engine::Engine::isExcluded, py::const_),
+             py::arg("path"))
+        .def("isExcluded",
+             py::overload_cast<const capiocl::engine::EntryHandle &>(
+                 &capiocl::engine::Engine::isExcluded, py::const_),
+             py::arg("handle"))
+        .def("isDirectory",
+             py::overload_cast<const std::filesystem::path &>(
+                 &capiocl::engine::Engine::isDirectory, py::const_),
+             py::arg("path"))
+        .def("isDirectory",
+             py::overload_cast<const capiocl::engine::EntryHandle &>(
+                 &capiocl::engine::Engine::isDirectory, py::const_),
+             py::arg("handle"))
+        .def("isStoredInMemory",
+             py::overload_cast<const std::filesystem::path &>(
+                 &capiocl::engine::Engine::isStoredInMemory, py::const_),
+             py::arg("path"))
+        .def("isStoredInMemory",
+             py::overload_cast<const capiocl::engine::EntryHandle &>(
+                 &capiocl::engine::Engine::isStoredInMemory, py::const_),
+             py::arg("handle"))
+        .def("isPermanent",
+             py::overload_cast<const std::filesystem::path &>(
+                 &capiocl::engine::Engine::isPermanent, py::const_),
+             py::arg("path"))
+        .def("isPermanent",
+             py::overload_cast<const capiocl::engine::EntryHandle &>(
+                 &capiocl::engine::Engine::isPermanent, py::const_),
+             py::arg("handle"))
         .def("setAllStoreInMemory", &capiocl::engine::Engine::setAllStoreInMemory)
         .def("getWorkflowName", &capiocl::engine::Engine::getWorkflowName)
         .def("setWorkflowName", &capiocl::engine::Engine::setWorkflowName, py::arg("name"))
         .def("setCommitted", &capiocl::engine::Engine::setCommitted, py::arg("path"))
         .def("isCommitted", &capiocl::engine::Engine::isCommitted, py::arg("path"))
+        .def("waitForCommit", &capiocl::engine::Engine::waitForCommit, py::arg("path"),
+             py::arg("timeout"), py::call_guard<py::gil_scoped_release>())
+        .def("waitForAnyCommit", &capiocl::engine::Engine::waitForAnyCommit, py::arg("paths"),
+             py::arg("timeout"), py::call_guard<py::gil_scoped_release>())
+        .def("onCommitted", &capiocl::engine::Engine::onCommitted, py::arg("path"),
+             py::arg("callback"))
+        .def("notifyClose", &capiocl::engine::Engine::notifyClose, py::arg("path"))
+        .def("getCloseCount", &capiocl::engine::Engine::getCloseCount, py::arg("path"))
+        .def("getObservedFileCount", &capiocl::engine::Engine::getObservedFileCount,
+             py::arg("path"))
         .def("setHomeNode", &capiocl::engine::Engine::setHomeNode, py::arg("path"))
         .def("getPaths", &capiocl::engine::Engine::getPaths)
         .def("startApiServer", &capiocl::engine::Engine::startApiServer)
@@ -117,6 +359,44 @@ PYBIND11_MODULE(_py_capio_cl, m) {
              })
         .def(py::self == py::self);
 
+    py::class_<capiocl::engine::EngineBuilder>(
+        m, "EngineBuilder", "Collects CAPIO-CL entries and publishes them into an Engine at once.")
+        .def(py::init<>())
+        .def("newFile", &capiocl::engine::EngineBuilder::newFile, py::arg("filename"))
+        .def("size", &capiocl::engine::EngineBuilder::size)
+        .def("addProducer", &capiocl::engine::EngineBuilder::addProducer, py::arg("path"),
+             py::arg("producer"))
+        .def("addConsumer", &capiocl::engine::EngineBuilder::addConsumer, py::arg("path"),
+             py::arg("consumer"))
+        .def("addFileDependency", &capiocl::engine::EngineBuilder::addFileDependency,
+             py::arg("path"), py::arg("file_dependency"))
+        .def("setCommitRule",
+             py::overload_cast<const std::filesystem::path &, const std::string &>(
+                 &capiocl::engine::EngineBuilder::setCommitRule),
+             py::arg("path"), py::arg("commit_rule"))
+        .def("setFireRule",
+             py::overload_cast<const std::filesystem::path &, const std::string &>(
+                 &capiocl::engine::EngineBuilder::setFireRule),
+             py::arg("path"), py::arg("fire_rule"))
+        .def("setPermanent", &capiocl::engine::EngineBuilder::setPermanent, py::arg("path"),
+             py::arg("permanent"))
+        .def("setExclude", &capiocl::engine::EngineBuilder::setExclude, py::arg("path"),
+             py::arg("exclude"))
+        .def("setDirectory", &capiocl::engine::EngineBuilder::setDirectory, py::arg("path"))
+        .def("setFile", &capiocl::engine::EngineBuilder::setFile, py::arg("path"))
+        .def("setCommittedCloseNumber", &capiocl::engine::EngineBuilder::setCommitedCloseNumber,
+             py::arg("path"), py::arg("num"))
+        .def("setDirectoryFileCount", &capiocl::engine::EngineBuilder::setDirectoryFileCount,
+             py::arg("path"), py::arg("num"))
+        .def("setFileDeps", &capiocl::engine::EngineBuilder::setFileDeps, py::arg("path"),
+             py::arg("dependencies"))
+        .def("setStoreFileInMemory", &capiocl::engine::EngineBuilder::setStoreFileInMemory,
+             py::arg("path"))
+        .def("setStoreFileInFileSystem",
+             &capiocl::engine::EngineBuilder::setStoreFileInFileSystem, py::arg("path"))
+        .def("setAllStoreInMemory", &capiocl::engine::EngineBuilder::setAllStoreInMemory)
+        .def("publish", &capiocl::engine::EngineBuilder::publish, py::arg("engine"));
+
     py::class_<capiocl::parser::Parser>(m, "Parser", "The CAPIO-CL Parser component.")
         .def_static("parse", &capiocl::parser::Parser::parse, py::arg("source"),
                     py::arg("resolve_prefix") = "", py::arg("store_only_in_memory") = false)
@@ -133,21 +413,56 @@ PYBIND11_MODULE(_py_capio_cl, m) {
 
     py::class_<capiocl::engine::CapioCLEntry>(m, "CapioCLEntry")
         .def(py::init<>())
-        .def_readwrite("producers", &capiocl::engine::CapioCLEntry::producers)
-        .def_readwrite("consumers", &capiocl::engine::CapioCLEntry::consumers)
+        .def_property(
+            "producers",
+            [](const capiocl::engine::CapioCLEntry &e) { return e.producers.names(); },
+            [](capiocl::engine::CapioCLEntry &e, const std::vector<std::string> &producers) {
+                e.producers = producers;
+            })
+        .def_property(
+            "consumers",
+            [](const capiocl::engine::CapioCLEntry &e) { return e.consumers.names(); },
+            [](capiocl::engine::CapioCLEntry &e, const std::vector<std::string> &consumers) {
+                e.consumers = consumers;
+            })
         .def_readwrite("file_dependencies", &capiocl::engine::CapioCLEntry::file_dependencies)
-        .def_readwrite("commit_rule", &capiocl::engine::CapioCLEntry::commit_rule)
-        .def_readwrite("fire_rule", &capiocl::engine::CapioCLEntry::fire_rule)
+        .def_property(
+            "commit_rule",
+            [](const capiocl::engine::CapioCLEntry &e) {
+                return std::string(capiocl::commitRules::toString(e.commit_rule));
+            },
+            [](capiocl::engine::CapioCLEntry &e, const std::string &commit_rule) {
+                e.commit_rule = capiocl::commitRules::fromString(commit_rule);
+            })
+        .def_property(
+            "fire_rule",
+            [](const capiocl::engine::CapioCLEntry &e) {
+                return std::string(capiocl::fireRules::toString(e.fire_rule));
+            },
+            [](capiocl::engine::CapioCLEntry &e, const std::string &fire_rule) {
+                e.fire_rule = capiocl::fireRules::fromString(fire_rule);
+            })
         .def_readwrite("directory_children_count",
                        &capiocl::engine::CapioCLEntry::directory_children_count)
         .def_readwrite("commit_on_close_count",
                        &capiocl::engine::CapioCLEntry::commit_on_close_count)
-        .def_readwrite("enable_directory_count_update",
-                       &capiocl::engine::CapioCLEntry::enable_directory_count_update)
-        .def_readwrite("store_in_memory", &capiocl::engine::CapioCLEntry::store_in_memory)
-        .def_readwrite("permanent", &capiocl::engine::CapioCLEntry::permanent)
-        .def_readwrite("excluded", &capiocl::engine::CapioCLEntry::excluded)
-        .def_readwrite("is_file", &capiocl::engine::CapioCLEntry::is_file)
+        .def_property(
+            "enable_directory_count_update",
+            [](const capiocl::engine::CapioCLEntry &e) { return e.enable_directory_count_update; },
+            [](capiocl::engine::CapioCLEntry &e, bool v) { e.enable_directory_count_update = v; })
+        .def_property(
+            "store_in_memory",
+            [](const capiocl::engine::CapioCLEntry &e) { return e.store_in_memory; },
+            [](capiocl::engine::CapioCLEntry &e, bool v) { e.store_in_memory = v; })
+        .def_property(
+            "permanent", [](const capiocl::engine::CapioCLEntry &e) { return e.permanent; },
+            [](capiocl::engine::CapioCLEntry &e, bool v) { e.permanent = v; })
+        .def_property(
+            "excluded", [](const capiocl::engine::CapioCLEntry &e) { return e.excluded; },
+            [](capiocl::engine::CapioCLEntry &e, bool v) { e.excluded = v; })
+        .def_property(
+            "is_file", [](const capiocl::engine::CapioCLEntry &e) { return e.is_file; },
+            [](capiocl::engine::CapioCLEntry &e, bool v) { e.is_file = v; })
         .def_static("from_json", &capiocl::engine::CapioCLEntry::fromJson, py::arg("in"))
         .def("to_json", &capiocl::engine::CapioCLEntry::toJson);
 }
\ No newline at end of file
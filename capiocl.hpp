@@ -1,6 +1,8 @@
 #ifndef CAPIO_CL_CAPIOCL_HPP
 #define CAPIO_CL_CAPIOCL_HPP
 
+#include <cstdint>
+#include <iterator>
 #include <jsoncons/basic_json.hpp>
 #include <string>
 
@@ -17,20 +19,40 @@ constexpr char NO_UPDATE[] = "no_update";
 /// @brief FoC Streaming Rule
 constexpr char UPDATE[]    = "update";
 
+/// @brief Fire rules as stored within the CAPIO-CL Engine
+enum class FIRE_RULE : std::uint8_t { NO_UPDATE, UPDATE };
+
 /**
- * Sanitize fire rule from input
- * @param input
- * @return sanitized fire rule
+ * Convert a fire rule keyword to its typed representation
+ * @param input fire rule keyword
+ * @return the typed fire rule
+ * @throw std::invalid_argument if @p input is not a valid CAPIO-CL fire rule
  */
-inline std::string sanitize(const std::string &input) {
+inline FIRE_RULE fromString(const std::string &input) {
     if (input == NO_UPDATE) {
-        return NO_UPDATE;
+        return FIRE_RULE::NO_UPDATE;
     } else if (input == UPDATE) {
-        return UPDATE;
+        return FIRE_RULE::UPDATE;
     } else {
         throw std::invalid_argument("Input fire rule: " + input + " is not a valid CAPIO-CL rule");
     }
 }
+
+/**
+ * Convert a typed fire rule to its keyword
+ * @param rule typed fire rule
+ * @return the fire rule keyword
+ */
+inline const char *toString(const FIRE_RULE rule) {
+    return rule == FIRE_RULE::NO_UPDATE ? NO_UPDATE : UPDATE;
+}
+
+/**
+ * Sanitize fire rule from input
+ * @param input
+ * @return sanitized fire rule
+ */
+inline std::string sanitize(const std::string &input) { return toString(fromString(input)); }
 } // namespace fireRules
 
 /// @brief Namespace containing the CAPIO-CL Commit Rules
@@ -44,25 +66,42 @@ constexpr char ON_N_FILES[]     = "on_n_files";
 /// @brief CoT Streaming Rule
 constexpr char ON_TERMINATION[] = "on_termination";
 
+/// @brief Commit rules as stored within the CAPIO-CL Engine
+enum class COMMIT_RULE : std::uint8_t { ON_CLOSE, ON_FILE, ON_N_FILES, ON_TERMINATION };
+
+/// @brief Keywords of the commit rules, indexed by COMMIT_RULE
+constexpr const char *KEYWORDS[] = {ON_CLOSE, ON_FILE, ON_N_FILES, ON_TERMINATION};
+
+/**
+ * Convert a commit rule keyword to its typed representation
+ * @param input commit rule keyword
+ * @return the typed commit rule
+ * @throw std::invalid_argument if @p input is not a valid CAPIO-CL commit rule
+ */
+inline COMMIT_RULE fromString(const std::string &input) {
+    for (std::uint8_t i = 0; i < std::size(KEYWORDS); i++) {
+        if (input == KEYWORDS[i]) {
+            return static_cast<COMMIT_RULE>(i);
+        }
+    }
+    throw std::invalid_argument("Input commit rule: " + input + " is not a valid CAPIO-CL rule");
+}
+
+/**
+ * Convert a typed commit rule to its keyword
+ * @param rule typed commit rule
+ * @return the commit rule keyword
+ */
+inline const char *toString(const COMMIT_RULE rule) {
+    return KEYWORDS[static_cast<std::uint8_t>(rule)];
+}
+
 /**
  * Sanitize commit rule from input
  * @param input
  * @return sanitized commit rule
  */
-inline std::string sanitize(const std::string &input) {
-    if (input == ON_CLOSE) {
-        return ON_CLOSE;
-    } else if (input == ON_FILE) {
-        return ON_FILE;
-    } else if (input == ON_N_FILES) {
-        return ON_N_FILES;
-    } else if (input == ON_TERMINATION) {
-        return ON_TERMINATION;
-    } else {
-        throw std::invalid_argument("Input commit rule: " + input +
-                                    " is not a valid CAPIO-CL rule");
-    }
-}
+inline std::string sanitize(const std::string &input) { return toString(fromString(input)); }
 } // namespace commitRules
 
 /// @brief Available versions of CAPIO-CL language
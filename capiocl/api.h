@@ -1,22 +1,35 @@
 #ifndef CAPIO_CL_WEBAPI_H
 #define CAPIO_CL_WEBAPI_H
-#include <atomic>
-#include <thread>
+#include <memory>
+#include <vector>
 
 #include "capiocl.hpp"
 #include "configuration.h"
+#include "reactor.h"
 
 /// @brief Class that exposes a REST Web Server to interact with the current configuration
 class capiocl::api::CapioClApiServer {
 
-    /// @brief asynchronous running webserver thread
-    std::thread _webApiThread;
+    /// @brief Event loop watching the socket of the server
+    std::shared_ptr<monitor::Reactor> reactor;
+
+    /// @brief Socket receiving the updates
+    int socket_fd = -1;
+
+    /// @brief Engine the received updates are applied to
+    engine::Engine *engine;
 
     /// @brief port on which the current server runs
     const configuration::CapioClConfiguration &capiocl_configuration;
 
-    /// @brief variable to tell the thread to terminate
-    std::atomic<bool> _terminate = false;
+    /// @brief Buffer for the received datagrams
+    std::vector<char> buffer;
+
+    /**
+     * @brief Reactor handler of the server socket: apply every received update
+     * @param socket Readable server socket
+     */
+    void receive(int socket);
 
   public:
     /// @brief default constructor.
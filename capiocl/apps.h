@@ -0,0 +1,236 @@
+#ifndef CAPIO_CL_APPS_H
+#define CAPIO_CL_APPS_H
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <string>
+#include <vector>
+
+/// @brief Namespace containing the CAPIO-CL Engine
+namespace capiocl::engine {
+
+/// @brief Identifier of an application name, assigned by AppInterner
+typedef std::uint32_t AppId;
+
+/**
+ * @brief Process-wide table mapping application names to small integer identifiers.
+ *
+ * Identifiers are assigned in order of first appearance, starting from zero, and are never
+ * reclaimed. Workflows usually involve a handful of applications, so the first identifiers fit the
+ * inline bitset of AppSet. All methods are thread safe. Lookups read an immutable table published
+ * by intern() whenever it assigns an identifier, so they never wait for each other or for writers.
+ */
+class AppInterner final {
+  public:
+    /// @brief Identifier returned by find() for names that were never interned
+    static constexpr AppId NONE = UINT32_MAX;
+
+    /**
+     * @brief Get the identifier of an application, assigning a new one if needed
+     * @param name Application name
+     * @return The identifier of @p name
+     */
+    static AppId intern(const std::string &name);
+
+    /**
+     * @brief Get the identifier of an application without assigning a new one
+     * @param name Application name
+     * @return The identifier of @p name, or #NONE if it was never interned
+     */
+    static AppId find(const std::string &name);
+
+    /**
+     * @brief Get the name of an application
+     * @param id Application identifier returned by intern()
+     * @return The application name. The reference remains valid for the whole process lifetime
+     */
+    static const std::string &name(AppId id);
+};
+
+/**
+ * @brief Set of applications, stored as a bitset over the identifiers assigned by AppInterner.
+ *
+ * The set fits in a single machine word. When the lowest bit of the word is set, the remaining
+ * bits are the membership bitset of the first #INLINE_APPS identifiers (63 on 64-bit platforms),
+ * so an entry whose producers and consumers are among the first applications of the workflow does
+ * not allocate. Otherwise the word is either zero, for the empty set, or a pointer to a sorted
+ * array of identifiers, allocated once an identifier that does not fit inline is added. Iterating
+ * the set yields the application names in identifier order, which keeps the set usable where a
+ * std::vector<std::string> was expected.
+ */
+class AppSet final {
+    /// @brief Number of identifiers stored inline: all the bits of #word but the tag
+    static constexpr AppId INLINE_APPS = std::numeric_limits<std::uintptr_t>::digits - 1;
+
+    /// @brief Tag marking #word as an inline bitset
+    static constexpr std::uintptr_t INLINE_TAG = 1;
+
+    /// @brief Inline bitset, nullptr or pointer to the sorted identifiers, see the class notes
+    std::uintptr_t word = 0;
+
+    /// @brief Whether #word holds an inline bitset
+    [[nodiscard]] bool isInline() const { return (word & INLINE_TAG) != 0; }
+
+    /// @brief Sorted identifiers, when #word is a pointer
+    [[nodiscard]] std::vector<AppId> *array() const {
+        return reinterpret_cast<std::vector<AppId> *>(word);
+    }
+
+    /**
+     * @brief Get the first identifier in the set that is greater or equal than @p id
+     * @param id Lower bound
+     * @return The identifier, or AppInterner::NONE if there is none
+     */
+    [[nodiscard]] AppId next(AppId id) const;
+
+  public:
+    /// @brief Iterator over the names of the applications in the set
+    class const_iterator {
+        /// @brief Set being iterated
+        const AppSet *set = nullptr;
+        /// @brief Current identifier, AppInterner::NONE at the end
+        AppId id = AppInterner::NONE;
+
+      public:
+        /// @brief Iterator category
+        typedef std::forward_iterator_tag iterator_category;
+        /// @brief Value type
+        typedef std::string value_type;
+        /// @brief Difference type
+        typedef std::ptrdiff_t difference_type;
+        /// @brief Pointer type
+        typedef const std::string *pointer;
+        /// @brief Reference type
+        typedef const std::string &reference;
+
+        const_iterator() = default;
+
+        /**
+         * @brief Build an iterator pointing to @p id
+         * @param set Set being iterated
+         * @param id Current identifier
+         */
+        const_iterator(const AppSet *set, AppId id) : set(set), id(id) {}
+
+        /// @brief Name of the current application
+        reference operator*() const { return AppInterner::name(id); }
+
+        /// @brief Pointer to the name of the current application
+        pointer operator->() const { return &AppInterner::name(id); }
+
+        /// @brief Identifier of the current application
+        [[nodiscard]] AppId appId() const { return id; }
+
+        /// @brief Move to the next application
+        const_iterator &operator++() {
+            id = set->next(id + 1);
+            return *this;
+        }
+
+        /// @brief Move to the next application
+        const_iterator operator++(int) {
+            const auto copy = *this;
+            ++*this;
+            return copy;
+        }
+
+        /// @brief Check whether two iterators point to the same application
+        bool operator==(const const_iterator &other) const { return id == other.id; }
+
+        /// @brief Check whether two iterators point to different applications
+        bool operator!=(const const_iterator &other) const { return id != other.id; }
+    };
+
+    AppSet() = default;
+
+    /// @brief Copy constructor
+    AppSet(const AppSet &other);
+
+    /// @brief Move constructor
+    AppSet(AppSet &&other) noexcept;
+
+    /// @brief Build a set from a list of application names
+    AppSet(std::initializer_list<std::string> names);
+
+    /// @brief Build a set from a list of application names
+    AppSet(const std::vector<std::string> &names);
+
+    /// @brief Copy assignment
+    AppSet &operator=(const AppSet &other);
+
+    /// @brief Move assignment
+    AppSet &operator=(AppSet &&other) noexcept;
+
+    ~AppSet();
+
+    /**
+     * @brief Add an application to the set
+     * @param id Application identifier
+     * @return true if the application was not already in the set
+     */
+    bool insert(AppId id);
+
+    /**
+     * @brief Add an application to the set, interning its name
+     * @param name Application name
+     * @return true if the application was not already in the set
+     */
+    bool insert(const std::string &name);
+
+    /**
+     * @brief Remove an application from the set
+     * @param id Application identifier
+     * @return true if the application was in the set
+     */
+    bool erase(AppId id);
+
+    /**
+     * @brief Remove an application from the set
+     * @param name Application name
+     * @return true if the application was in the set
+     */
+    bool erase(const std::string &name);
+
+    /**
+     * @brief Check whether an application is in the set
+     * @param id Application identifier
+     * @return true if @p id is in the set
+     */
+    [[nodiscard]] bool contains(AppId id) const;
+
+    /**
+     * @brief Check whether an application is in the set
+     * @param name Application name
+     * @return true if @p name is in the set
+     */
+    [[nodiscard]] bool contains(const std::string &name) const;
+
+    /// @brief Number of applications in the set
+    [[nodiscard]] std::size_t size() const;
+
+    /// @brief Check whether the set is empty
+    [[nodiscard]] bool empty() const;
+
+    /// @brief Names of the applications in the set, in identifier order
+    [[nodiscard]] std::vector<std::string> names() const;
+
+    /// @brief Iterator to the first application of the set
+    [[nodiscard]] const_iterator begin() const;
+
+    /// @brief Iterator past the last application of the set
+    [[nodiscard]] const_iterator end() const;
+
+    /// @brief Add all the applications of @p rhs to this set
+    AppSet &operator|=(const AppSet &rhs);
+
+    /// @brief Check whether two sets contain the same applications
+    bool operator==(const AppSet &other) const;
+
+    /// @brief Check whether two sets contain different applications
+    bool operator!=(const AppSet &other) const;
+};
+
+} // namespace capiocl::engine
+
+#endif // CAPIO_CL_APPS_H
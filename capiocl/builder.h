@@ -0,0 +1,138 @@
+#ifndef CAPIO_CL_BUILDER_H
+#define CAPIO_CL_BUILDER_H
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "capiocl.hpp"
+#include "capiocl/engine.h"
+#include "capiocl/graph.h"
+#include "capiocl/index.h"
+#include "capiocl/tree.h"
+
+/// @brief Namespace containing the CAPIO-CL Engine
+namespace capiocl::engine {
+
+/**
+ * @brief Staging area used to fill an Engine with many entries at once.
+ *
+ * The builder offers the same setters of Engine, with the same semantics: entries are created on
+ * first use from the longest matching glob rule collected by the builder, and directory counters
+ * are updated as children are added. Entries are however kept in plain tables without any
+ * synchronization, so a builder must be used by a single thread. Calling the setters of the same
+ * path multiple times updates a single entry. Once complete, the entries are moved into an Engine
+ * by publish(), which acquires each lock of the Engine once instead of once per call.
+ */
+class EngineBuilder final {
+    /// @brief Entries of literal paths
+    std::unordered_map<std::string, CapioCLEntry> _entries;
+
+    /// @brief Entries of glob patterns
+    std::unordered_map<std::string, CapioCLEntry> _rules;
+
+    /// @brief Index of the keys of #_rules
+    PatternIndex _patterns;
+
+    /// @brief Directory hierarchy of #_entries
+    DirectoryTree _tree;
+
+    /// @brief Commit on File dependencies of #_entries
+    DependencyGraph _graph;
+
+    /// @brief Whether new entries are stored in memory, see Engine::setAllStoreInMemory()
+    bool _store_all_in_memory = false;
+
+    /**
+     * @brief Get the entry of @p path, creating it like Engine::newFile() if needed
+     * @param path Path of the entry
+     * @return The entry of @p path
+     */
+    CapioCLEntry &_entry(const std::filesystem::path &path);
+
+  public:
+    /// @brief Same as Engine::newFile()
+    void newFile(const std::filesystem::path &path);
+
+    /// @brief Same as Engine::addProducer()
+    void addProducer(const std::filesystem::path &path, std::string producer);
+
+    /// @brief Same as Engine::addConsumer()
+    void addConsumer(const std::filesystem::path &path, std::string consumer);
+
+    /**
+     * @brief Same as Engine::addFileDependency()
+     * @throw std::invalid_argument if @p file_dependency depends on @p path, directly or not
+     */
+    void addFileDependency(const std::filesystem::path &path,
+                           const std::filesystem::path &file_dependency);
+
+    /**
+     * @brief Same as Engine::setCommitRule()
+     * @throw std::invalid_argument if commit rule is not a valid CAPIO-CL commit rule
+     */
+    void setCommitRule(const std::filesystem::path &path, const std::string &commit_rule);
+
+    /// @brief Same as Engine::setCommitRule()
+    void setCommitRule(const std::filesystem::path &path, commitRules::COMMIT_RULE commit_rule);
+
+    /**
+     * @brief Same as Engine::setFireRule()
+     * @throw std::invalid_argument if fire rule is not a valid CAPIO-CL Firing rule
+     */
+    void setFireRule(const std::filesystem::path &path, const std::string &fire_rule);
+
+    /// @brief Same as Engine::setFireRule()
+    void setFireRule(const std::filesystem::path &path, fireRules::FIRE_RULE fire_rule);
+
+    /// @brief Same as Engine::setPermanent()
+    void setPermanent(const std::filesystem::path &path, bool value);
+
+    /// @brief Same as Engine::setExclude()
+    void setExclude(const std::filesystem::path &path, bool value);
+
+    /// @brief Same as Engine::setDirectory()
+    void setDirectory(const std::filesystem::path &path);
+
+    /// @brief Same as Engine::setFile()
+    void setFile(const std::filesystem::path &path);
+
+    /// @brief Same as Engine::setCommitedCloseNumber()
+    void setCommitedCloseNumber(const std::filesystem::path &path, long num);
+
+    /// @brief Same as Engine::setDirectoryFileCount()
+    void setDirectoryFileCount(const std::filesystem::path &path, long num);
+
+    /**
+     * @brief Same as Engine::setFileDeps()
+     * @throw std::invalid_argument if the dependencies would form a cycle
+     */
+    void setFileDeps(const std::filesystem::path &path,
+                     const std::vector<std::filesystem::path> &dependencies);
+
+    /// @brief Same as Engine::setStoreFileInMemory()
+    void setStoreFileInMemory(const std::filesystem::path &path);
+
+    /// @brief Same as Engine::setStoreFileInFileSystem()
+    void setStoreFileInFileSystem(const std::filesystem::path &path);
+
+    /// @brief Same as Engine::setAllStoreInMemory()
+    void setAllStoreInMemory();
+
+    /// @brief Number of entries collected so far, glob rules included
+    [[nodiscard]] std::size_t size() const;
+
+    /**
+     * @brief Move the collected entries into @p engine, leaving this builder empty. Entries that
+     * already exist within @p engine are merged with CapioCLEntry::operator+=(), and the directory
+     * counters of @p engine are updated with the new children.
+     * @param engine Engine receiving the entries
+     * @throw std::invalid_argument if the collected dependencies form a cycle with the ones of
+     * @p engine. In that case neither the entries nor their dependencies are published
+     */
+    void publish(Engine &engine);
+};
+
+} // namespace capiocl::engine
+
+#endif // CAPIO_CL_BUILDER_H
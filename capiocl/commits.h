@@ -0,0 +1,122 @@
+#ifndef CAPIO_CL_COMMITS_H
+#define CAPIO_CL_COMMITS_H
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+
+/// @brief Namespace containing the CAPIO-CL Monitor components
+namespace capiocl::monitor {
+
+/**
+ * @brief Concurrent set of committed paths, used by the monitor backends to record commit state.
+ *
+ * Paths are spread over #SHARDS hash sets, each protected by its own lock, so that the listener
+ * thread recording the commits of other processes and the threads querying them do not serialize
+ * on a single mutex. A Bloom filter of atomic words sits in front of the shards: a path whose bits
+ * are not all set was never inserted, and contains() answers it without taking any lock.
+ *
+ * In compact mode only the 64-bit hash of each path is stored, which bounds the memory of very
+ * large commit sets regardless of path length. Two distinct paths with the same hash are then
+ * indistinguishable, which with 64-bit hashes is negligible below billions of commits.
+ */
+class CommitSet final {
+  public:
+    /// @brief Number of independently locked hash sets
+    static constexpr std::size_t SHARDS = 64;
+
+    /// @brief Number of bits of the Bloom filter set by each path
+    static constexpr std::size_t BLOOM_HASHES = 4;
+
+  private:
+    /// @brief Paths whose hash selects this shard
+    struct Shard {
+        /// @brief Mutex protecting #paths and #hashes
+        mutable std::mutex lock;
+        /// @brief Committed paths, when not in compact mode
+        std::unordered_set<std::string> paths;
+        /// @brief Hashes of the committed paths, in compact mode
+        std::unordered_set<std::uint64_t> hashes;
+    };
+
+    /// @brief The #SHARDS shards
+    std::unique_ptr<Shard[]> shards;
+
+    /// @brief Words of the Bloom filter, or nullptr when the filter is disabled
+    std::unique_ptr<std::atomic<std::uint64_t>[]> bloom;
+
+    /// @brief Number of bits of the Bloom filter minus one. The size is a power of two
+    std::uint64_t bloom_mask = 0;
+
+    /// @brief Whether only the hashes of the paths are stored
+    bool compact = false;
+
+    /// @brief Number of committed paths
+    std::atomic<std::size_t> count = 0;
+
+    /**
+     * @brief Set the bits of @p hash in the Bloom filter
+     * @param hash Hash of the path
+     */
+    void bloomInsert(std::uint64_t hash);
+
+    /**
+     * @brief Check the bits of @p hash in the Bloom filter
+     * @param hash Hash of the path
+     * @return false if the path was never inserted, true if it may have been
+     */
+    [[nodiscard]] bool bloomContains(std::uint64_t hash) const;
+
+  public:
+    /**
+     * @brief Build an empty set. The Bloom filter is disabled by default, and only allocated by
+     * the backends that enable it through configure()
+     * @param compact Whether to store only the hashes of the paths
+     * @param bloom_bits Number of bits of the Bloom filter, rounded up to a power of two. Zero
+     * disables the filter. With #BLOOM_HASHES hashes, 8 bits per path give about 2% of false
+     * positives
+     */
+    explicit CommitSet(bool compact = false, std::size_t bloom_bits = 0);
+
+    /**
+     * @brief Clear the set and change its representation. Not thread safe: must be called before
+     * the set is shared with other threads
+     * @param compact Whether to store only the hashes of the paths
+     * @param bloom_bits Number of bits of the Bloom filter, zero to disable it
+     */
+    void configure(bool compact, std::size_t bloom_bits);
+
+    /**
+     * @brief 64-bit hash of a path, used to select its shard and its Bloom filter bits
+     * @param path Path to hash
+     * @return The hash of @p path
+     */
+    static std::uint64_t hash(const std::string &path);
+
+    /**
+     * @brief Insert a path
+     * @param path Committed path
+     * @return true if @p path was not in the set yet
+     */
+    bool insert(const std::string &path);
+
+    /**
+     * @brief Check whether a path was inserted. Paths rejected by the Bloom filter are answered
+     * without taking any lock
+     * @param path Path to look for
+     * @return true if @p path is in the set
+     */
+    [[nodiscard]] bool contains(const std::string &path) const;
+
+    /// @brief Number of paths in the set
+    [[nodiscard]] std::size_t size() const;
+
+    /// @brief Whether only the hashes of the paths are stored
+    [[nodiscard]] bool isCompact() const;
+};
+} // namespace capiocl::monitor
+
+#endif // CAPIO_CL_COMMITS_H
@@ -29,10 +29,34 @@ struct capiocl::configuration::defaults {
     static ConfigurationEntry DEFAULT_MONITOR_HOMENODE_PORT;
     /// @brief Enable File system monitor by default
     static ConfigurationEntry DEFAULT_MONITOR_FS_ENABLED;
+    /// @brief Whether the multicast monitor stores only the hashes of the committed paths
+    static ConfigurationEntry DEFAULT_MONITOR_COMMITS_COMPACT;
+    /// @brief Number of bits of the Bloom filter in front of the committed paths
+    static ConfigurationEntry DEFAULT_MONITOR_COMMITS_BLOOM_BITS;
+    /// @brief Maximum number of multicast datagrams sent by a single system call
+    static ConfigurationEntry DEFAULT_MONITOR_MCAST_BATCH_SIZE;
+    /// @brief Maximum time in microseconds a multicast datagram waits to be batched with others
+    static ConfigurationEntry DEFAULT_MONITOR_MCAST_BATCH_DELAY;
+    /// @brief Maximum size in bytes of a multicast datagram carrying several messages
+    static ConfigurationEntry DEFAULT_MONITOR_MCAST_BATCH_MTU;
+    /// @brief Whether the paths packed in a multicast datagram are compressed against each other
+    static ConfigurationEntry DEFAULT_MONITOR_MCAST_BATCH_PREFIX;
+    /// @brief Percentile of the query round trip times the multicast query timeout derives from
+    static ConfigurationEntry DEFAULT_MONITOR_MCAST_TIMEOUT_PERCENTILE;
+    /// @brief Multiplier applied to the round trip time percentile to get the query timeout
+    static ConfigurationEntry DEFAULT_MONITOR_MCAST_TIMEOUT_FACTOR;
+    /// @brief Shortest multicast query timeout in microseconds
+    static ConfigurationEntry DEFAULT_MONITOR_MCAST_TIMEOUT_MIN;
     /// @brief IP multicast address for receiving and sending changes in the CapioCL configuration
     static ConfigurationEntry DEFAULT_API_MULTICAST_IP;
     /// @brief IP multicast port for receiving and sending changes in the CapioCL configuration
     static ConfigurationEntry DEFAULT_API_MULTICAST_PORT;
+    /// @brief Number of shards of the Engine entry table
+    static ConfigurationEntry DEFAULT_ENGINE_SHARDS;
+    /// @brief Whether Engine readers use published snapshots instead of locks
+    static ConfigurationEntry DEFAULT_ENGINE_SNAPSHOT_READS;
+    /// @brief Whether Engine queries that miss create an entry for the queried path
+    static ConfigurationEntry DEFAULT_ENGINE_MATERIALIZE_READS;
 };
 
 /// @brief Load configuration and store it from a CAPIO-CL TOML configuration file
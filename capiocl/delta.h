@@ -0,0 +1,135 @@
+#ifndef CAPIO_CL_DELTA_H
+#define CAPIO_CL_DELTA_H
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// @brief Namespace containing the CAPIO-CL Engine
+namespace capiocl::engine {
+
+struct CapioCLEntry;
+
+/**
+ * @brief A single change to the entry of a path, applied by Engine::apply().
+ *
+ * Scalar fields are set to a value, or unset to go back to the value inherited from the matching
+ * glob rule. Producers, consumers and Commit on File dependencies are changed one element at a
+ * time, and ERASE removes the whole entry. Every operation leaves the entry in the same state
+ * however many times it is applied, so deltas can be delivered more than once, and peers can
+ * exchange them instead of whole entries.
+ */
+struct Delta final {
+    /// @brief Kind of change. #field is ignored by ERASE
+    typedef enum { SET, UNSET, ADD, REMOVE, ERASE } OPERATION;
+
+    /// @brief Field changed. The last three are lists, changed with ADD and REMOVE
+    typedef enum {
+        COMMIT_RULE,
+        FIRE_RULE,
+        COMMIT_ON_CLOSE_COUNT,
+        DIRECTORY_FILE_COUNT,
+        PERMANENT,
+        EXCLUDED,
+        STORE_IN_MEMORY,
+        IS_FILE,
+        PRODUCER,
+        CONSUMER,
+        DEPENDENCY
+    } FIELD;
+
+    /// @brief Version of the Engine that applied the delta, as returned by Engine::changesSince().
+    /// Ignored by Engine::apply()
+    std::uint64_t version = 0;
+    /// @brief Path of the entry
+    std::string path;
+    /// @brief Kind of change
+    OPERATION operation = SET;
+    /// @brief Field changed
+    FIELD field = COMMIT_RULE;
+    /// @brief Rule keyword, application name or dependency, depending on #field
+    std::string value;
+    /// @brief Count, or 0 and 1 for boolean fields, depending on #field
+    long number = 0;
+
+    /**
+     * @brief Build a delta setting a rule of @p path
+     * @param path Path of the entry
+     * @param field #COMMIT_RULE or #FIRE_RULE
+     * @param keyword Keyword of the rule
+     * @return The delta
+     */
+    static Delta set(const std::string &path, FIELD field, const std::string &keyword);
+
+    /**
+     * @brief Build a delta setting a count or a boolean field of @p path
+     * @param path Path of the entry
+     * @param field Field to set
+     * @param number New value, 0 or 1 for boolean fields
+     * @return The delta
+     */
+    static Delta set(const std::string &path, FIELD field, long number);
+
+    /**
+     * @brief Build a delta restoring a field of @p path to the value of the matching glob rule
+     * @param path Path of the entry
+     * @param field Field to unset
+     * @return The delta
+     */
+    static Delta unset(const std::string &path, FIELD field);
+
+    /**
+     * @brief Build a delta adding an element to a list of @p path
+     * @param path Path of the entry
+     * @param field #PRODUCER, #CONSUMER or #DEPENDENCY
+     * @param value Application name or dependency
+     * @return The delta
+     */
+    static Delta add(const std::string &path, FIELD field, const std::string &value);
+
+    /**
+     * @brief Build a delta removing an element from a list of @p path
+     * @param path Path of the entry
+     * @param field #PRODUCER, #CONSUMER or #DEPENDENCY
+     * @param value Application name or dependency
+     * @return The delta
+     */
+    static Delta remove(const std::string &path, FIELD field, const std::string &value);
+
+    /**
+     * @brief Build a delta removing the entry of @p path, as Engine::remove() does
+     * @param path Path of the entry
+     * @return The delta
+     */
+    static Delta erase(const std::string &path);
+
+    /**
+     * @brief Build the deltas that bring the entry of @p path to the content of @p entry, without
+     * removing anything. Used to apply whole entries received from older peers
+     * @param path Path of the entry
+     * @param entry Entry to apply
+     * @return The deltas
+     */
+    static std::vector<Delta> fromEntry(const std::string &path, const CapioCLEntry &entry);
+
+    /**
+     * @brief Generate a delta from a JSON input
+     * @param in string with JSON to be parsed
+     * @return The delta
+     * @throws std::invalid_argument if the operation or the field is unknown
+     */
+    static Delta fromJson(const std::string &in);
+
+    /// @brief Serialize this delta to a JSON object returned as string to be sent over network
+    [[nodiscard]] std::string toJson() const;
+
+    /// @brief Whether #field is a list, changed with ADD and REMOVE
+    [[nodiscard]] bool isList() const;
+
+    /// @brief Key of the element changed: deltas with the same key overwrite each other. The key
+    /// of an ERASE is a prefix of the keys of every other change of the same entry
+    [[nodiscard]] std::string key() const;
+};
+
+} // namespace capiocl::engine
+
+#endif // CAPIO_CL_DELTA_H
@@ -1,13 +1,28 @@
 #ifndef CAPIO_CL_ENGINE_H
 #define CAPIO_CL_ENGINE_H
+#include <atomic>
 #include <jsoncons/basic_json.hpp>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <shared_mutex>
 #include <vector>
 
 #include "capiocl.hpp"
 #include "capiocl/api.h"
+#include "capiocl/apps.h"
+#include "capiocl/delta.h"
+#include "capiocl/graph.h"
+#include "capiocl/index.h"
+#include "capiocl/merkle.h"
 #include "capiocl/monitor.h"
 #include "capiocl/serializer.h"
+#include "capiocl/stats.h"
+#include "capiocl/tree.h"
+
+namespace capiocl::snapshot {
+class Image;
+} // namespace capiocl::snapshot
 
 /// @brief Namespace containing the CAPIO-CL Engine
 namespace capiocl::engine {
@@ -17,31 +32,36 @@ namespace capiocl::engine {
 struct CapioCLEntry final {
     // LCOV_EXCL_START
     ///@brief Producers of file
-    std::vector<std::string> producers;
+    AppSet producers;
     ///@brief consumers of file
-    std::vector<std::string> consumers;
+    AppSet consumers;
     ///@brief Dependencies for Commit
     std::vector<std::filesystem::path> file_dependencies;
-    ///@brief Commit rule
-    std::string commit_rule            = commitRules::ON_TERMINATION;
-    ///@brief Fire rule
-    std::string fire_rule              = fireRules::UPDATE;
     ///@brief Expected number of files in directory
-    long directory_children_count      = 0;
+    long directory_children_count        = 0;
     ///@brief Expected close count
-    long commit_on_close_count         = 0;
+    long commit_on_close_count           = 0;
+    ///@brief Commit rule
+    commitRules::COMMIT_RULE commit_rule = commitRules::COMMIT_RULE::ON_TERMINATION;
+    ///@brief Fire rule
+    fireRules::FIRE_RULE fire_rule       = fireRules::FIRE_RULE::UPDATE;
     /// @brief whether to update or not directory item count
-    bool enable_directory_count_update = true;
+    bool enable_directory_count_update : 1;
     /// @brief Store in memory or on the file system
-    bool store_in_memory               = false;
+    bool store_in_memory : 1;
     /// @brief whether the file should persiste after workflow termination
-    bool permanent                     = false;
+    bool permanent : 1;
     /// @brief whether to ignore this entry
-    bool excluded                      = false;
+    bool excluded : 1;
     /// @brief whether this entry is a file or a directory
-    bool is_file                       = true;
+    bool is_file : 1;
     // LCOV_EXCL_STOP
 
+    /// @brief Build an entry with the default CAPIO-CL rules
+    CapioCLEntry()
+        : enable_directory_count_update(true), store_in_memory(false), permanent(false),
+          excluded(false), is_file(true) {}
+
     /**
      * Generate a new CapioClEntry from a JSON input
      * @param in string with JSON to be parsed
@@ -52,17 +72,75 @@ struct CapioCLEntry final {
     /// @brief Serialize this entry to a JSON object returned as string to be sent over network
     [[nodiscard]] std::string toJson() const;
 
-    /// @brief add a new CapioClEntry to this one
+    /// @brief add a new CapioClEntry to this one. Lists are merged without duplicates, rules and
+    /// counts set explicitly are taken from @p rhs, so adding the same entry twice has no effect
     CapioCLEntry &operator+=(const CapioCLEntry &rhs);
 
     /// @brief add a new CapioClEntry to this one
     CapioCLEntry operator+(const CapioCLEntry &rhs);
 
+    /// @brief Hash of the content of this entry. Lists are hashed regardless of the order of
+    /// their elements, and applications by name, so the hash is the same on every process
+    [[nodiscard]] std::uint64_t hash() const;
+
     /// @brief check for equality of rules
-    bool operator==(const CapioCLEntry &other);
+    bool operator==(const CapioCLEntry &other) const;
 
     /// @brief check for inequality
-    bool operator!=(const CapioCLEntry &other);
+    bool operator!=(const CapioCLEntry &other) const;
+};
+
+static_assert(sizeof(CapioCLEntry) <= 64, "CapioCLEntry must fit in a cache line");
+
+/// @brief Rule attributes of a path, as returned by Engine::queryBatch()
+struct EntryAttributes final {
+    /// @brief Expected close count
+    long commit_on_close_count           = 0;
+    /// @brief Number of files the commit depends on
+    std::size_t file_dependencies_count  = 0;
+    /// @brief Commit rule
+    commitRules::COMMIT_RULE commit_rule = commitRules::COMMIT_RULE::ON_TERMINATION;
+    /// @brief Fire rule
+    fireRules::FIRE_RULE fire_rule       = fireRules::FIRE_RULE::UPDATE;
+    /// @brief whether the file should persist after workflow termination
+    bool permanent                       = false;
+    /// @brief whether the entry is excluded
+    bool excluded                        = false;
+    /// @brief whether the entry is a file or a directory
+    bool is_file                         = true;
+    /// @brief Store in memory or on the file system
+    bool store_in_memory                 = false;
+};
+
+/**
+ * @brief Reference to an entry of an Engine, returned by Engine::resolve().
+ *
+ * Queries issued through a handle access the entry directly, without hashing the path again.
+ * Handles stay valid while other entries are inserted or modified. When the entry may have been
+ * removed, the handle is detected as stale by a generation counter and queries fall back to a
+ * lookup by path, as if the path based method was called.
+ */
+class EntryHandle final {
+    friend class Engine;
+
+    /// @brief Value of #_shard for entries of glob rules
+    static constexpr std::uint32_t RULES = UINT32_MAX;
+
+    /// @brief Path of the entry
+    std::string _path;
+    /// @brief Resolved entry, nullptr for empty handles
+    const CapioCLEntry *_entry = nullptr;
+    /// @brief Index of the shard storing the entry, or #RULES
+    std::uint32_t _shard = 0;
+    /// @brief Generation of the shard when the handle was resolved
+    std::uint64_t _generation = 0;
+
+  public:
+    /// @brief Path the handle was resolved from
+    [[nodiscard]] const std::string &path() const { return _path; }
+
+    /// @brief Check whether the handle does not refer to any entry
+    [[nodiscard]] bool empty() const { return _entry == nullptr; }
 };
 
 /**
@@ -82,9 +160,57 @@ struct CapioCLEntry final {
  */
 class Engine final {
     friend class serializer::Serializer;
-
-    /// @brief Synchronization variable for locking
-    mutable std::shared_mutex _shared_mutex;
+    friend class EngineBuilder;
+
+    /// @brief Immutable view of a set of entries, published to readers in snapshot mode
+    typedef std::unordered_map<std::string, std::shared_ptr<const CapioCLEntry>> EntrySnapshot;
+
+    /// @brief A segment of the entry table, with its own lock
+    struct EntryShard {
+        /// @brief Synchronization variable for the entries of this shard
+        mutable std::shared_mutex mutex;
+        /// @brief Entries whose path hashes to this shard
+        std::unordered_map<std::string, CapioCLEntry> entries;
+        /// @brief Last published view of #entries. Only maintained in snapshot mode
+        std::shared_ptr<const EntrySnapshot> snapshot;
+        /// @brief Incremented whenever an entry is removed, to detect stale EntryHandle objects
+        std::uint64_t generation = 0;
+        /// @brief Synchronization variable for #closes. The counters themselves are atomic, so
+        /// they are incremented while holding it shared
+        mutable std::shared_mutex closes_mutex;
+        /// @brief Number of close operations observed by notifyClose(), by path
+        std::unordered_map<std::string, std::atomic<long>> closes;
+        /// @brief Synchronization variable for #files. The counters themselves are atomic, so they
+        /// are incremented while holding it shared
+        mutable std::shared_mutex files_mutex;
+        /// @brief Number of files observed by _observe() within a directory, by directory path
+        std::unordered_map<std::string, std::atomic<long>> files;
+        /// @brief Synchronization variable for #observed
+        mutable std::mutex observed_mutex;
+        /// @brief Paths already counted by _observe() within a directory, by directory path
+        std::unordered_map<std::string, std::unordered_set<std::string>> observed;
+        /// @brief Incremented by _publish() whenever #entries changes. Guarded by #mutex
+        std::uint64_t changes = 1;
+        /// @brief Synchronization variable for #digest and #digest_changes
+        mutable std::mutex digest_mutex;
+        /// @brief Sum of the MerkleTree::leaf() hashes of #entries, by bucket, sorted by bucket
+        std::vector<std::pair<std::uint32_t, std::uint64_t>> digest;
+        /// @brief Value of #changes when #digest was computed
+        std::uint64_t digest_changes = 0;
+    };
+
+    /// @brief Immutable view of the glob rules, published to readers in snapshot mode
+    struct RulesSnapshot {
+        /// @brief Entries of the glob rules
+        EntrySnapshot rules;
+        /// @brief Index of the keys of #rules
+        PatternIndex patterns;
+    };
+
+    /// @brief Synchronization variable for #_rules, #_patterns and engine-wide settings. When
+    /// both are needed, this lock is always acquired before a shard lock, and at most one shard
+    /// lock is held at any time
+    mutable std::shared_mutex _rules_mutex;
 
     /// @brief Whether current engine instance should store all files in memory
     bool store_all_in_memory = false;
@@ -104,8 +230,215 @@ class Engine final {
     /// @brief CAPIO-CL APIs Web Server
     std::unique_ptr<api::CapioClApiServer> webapi_server;
 
-    /// @brief Hash map used to store the configuration from CAPIO-CL
-    mutable std::unordered_map<std::string, CapioCLEntry> _capio_cl_entries;
+    /// @brief Hash-sharded table storing the entries of literal paths from CAPIO-CL
+    std::vector<std::unique_ptr<EntryShard>> _shards;
+
+    /// @brief Entries of glob patterns from CAPIO-CL, used as templates for new files
+    mutable std::unordered_map<std::string, CapioCLEntry> _rules;
+
+    /// @brief Index of the keys of #_rules
+    mutable PatternIndex _patterns;
+
+    /// @brief Incremented whenever a glob rule is removed, to detect stale EntryHandle objects
+    mutable std::uint64_t _rules_generation = 0;
+
+    /// @brief Whether readers use the published snapshots instead of taking locks
+    bool _snapshot_reads = false;
+
+    /// @brief Last published view of #_rules. Only maintained in snapshot mode
+    mutable std::shared_ptr<const RulesSnapshot> _rules_snapshot;
+
+    /// @brief Incremented by _publish_rules() whenever #_rules changes. Guarded by #_rules_mutex
+    mutable std::uint64_t _rules_changes = 1;
+
+    /// @brief Synchronization variable for #_rules_digest and #_rules_digest_changes
+    mutable std::mutex _rules_digest_mutex;
+
+    /// @brief Same as EntryShard::digest, for #_rules
+    mutable std::vector<std::pair<std::uint32_t, std::uint64_t>> _rules_digest;
+
+    /// @brief Value of #_rules_changes when #_rules_digest was computed
+    mutable std::uint64_t _rules_digest_changes = 0;
+
+    /// @brief Synchronization variable for #_tree. No other lock is acquired while holding it
+    mutable std::shared_mutex _tree_mutex;
+
+    /// @brief Directory hierarchy of the literal paths with an entry
+    mutable DirectoryTree _tree;
+
+    /// @brief Synchronization variable for #_graph. No other lock is acquired while holding it
+    mutable std::mutex _graph_mutex;
+
+    /// @brief Commit on File dependencies of the literal paths with an entry
+    mutable DependencyGraph _graph;
+
+    /// @brief Whether queries on paths without an entry create one. When false, they are answered
+    /// from the matching glob rule, and entries are only created by methods that modify them.
+    /// Ignored in snapshot mode, see _materializes()
+    bool _materialize_reads = true;
+
+    /// @brief Number of queries answered without creating the entry of the queried path
+    mutable std::atomic<std::uint64_t> _avoided_entries = 0;
+
+    /// @brief Counters and latencies reported by stats()
+    StatsCollector _stats;
+
+    /// @brief Snapshot opened by openSnapshot(). Its records of literal paths are moved into the
+    /// shards the first time they are looked up
+    std::shared_ptr<const snapshot::Image> _image;
+
+    /// @brief Whether the paths of #_image still have to be inserted into #_tree
+    mutable std::atomic<bool> _tree_pending = false;
+
+    /// @brief Whether the dependencies of #_image still have to be inserted into #_graph
+    mutable std::atomic<bool> _graph_pending = false;
+
+    /// @brief Synchronization variable for #_version, #_changes and #_latest. No other lock is
+    /// acquired while holding it
+    mutable std::mutex _changes_mutex;
+
+    /// @brief Version of the last recorded change
+    mutable std::uint64_t _version = 0;
+
+    /// @brief Recorded changes, keyed by version. Only the last change of each Delta::key() is
+    /// kept, and the removal of an entry drops the changes made to it before, so the log grows
+    /// with the number of fields of the existing entries, not with the number of changes
+    mutable std::map<std::uint64_t, Delta> _changes;
+
+    /// @brief Version of the last change of each Delta::key() within #_changes. Ordered, so that
+    /// the changes of an entry are found from the key of its removal, which is their prefix
+    mutable std::map<std::string, std::uint64_t> _latest;
+
+    /**
+     * @brief Publish a new snapshot of @p shard where only the entry of @p path changed, and
+     * invalidate the digest of @p shard. Must be called with the lock of @p shard held exclusively
+     * @param shard Shard that was modified
+     * @param path Path of the entry that was inserted, modified or removed
+     */
+    void _publish(EntryShard &shard, const std::string &path) const;
+
+    /**
+     * @brief Publish a new snapshot of @p shard where only the entries of @p paths changed, and
+     * invalidate the digest of @p shard. Must be called with the lock of @p shard held exclusively
+     * @param shard Shard that was modified
+     * @param paths Paths of the entries that were inserted, modified or removed
+     */
+    void _publish(EntryShard &shard, const std::vector<std::string> &paths) const;
+
+    /**
+     * @brief Publish a new snapshot of #_rules, and invalidate #_rules_digest. Must be called with
+     * #_rules_mutex held exclusively
+     */
+    void _publish_rules() const;
+
+    /**
+     * @brief Compute the sum of the MerkleTree::leaf() hashes of a set of entries, by bucket
+     * @param entries Entries to hash, keyed by path
+     * @return The sums of the non-empty buckets, sorted by bucket
+     */
+    template <typename Map>
+    static std::vector<std::pair<std::uint32_t, std::uint64_t>> _digest(const Map &entries);
+
+    /**
+     * @brief Enable or disable snapshot reads. Must not be called concurrently with other
+     * methods of this class
+     * @param enabled Whether readers should use the published snapshots
+     */
+    void _set_snapshot_reads(bool enabled);
+
+    /**
+     * @brief Whether queries on paths without an entry create one. Never in snapshot mode, where
+     * each insertion copies the snapshot map of its shard
+     * @return true if #_materialize_reads is set and #_snapshot_reads is not
+     */
+    [[nodiscard]] bool _materializes() const;
+
+    /**
+     * @brief Check whether any glob rule matching @p path satisfies @p pred
+     * @param path Path to resolve
+     * @param pred Predicate receiving a const reference to the rule entry
+     * @return true if at least a matching rule satisfies @p pred
+     */
+    template <typename F> bool _any_rule(const std::string &path, F &&pred) const;
+
+    /**
+     * @brief Get the index of the shard storing a literal path
+     * @param path Literal path
+     * @return The index within #_shards of the shard responsible for @p path
+     */
+    std::size_t _shard_index(const std::string &path) const;
+
+    /**
+     * @brief Get the shard storing a literal path
+     * @param path Literal path
+     * @return The shard responsible for @p path
+     */
+    EntryShard &_shard(const std::string &path) const;
+
+    /**
+     * @brief Redistribute the entries over a new number of shards. Must not be called
+     * concurrently with other methods of this class
+     * @param count Number of shards
+     */
+    void _reshard(std::size_t count);
+
+    /**
+     * @brief Invoke @p fn on the entry of @p path, holding a shared lock on it. In snapshot mode
+     * no lock is taken and @p fn receives the entry from the last published snapshot
+     * @param path Path of the entry
+     * @param fn Callback receiving a const reference to the entry
+     * @return false if @p path has no entry
+     */
+    template <typename F> bool _find(const std::string &path, F &&fn) const;
+
+    /**
+     * @brief Invoke @p fn on the entry referenced by @p handle, holding a shared lock on it. The
+     * lock is taken also in snapshot mode, so that @p fn always sees the latest version
+     * @param handle Handle returned by resolve()
+     * @param fn Callback receiving a const reference to the entry
+     * @return false if @p handle is empty or stale
+     */
+    template <typename F> bool _find(const EntryHandle &handle, F &&fn) const;
+
+    /**
+     * @brief Invoke @p fn on the entry of @p path, holding an exclusive lock on it
+     * @param path Path of the entry
+     * @param fn Callback receiving a reference to the entry
+     * @return false if @p path has no entry
+     */
+    template <typename F> bool _modify(const std::string &path, F &&fn) const;
+
+    /**
+     * @brief Same as _find(), but a default entry is created first if @p path has none. If
+     * _materializes() is false, @p fn receives the default entry without storing it
+     * @param path Path of the entry
+     * @param fn Callback receiving a const reference to the entry
+     */
+    template <typename F> void _read(const std::filesystem::path &path, F &&fn) const;
+
+    /**
+     * @brief Same as _modify(), but a default entry is created first if @p path has none
+     * @param path Path of the entry
+     * @param fn Callback receiving a reference to the entry
+     */
+    template <typename F> void _write(const std::filesystem::path &path, F &&fn) const;
+
+    /**
+     * @brief Invoke @p fn on every entry, one shard at a time
+     * @param fn Callback receiving the path and a const reference to the entry
+     */
+    template <typename F> void _for_each(F &&fn) const;
+
+    /**
+     * @brief Insert a new entry, keeping #_patterns up to date
+     * @param path Path of the entry
+     * @param entry Entry to insert
+     * @return false if @p path already had an entry, which is left untouched
+     */
+    bool _insert(const std::string &path, CapioCLEntry entry) const;
+
+    /// @brief Copy of all the entries, used by serializers
+    std::unordered_map<std::string, CapioCLEntry> _entries() const;
 
     /**
      * @brief Utility method to truncate a string to its last @p n characters. This is only used
@@ -125,13 +458,68 @@ class Engine final {
     }
 
     /**
-     * @brief Insert a new empty default file in #_capio_cl_entries
+     * @brief Build the default entry of @p path, inherited from the longest matching glob rule.
+     * Must be called with #_rules_mutex held
+     * @param path File path name
+     * @return The entry to insert for @p path
+     */
+    CapioCLEntry _template(const std::filesystem::path &path) const;
+
+    /**
+     * @brief Build the default entry of @p path out of a set of glob rules
+     * @param path File path name
+     * @param rules Glob rules, keyed by pattern
+     * @param patterns Index of the keys of @p rules
+     * @param store_all_in_memory Whether new entries are stored in memory
+     * @return The entry to insert for @p path
+     */
+    static CapioCLEntry _template(const std::filesystem::path &path,
+                                  const std::unordered_map<std::string, CapioCLEntry> &rules,
+                                  const PatternIndex &patterns, bool store_all_in_memory);
+
+    /**
+     * @brief Insert a new default entry for @p path, inherited from the longest matching glob
+     * rule. No lock must be held by the caller
      * @param path File path name
      */
     void _newFile(const std::filesystem::path &path) const;
 
     /**
-     * @brief Updates the number of entries in the parent directory of the given path.
+     * @brief Called by queries that did not find an entry for @p path. Creates the entry with
+     * _newFile(), unless _materializes() is false. No lock must be held by the caller
+     * @param path File path name
+     */
+    void _missed(const std::filesystem::path &path) const;
+
+    /**
+     * @brief Move the entry of @p path from #_image into its shard, if #_image has one that was
+     * not moved yet. No lock must be held by the caller
+     * @param path Literal path that was not found in the shards
+     * @return true if #_image has a record for @p path, so that the lookup must be retried
+     */
+    bool _fault(const std::string &path) const;
+
+    /**
+     * @brief Move the entry of a record of #_image into its shard, unless it was already moved.
+     * No lock must be held by the caller
+     * @param position Position of the record within #_image
+     */
+    void _claim(std::size_t position) const;
+
+    /// @brief Move all the remaining entries of #_image into the shards
+    void _drain() const;
+
+    /// @brief Insert the paths of #_image into #_tree, the first time the tree is needed. Must be
+    /// called before acquiring #_tree_mutex
+    void _load_tree() const;
+
+    /// @brief Insert the dependencies of #_image into #_graph, the first time the graph is
+    /// needed. Must be called before acquiring #_graph_mutex
+    void _load_graph() const;
+
+    /**
+     * @brief Records a new entry in the directory tree, and updates the number of entries of its
+     * parent directory and, if the new entry already has known children, of the entry itself.
      *
      * @note The computed value remains valid only until `setDirectoryFileCount()` is called.
      * Once `setDirectoryFileCount()` is used, this method is no longer responsible for computing
@@ -140,10 +528,82 @@ class Engine final {
      * that provided count includes or excludes the files automatically computed from CAPIO-CL
      * information, or if it includes also all future created CAPIO-CL file entries or not.
      *
-     * @param path The path whose parent directory entry count should be updated.
+     * @param path The path of the new entry. No lock must be held by the caller
      */
     void compute_directory_entry_count(const std::filesystem::path &path) const;
 
+    /**
+     * @brief Update the Commit on File dependencies of @p path within #_graph. Glob rules are not
+     * linked, the entries inheriting their dependencies are
+     * @param path Path of the entry
+     * @param dependencies Dependencies of @p path
+     * @param replace Whether @p dependencies replace the current ones or are added to them
+     * @return true if the dependencies of @p path are all committed while @p path is not, including
+     * the ones committed before being linked: the caller must pass @p path to _cascade() once it
+     * holds no lock
+     * @throw std::invalid_argument if a dependency would close a cycle
+     */
+    bool _link(const std::filesystem::path &path,
+               const std::vector<std::filesystem::path> &dependencies, bool replace) const;
+
+    /**
+     * @brief Commit the Commit on File targets whose dependencies are all committed, then the
+     * targets this unblocks in turn. No lock must be held by the caller
+     * @param ready Targets whose dependencies are all committed
+     */
+    void _cascade(std::vector<std::string> ready) const;
+
+    /**
+     * @brief Commit within #_graph the files returned by DependencyGraph::takeUnknown() that the
+     * monitor reports as committed, as #_graph does not remember the commits of files it did not
+     * contain. The monitor is queried without waiting for other processes, and without the lock of
+     * #_graph
+     * @param unknown Files returned by DependencyGraph::takeUnknown()
+     * @return The targets whose dependencies are now all committed, to be passed to _cascade()
+     */
+    std::vector<std::string> _settle(const std::vector<std::string> &unknown) const;
+
+    /**
+     * @brief Link the dependencies a new entry inherited from a glob rule. Dependencies closing a
+     * cycle are reported with a warning and left out of #_graph
+     * @param path Path of the new entry
+     * @param dependencies Dependencies of @p path
+     */
+    void _inherit(const std::filesystem::path &path,
+                  const std::vector<std::filesystem::path> &dependencies) const;
+
+    /**
+     * @brief Count @p path among the files of its parent directory, when the directory follows the
+     * Commit on N Files rule with an explicit file count. Each path is counted once, whether it is
+     * created or committed first. The directory is committed through setCommitted() by the call
+     * that brings its counter to the expected number of files. No lock must be held by the caller
+     * @param path Path of the new or committed file
+     */
+    void _observe(const std::filesystem::path &path) const;
+
+    /**
+     * @brief Forget the files counted by _observe() in @p path, and @p path itself in the count of
+     * its parent directory, so that they are counted again when they are created anew. No lock
+     * must be held by the caller
+     * @param path Path of the removed file or directory
+     */
+    void _unobserve(const std::filesystem::path &path) const;
+
+    /**
+     * @brief Record a change in #_changes with a new version, replacing the previous change of
+     * the same Delta::key(). Can be called while holding the lock of the changed entry
+     * @param delta Change applied
+     * @return The version of the change
+     */
+    std::uint64_t _record(Delta delta) const;
+
+    /**
+     * @brief Remove the entry or the glob rule of @p path, recording the removal of entries
+     * @param path Path of the entry or glob rule
+     * @return The version of the removal, or 0 if no entry was removed
+     */
+    std::uint64_t _remove(const std::filesystem::path &path) const;
+
   public:
     /// @brief Class constructor
     explicit Engine(bool use_default_settings = true);
@@ -174,6 +634,7 @@ class Engine final {
      * @param permanent Whether the file/directory is permanent.
      * @param exclude Whether the file/directory is excluded.
      * @param dependencies List of dependent files.
+     * @throw std::invalid_argument if the dependencies would form a cycle
      */
     void add(std::filesystem::path &path, std::vector<std::string> &producers,
              std::vector<std::string> &consumers, const std::string &commit_rule,
@@ -181,9 +642,11 @@ class Engine final {
              std::vector<std::filesystem::path> &dependencies);
 
     /**
-     * Add a new CapioClEntry to the internal Database
+     * Add a new CapioClEntry to the internal Database. An existing entry is merged with
+     * CapioCLEntry::operator+=, so adding the same entry twice has no further effect
      * @param path The path of the CapioCLEnty
      * @param entry the new entry to add
+     * @throw std::invalid_argument if the dependencies would form a cycle
      */
     void add(const std::filesystem::path &path, const CapioCLEntry &entry) const;
 
@@ -209,24 +672,115 @@ class Engine final {
      *
      * @param path targeted file path
      * @param file_dependency the new file for this the path is subject to commit rule
+     * @throw std::invalid_argument if @p file_dependency depends on @p path, directly or not
      */
     void addFileDependency(const std::filesystem::path &path,
                            std::filesystem::path &file_dependency);
 
     /**
      * @brief Create a new CAPIO file entry. Commit and fire rules are automatically computed using
-     * the longest prefix match from the configuration.
+     * the longest prefix match from the configuration. The file is counted among the files of its
+     * parent directory, if the directory follows the Commit on N Files rule.
      *
      * @param path Path of the new file.
      */
     void newFile(const std::filesystem::path &path) const;
 
     /**
-     * @brief Remove a file from the configuration.
+     * @brief Remove a file from the configuration. The removal is recorded as a change, returned
+     * by changesSince() in place of the changes made to the file before.
      * @param path Path of the file to remove.
      */
     void remove(const std::filesystem::path &path) const;
 
+    /**
+     * @brief Resolve a path to a handle, creating its entry like newFile() if needed, regardless
+     * of `engine.materialize_reads`. Handles can be used in place of the path with the getters of
+     * this class, avoiding a lookup for each query.
+     * @param path Path to resolve.
+     * @return A handle to the entry of @p path, empty if @p path is empty.
+     */
+    EntryHandle resolve(const std::filesystem::path &path) const;
+
+    /**
+     * @brief Get the rule attributes of many paths at once. Paths are grouped by shard, so that
+     * each shard is locked once for reading, or its snapshot is loaded once in snapshot mode.
+     * Missing entries are created like newFile(), within a single exclusive section per shard,
+     * unless `engine.materialize_reads` is disabled.
+     * @param paths Paths to query.
+     * @return The attributes of each path, in the same order as @p paths. Empty paths get the
+     * attributes of a default entry.
+     */
+    std::vector<EntryAttributes> queryBatch(const std::vector<std::filesystem::path> &paths) const;
+
+    /**
+     * @brief Get the number of queries that were answered from a glob rule or from the default
+     * rules without creating an entry, because `engine.materialize_reads` is disabled.
+     * @return The number of entries that were not created.
+     */
+    std::uint64_t getAvoidedEntries() const;
+
+    /**
+     * @brief Get the statistics collected by this Engine: number of entries and glob rules, glob
+     * comparisons, materialized entries, lookup hits and misses, lock acquisitions and waits, and
+     * the latency distribution of the main methods. Counters are only collected when CAPIO-CL is
+     * built with `CAPIO_CL_ENABLE_STATS`; otherwise only the sizes and the number of messages,
+     * datagrams and batches sent by the monitor backends are reported.
+     * @return A snapshot of the statistics. Counters updated concurrently may be slightly ahead
+     * of each other.
+     */
+    EngineStats stats() const;
+
+    /**
+     * @brief Apply a change to the entry of a path, creating the entry if needed. Applying the
+     * same delta again leaves the entry unchanged, and only the entry of @p delta is accessed.
+     * Changes that modify the entry are given a new version, and are returned by changesSince().
+     * Changes made through apply() and add(path, entry) are versioned, the ones made through the
+     * other setters are not.
+     * @param delta Change to apply. Its version is ignored
+     * @return The version of the change, or the current version if the entry was unchanged
+     * @throw std::invalid_argument if the operation does not apply to the field, if a rule keyword
+     * is not valid, or if a dependency would close a cycle
+     */
+    std::uint64_t apply(const Delta &delta) const;
+
+    /**
+     * @brief Get the changes recorded after @p version, in version order. Applying them to a peer
+     * that applied every change up to @p version brings the peer to the same state. Only the last
+     * change of each field, or of each element of a list, is returned
+     * @param version Last version already applied, 0 to get every change
+     * @return The changes, each carrying its version
+     */
+    std::vector<Delta> changesSince(std::uint64_t version) const;
+
+    /// @brief Get the version of the last change recorded by apply()
+    std::uint64_t getVersion() const;
+
+    /**
+     * @brief Get the Merkle tree of the rules and entries of this Engine. Each shard caches the
+     * hashes of its buckets until one of its entries changes, so building the tree of an
+     * unchanged Engine does not depend on the number of entries. Two engines, in the same
+     * process or not, have the same content if their trees have the same MerkleTree::root(), and
+     * MerkleTree::diff() finds the buckets where they differ.
+     * @return The Merkle tree of this Engine
+     */
+    MerkleTree fingerprint() const;
+
+    /**
+     * @brief Get the paths of the entries and rules falling into a bucket of the Merkle tree, to
+     * find the entries that differ once MerkleTree::diff() found the buckets
+     * @param bucket Bucket, as returned by MerkleTree::diff()
+     * @return The paths within @p bucket
+     */
+    std::vector<std::string> getBucketPaths(std::size_t bucket) const;
+
+    /**
+     * @brief Check whether a handle still refers to a live entry.
+     * @param handle Handle returned by resolve().
+     * @return false if @p handle is empty or its entry may have been removed since it was resolved.
+     */
+    bool isValid(const EntryHandle &handle) const;
+
     /**
      * @brief Set the commit rule of a file.
      * @param path File path.
@@ -235,6 +789,13 @@ class Engine final {
      */
     void setCommitRule(const std::filesystem::path &path, const std::string &commit_rule);
 
+    /**
+     * @brief Set the commit rule of a file.
+     * @param path File path.
+     * @param commit_rule Commit rule.
+     */
+    void setCommitRule(const std::filesystem::path &path, commitRules::COMMIT_RULE commit_rule);
+
     /**
      * @brief Set the fire rule of a file.
      * @param path File path.
@@ -243,6 +804,13 @@ class Engine final {
      */
     void setFireRule(const std::filesystem::path &path, const std::string &fire_rule);
 
+    /**
+     * @brief Set the fire rule of a file.
+     * @param path File path.
+     * @param fire_rule Fire rule.
+     */
+    void setFireRule(const std::filesystem::path &path, fireRules::FIRE_RULE fire_rule);
+
     /**
      * @brief Mark a file as permanent or not.
      * @param path File path.
@@ -292,11 +860,21 @@ class Engine final {
 
     void setDirectoryFileCount(const std::filesystem::path &path, long num);
 
+    /**
+     * @brief Get the known children of a directory, that is the paths with an entry whose parent
+     * directory is @p path. Glob rules are not included.
+     * @param path The directory path.
+     * @return The paths of the children, in no particular order.
+     */
+    std::vector<std::string> getChildren(const std::filesystem::path &path) const;
+
     /**
      * @brief Set the dependencies of a file. This method as a side effect sets the commit rule to
      * Commit on Files.
      * @param path File path.
      * @param dependencies List of dependent files.
+     * @throw std::invalid_argument if the dependencies would form a cycle. The entry is left
+     * unchanged
      */
     void setFileDeps(const std::filesystem::path &path,
                      const std::vector<std::filesystem::path> &dependencies);
@@ -331,31 +909,74 @@ class Engine final {
      */
     long getDirectoryFileCount(const std::filesystem::path &path) const;
 
+    /// @brief Same as getDirectoryFileCount(), using a handle returned by resolve().
+    long getDirectoryFileCount(const EntryHandle &handle) const;
+
     /// @brief Get the commit rule of a file.
     std::string getCommitRule(const std::filesystem::path &path) const;
 
+    /// @brief Get the commit rule of a file, using a handle returned by resolve().
+    std::string getCommitRule(const EntryHandle &handle) const;
+
     /// @brief Get the fire rule of a file.
     std::string getFireRule(const std::filesystem::path &path) const;
 
+    /// @brief Get the fire rule of a file, using a handle returned by resolve().
+    std::string getFireRule(const EntryHandle &handle) const;
+
+    /// @brief Get the commit rule of a file, without converting it to its keyword.
+    commitRules::COMMIT_RULE getCommitRuleType(const std::filesystem::path &path) const;
+
+    /// @brief Same as getCommitRuleType(), using a handle returned by resolve().
+    commitRules::COMMIT_RULE getCommitRuleType(const EntryHandle &handle) const;
+
+    /// @brief Get the fire rule of a file, without converting it to its keyword.
+    fireRules::FIRE_RULE getFireRuleType(const std::filesystem::path &path) const;
+
+    /// @brief Same as getFireRuleType(), using a handle returned by resolve().
+    fireRules::FIRE_RULE getFireRuleType(const EntryHandle &handle) const;
+
     /// @brief Get the producers of a file.
     std::vector<std::string> getProducers(const std::filesystem::path &path) const;
 
+    /// @brief Get the producers of a file, using a handle returned by resolve().
+    std::vector<std::string> getProducers(const EntryHandle &handle) const;
+
     /// @brief Get the consumers of a file.
     std::vector<std::string> getConsumers(const std::filesystem::path &path) const;
 
+    /// @brief Get the consumers of a file, using a handle returned by resolve().
+    std::vector<std::string> getConsumers(const EntryHandle &handle) const;
+
     /// @brief Get the commit-on-close counter for a file.
     long getCommitCloseCount(const std::filesystem::path &path) const;
 
+    /// @brief Get the commit-on-close counter for a file, using a handle returned by resolve().
+    long getCommitCloseCount(const EntryHandle &handle) const;
+
     /// @brief Get file dependencies.
     std::vector<std::filesystem::path>
     getCommitOnFileDependencies(const std::filesystem::path &path) const;
 
+    /// @brief Get file dependencies, using a handle returned by resolve().
+    std::vector<std::filesystem::path> getCommitOnFileDependencies(const EntryHandle &handle) const;
+
+    /**
+     * @brief Get the files whose Commit on File dependencies include @p path
+     * @param path File path
+     * @return The paths of the dependent files, in no particular order
+     */
+    std::vector<std::string> getFileDependents(const std::filesystem::path &path) const;
+
     /// @brief Get the list of files stored in memory.
     std::vector<std::string> getFileToStoreInMemory() const;
 
     /// @brief Get the home node of a file.
     std::set<std::string> getHomeNode(const std::filesystem::path &path) const;
 
+    /// @brief Same as getHomeNode(), without blocking the caller while other nodes are queried.
+    std::future<std::set<std::string>> getHomeNodeAsync(const std::filesystem::path &path) const;
+
     /// @brief Set the home node for a given path
     void setHomeNode(const std::filesystem::path &path) const;
 
@@ -370,6 +991,9 @@ class Engine final {
      */
     bool isProducer(const std::filesystem::path &path, const std::string &app_name) const;
 
+    /// @brief Same as isProducer(), using a handle returned by resolve().
+    bool isProducer(const EntryHandle &handle, const std::string &app_name) const;
+
     /**
      * @brief Check if a process is a consumer for a file.
      * @param path File path.
@@ -378,6 +1002,9 @@ class Engine final {
      */
     bool isConsumer(const std::filesystem::path &path, const std::string &app_name) const;
 
+    /// @brief Same as isConsumer(), using a handle returned by resolve().
+    bool isConsumer(const EntryHandle &handle, const std::string &app_name) const;
+
     /**
      * @brief Check if a file is firable, that is fire rule is no_update.
      * @param path File path.
@@ -385,6 +1012,9 @@ class Engine final {
      */
     bool isFirable(const std::filesystem::path &path) const;
 
+    /// @brief Same as isFirable(), using a handle returned by resolve().
+    bool isFirable(const EntryHandle &handle) const;
+
     /**
      * @brief Check if a path refers to a file.
      * @param path File path.
@@ -392,6 +1022,9 @@ class Engine final {
      */
     bool isFile(const std::filesystem::path &path) const;
 
+    /// @brief Same as isFile(), using a handle returned by resolve().
+    bool isFile(const EntryHandle &handle) const;
+
     /**
      * @brief Check if a path is excluded.
      * @param path File path.
@@ -399,6 +1032,9 @@ class Engine final {
      */
     bool isExcluded(const std::filesystem::path &path) const;
 
+    /// @brief Same as isExcluded(), using a handle returned by resolve().
+    bool isExcluded(const EntryHandle &handle) const;
+
     /**
      * @brief Check if a path is a directory.
      * @param path Directory path.
@@ -406,6 +1042,9 @@ class Engine final {
      */
     bool isDirectory(const std::filesystem::path &path) const;
 
+    /// @brief Same as isDirectory(), using a handle returned by resolve().
+    bool isDirectory(const EntryHandle &handle) const;
+
     /**
      * @brief Check if a file is stored in memory.
      * @param path File path to query
@@ -413,6 +1052,9 @@ class Engine final {
      */
     bool isStoredInMemory(const std::filesystem::path &path) const;
 
+    /// @brief Same as isStoredInMemory(), using a handle returned by resolve().
+    bool isStoredInMemory(const EntryHandle &handle) const;
+
     /**
      * @brief Check if file should remain on file system after workflow terminates
      * @param path File path to query
@@ -420,6 +1062,9 @@ class Engine final {
      */
     bool isPermanent(const std::filesystem::path &path) const;
 
+    /// @brief Same as isPermanent(), using a handle returned by resolve().
+    bool isPermanent(const EntryHandle &handle) const;
+
     /**
      * Check whether the path is committed or not
      * @param path
@@ -428,11 +1073,80 @@ class Engine final {
     bool isCommitted(const std::filesystem::path &path) const;
 
     /**
-     * Set file indicated by path as committed
+     * Set file indicated by path as committed. The files with the Commit on File rule whose
+     * dependencies are now all committed are committed as well, and so on along the dependency
+     * graph. Only the commits notified through this method are taken into account. Committed files
+     * are counted among the files of their parent directory, as done by newFile(), so that a
+     * directory with the Commit on N Files rule is committed as well once it holds the expected
+     * number of files
      * @param path
      */
     void setCommitted(const std::filesystem::path &path) const;
 
+    /**
+     * @brief Wait until a file is committed. The caller sleeps on a wait slot of the file, and is
+     * woken as soon as the commit is set locally with setCommitted() or received by a monitor
+     * backend, without polling isCommitted()
+     * @param path Path of the file to wait for
+     * @param timeout Maximum time to wait
+     * @return true if the file is committed, false if @p timeout expired first
+     */
+    bool waitForCommit(const std::filesystem::path &path, std::chrono::milliseconds timeout) const;
+
+    /**
+     * @brief Wait until any of the given files is committed, as done by waitForCommit()
+     * @param paths Paths of the files to wait for
+     * @param timeout Maximum time to wait
+     * @return The path of a committed file, or an empty string if @p timeout expired first
+     */
+    std::string waitForAnyCommit(const std::vector<std::filesystem::path> &paths,
+                                 std::chrono::milliseconds timeout) const;
+
+    /**
+     * @brief Same as isCommitted(), without blocking the caller while other nodes are queried.
+     * Outstanding queries cost no thread: they are answered by the monitor backends as the
+     * replies arrive, or expire after the multicast delay
+     * @param path File path
+     * @return A future holding the commit status of @p path
+     */
+    std::future<bool> isCommittedAsync(const std::filesystem::path &path) const;
+
+    /**
+     * @brief Run @p callback once @p path is committed, either in the calling thread if it is
+     * already committed, or in the monitor thread observing the commit. The callback must not
+     * block
+     * @param path File path
+     * @param callback Callback receiving the committed path
+     */
+    void onCommitted(const std::filesystem::path &path,
+                     std::function<void(const std::string &)> callback) const;
+
+    /**
+     * @brief Notify that a close operation was performed on a file. When the file follows the
+     * Commit on Close rule and this is its N-th close, where N is its commit-on-close counter (at
+     * least one), the file is committed through setCommitted(). Closes are counted with an atomic
+     * counter, without locking the entry for writing, so exactly one of the concurrent calls
+     * reaching N commits the file.
+     * @param path Path of the closed file
+     * @return true if this close committed the file
+     */
+    bool notifyClose(const std::filesystem::path &path) const;
+
+    /**
+     * @brief Get the number of close operations notified on a file with notifyClose()
+     * @param path File path
+     * @return The number of closes counted for @p path
+     */
+    long getCloseCount(const std::filesystem::path &path) const;
+
+    /**
+     * @brief Get the number of files created with newFile() or committed with setCommitted()
+     * within a directory following the Commit on N Files rule
+     * @param path Directory path
+     * @return The number of distinct files counted for @p path
+     */
+    long getObservedFileCount(const std::filesystem::path &path) const;
+
     /**
      * Get all the paths that are presents within the Current instance of Engine
      * @return
@@ -446,6 +1160,25 @@ class Engine final {
      */
     bool operator==(const Engine &other) const;
 
+    /**
+     * @brief Save the rules and entries of this Engine to a binary snapshot file, that
+     * openSnapshot() loads without parsing. The file is replaced atomically.
+     * @param path Snapshot file
+     * @throws snapshot::SnapshotException if the file cannot be written
+     */
+    void saveSnapshot(const std::filesystem::path &path) const;
+
+    /**
+     * @brief Open a binary snapshot written by saveSnapshot(). The file is mapped read-only and
+     * shared with the other processes that open it: glob rules are loaded at once, while the
+     * entry of a path is decoded the first time the path is looked up, through the hash index of
+     * the snapshot. Entries already in this Engine are merged with the ones of the snapshot.
+     * Must not be called concurrently with other methods.
+     * @param path Snapshot file
+     * @throws snapshot::SnapshotException if the file is not a valid snapshot
+     */
+    void openSnapshot(const std::filesystem::path &path);
+
     /**
      * Load a CAPIO-CL TOML configuration file
      * @param path
@@ -0,0 +1,99 @@
+#ifndef CAPIO_CL_FRAME_H
+#define CAPIO_CL_FRAME_H
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// @brief Namespace containing the CAPIO-CL Monitor components
+namespace capiocl::monitor {
+
+/**
+ * @brief Datagram carrying several multicast monitor messages.
+ *
+ * A message is a command character followed by a payload: a path, or a path and a home node.
+ * The plain format, understood by every CAPIO-CL version, carries a single message as
+ * `<command> <payload>`. A frame starts with #MAGIC and #VERSION, followed by one record per
+ * message:
+ *
+ *     <command> <shared> <length> <suffix>
+ *
+ * where `shared` is the number of leading bytes the payload has in common with the payload of
+ * the previous record, `suffix` the remaining `length` bytes, and both numbers are LEB128
+ * varints. Without prefix compression `shared` is always zero. Records are added until the
+ * frame reaches its maximum size, usually the MTU, and a frame holding a single message is sent
+ * in the plain format.
+ */
+class MessageFrame final {
+  public:
+    /// @brief First byte of a frame. Plain messages start with their command instead
+    static constexpr char MAGIC = '#';
+
+    /// @brief Version of the frame format, second byte of a frame
+    static constexpr char VERSION = 1;
+
+    /// @brief A decoded message
+    struct Record {
+        /// @brief Command of the message
+        char command;
+        /// @brief Path, or path and home node, of the message
+        std::string payload;
+    };
+
+  private:
+    /// @brief Encoded frame, starting with #MAGIC and #VERSION
+    std::string buffer;
+
+    /// @brief Payload of the last record, against which the next one is compressed
+    std::string previous;
+
+    /// @brief The first message in the plain format, sent when it is the only one
+    std::string plain;
+
+    /// @brief Maximum size of the frame in bytes
+    std::size_t max_size;
+
+    /// @brief Whether payloads are compressed against the previous one
+    bool prefix_compression;
+
+    /// @brief Number of messages in the frame
+    std::size_t count = 0;
+
+  public:
+    /**
+     * @brief Build an empty frame
+     * @param max_size Maximum size of the datagram in bytes
+     * @param prefix_compression Whether payloads are compressed against the previous one
+     */
+    MessageFrame(std::size_t max_size, bool prefix_compression);
+
+    /**
+     * @brief Append a message, if it fits. A message is always accepted by an empty frame, even
+     * when larger than the maximum size
+     * @param command Command of the message
+     * @param payload Payload of the message
+     * @return false if the frame is full and the message must go in the next one
+     */
+    bool add(char command, const std::string &payload);
+
+    /// @brief Number of messages in the frame
+    [[nodiscard]] std::size_t size() const;
+
+    /**
+     * @brief Get the datagram to send and empty the frame
+     * @return The frame, or the plain message when the frame holds only one
+     */
+    std::string take();
+
+    /**
+     * @brief Decode a received datagram, either a frame or a plain message. Decoding stops at
+     * the first malformed record
+     * @param data Content of the datagram
+     * @param length Size of the datagram
+     * @return The messages of the datagram, in the order they were added
+     */
+    static std::vector<Record> decode(const char *data, std::size_t length);
+};
+} // namespace capiocl::monitor
+
+#endif // CAPIO_CL_FRAME_H
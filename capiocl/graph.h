@@ -0,0 +1,158 @@
+#ifndef CAPIO_CL_GRAPH_H
+#define CAPIO_CL_GRAPH_H
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+/// @brief Namespace containing the CAPIO-CL Engine
+namespace capiocl::engine {
+
+/**
+ * @brief Dependencies among the files committed with the Commit on File rule.
+ *
+ * Every target keeps the set of files it depends on, and every file keeps the reverse index of
+ * the targets depending on it, so the targets affected by a commit are found without scanning the
+ * Engine. Each target also counts its dependencies that are not committed yet: when the count
+ * drops to zero the target is ready to be committed in turn. Commits of paths that are not in the
+ * graph are not remembered, so the graph only grows with the dependencies in use: the caller looks
+ * up the files returned by takeUnknown() instead, and commits the ones committed before they were
+ * linked. The graph is always acyclic, as adding a dependency that would close a cycle is rejected.
+ *
+ * The graph is not thread safe: Engine guards it with its own lock.
+ */
+class DependencyGraph final {
+    /// @brief A file of the graph
+    struct Node {
+        /// @brief Path of the file, owned by the key of #nodes
+        const std::string *path = nullptr;
+        /// @brief Files this file depends on
+        std::unordered_set<Node *> dependencies;
+        /// @brief Files depending on this file
+        std::unordered_set<Node *> dependents;
+        /// @brief Number of #dependencies that are not committed
+        std::size_t pending = 0;
+        /// @brief Whether commit() was called on this file
+        bool committed = false;
+    };
+
+    /// @brief Nodes of the graph, keyed by path. Nodes are never moved once inserted
+    std::unordered_map<std::string, Node> nodes;
+
+    /// @brief Files that got their first dependent while not committed, since the last call to
+    /// takeUnknown()
+    std::vector<std::string> unknown;
+
+    /**
+     * @brief Whether @p node is a target whose dependencies are all committed, while the target
+     * itself is not
+     * @param node Node to check
+     */
+    static bool unblocked(const Node &node);
+
+    /**
+     * @brief Get the node of @p path, creating it if needed
+     * @param path Path of the node
+     * @return The node of @p path
+     */
+    Node &node(const std::filesystem::path &path);
+
+    /**
+     * @brief Check that @p target may depend on @p dependencies without closing a cycle
+     * @param target Path of the target
+     * @param dependencies Paths the target would depend on
+     * @throw std::invalid_argument if a dependency is @p target or depends on it
+     */
+    void check(const std::filesystem::path &target,
+               const std::vector<std::filesystem::path> &dependencies) const;
+
+    /**
+     * @brief Make @p target depend on @p dependency
+     * @param target Node of the target
+     * @param dependency Node of the dependency
+     * @return true if the dependency is new
+     */
+    bool link(Node &target, Node &dependency);
+
+    /**
+     * @brief Drop the dependencies of @p target
+     * @param target Node of the target
+     */
+    void unlink(Node &target);
+
+    /**
+     * @brief Drop @p node if it has neither dependencies nor dependents
+     * @param node Node to check
+     */
+    void prune(Node *node);
+
+  public:
+    /**
+     * @brief Add dependencies to @p target
+     * @param target Path of the target
+     * @param dependencies Paths of the files @p target depends on
+     * @return true if the dependencies of @p target are all committed, and @p target is not: the
+     * caller must commit it, as no call to commit() will report it
+     * @throw std::invalid_argument if a dependency would close a cycle. The graph is left unchanged
+     */
+    bool add(const std::filesystem::path &target,
+             const std::vector<std::filesystem::path> &dependencies);
+
+    /**
+     * @brief Add dependencies to several targets, as add() does for each of them
+     * @param links Paths of the targets, with the paths of the files each of them depends on
+     * @return The targets whose dependencies are all committed while they are not, see add()
+     * @throw std::invalid_argument if a dependency would close a cycle, with the other dependencies
+     * or with the ones of a previous target of @p links. The graph is left unchanged
+     */
+    std::vector<std::string>
+    addAll(const std::vector<std::pair<std::string, std::vector<std::filesystem::path>>> &links);
+
+    /**
+     * @brief Replace the dependencies of @p target
+     * @param target Path of the target
+     * @param dependencies Paths of the files @p target depends on
+     * @return true if the dependencies of @p target are all committed, as add()
+     * @throw std::invalid_argument if a dependency would close a cycle. The graph is left unchanged
+     */
+    bool set(const std::filesystem::path &target,
+             const std::vector<std::filesystem::path> &dependencies);
+
+    /**
+     * @brief Drop the dependencies of @p target
+     * @param target Path of the target
+     */
+    void erase(const std::filesystem::path &target);
+
+    /**
+     * @brief Record that @p path has been committed. Nothing is recorded if @p path is not in the
+     * graph
+     * @param path Path of the committed file
+     * @return The targets depending on @p path whose dependencies are now all committed
+     */
+    std::vector<std::string> commit(const std::filesystem::path &path);
+
+    /**
+     * @brief Get the files that became a dependency while not committed, since the last call. They
+     * may have been committed before, when they were not in the graph: the caller must commit()
+     * the ones that are
+     * @return The paths of the files, some of which may have left the graph since
+     */
+    std::vector<std::string> takeUnknown();
+
+    /**
+     * @brief Get the targets depending on @p path
+     * @param path File path
+     * @return The paths of the targets that depend on @p path, in no particular order
+     */
+    [[nodiscard]] std::vector<std::string> dependents(const std::filesystem::path &path) const;
+
+    /// @brief Number of files in the graph, either targets or dependencies
+    [[nodiscard]] std::size_t size() const;
+};
+
+} // namespace capiocl::engine
+
+#endif // CAPIO_CL_GRAPH_H
@@ -0,0 +1,42 @@
+#ifndef CAPIO_CL_HASH_H
+#define CAPIO_CL_HASH_H
+#include <cstdint>
+#include <string_view>
+
+/**
+ * @brief Namespace containing the hash functions shared by the CAPIO-CL components. Internal to
+ * the library: the values are stable across processes and builds, since they are exchanged over
+ * the network and stored in snapshot files
+ */
+namespace capiocl::hashing {
+
+/**
+ * @brief 64-bit FNV-1a hash
+ * @param value Bytes to hash
+ * @return The hash of @p value
+ */
+inline std::uint64_t fnv1a(const std::string_view value) {
+    std::uint64_t hash = 0xcbf29ce484222325ULL;
+    for (const auto c : value) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+/**
+ * @brief Finalizer of SplitMix64, spreading every bit of @p value over the result
+ * @param value Value to mix
+ * @return The mixed value
+ */
+inline std::uint64_t mix(std::uint64_t value) {
+    value ^= value >> 30;
+    value *= 0xbf58476d1ce4e5b9ULL;
+    value ^= value >> 27;
+    value *= 0x94d049bb133111ebULL;
+    value ^= value >> 31;
+    return value;
+}
+} // namespace capiocl::hashing
+
+#endif // CAPIO_CL_HASH_H
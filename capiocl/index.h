@@ -0,0 +1,168 @@
+#ifndef CAPIO_CL_INDEX_H
+#define CAPIO_CL_INDEX_H
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "capiocl/stats.h"
+
+/// @brief Namespace containing the CAPIO-CL Engine
+namespace capiocl::engine {
+
+/**
+ * @brief Compiled index of the glob patterns registered within an instance of Engine.
+ *
+ * Literal paths are resolved by Engine directly through its hash table. Paths containing glob
+ * wildcards are instead stored in a trie keyed by path component: each pattern is attached to the
+ * node reached by walking its leading literal components. Resolving a path then only visits the
+ * nodes along the components of the path itself.
+ *
+ * Within a node, the remainder of each pattern is compiled when the pattern is inserted:
+ * - `head*tail` remainders with a non empty literal head are bucketed by head;
+ * - `*tail` remainders (e.g. `*.dat`) are bucketed by their literal tail;
+ * - every other remainder falls back to fnmatch.
+ * Buckets are probed once per distinct head or tail length registered on the node, so a single
+ * pass over the path returns the identifiers of all the matching patterns without calling fnmatch
+ * for the common shapes. Inserting or removing a pattern only updates the buckets of one node.
+ */
+class PatternIndex final {
+  public:
+    /// @brief Identifier of a pattern. Stable for as long as the pattern is in the index
+    typedef std::uint32_t PatternId;
+
+  private:
+    struct Node;
+
+    /// @brief Pattern shapes recognized when compiling a pattern
+    typedef enum { HEAD, TAIL, GENERIC } PATTERN_KIND;
+
+    /// @brief A pattern compiled against the node it is stored in
+    struct CompiledPattern {
+        /// @brief Original glob pattern
+        std::string pattern;
+        /// @brief Node in which the pattern is stored
+        Node *node = nullptr;
+        /// @brief Bucket in which the pattern is stored
+        PATTERN_KIND kind = GENERIC;
+        /// @brief Literal text between the node prefix and the '*' wildcard
+        std::string head;
+        /// @brief Literal text after the '*' wildcard
+        std::string tail;
+    };
+
+    /// @brief Trie node. Children are keyed by literal path component
+    struct Node {
+        /// @brief Child nodes, keyed by literal path component
+        std::unordered_map<std::string, std::unique_ptr<Node>> children;
+        /// @brief HEAD patterns, keyed by their literal head
+        std::unordered_map<std::string, std::vector<PatternId>> heads;
+        /// @brief TAIL patterns, keyed by their literal tail
+        std::unordered_map<std::string, std::vector<PatternId>> tails;
+        /// @brief Distinct head lengths in #heads, with their number of occurrences
+        std::map<std::size_t, std::size_t> head_lengths;
+        /// @brief Distinct tail lengths in #tails, with their number of occurrences
+        std::map<std::size_t, std::size_t> tail_lengths;
+        /// @brief Patterns that must be matched with fnmatch
+        std::vector<PatternId> generic;
+    };
+
+    /// @brief Root of the trie, holding patterns with a wildcard in their first component
+    Node root;
+
+    /// @brief Compiled patterns, indexed by PatternId. Erased patterns leave a nullptr slot
+    std::vector<std::unique_ptr<CompiledPattern>> compiled;
+
+    /// @brief Slots of #compiled available for reuse
+    std::vector<PatternId> free_ids;
+
+    /// @brief Lookup table from pattern to its identifier
+    std::unordered_map<std::string, PatternId> ids;
+
+    /// @brief Statistics receiving the number of glob comparisons, if any
+    const StatsCollector *stats = nullptr;
+
+    /**
+     * @brief Get the node where @p pattern is stored
+     * @param pattern Glob pattern
+     * @param create Whether missing nodes should be created
+     * @param prefix_length Output: length of the literal prefix consumed by the trie
+     * @return The node, or nullptr if it does not exist and @p create is false
+     */
+    Node *node_for(std::string_view pattern, bool create, std::size_t &prefix_length);
+
+    /**
+     * @brief Invoke @p fn on the identifier of every pattern matching @p path
+     * @param path Path being resolved
+     * @param fn Callback receiving the identifiers. Returning false stops the visit
+     */
+    template <typename F> void visit(const std::string &path, F &&fn) const;
+
+  public:
+    /**
+     * @brief Check whether a path contains glob wildcards and should therefore be matched with
+     * fnmatch instead of being looked up literally.
+     * @param path Path to check
+     * @return true if @p path contains at least one of '*', '?' or '['
+     */
+    static bool isPattern(std::string_view path);
+
+    /**
+     * @brief Register a new glob pattern
+     * @param pattern Glob pattern
+     * @return true if the pattern was not already present
+     */
+    bool insert(const std::string &pattern);
+
+    /**
+     * @brief Remove a glob pattern
+     * @param pattern Glob pattern
+     * @return true if the pattern was present
+     */
+    bool erase(const std::string &pattern);
+
+    /// @brief Number of patterns stored in the index
+    [[nodiscard]] std::size_t size() const;
+
+    /**
+     * @brief Get the pattern associated to an identifier returned by match()
+     * @param id Pattern identifier
+     * @return The glob pattern
+     */
+    [[nodiscard]] const std::string &pattern(PatternId id) const;
+
+    /**
+     * @brief Find the longest pattern matching @p path
+     * @param path Path to resolve
+     * @return Pointer to the longest matching pattern, or nullptr if no pattern matches. The
+     * pointer remains valid until the pattern set is modified.
+     */
+    [[nodiscard]] const std::string *longestMatch(const std::string &path) const;
+
+    /**
+     * @brief Check whether at least one pattern matches @p path
+     * @param path Path to check
+     * @return true if @p path is matched by any pattern
+     */
+    [[nodiscard]] bool matchesAny(const std::string &path) const;
+
+    /**
+     * @brief Get the identifiers of all the patterns matching @p path
+     * @param path Path to resolve
+     * @return Identifiers of the matching patterns
+     */
+    [[nodiscard]] std::vector<PatternId> match(const std::string &path) const;
+
+    /**
+     * @brief Count the glob comparisons performed by the queries on this index, and on its copies
+     * @param collector Statistics to update, or nullptr to stop counting
+     */
+    void setStats(const StatsCollector *collector);
+};
+
+} // namespace capiocl::engine
+
+#endif // CAPIO_CL_INDEX_H
@@ -0,0 +1,107 @@
+#ifndef CAPIO_CL_MERKLE_H
+#define CAPIO_CL_MERKLE_H
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+/// @brief Namespace containing the CAPIO-CL Engine
+namespace capiocl::engine {
+
+/**
+ * @brief Merkle tree over the content of an Engine, returned by Engine::fingerprint().
+ *
+ * Entries are assigned to one of #LEAVES buckets by the hash of their parent directory, so that
+ * the files of a directory fall into the same bucket. The hash of a bucket is the sum of the
+ * hashes of its entries, which does not depend on the order entries were inserted in, and each
+ * inner node hashes the ordered hashes of its #FANOUT children. Empty subtrees hash to zero.
+ *
+ * Every hash is computed from paths and application names, never from pointers or identifiers
+ * local to a process, so trees built by different processes or nodes can be compared: equal
+ * roots mean equal content, and diff() finds the differing buckets visiting only the subtrees
+ * whose hashes differ.
+ */
+class MerkleTree final {
+    /// @brief Hashes of the nodes, one level after the other starting from the root
+    std::vector<std::uint64_t> nodes;
+
+  public:
+    /// @brief Number of children of each inner node
+    static constexpr std::size_t FANOUT = 16;
+
+    /// @brief Number of levels below the root
+    static constexpr std::size_t DEPTH = 3;
+
+    /// @brief Number of buckets, at the last level
+    static constexpr std::size_t LEAVES = 4096;
+
+    static_assert(LEAVES == FANOUT * FANOUT * FANOUT, "LEAVES must be FANOUT^DEPTH");
+
+    /// @brief Build the tree of an empty Engine
+    MerkleTree();
+
+    /**
+     * @brief Build a tree from the hashes of its buckets
+     * @param leaves Hash of each bucket, #LEAVES values
+     */
+    explicit MerkleTree(const std::vector<std::uint64_t> &leaves);
+
+    /**
+     * @brief 64-bit FNV-1a hash, stable across processes and builds
+     * @param value Bytes to hash
+     * @return The hash of @p value
+     */
+    static std::uint64_t hash(std::string_view value);
+
+    /**
+     * @brief Fold @p value into @p seed. The result depends on the order values are folded in
+     * @param seed Hash of the values folded so far
+     * @param value Value to fold
+     * @return The new hash
+     */
+    static std::uint64_t combine(std::uint64_t seed, std::uint64_t value);
+
+    /**
+     * @brief Get the bucket of a path, chosen by the hash of its parent directory
+     * @param path Path or glob pattern of the entry
+     * @return The bucket of @p path, in [0, #LEAVES)
+     */
+    static std::size_t bucket(std::string_view path);
+
+    /**
+     * @brief Get the contribution of an entry to the hash of its bucket
+     * @param path Path or glob pattern of the entry
+     * @param entry_hash Hash of the entry, as returned by CapioCLEntry::hash()
+     * @return The value to add to the hash of the bucket of @p path
+     */
+    static std::uint64_t leaf(std::string_view path, std::uint64_t entry_hash);
+
+    /// @brief Hash of the whole tree
+    [[nodiscard]] std::uint64_t root() const { return nodes.front(); }
+
+    /**
+     * @brief Get the hash of a node, to compare trees that are not in the same process
+     * @param level Level of the node, 0 for the root and #DEPTH for the buckets
+     * @param index Position of the node within its level, in [0, FANOUT^level)
+     * @return The hash of the node
+     */
+    [[nodiscard]] std::uint64_t node(std::size_t level, std::size_t index) const;
+
+    /**
+     * @brief Find the buckets whose hashes differ from the ones of @p other. Only the children of
+     * differing nodes are visited
+     * @param other Tree to compare with
+     * @return The differing buckets, in increasing order
+     */
+    [[nodiscard]] std::vector<std::size_t> diff(const MerkleTree &other) const;
+
+    /// @brief Check whether two trees have the same root
+    bool operator==(const MerkleTree &other) const { return root() == other.root(); }
+
+    /// @brief Check whether two trees have different roots
+    bool operator!=(const MerkleTree &other) const { return root() != other.root(); }
+};
+
+} // namespace capiocl::engine
+
+#endif // CAPIO_CL_MERKLE_H
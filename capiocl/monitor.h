@@ -2,7 +2,12 @@
 #define CAPIO_CL_MONITOR_H
 
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <filesystem>
+#include <functional>
+#include <future>
+#include <memory>
 #include <mutex>
 #include <set>
 #include <string>
@@ -10,7 +15,11 @@
 #include <unordered_map>
 #include <vector>
 
+#include "commits.h"
 #include "configuration.h"
+#include "reactor.h"
+#include "rtt.h"
+#include "sender.h"
 
 #ifndef PATH_MAX
 #define PATH_MAX 4096
@@ -46,6 +55,88 @@ class MonitorException final : public std::exception {
     [[nodiscard]] const char *what() const noexcept override { return message.c_str(); }
 };
 
+/**
+ * @brief Threads and callbacks waiting for an event on a path, such as a commit or the answer to a
+ * home node query, parked on per-path wait slots.
+ *
+ * Each waiter registers itself in the slot of every path it waits for, and sleeps on its own
+ * condition variable. Callbacks are registered the same way, without a thread. notify() wakes the
+ * waiters and runs the callbacks of a single path, so events on paths nobody is waiting for cost
+ * a single lookup.
+ */
+class WaitList {
+  public:
+    /// @brief Called with the notified path, or with an empty string when removed by expire()
+    using Callback = std::function<void(const std::string &)>;
+
+  private:
+    /// @brief A thread waiting in wait()
+    struct Waiter {
+        /// @brief Signaled when one of the paths of the waiter is notified
+        std::condition_variable cv;
+        /// @brief Whether notify() was called on one of the paths of the waiter
+        bool notified = false;
+        /// @brief Path notified to the waiter
+        std::string path;
+    };
+
+    /// @brief Mutex protecting #slots, #callbacks and #next_id
+    mutable std::mutex lock;
+
+    /// @brief Waiters registered for each path
+    mutable std::unordered_map<std::string, std::vector<Waiter *>> slots;
+
+    /// @brief Callbacks registered for each path, with their identifier
+    mutable std::unordered_map<std::string, std::vector<std::pair<std::uint64_t, Callback>>>
+        callbacks;
+
+    /// @brief Identifier of the next callback
+    mutable std::uint64_t next_id = 0;
+
+  public:
+    /**
+     * @brief Wait until one of @p paths is notified, or until @p deadline.
+     *
+     * The waiter is registered before the first call to @p check, so that events notified
+     * meanwhile are not lost. @p check is called again every @p recheck, for backends that do not
+     * notify the events they observe.
+     *
+     * @param paths Paths to wait for
+     * @param deadline Time after which the wait gives up
+     * @param recheck Interval between two calls to @p check
+     * @param check Returns one of @p paths if its event already happened, or an empty string
+     * @return The notified path, or an empty string if @p deadline expired first
+     */
+    std::string wait(const std::vector<std::string> &paths,
+                     std::chrono::steady_clock::time_point deadline,
+                     std::chrono::milliseconds recheck,
+                     const std::function<std::string()> &check) const;
+
+    /**
+     * @brief Register @p callback to run once, on the next notify() of @p path
+     * @param path Path to wait for
+     * @param callback Callback to run
+     * @return Identifier of the callback, to be passed to expire()
+     */
+    std::uint64_t subscribe(const std::string &path, Callback callback) const;
+
+    /**
+     * @brief Remove a callback that did not run yet, and run it with an empty string
+     * @param path Path the callback was registered for
+     * @param id Identifier returned by subscribe()
+     */
+    void expire(const std::string &path, std::uint64_t id) const;
+
+    /// @brief Paths with at least a registered callback
+    [[nodiscard]] std::vector<std::string> subscribed() const;
+
+    /**
+     * @brief Wake the threads waiting for @p path, then run its callbacks in the calling thread
+     * @param path Notified path
+     */
+    void notify(const std::string &path) const;
+};
+
 /**
  * @brief Abstract interface for monitoring the commit state of files in CAPIO-CL.
  *
@@ -54,15 +145,24 @@ class MonitorException final : public std::exception {
  * monitor commit state using different backends (e.g., filesystem signals or
  * multicast synchronization).
  *
- * The class is thread-safe through `committed_lock`, protecting `_committed_files`
- * which stores the list of committed file paths.
+ * The class is thread-safe: committed file paths are stored in `_committed_files`, a concurrent
+ * CommitSet, and home nodes are protected by `home_node_lock`.
  */
 class MonitorInterface {
+    friend class Monitor;
+
   protected:
     /**
-     * @brief Mutex protecting access to the committed file list.
+     * @brief Waiters to notify of the commits observed by this backend without a call to
+     * setCommitted(). Set when the backend is registered in a Monitor
+     */
+    mutable std::atomic<const WaitList *> commit_waiters = nullptr;
+
+    /**
+     * @brief Waiters to notify of the home nodes learned by this backend without a call to
+     * setHomeNode(). Set when the backend is registered in a Monitor
      */
-    mutable std::mutex committed_lock;
+    mutable std::atomic<const WaitList *> home_node_waiters = nullptr;
 
     /**
      * @brief Mutex protecting access to the home nodes list.
@@ -70,9 +170,9 @@ class MonitorInterface {
     mutable std::mutex home_node_lock;
 
     /**
-     * @brief List of committed file paths stored as strings.
+     * @brief Set of committed file paths.
      */
-    mutable std::vector<std::string> _committed_files;
+    mutable CommitSet _committed_files;
 
     /**
      * @brief Lookup table to get home node staring from path.
@@ -100,6 +200,16 @@ class MonitorInterface {
      */
     virtual bool isCommitted(const std::filesystem::path &path) const;
 
+    /**
+     * @brief Check whether the given file is known to be committed, without waiting for other
+     * processes to answer. Backends learning commits from the network may send a request, and
+     * notify the answer later through #commit_waiters. Defaults to isCommitted().
+     *
+     * @param path Path to the file being queried.
+     * @return true if the file is recorded as committed, false otherwise.
+     */
+    virtual bool queryCommitted(const std::filesystem::path &path) const;
+
     /**
      * @brief Mark the given file as committed.
      *
@@ -119,6 +229,39 @@ class MonitorInterface {
      * @return the home node responsible for the given path
      */
     virtual const std::string &getHomeNode(const std::filesystem::path &path) const;
+
+    /**
+     * Get the home node for a given path without waiting for other processes to answer, as done
+     * by queryCommitted(). Defaults to getHomeNode().
+     * @param path
+     * @return the home node responsible for the given path, or NO_HOME_NODE if not known yet
+     */
+    virtual const std::string &queryHomeNode(const std::filesystem::path &path) const;
+
+    /**
+     * @brief Time after which the requests sent by queryCommitted() and queryHomeNode() are
+     * considered unanswered. Defaults to zero, for backends that do not send requests
+     */
+    [[nodiscard]] virtual std::chrono::milliseconds queryTimeout() const;
+
+    /**
+     * @brief Whether every commit observed by the backend after a query is notified through
+     * #commit_waiters, so that waiting for a commit does not need to query the backend again.
+     * Defaults to false, for backends whose commits are only seen by querying them, such as the
+     * commit tokens written by other processes
+     */
+    [[nodiscard]] virtual bool notifiesCommits() const;
+
+    /// @brief Number of messages sent to other processes. Defaults to zero, for backends that do
+    /// not use the network
+    [[nodiscard]] virtual std::uint64_t messagesSent() const;
+
+    /// @brief Number of datagrams the sent messages were packed in. Defaults to zero
+    [[nodiscard]] virtual std::uint64_t datagramsSent() const;
+
+    /// @brief Number of batches the sent messages were grouped in, each sent with a single system
+    /// call. Defaults to zero
+    [[nodiscard]] virtual std::uint64_t batchesFlushed() const;
 };
 
 /**
@@ -128,17 +271,31 @@ class MonitorInterface {
  * multicast network messages. When one process commits a file, it broadcasts a message
  * so that other collaborators update their commit state.
  *
- * A background thread (`commit_listener_thread`) listens for notifications from
- * the network to update the internal commit list.
+ * The commit and home node sockets are watched by the Reactor shared by every CAPIO-CL component
+ * of the process, which runs receive_commits() and receive_home_nodes() when messages arrive, so
+ * an idle monitor uses no thread and no CPU.
+ *
+ * Messages are not sent by the calling thread: they are queued in a MulticastSender, which packs
+ * them into MessageFrame datagrams and sends them in batches through a socket kept open for the
+ * lifetime of the monitor. Listeners accept both frames and plain single-message datagrams.
+ *
+ * isCommitted() and getHomeNode() return as soon as the answer to their query is received. The
+ * time they wait for an answer that never comes adapts to the round trip times of the answered
+ * queries, up to `monitor.mcast.delay_ms`.
  */
 class MulticastMonitor final : public MonitorInterface {
 
-    static constexpr int MESSAGE_SIZE = (2 + PATH_MAX + PATH_MAX); ///< Max network message size.
+    static constexpr int MESSAGE_SIZE = 65507; ///< Max network message size: a UDP datagram.
 
-    /**
-     * @brief Background threads used to listen for commit messages and for home nodes.
-     */
-    std::thread commit_thread, home_node_thread;
+    /// @brief Event loop watching the sockets of this monitor
+    std::shared_ptr<Reactor> reactor;
+
+    /// @brief Sockets receiving the commit and the home node messages
+    int commit_socket = -1, home_node_socket = -1;
+
+    /// @brief Buffer for the received datagrams. Shared by both sockets, whose handlers all run
+    /// on the reactor thread
+    mutable std::vector<char> incoming;
 
     /**
      * @brief Multicast group IP address.
@@ -147,12 +304,6 @@ class MulticastMonitor final : public MonitorInterface {
 
     std::string MULTICAST_HOME_NODE_ADDR;
 
-    /// @brief variable to terminate execution
-    std::atomic<bool> terminate = false;
-
-    /// @brief Multicast poll timeout interval
-    static constexpr int MULTICAST_THREAD_POLL_INTERVAL = 250;
-
     /**
      * @brief Multicast port number.
      */
@@ -160,9 +311,43 @@ class MulticastMonitor final : public MonitorInterface {
 
     int MULTICAST_HOME_NODE_PORT{};
 
-    ///@brief Delay in milliseconds before checking again for a status change
+    ///@brief Longest time in milliseconds a query waits for its answer
     int MULTICAST_DELAY_MILLIS{};
 
+    /// @brief Queries sent and not answered yet
+    struct PendingQueries {
+        /// @brief An unanswered query
+        struct Query {
+            /// @brief Time at which the oldest unanswered query on the path was sent
+            std::chrono::steady_clock::time_point sent;
+            /// @brief Time after which no caller waits for the answer anymore
+            std::chrono::steady_clock::time_point deadline;
+        };
+        /// @brief Mutex protecting #slots
+        std::mutex lock;
+        /// @brief Unanswered queries, by path
+        std::unordered_map<std::string, Query> slots;
+    };
+
+    /// @brief Commit queries sent and not answered yet
+    mutable PendingQueries commit_queries;
+
+    /// @brief Home node queries sent and not answered yet
+    mutable PendingQueries home_node_queries;
+
+    /// @brief Threads waiting in isCommitted() for the answer to their query
+    WaitList commit_replies;
+
+    /// @brief Threads waiting in getHomeNode() for the answer to their query
+    WaitList home_node_replies;
+
+    /// @brief Timeout of the queries, derived from the round trip times of the answered ones
+    std::unique_ptr<RttEstimator> rtt;
+
+    /// @brief Queue and socket used to send every message of this monitor. Created before the
+    /// sockets are watched, since queries are answered through it
+    std::unique_ptr<MulticastSender> sender;
+
     /**
      * @brief Supported network command types for commit messages.
      */
@@ -171,47 +356,59 @@ class MulticastMonitor final : public MonitorInterface {
     /**
      * @brief Send a commit or request message over multicast.
      *
+     * @param sender Queue through which the message is sent.
      * @param ip_addr Destination multicast address.
      * @param ip_port Destination multicast port.
      * @param path File path associated with the message.
      * @param action The type of message to send (COMMIT or REQUEST).
      */
-    static void _send_message(const std::string &ip_addr, int ip_port, const std::string &path,
-                              MESSAGE_COMMANDS action);
+    static void _send_message(MulticastSender &sender, const std::string &ip_addr, int ip_port,
+                              const std::string &path, MESSAGE_COMMANDS action);
 
     /**
-     * @brief Background thread function to listen for commit messages.
+     * @brief Record that a query on @p path is sent and awaited for @p timeout. A query still
+     * pending on the same path keeps its send time, and its deadline is extended.
      *
-     * This function runs continuously while @p continue_execution remains true.
-     * When commit events are received, the corresponding file paths are recorded
-     * into @p committed_files.
+     * @param queries Pending queries of the kind of the query
+     * @param path Queried path
+     * @param timeout Time the caller waits for the answer
+     */
+    void track_query(PendingQueries &queries, const std::string &path,
+                     std::chrono::microseconds timeout) const;
+
+    /**
+     * @brief Drop the pending query on @p path, if any, and record its round trip time if no
+     * caller gave up waiting for it yet. Adverts received after the deadline, such as commits of
+     * files queried before being produced, are not round trip times.
      *
-     * @param committed_files Vector storing committed file paths.
-     * @param lock Mutex protecting shared access to committed_files.
-     * @param ip_addr Multicast commit listen address.
-     * @param ip_port Multicast commit listen port.
-     * @param terminate Atomic Boolean flag to terminate thread
+     * @param queries Pending queries of the kind of the answer
+     * @param path Path of the received answer
      */
-    static void commit_listener(std::vector<std::string> &committed_files, std::mutex &lock,
-                                const std::string &ip_addr, int ip_port,
-                                const std::atomic<bool> *terminate);
+    void answer_query(PendingQueries &queries, const std::string &path) const;
 
     /**
-     * @brief Background thread function to listen for commit messages.
+     * @brief Drop the pending query on @p path once its deadline passed, when its caller gave up
      *
-     * This function runs continuously while @p continue_execution remains true.
-     * When commit events are received, the corresponding file paths are recorded
-     * into @p committed_files.
+     * @param queries Pending queries of the kind of the query
+     * @param path Queried path
+     */
+    static void expire_query(PendingQueries &queries, const std::string &path);
+
+    /**
+     * @brief Reactor handler of the commit socket. Drains the received datagrams, records the
+     * announced commits and answers the queries on files committed by this process.
+     *
+     * @param socket Readable commit socket
+     */
+    void receive_commits(int socket) const;
+
+    /**
+     * @brief Reactor handler of the home node socket. Drains the received datagrams, records the
+     * announced home nodes and answers the queries on paths whose home node is this host.
      *
-     * @param home_nodes Vector storing committed file paths.
-     * @param lock Mutex protecting shared access to committed_files.
-     * @param ip_addr Multicast home node listen address.
-     * @param ip_port Multicast home node listen port.
-     * @param terminate Atomic Boolean flag to terminate thread
+     * @param socket Readable home node socket
      */
-    static void home_node_listener(std::unordered_map<std::string, std::string> &home_nodes,
-                                   std::mutex &lock, const std::string &ip_addr, int ip_port,
-                                   const std::atomic<bool> *terminate);
+    void receive_home_nodes(int socket) const;
 
   public:
     /**
@@ -222,14 +419,21 @@ class MulticastMonitor final : public MonitorInterface {
     MulticastMonitor(const capiocl::configuration::CapioClConfiguration &config);
 
     /**
-     * @brief Destructor; stops listener thread and cleans resources.
+     * @brief Destructor; stops watching the sockets and closes them.
      */
     ~MulticastMonitor() override;
 
     bool isCommitted(const std::filesystem::path &path) const override;
+    bool queryCommitted(const std::filesystem::path &path) const override;
     void setCommitted(const std::filesystem::path &path) const override;
     void setHomeNode(const std::filesystem::path &path) const override;
     const std::string &getHomeNode(const std::filesystem::path &path) const override;
+    const std::string &queryHomeNode(const std::filesystem::path &path) const override;
+    [[nodiscard]] std::chrono::milliseconds queryTimeout() const override;
+    [[nodiscard]] bool notifiesCommits() const override;
+    [[nodiscard]] std::uint64_t messagesSent() const override;
+    [[nodiscard]] std::uint64_t datagramsSent() const override;
+    [[nodiscard]] std::uint64_t batchesFlushed() const override;
 };
 
 /**
@@ -301,7 +505,77 @@ class Monitor {
 
     std::vector<const MonitorInterface *> interfaces;
 
+    /// @brief Threads and callbacks waiting for commits
+    WaitList commit_waiters;
+
+    /// @brief Callbacks waiting for home nodes
+    WaitList home_node_waiters;
+
+    /// @brief Interval in milliseconds between two checks of the backends that do not notify their
+    /// commits, such as the commit tokens of other processes, by a waiting thread
+    static constexpr int WAIT_RECHECK_INTERVAL = 250;
+
+    /// @brief Number of registered backends that do not notify their commits
+    std::size_t polled_backends = 0;
+
+    /// @brief A callback to expire if it did not run before its deadline
+    struct Expiration {
+        /// @brief Time at which the callback expires
+        std::chrono::steady_clock::time_point deadline;
+        /// @brief Wait list of the callback
+        const WaitList *list;
+        /// @brief Path the callback was registered for
+        std::string path;
+        /// @brief Identifier of the callback
+        std::uint64_t id;
+        /// @brief Whether the backends are queried again for the commit of #path, instead of
+        /// expiring the callback
+        bool requery = false;
+
+        /// @brief Order expirations in a min-heap by deadline
+        bool operator<(const Expiration &other) const { return deadline > other.deadline; }
+    };
+
+    /// @brief Mutex protecting the watcher thread state
+    mutable std::mutex watcher_lock;
+
+    /// @brief Signaled when a new expiration is scheduled, or when the watcher must stop
+    mutable std::condition_variable watcher_cv;
+
+    /// @brief Thread running the asynchronous queries, started by the first of them
+    mutable std::thread watcher;
+
+    /// @brief Pending expirations, as a min-heap by deadline
+    mutable std::vector<Expiration> expirations;
+
+    /// @brief Whether the watcher thread must stop
+    mutable bool stop_watcher = false;
+
+    /**
+     * @brief Body of the watcher thread. Expires the callbacks whose deadline passed, and checks
+     * the backends that do not notify their commits every #WAIT_RECHECK_INTERVAL for the commits
+     * awaited by callbacks. Sleeps without timeout when no backend needs it
+     */
+    void watch() const;
+
+    /**
+     * @brief Start the watcher thread, if not running yet, and schedule an expiration
+     * @param expiration Expiration to schedule, or nullptr to only start the thread
+     */
+    void schedule(const Expiration *expiration) const;
+
+    /// @brief Largest queryTimeout() among the backends
+    [[nodiscard]] std::chrono::milliseconds queryTimeout() const;
+
   public:
+    /**
+     * @brief Query the backends for the commit of @p path, without waiting for other processes
+     * @param path Path of the file
+     * @param all Whether every backend is queried, or only the ones that do not notify commits
+     * @return true if a queried backend reports the commit
+     */
+    [[nodiscard]] bool query(const std::string &path, bool all) const;
+
     /**
      * Check whether a file is committed or not. First look into _committed_files. If not found
      * then look into the file system for a committed token. If the committed token is not found
@@ -320,6 +594,47 @@ class Monitor {
      */
     void setCommitted(std::filesystem::path path) const;
 
+    /**
+     * Wait until a file is committed. The calling thread sleeps until the commit is set locally
+     * or received by a backend, instead of polling isCommitted()
+     *
+     * @param path Path of the file to wait for
+     * @param timeout Maximum time to wait
+     * @return true if the file is committed, false if @p timeout expired first
+     */
+    [[nodiscard]] bool waitForCommit(const std::filesystem::path &path,
+                                     std::chrono::milliseconds timeout) const;
+
+    /**
+     * Wait until any of the given files is committed
+     *
+     * @param paths Paths of the files to wait for
+     * @param timeout Maximum time to wait
+     * @return The path of a committed file, or an empty string if @p timeout expired first
+     */
+    [[nodiscard]] std::string waitForAnyCommit(const std::vector<std::filesystem::path> &paths,
+                                               std::chrono::milliseconds timeout) const;
+
+    /**
+     * Check whether a file is committed without blocking the caller. The future is ready as soon
+     * as a backend reports the commit, or with false once the requests to the other processes are
+     * unanswered for the query timeout of the backends
+     *
+     * @param path path to check for the commit status
+     * @return a future holding the commit status of @p path
+     */
+    [[nodiscard]] std::future<bool> isCommittedAsync(const std::filesystem::path &path) const;
+
+    /**
+     * Run a callback once a file is committed. The callback runs immediately in the calling thread
+     * if the file is already committed, otherwise in the thread observing the commit: it must not
+     * block
+     *
+     * @param path Path of the file to wait for
+     * @param callback Callback to run, with the path of the committed file
+     */
+    void onCommitted(const std::filesystem::path &path, WaitList::Callback callback) const;
+
     /**
      * Add a new backend for monitor. Must be a derived class from MonitorInterface
      * @param interface
@@ -340,6 +655,23 @@ class Monitor {
      */
     [[nodiscard]] std::set<std::string> getHomeNode(const std::filesystem::path &path) const;
 
+    /**
+     * Get the set of home nodes without blocking the caller, as done by isCommittedAsync()
+     * @param path
+     * @return a future holding the home nodes known for @p path
+     */
+    [[nodiscard]] std::future<std::set<std::string>>
+    getHomeNodeAsync(const std::filesystem::path &path) const;
+
+    /// @brief Number of messages sent to other processes by all registered backends
+    [[nodiscard]] std::uint64_t messagesSent() const;
+
+    /// @brief Number of datagrams the messages of all registered backends were packed in
+    [[nodiscard]] std::uint64_t datagramsSent() const;
+
+    /// @brief Number of batches the messages of all registered backends were sent in
+    [[nodiscard]] std::uint64_t batchesFlushed() const;
+
     ~Monitor();
 };
 } // namespace capiocl::monitor
@@ -0,0 +1,103 @@
+#ifndef CAPIO_CL_REACTOR_H
+#define CAPIO_CL_REACTOR_H
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+/// @brief Namespace containing the CAPIO-CL Monitor components
+namespace capiocl::monitor {
+
+/**
+ * @brief Event loop running the handlers of every CAPIO-CL network socket of the process.
+ *
+ * A single thread sleeps in epoll_wait() on all the registered sockets, with no timeout, and runs
+ * the handler of each socket that becomes readable. An eventfd is registered next to the sockets
+ * to wake the thread when the reactor is destroyed, so shutdown does not wait for a timeout and
+ * idle processes use no CPU. Platforms without epoll use poll() and a pipe instead.
+ *
+ * The reactor is shared: instance() returns the running one, or starts a new one, and the loop
+ * stops when the last owner releases it. Handlers all run on the reactor thread, one at a time,
+ * so they must not block.
+ */
+class Reactor final {
+  public:
+    /// @brief Called with the socket when it is readable. Must read until the socket is drained
+    using Handler = std::function<void(int)>;
+
+  private:
+    /// @brief epoll instance, or -1 when poll() is used
+    int epoll_fd = -1;
+
+    /// @brief Descriptor written to wake the loop: an eventfd, or the write end of a pipe
+    int wake_fd = -1;
+
+    /// @brief Read end of the wake pipe, or the eventfd itself
+    int wake_read_fd = -1;
+
+    /// @brief Mutex protecting #handlers, #running and #stop
+    std::mutex lock;
+
+    /// @brief Signaled when a handler returns
+    std::condition_variable handler_done;
+
+    /// @brief Handlers of the registered sockets
+    std::unordered_map<int, std::shared_ptr<Handler>> handlers;
+
+    /// @brief Socket whose handler is running, or -1
+    int running = -1;
+
+    /// @brief Whether the loop must stop
+    bool stop = false;
+
+    /// @brief Thread running the loop
+    std::thread loop;
+
+    /// @brief Body of the loop thread
+    void run();
+
+    /**
+     * @brief Run the handler of a readable socket, unless it was removed meanwhile
+     * @param fd Readable socket
+     */
+    void dispatch(int fd);
+
+    /// @brief Wake the loop thread
+    void wake() const;
+
+  public:
+    /// @brief Start the loop thread. Use instance() to share the reactor of the process
+    Reactor();
+
+    /// @brief Stop the loop thread immediately, waiting only for the running handler
+    ~Reactor();
+
+    Reactor(const Reactor &)            = delete;
+    Reactor &operator=(const Reactor &) = delete;
+
+    /**
+     * @brief Get the reactor of the process, starting it if no one owns it
+     * @return A shared reference to the reactor
+     */
+    static std::shared_ptr<Reactor> instance();
+
+    /**
+     * @brief Run @p handler each time @p fd is readable
+     * @param fd Socket to watch
+     * @param handler Handler to run on the reactor thread
+     */
+    void add(int fd, Handler handler);
+
+    /**
+     * @brief Stop watching a socket. When called outside the reactor thread, waits for the
+     * handler of @p fd to return if it is running, so that the socket can be closed and the state
+     * of the handler released as soon as this method returns
+     * @param fd Socket to stop watching
+     */
+    void remove(int fd);
+};
+} // namespace capiocl::monitor
+
+#endif // CAPIO_CL_REACTOR_H
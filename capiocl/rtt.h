@@ -0,0 +1,79 @@
+#ifndef CAPIO_CL_RTT_H
+#define CAPIO_CL_RTT_H
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+/// @brief Namespace containing the CAPIO-CL Monitor components
+namespace capiocl::monitor {
+
+/**
+ * @brief Timeout of network queries derived from the round trip times of the answered ones.
+ *
+ * The last #WINDOW round trip times are kept in a ring. Once #MIN_SAMPLES of them are known, the
+ * timeout is #factor times their #percentile-th percentile, clamped between #floor and #ceiling.
+ * Before that, and whenever the network is slower than the ceiling, queries wait for #ceiling.
+ * The timeout is recomputed by record() and read without locking by timeout().
+ */
+class RttEstimator final {
+  public:
+    /// @brief Number of most recent round trip times the timeout is computed from
+    static constexpr std::size_t WINDOW = 256;
+
+    /// @brief Number of round trip times needed before the timeout is shortened
+    static constexpr std::size_t MIN_SAMPLES = 16;
+
+  private:
+    /// @brief Percentile of the round trip times the timeout is computed from, in [1, 100]
+    unsigned percentile;
+
+    /// @brief Multiplier applied to the percentile, to absorb the jitter of the network
+    unsigned factor;
+
+    /// @brief Shortest timeout
+    std::chrono::microseconds floor;
+
+    /// @brief Longest timeout, used until enough round trip times are known
+    std::chrono::microseconds ceiling;
+
+    /// @brief Mutex protecting #samples and #recorded
+    std::mutex lock;
+
+    /// @brief Ring of the last round trip times, in microseconds
+    std::array<std::int64_t, WINDOW> samples{};
+
+    /// @brief Number of round trip times recorded since construction
+    std::size_t recorded = 0;
+
+    /// @brief Current timeout in microseconds
+    std::atomic<std::int64_t> current;
+
+  public:
+    /**
+     * @brief Build an estimator with no round trip time
+     * @param percentile Percentile of the round trip times, between 1 and 100
+     * @param factor Multiplier applied to the percentile, at least one
+     * @param floor Shortest timeout
+     * @param ceiling Longest timeout, and timeout until #MIN_SAMPLES round trip times are known
+     */
+    RttEstimator(unsigned percentile, unsigned factor, std::chrono::microseconds floor,
+                 std::chrono::microseconds ceiling);
+
+    /**
+     * @brief Record the round trip time of an answered query and update the timeout
+     * @param rtt Time elapsed between the query and its answer
+     */
+    void record(std::chrono::microseconds rtt);
+
+    /// @brief Time after which a query is considered unanswered
+    [[nodiscard]] std::chrono::microseconds timeout() const;
+
+    /// @brief Number of round trip times recorded since construction
+    [[nodiscard]] std::size_t size();
+};
+} // namespace capiocl::monitor
+
+#endif // CAPIO_CL_RTT_H
@@ -0,0 +1,154 @@
+#ifndef CAPIO_CL_SENDER_H
+#define CAPIO_CL_SENDER_H
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <netinet/in.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+/// @brief Namespace containing the CAPIO-CL Monitor components
+namespace capiocl::monitor {
+
+/**
+ * @brief Queue of multicast monitor messages sent through a single long-lived socket.
+ *
+ * send() only appends the message to a queue and returns. A flusher thread waits until either the
+ * pending messages fill #batch_size datagrams or the oldest one has waited #max_delay. It then
+ * packs the pending messages for each destination into MessageFrame datagrams of at most
+ * #max_datagram bytes, and sends them with as few sendmmsg() calls as possible. Messages queued
+ * while a batch is being sent are coalesced into the next one, so under load the number of
+ * datagrams grows with the bytes sent, and the number of system calls with the number of batches,
+ * rather than with the number of messages. Pending messages are sent before the destructor
+ * returns.
+ */
+class MulticastSender final {
+    /// @brief A queued message
+    struct Message {
+        /// @brief Destination address
+        sockaddr_in destination;
+        /// @brief Command of the message
+        char command;
+        /// @brief Payload of the message
+        std::string payload;
+    };
+
+    /// @brief A datagram ready to be sent
+    struct Datagram {
+        /// @brief Destination address
+        sockaddr_in destination;
+        /// @brief Content of the datagram
+        std::string content;
+        /// @brief Number of messages packed in the datagram
+        std::size_t messages;
+    };
+
+    /// @brief Socket used to send every datagram
+    int socket_fd = -1;
+
+    /// @brief Maximum number of datagrams sent by a single sendmmsg() call
+    std::size_t batch_size;
+
+    /// @brief Maximum time a message waits in the queue for others to join its batch
+    std::chrono::microseconds max_delay;
+
+    /// @brief Maximum size of a datagram carrying several messages
+    std::size_t max_datagram;
+
+    /// @brief Whether the payloads packed in a datagram are compressed against the previous one
+    bool prefix_compression;
+
+    /// @brief Mutex protecting #pending, #pending_bytes, #oldest and #stop
+    std::mutex lock;
+
+    /// @brief Signaled when the flusher has messages to send, or must stop
+    std::condition_variable cv;
+
+    /// @brief Messages waiting to be sent
+    std::vector<Message> pending;
+
+    /// @brief Size of the pending messages, to know when they fill a batch
+    std::size_t pending_bytes = 0;
+
+    /// @brief Time at which the oldest message of #pending was queued
+    std::chrono::steady_clock::time_point oldest;
+
+    /// @brief Whether the flusher must send the pending messages and stop
+    bool stop = false;
+
+    /// @brief Number of messages handed to the kernel
+    std::atomic<std::uint64_t> messages_sent = 0;
+
+    /// @brief Number of datagrams handed to the kernel
+    std::atomic<std::uint64_t> datagrams_sent = 0;
+
+    /// @brief Number of sendmmsg() calls
+    std::atomic<std::uint64_t> batches_flushed = 0;
+
+    /// @brief Thread sending the queued messages
+    std::thread flusher;
+
+    /// @brief Body of the flusher thread
+    void run();
+
+    /**
+     * @brief Pack messages into datagrams, keeping the order of the messages of each destination
+     * @param messages Messages to pack
+     * @return The datagrams to send
+     */
+    [[nodiscard]] std::vector<Datagram> pack(std::vector<Message> &messages) const;
+
+    /**
+     * @brief Send datagrams in batches of at most #batch_size
+     * @param datagrams Datagrams to send
+     */
+    void sendBatches(const std::vector<Datagram> &datagrams);
+
+  public:
+    /// @brief Default maximum size of a datagram: an Ethernet MTU minus the IP and UDP headers
+    static constexpr std::size_t DEFAULT_MAX_DATAGRAM = 1472;
+
+    /**
+     * @brief Open the socket and start the flusher thread
+     * @param batch_size Maximum number of datagrams sent by a single system call, at least one
+     * @param max_delay Maximum time a message waits for others. Zero sends each batch as soon as
+     * the flusher wakes up
+     * @param max_datagram Maximum size of a datagram carrying several messages
+     * @param prefix_compression Whether the payloads packed in a datagram are compressed against
+     * the previous one
+     */
+    MulticastSender(std::size_t batch_size, std::chrono::microseconds max_delay,
+                    std::size_t max_datagram = DEFAULT_MAX_DATAGRAM,
+                    bool prefix_compression = true);
+
+    /// @brief Send the pending messages, stop the flusher and close the socket
+    ~MulticastSender();
+
+    MulticastSender(const MulticastSender &)            = delete;
+    MulticastSender &operator=(const MulticastSender &) = delete;
+
+    /**
+     * @brief Queue a message
+     * @param ip_addr Destination address
+     * @param ip_port Destination port
+     * @param command Command of the message
+     * @param payload Payload of the message
+     */
+    void send(const std::string &ip_addr, int ip_port, char command, std::string payload);
+
+    /// @brief Number of messages handed to the kernel
+    [[nodiscard]] std::uint64_t messagesSent() const;
+
+    /// @brief Number of datagrams handed to the kernel, each carrying one or more messages
+    [[nodiscard]] std::uint64_t datagramsSent() const;
+
+    /// @brief Number of batches sent, each with a single system call
+    [[nodiscard]] std::uint64_t batchesFlushed() const;
+};
+} // namespace capiocl::monitor
+
+#endif // CAPIO_CL_SENDER_H
@@ -0,0 +1,191 @@
+#ifndef CAPIO_CL_SNAPSHOT_H
+#define CAPIO_CL_SNAPSHOT_H
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "capiocl/engine.h"
+
+/// @brief Namespace containing the CAPIO-CL binary snapshots of Engine
+namespace capiocl::snapshot {
+
+/**
+ * @brief Custom exception thrown when saving or opening a snapshot of an Engine
+ */
+class SnapshotException final : public std::exception {
+    std::string message;
+
+  public:
+    /**
+     * @brief Construct a new CAPIO-CL Exception
+     * @param msg Error Message that raised this exception
+     */
+    explicit SnapshotException(const std::string &msg);
+    /**
+     * Get the description of the error causing the exception
+     * @return
+     */
+    [[nodiscard]] const char *what() const noexcept override { return message.c_str(); }
+};
+
+/**
+ * @brief Read-only view of a binary snapshot of an Engine, mapped in memory.
+ *
+ * A snapshot file is made of a header, a pool of the strings (paths, application names and
+ * dependencies), an array of fixed-size records, one per entry, an array of references to the
+ * pool for the lists of the records, and an open-addressing hash index over the records of the
+ * literal paths. Every reference is an offset from the start of the file, so the file is used as
+ * mapped, without parsing: processes opening the same snapshot share its pages. The records of
+ * the glob rules come first, followed by the ones of the literal paths.
+ *
+ * Integers are stored in the byte order of the machine that saved the snapshot, which is checked
+ * when the file is opened. The format is versioned by #VERSION.
+ *
+ * Records of literal paths are handed out once: claim() marks a record as moved into the Engine,
+ * so that it is neither decoded twice nor resurrected after its entry is removed.
+ */
+class Image final {
+    /// @brief File header
+    struct Header;
+    /// @brief Reference to a string of the pool
+    struct StringRef;
+    /// @brief Entry of a path or of a glob rule
+    struct Record;
+
+    /// @brief Start of the mapping
+    const char *base = nullptr;
+    /// @brief Size of the mapping
+    std::size_t length = 0;
+    /// @brief Header, at the start of the mapping
+    const Header *header = nullptr;
+    /// @brief String pool
+    const char *strings = nullptr;
+    /// @brief References of the lists of producers, consumers and dependencies
+    const StringRef *lists = nullptr;
+    /// @brief Records of the glob rules, then of the literal paths
+    const Record *records = nullptr;
+    /// @brief Hash index of the literal paths: record position plus one, zero for empty buckets
+    const std::uint32_t *buckets = nullptr;
+
+    /// @brief One bit per record of a literal path, set once the record is claimed
+    mutable std::vector<std::atomic<std::uint64_t>> claims;
+    /// @brief Number of records of literal paths not claimed yet
+    mutable std::atomic<std::size_t> unclaimed_count = 0;
+
+    /**
+     * @brief Get a string of the pool
+     * @param ref Reference to the string
+     * @return The string, pointing into the mapping
+     * @throws SnapshotException if @p ref is out of the pool
+     */
+    [[nodiscard]] std::string_view string(const StringRef &ref) const;
+
+    /**
+     * @brief Get a list of strings of a record
+     * @param first Position of the first reference within #lists
+     * @param count Number of references
+     * @return The strings, pointing into the mapping
+     * @throws SnapshotException if the list is out of the reference array
+     */
+    [[nodiscard]] std::vector<std::string_view> list(std::uint32_t first,
+                                                     std::uint32_t count) const;
+
+  public:
+    /// @brief Version of the snapshot format written by save()
+    static constexpr std::uint32_t VERSION = 1;
+
+    /// @brief Position returned by find() for paths without a record
+    static constexpr std::size_t NONE = SIZE_MAX;
+
+    /**
+     * @brief Map a snapshot file. Only the header and the bounds of the sections are checked
+     * @param path Snapshot file
+     * @throws SnapshotException if the file cannot be mapped or is not a valid snapshot
+     */
+    explicit Image(const std::filesystem::path &path);
+
+    ~Image();
+
+    Image(const Image &)            = delete;
+    Image &operator=(const Image &) = delete;
+
+    /**
+     * @brief Write a snapshot file. The file is written next to @p path and renamed, so that
+     * processes that mapped a previous version of @p path keep reading it unchanged.
+     * @param path Snapshot file
+     * @param workflow_name Name of the workflow
+     * @param store_all_in_memory Whether all the files are stored in memory
+     * @param rules Glob rules
+     * @param entries Entries of the literal paths
+     * @throws SnapshotException if the file cannot be written
+     */
+    static void save(const std::filesystem::path &path, const std::string &workflow_name,
+                     bool store_all_in_memory,
+                     const std::vector<std::pair<std::string, engine::CapioCLEntry>> &rules,
+                     const std::vector<std::pair<std::string, engine::CapioCLEntry>> &entries);
+
+    /// @brief Name of the workflow
+    [[nodiscard]] std::string_view workflowName() const;
+
+    /// @brief Whether all the files are stored in memory
+    [[nodiscard]] bool storeAllInMemory() const;
+
+    /// @brief Number of glob rules, at positions [0, rules())
+    [[nodiscard]] std::size_t rules() const;
+
+    /// @brief Number of records, glob rules included
+    [[nodiscard]] std::size_t size() const;
+
+    /**
+     * @brief Look up the record of a literal path in the hash index
+     * @param path Literal path
+     * @return The position of the record, or #NONE
+     */
+    [[nodiscard]] std::size_t find(std::string_view path) const;
+
+    /**
+     * @brief Get the path of a record
+     * @param position Position of the record
+     * @return The path, pointing into the mapping
+     */
+    [[nodiscard]] std::string_view path(std::size_t position) const;
+
+    /**
+     * @brief Decode the entry of a record
+     * @param position Position of the record
+     * @return A copy of the entry
+     */
+    [[nodiscard]] engine::CapioCLEntry entry(std::size_t position) const;
+
+    /**
+     * @brief Get the Commit on File dependencies of a record, without decoding the whole entry
+     * @param position Position of the record
+     * @return The dependencies, pointing into the mapping
+     */
+    [[nodiscard]] std::vector<std::string_view> dependencies(std::size_t position) const;
+
+    /**
+     * @brief Check whether the record of a literal path was claimed
+     * @param position Position of the record, not a glob rule
+     * @return true if claim() already succeeded on @p position
+     */
+    [[nodiscard]] bool claimed(std::size_t position) const;
+
+    /**
+     * @brief Mark the record of a literal path as claimed
+     * @param position Position of the record, not a glob rule
+     * @return true if the record was not claimed yet
+     */
+    bool claim(std::size_t position) const;
+
+    /// @brief Number of records of literal paths not claimed yet
+    [[nodiscard]] std::size_t unclaimed() const;
+};
+
+} // namespace capiocl::snapshot
+
+#endif // CAPIO_CL_SNAPSHOT_H
@@ -0,0 +1,259 @@
+#ifndef CAPIO_CL_STATS_H
+#define CAPIO_CL_STATS_H
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <string>
+
+/// @brief Namespace containing the CAPIO-CL Engine
+namespace capiocl::engine {
+
+/// @brief Distribution of the latencies of an Engine method, on a logarithmic scale
+struct LatencyHistogram {
+    /// @brief Number of buckets. The last one also counts the latencies above its upper bound
+    static constexpr std::size_t BUCKETS = 32;
+
+    /// @brief Bucket i counts the calls that took between 2^i and 2^(i+1) nanoseconds
+    std::array<std::uint64_t, BUCKETS> buckets{};
+    /// @brief Number of calls
+    std::uint64_t count = 0;
+    /// @brief Total time spent in the calls, in nanoseconds
+    std::uint64_t total_ns = 0;
+
+    /// @brief Average latency in nanoseconds, or zero without calls
+    [[nodiscard]] double mean() const;
+
+    /**
+     * @brief Estimate a percentile of the latencies
+     * @param p Percentile, between 0 and 100
+     * @return Upper bound in nanoseconds of the bucket holding the percentile, or zero without
+     * calls
+     */
+    [[nodiscard]] std::uint64_t percentile(double p) const;
+};
+
+/// @brief Statistics of an Engine, as returned by Engine::stats()
+struct EngineStats {
+    /// @brief Whether statistics were compiled in. When false, only the sizes are reported
+    bool enabled = false;
+    /// @brief Number of entries of literal paths
+    std::size_t entries = 0;
+    /// @brief Number of glob rules
+    std::size_t patterns = 0;
+    /// @brief Number of entries created from the glob rules by queries and updates
+    std::uint64_t materializations = 0;
+    /// @brief Number of glob patterns compared against a path while resolving it
+    std::uint64_t glob_comparisons = 0;
+    /// @brief Number of lookups that found an entry
+    std::uint64_t lookup_hits = 0;
+    /// @brief Number of lookups that did not find an entry
+    std::uint64_t lookup_misses = 0;
+    /// @brief Number of exclusive acquisitions of the entry table locks
+    std::uint64_t exclusive_locks = 0;
+    /// @brief Number of shared acquisitions of the entry table locks
+    std::uint64_t shared_locks = 0;
+    /// @brief Time spent waiting for the entry table locks, in nanoseconds
+    std::uint64_t lock_wait_ns = 0;
+    /// @brief Latencies of the Engine methods, by method name
+    std::map<std::string, LatencyHistogram> latencies;
+    /// @brief Number of messages sent to other processes by the monitor backends
+    std::uint64_t messages_sent = 0;
+    /// @brief Number of datagrams the messages were packed in
+    std::uint64_t datagrams_sent = 0;
+    /// @brief Number of batches the messages were sent in, each with a single system call
+    std::uint64_t batches_flushed = 0;
+
+    /// @brief Fraction of the lookups that found an entry, or zero without lookups
+    [[nodiscard]] double hitRatio() const;
+};
+
+/**
+ * @brief Statistics collected by an Engine.
+ *
+ * Counters are spread over cache-line aligned slots, and each thread only updates the slot it is
+ * assigned the first time it records something, with relaxed atomic operations. Recording is
+ * therefore never a contention point, and snapshot() sums the slots. When CAPIO-CL is built
+ * without CAPIO_CL_ENABLE_STATS, every method but snapshot() is a no-op and no slot is allocated.
+ */
+class StatsCollector final {
+  public:
+    /// @brief Counters of EngineStats
+    typedef enum {
+        MATERIALIZATIONS,
+        GLOB_COMPARISONS,
+        LOOKUP_HITS,
+        LOOKUP_MISSES,
+        EXCLUSIVE_LOCKS,
+        SHARED_LOCKS,
+        LOCK_WAIT_NS,
+        COUNTERS
+    } COUNTER;
+
+    /// @brief Methods with a latency histogram
+    typedef enum {
+        NEW_FILE,
+        QUERY,
+        UPDATE,
+        REMOVE,
+        QUERY_BATCH,
+        SET_COMMITTED,
+        NOTIFY_CLOSE,
+        METHODS
+    } METHOD;
+
+    /// @brief Records the latency of a method from its construction to its destruction
+    class Timer {
+#ifdef CAPIO_CL_ENABLE_STATS
+        const StatsCollector &stats;
+        METHOD method;
+        std::chrono::steady_clock::time_point start;
+
+      public:
+        /// @brief Start timing @p method
+        Timer(const StatsCollector &stats, const METHOD method)
+            : stats(stats), method(method), start(std::chrono::steady_clock::now()) {}
+
+        /// @brief Record the latency
+        ~Timer() { stats.record(method, std::chrono::steady_clock::now() - start); }
+#else
+      public:
+        /// @brief Statistics are compiled out: nothing to time
+        Timer(const StatsCollector &, METHOD) {}
+#endif
+
+        Timer(const Timer &)            = delete;
+        Timer &operator=(const Timer &) = delete;
+    };
+
+  private:
+#ifdef CAPIO_CL_ENABLE_STATS
+    /// @brief Number of slots. Threads beyond this number share slots
+    static constexpr std::size_t SLOTS = 16;
+
+    /// @brief Counters updated by the threads assigned to a slot
+    struct alignas(64) Slot {
+        /// @brief Values of the counters
+        std::array<std::atomic<std::uint64_t>, COUNTERS> counters{};
+        /// @brief Latency buckets, by method
+        std::array<std::array<std::atomic<std::uint64_t>, LatencyHistogram::BUCKETS>, METHODS>
+            buckets{};
+        /// @brief Total latency in nanoseconds, by method
+        std::array<std::atomic<std::uint64_t>, METHODS> total_ns{};
+    };
+
+    /// @brief Slots of the counters
+    mutable std::array<Slot, SLOTS> slots;
+
+    /// @brief Slot assigned to the calling thread
+    [[nodiscard]] Slot &slot() const;
+#endif
+
+  public:
+    /**
+     * @brief Add @p value to a counter
+     * @param counter Counter to update
+     * @param value Value to add
+     */
+    void add([[maybe_unused]] const COUNTER counter,
+             [[maybe_unused]] const std::uint64_t value = 1) const {
+#ifdef CAPIO_CL_ENABLE_STATS
+        slot().counters[counter].fetch_add(value, std::memory_order_relaxed);
+#endif
+    }
+
+    /**
+     * @brief Record a call to @p method
+     * @param method Method called
+     * @param latency Duration of the call
+     */
+    void record(METHOD method, std::chrono::steady_clock::duration latency) const;
+
+    /**
+     * @brief Acquire @p mutex exclusively, counting the acquisition and the time spent waiting
+     * @param mutex Mutex to lock
+     */
+    template <typename Mutex> void lock(Mutex &mutex) const {
+#ifdef CAPIO_CL_ENABLE_STATS
+        // The clock is only read when the lock is contended
+        if (!mutex.try_lock()) {
+            const auto start = std::chrono::steady_clock::now();
+            mutex.lock();
+            this->wait(std::chrono::steady_clock::now() - start);
+        }
+        this->add(EXCLUSIVE_LOCKS);
+#else
+        mutex.lock();
+#endif
+    }
+
+    /**
+     * @brief Acquire @p mutex shared, counting the acquisition and the time spent waiting
+     * @param mutex Mutex to lock
+     */
+    template <typename SharedMutex> void lockShared(SharedMutex &mutex) const {
+#ifdef CAPIO_CL_ENABLE_STATS
+        if (!mutex.try_lock_shared()) {
+            const auto start = std::chrono::steady_clock::now();
+            mutex.lock_shared();
+            this->wait(std::chrono::steady_clock::now() - start);
+        }
+        this->add(SHARED_LOCKS);
+#else
+        mutex.lock_shared();
+#endif
+    }
+
+    /**
+     * @brief Add @p duration to the time spent waiting for locks
+     * @param duration Time spent waiting
+     */
+    void wait(std::chrono::steady_clock::duration duration) const;
+
+    /// @brief Sum the counters of all the slots
+    [[nodiscard]] EngineStats snapshot() const;
+
+    /// @brief Name of @p method in EngineStats::latencies
+    [[nodiscard]] static const char *name(METHOD method);
+};
+
+/// @brief Class to implement a shared mutex lock guard
+template <typename SharedMutex> class shared_lock_guard {
+  public:
+    /// @brief Constructor: acquire semaphore shared
+    explicit shared_lock_guard(SharedMutex &m) : mutex_(m) { mutex_.lock_shared(); }
+    /// @brief Constructor: acquire semaphore shared, recording the acquisition in @p stats
+    shared_lock_guard(SharedMutex &m, const StatsCollector &stats) : mutex_(m) {
+        stats.lockShared(mutex_);
+    }
+    /// @brief Destructor: release resources
+    ~shared_lock_guard() { mutex_.unlock_shared(); }
+
+    shared_lock_guard(const shared_lock_guard &)            = delete;
+    shared_lock_guard &operator=(const shared_lock_guard &) = delete;
+
+  private:
+    /// @brief Reference to mutex
+    SharedMutex &mutex_;
+};
+
+/// @brief Class to implement an exclusive lock guard, recording the acquisition in the statistics
+template <typename Mutex> class exclusive_lock_guard {
+  public:
+    /// @brief Constructor: acquire semaphore exclusively
+    exclusive_lock_guard(Mutex &m, const StatsCollector &stats) : mutex_(m) { stats.lock(mutex_); }
+    /// @brief Destructor: release resources
+    ~exclusive_lock_guard() { mutex_.unlock(); }
+
+    exclusive_lock_guard(const exclusive_lock_guard &)            = delete;
+    exclusive_lock_guard &operator=(const exclusive_lock_guard &) = delete;
+
+  private:
+    /// @brief Reference to mutex
+    Mutex &mutex_;
+};
+
+} // namespace capiocl::engine
+
+#endif // CAPIO_CL_STATS_H
@@ -0,0 +1,98 @@
+#ifndef CAPIO_CL_TREE_H
+#define CAPIO_CL_TREE_H
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/// @brief Namespace containing the CAPIO-CL Engine
+namespace capiocl::engine {
+
+/**
+ * @brief Directory hierarchy of the literal paths stored within an instance of Engine.
+ *
+ * Each path with an entry in the Engine has a node in the tree, linked to the node of its parent
+ * directory, as returned by std::filesystem::path::parent_path(). Ancestors without an entry get
+ * a placeholder node, so that a directory created after its files still finds them. Each node
+ * counts its children that have an entry, so directory operations only touch the nodes along the
+ * path and the children of the directory, regardless of the size of the Engine. Placeholder nodes
+ * are dropped as soon as they have no children left.
+ *
+ * The tree is not thread safe: Engine guards it with its own lock.
+ */
+class DirectoryTree final {
+    /// @brief A path of the hierarchy
+    struct Node {
+        /// @brief Full path of the node, owned by the key of #nodes
+        const std::string *path = nullptr;
+        /// @brief Node of the parent directory, nullptr for top level paths
+        Node *parent = nullptr;
+        /// @brief Nodes whose parent directory is this node
+        std::unordered_set<Node *> children;
+        /// @brief Number of #children that have an entry
+        std::size_t count = 0;
+        /// @brief Whether the path has an entry within the Engine
+        bool present = false;
+    };
+
+    /// @brief Nodes of the tree, keyed by full path. Nodes are never moved once inserted
+    std::unordered_map<std::string, Node> nodes;
+
+    /**
+     * @brief Get the node of @p path, creating it and its missing ancestors if needed
+     * @param path Path of the node
+     * @return The node of @p path
+     */
+    Node &node(const std::filesystem::path &path);
+
+    /**
+     * @brief Drop @p node and its ancestors, as long as they have neither an entry nor children
+     * @param node First node to check
+     */
+    void prune(Node *node);
+
+  public:
+    /// @brief Counters of the nodes touched by insert()
+    struct Counters {
+        /// @brief Number of children with an entry of the inserted path
+        std::size_t children = 0;
+        /// @brief Number of children with an entry of the parent of the inserted path
+        std::size_t siblings = 0;
+    };
+
+    /**
+     * @brief Record that @p path has an entry
+     * @param path Path of the entry
+     * @return The counters of @p path and of its parent directory, after the insertion
+     */
+    Counters insert(const std::filesystem::path &path);
+
+    /**
+     * @brief Record that @p path no longer has an entry
+     * @param path Path of the removed entry
+     */
+    void erase(const std::filesystem::path &path);
+
+    /**
+     * @brief Get the number of children of @p path that have an entry
+     * @param path Directory path
+     * @return The number of known children of @p path
+     */
+    [[nodiscard]] std::size_t count(const std::filesystem::path &path) const;
+
+    /**
+     * @brief Get the children of @p path that have an entry
+     * @param path Directory path
+     * @return The paths of the known children of @p path, in no particular order
+     */
+    [[nodiscard]] std::vector<std::string> children(const std::filesystem::path &path) const;
+
+    /// @brief Number of nodes in the tree, placeholders included
+    [[nodiscard]] std::size_t size() const;
+};
+
+} // namespace capiocl::engine
+
+#endif // CAPIO_CL_TREE_H
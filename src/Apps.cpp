@@ -0,0 +1,236 @@
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "capiocl/apps.h"
+
+/// Immutable view of the interned names, published to readers by intern()
+struct InternerSnapshot {
+    std::unordered_map<std::string, capiocl::engine::AppId> ids;
+    // Point into InternerTable::names, by identifier
+    std::vector<const std::string *> names;
+};
+
+/// Storage of the process-wide application interner
+struct InternerTable {
+    // Serializes intern() calls assigning new identifiers
+    std::mutex mutex;
+    // std::deque never relocates its elements, so references returned by name() stay valid
+    std::deque<std::string> names;
+    std::shared_ptr<const InternerSnapshot> snapshot = std::make_shared<InternerSnapshot>();
+};
+
+static InternerTable &interner_table() {
+    static InternerTable table;
+    return table;
+}
+
+capiocl::engine::AppId capiocl::engine::AppInterner::intern(const std::string &name) {
+    if (const auto id = find(name); id != NONE) {
+        return id;
+    }
+
+    // Identifiers are assigned rarely: copy the published table and publish the copy
+    auto &table = interner_table();
+    std::lock_guard lg(table.mutex);
+    auto snapshot = std::make_shared<InternerSnapshot>(*std::atomic_load(&table.snapshot));
+    const auto next_id         = static_cast<AppId>(snapshot->names.size());
+    const auto [itm, inserted] = snapshot->ids.try_emplace(name, next_id);
+    if (!inserted) {
+        return itm->second;
+    }
+    snapshot->names.push_back(&table.names.emplace_back(name));
+    std::atomic_store(&table.snapshot,
+                      std::shared_ptr<const InternerSnapshot>(std::move(snapshot)));
+    return next_id;
+}
+
+capiocl::engine::AppId capiocl::engine::AppInterner::find(const std::string &name) {
+    const auto snapshot = std::atomic_load(&interner_table().snapshot);
+    const auto itm      = snapshot->ids.find(name);
+    return itm == snapshot->ids.end() ? NONE : itm->second;
+}
+
+const std::string &capiocl::engine::AppInterner::name(const AppId id) {
+    return *std::atomic_load(&interner_table().snapshot)->names.at(id);
+}
+
+capiocl::engine::AppSet::AppSet(const AppSet &other) : word(other.word) {
+    if (!other.isInline() && other.word != 0) {
+        word = reinterpret_cast<std::uintptr_t>(new std::vector<AppId>(*other.array()));
+    }
+}
+
+capiocl::engine::AppSet::AppSet(AppSet &&other) noexcept : word(other.word) { other.word = 0; }
+
+capiocl::engine::AppSet::AppSet(std::initializer_list<std::string> names) {
+    for (const auto &name : names) {
+        this->insert(name);
+    }
+}
+
+capiocl::engine::AppSet::AppSet(const std::vector<std::string> &names) {
+    for (const auto &name : names) {
+        this->insert(name);
+    }
+}
+
+capiocl::engine::AppSet &capiocl::engine::AppSet::operator=(const AppSet &other) {
+    if (this != &other) {
+        AppSet copy(other);
+        std::swap(word, copy.word);
+    }
+    return *this;
+}
+
+capiocl::engine::AppSet &capiocl::engine::AppSet::operator=(AppSet &&other) noexcept {
+    std::swap(word, other.word);
+    return *this;
+}
+
+capiocl::engine::AppSet::~AppSet() {
+    if (!this->isInline()) {
+        delete this->array();
+    }
+}
+
+capiocl::engine::AppId capiocl::engine::AppSet::next(const AppId id) const {
+    if (this->isInline()) {
+        if (id < INLINE_APPS) {
+            if (const auto remaining = (word >> 1) & (~std::uint64_t{0} << id); remaining != 0) {
+                return static_cast<AppId>(__builtin_ctzll(remaining));
+            }
+        }
+    } else if (word != 0) {
+        const auto ids = this->array();
+        if (const auto itm = std::lower_bound(ids->begin(), ids->end(), id); itm != ids->end()) {
+            return *itm;
+        }
+    }
+    return AppInterner::NONE;
+}
+
+bool capiocl::engine::AppSet::insert(const AppId id) {
+    if (word == 0 && id < INLINE_APPS) {
+        word = INLINE_TAG;
+    }
+
+    if (this->isInline()) {
+        if (id < INLINE_APPS) {
+            const auto mask     = std::uintptr_t{1} << (id + 1);
+            const bool inserted = (word & mask) == 0;
+            word |= mask;
+            return inserted;
+        }
+
+        // The identifier does not fit inline: move to a sorted array
+        auto ids = new std::vector<AppId>();
+        for (auto itm = this->begin(); itm != this->end(); ++itm) {
+            ids->push_back(itm.appId());
+        }
+        word = reinterpret_cast<std::uintptr_t>(ids);
+    } else if (word == 0) {
+        word = reinterpret_cast<std::uintptr_t>(new std::vector<AppId>());
+    }
+
+    auto ids       = this->array();
+    const auto itm = std::lower_bound(ids->begin(), ids->end(), id);
+    if (itm != ids->end() && *itm == id) {
+        return false;
+    }
+    ids->insert(itm, id);
+    return true;
+}
+
+bool capiocl::engine::AppSet::insert(const std::string &name) {
+    return this->insert(AppInterner::intern(name));
+}
+
+bool capiocl::engine::AppSet::erase(const AppId id) {
+    if (this->isInline()) {
+        if (id >= INLINE_APPS) {
+            return false;
+        }
+        const auto mask   = std::uintptr_t{1} << (id + 1);
+        const bool erased = (word & mask) != 0;
+        word &= ~mask;
+        return erased;
+    }
+    if (word == 0) {
+        return false;
+    }
+
+    auto ids       = this->array();
+    const auto itm = std::lower_bound(ids->begin(), ids->end(), id);
+    if (itm == ids->end() || *itm != id) {
+        return false;
+    }
+    ids->erase(itm);
+    return true;
+}
+
+bool capiocl::engine::AppSet::erase(const std::string &name) {
+    const auto id = AppInterner::find(name);
+    return id != AppInterner::NONE && this->erase(id);
+}
+
+bool capiocl::engine::AppSet::contains(const AppId id) const {
+    if (this->isInline()) {
+        return id < INLINE_APPS && ((word >> (id + 1)) & 1) != 0;
+    }
+    return word != 0 && std::binary_search(this->array()->begin(), this->array()->end(), id);
+}
+
+bool capiocl::engine::AppSet::contains(const std::string &name) const {
+    const auto id = AppInterner::find(name);
+    return id != AppInterner::NONE && this->contains(id);
+}
+
+std::size_t capiocl::engine::AppSet::size() const {
+    if (this->isInline()) {
+        return __builtin_popcountll(word >> 1);
+    }
+    return word == 0 ? 0 : this->array()->size();
+}
+
+bool capiocl::engine::AppSet::empty() const { return this->size() == 0; }
+
+std::vector<std::string> capiocl::engine::AppSet::names() const {
+    return {this->begin(), this->end()};
+}
+
+capiocl::engine::AppSet::const_iterator capiocl::engine::AppSet::begin() const {
+    return {this, this->next(0)};
+}
+
+capiocl::engine::AppSet::const_iterator capiocl::engine::AppSet::end() const {
+    return {this, AppInterner::NONE};
+}
+
+capiocl::engine::AppSet &capiocl::engine::AppSet::operator|=(const AppSet &rhs) {
+    if (this->isInline() && rhs.isInline()) {
+        word |= rhs.word;
+        return *this;
+    }
+    for (auto itm = rhs.begin(); itm != rhs.end(); ++itm) {
+        this->insert(itm.appId());
+    }
+    return *this;
+}
+
+bool capiocl::engine::AppSet::operator==(const AppSet &other) const {
+    if (this->isInline() && other.isInline()) {
+        return (word >> 1) == (other.word >> 1);
+    }
+    auto lhs = this->begin(), rhs = other.begin();
+    for (; lhs != this->end() && rhs != other.end(); ++lhs, ++rhs) {
+        if (lhs.appId() != rhs.appId()) {
+            return false;
+        }
+    }
+    return lhs == this->end() && rhs == other.end();
+}
+
+bool capiocl::engine::AppSet::operator!=(const AppSet &other) const { return !(*this == other); }
@@ -0,0 +1,383 @@
+#include <algorithm>
+#include <iterator>
+#include <unordered_set>
+#include <utility>
+
+#include "capiocl/builder.h"
+#include "capiocl/printer.h"
+
+/// Get the parent directory of @p path, or an empty path if @p path has none
+static std::filesystem::path parent_of(const std::filesystem::path &path) {
+    auto parent = path.parent_path();
+    // The root directory is its own parent
+    if (parent == path) {
+        parent.clear();
+    }
+    return parent;
+}
+
+/// Raise the number of children of a directory entry to @p count, as Engine does on insertions
+static bool update_count(capiocl::engine::CapioCLEntry &entry, const std::size_t count) {
+    if (!entry.enable_directory_count_update ||
+        entry.directory_children_count >= static_cast<long>(count)) {
+        return false;
+    }
+    entry.directory_children_count = static_cast<long>(count);
+    entry.is_file                  = false;
+    return true;
+}
+
+capiocl::engine::CapioCLEntry &
+capiocl::engine::EngineBuilder::_entry(const std::filesystem::path &path) {
+    const auto pattern = PatternIndex::isPattern(path.native());
+    auto &table        = pattern ? _rules : _entries;
+    if (const auto itm = table.find(path.native()); itm != table.end()) {
+        return itm->second;
+    }
+
+    auto &entry = table.emplace(path.native(), Engine::_template(path, _rules, _patterns,
+                                                                 _store_all_in_memory))
+                      .first->second;
+    if (pattern) {
+        _patterns.insert(path.native());
+        return entry;
+    }
+
+    // Same as Engine::compute_directory_entry_count(), on the entries of this builder
+    const auto counters = _tree.insert(path);
+    if (counters.children > 0) {
+        update_count(entry, counters.children);
+    }
+    if (const auto parent = parent_of(path); !parent.empty()) {
+        if (const auto itm = _entries.find(parent.native()); itm != _entries.end()) {
+            update_count(itm->second, counters.siblings);
+        }
+    }
+
+    // Same as Engine::_inherit()
+    try {
+        _graph.add(path, entry.file_dependencies);
+    } catch (const std::invalid_argument &e) {
+        printer::print(printer::CLI_LEVEL_WARNING, e.what());
+    }
+    return entry;
+}
+
+void capiocl::engine::EngineBuilder::newFile(const std::filesystem::path &path) {
+    if (path.empty()) {
+        return;
+    }
+    this->_entry(path);
+}
+
+void capiocl::engine::EngineBuilder::addProducer(const std::filesystem::path &path,
+                                                 std::string producer) {
+    if (path.empty()) {
+        return;
+    }
+
+    producer.erase(remove_if(producer.begin(), producer.end(), isspace), producer.end());
+    this->_entry(path).producers.insert(producer);
+}
+
+void capiocl::engine::EngineBuilder::addConsumer(const std::filesystem::path &path,
+                                                 std::string consumer) {
+    if (path.empty()) {
+        return;
+    }
+
+    consumer.erase(remove_if(consumer.begin(), consumer.end(), isspace), consumer.end());
+    this->_entry(path).consumers.insert(consumer);
+}
+
+void capiocl::engine::EngineBuilder::addFileDependency(
+    const std::filesystem::path &path, const std::filesystem::path &file_dependency) {
+    if (path.empty()) {
+        return;
+    }
+
+    const auto exists = _entries.count(path.native()) > 0 || _rules.count(path.native()) > 0;
+    auto &entry       = this->_entry(path);
+    if (!exists) {
+        entry.commit_rule = commitRules::COMMIT_RULE::ON_FILE;
+    }
+    if (!PatternIndex::isPattern(path.native())) {
+        _graph.add(path, {file_dependency});
+    }
+
+    auto &vec = entry.file_dependencies;
+    if (std::find(vec.begin(), vec.end(), file_dependency) == vec.end()) {
+        vec.emplace_back(file_dependency);
+    }
+}
+
+void capiocl::engine::EngineBuilder::setCommitRule(const std::filesystem::path &path,
+                                                   const std::string &commit_rule) {
+    if (path.empty()) {
+        return;
+    }
+
+    this->setCommitRule(path, commitRules::fromString(commit_rule));
+}
+
+void capiocl::engine::EngineBuilder::setCommitRule(const std::filesystem::path &path,
+                                                   const commitRules::COMMIT_RULE commit_rule) {
+    if (path.empty()) {
+        return;
+    }
+
+    this->_entry(path).commit_rule = commit_rule;
+}
+
+void capiocl::engine::EngineBuilder::setFireRule(const std::filesystem::path &path,
+                                                 const std::string &fire_rule) {
+    if (path.empty()) {
+        return;
+    }
+
+    this->setFireRule(path, fireRules::fromString(fire_rule));
+}
+
+void capiocl::engine::EngineBuilder::setFireRule(const std::filesystem::path &path,
+                                                 const fireRules::FIRE_RULE fire_rule) {
+    if (path.empty()) {
+        return;
+    }
+
+    this->_entry(path).fire_rule = fire_rule;
+}
+
+void capiocl::engine::EngineBuilder::setPermanent(const std::filesystem::path &path,
+                                                  const bool value) {
+    if (path.empty()) {
+        return;
+    }
+
+    this->_entry(path).permanent = value;
+}
+
+void capiocl::engine::EngineBuilder::setExclude(const std::filesystem::path &path,
+                                                const bool value) {
+    if (path.empty()) {
+        return;
+    }
+
+    this->_entry(path).excluded = value;
+}
+
+void capiocl::engine::EngineBuilder::setDirectory(const std::filesystem::path &path) {
+    if (path.empty()) {
+        return;
+    }
+
+    this->_entry(path).is_file = false;
+}
+
+void capiocl::engine::EngineBuilder::setFile(const std::filesystem::path &path) {
+    if (path.empty()) {
+        return;
+    }
+
+    this->_entry(path).is_file = true;
+}
+
+void capiocl::engine::EngineBuilder::setCommitedCloseNumber(const std::filesystem::path &path,
+                                                            const long num) {
+    if (path.empty()) {
+        return;
+    }
+
+    this->_entry(path).commit_on_close_count = num;
+}
+
+void capiocl::engine::EngineBuilder::setDirectoryFileCount(const std::filesystem::path &path,
+                                                           const long num) {
+    if (path.empty()) {
+        return;
+    }
+
+    auto &entry                         = this->_entry(path);
+    entry.directory_children_count      = num;
+    entry.enable_directory_count_update = false;
+    entry.is_file                       = false;
+}
+
+void capiocl::engine::EngineBuilder::setFileDeps(
+    const std::filesystem::path &path, const std::vector<std::filesystem::path> &dependencies) {
+    if (path.empty() || dependencies.empty()) {
+        return;
+    }
+
+    auto &entry = this->_entry(path);
+    if (!PatternIndex::isPattern(path.native())) {
+        _graph.set(path, dependencies);
+    }
+    for (const auto &itm : dependencies) {
+        this->newFile(itm);
+    }
+
+    entry.file_dependencies = dependencies;
+}
+
+void capiocl::engine::EngineBuilder::setStoreFileInMemory(const std::filesystem::path &path) {
+    if (path.empty()) {
+        return;
+    }
+
+    this->_entry(path).store_in_memory = true;
+}
+
+void capiocl::engine::EngineBuilder::setStoreFileInFileSystem(const std::filesystem::path &path) {
+    if (path.empty()) {
+        return;
+    }
+
+    this->_entry(path).store_in_memory = false;
+}
+
+void capiocl::engine::EngineBuilder::setAllStoreInMemory() {
+    _store_all_in_memory = true;
+    for (auto &[path, entry] : _rules) {
+        entry.store_in_memory = true;
+    }
+    for (auto &[path, entry] : _entries) {
+        entry.store_in_memory = true;
+    }
+}
+
+std::size_t capiocl::engine::EngineBuilder::size() const {
+    return _entries.size() + _rules.size();
+}
+
+void capiocl::engine::EngineBuilder::publish(Engine &engine) {
+    // Entries still in a snapshot of the Engine are merged like the other ones
+    engine._drain();
+    engine._load_tree();
+    engine._load_graph();
+
+    // Link the dependencies first, so that a cycle is reported before the Engine is modified.
+    // Targets whose dependencies were committed before are committed once every lock is released
+    std::vector<std::pair<std::string, std::vector<std::filesystem::path>>> links;
+    for (const auto &[path, entry] : _entries) {
+        if (!entry.file_dependencies.empty()) {
+            links.emplace_back(path, entry.file_dependencies);
+        }
+    }
+    std::vector<std::string> ready, unknown;
+    {
+        exclusive_lock_guard lg(engine._graph_mutex, engine._stats);
+        ready   = engine._graph.addAll(links);
+        unknown = engine._graph.takeUnknown();
+    }
+
+    {
+        exclusive_lock_guard lg(engine._rules_mutex, engine._stats);
+        if (_store_all_in_memory) {
+            engine.store_all_in_memory = true;
+            for (auto &[pattern, entry] : engine._rules) {
+                entry.store_in_memory = true;
+            }
+        }
+        for (auto &[pattern, entry] : _rules) {
+            // try_emplace leaves entry untouched when the pattern already exists
+            if (auto [itm, inserted] = engine._rules.try_emplace(pattern, std::move(entry));
+                inserted) {
+                engine._patterns.insert(pattern);
+            } else {
+                itm->second += entry;
+            }
+        }
+        engine._publish_rules();
+    }
+
+    // Move the entries into the shards, acquiring each shard lock once. Extracted nodes are
+    // relinked into the shards, without copying paths or entries
+    std::vector<std::vector<decltype(_entries)::node_type>> groups(engine._shards.size());
+    for (auto itm = _entries.begin(); itm != _entries.end();) {
+        const auto next = std::next(itm);
+        groups[engine._shard_index(itm->first)].push_back(_entries.extract(itm));
+        itm = next;
+    }
+
+    std::vector<std::string> created;
+    for (std::size_t s = 0; s < groups.size(); s++) {
+        if (groups[s].empty() && !_store_all_in_memory) {
+            continue;
+        }
+
+        auto &shard = *engine._shards[s];
+        std::vector<std::string> published;
+        exclusive_lock_guard lg(shard.mutex, engine._stats);
+        if (_store_all_in_memory) {
+            for (auto &[path, entry] : shard.entries) {
+                entry.store_in_memory = true;
+                published.push_back(path);
+            }
+        }
+        for (auto &node : groups[s]) {
+            const auto result = shard.entries.insert(std::move(node));
+            if (result.inserted) {
+                created.push_back(result.position->first);
+            } else {
+                result.position->second += result.node.mapped();
+            }
+            published.push_back(result.position->first);
+        }
+        engine._publish(shard, published);
+    }
+
+    // Count the new children of the directories within the Engine, under a single tree lock
+    std::vector<std::vector<std::pair<std::string, std::size_t>>> counts(engine._shards.size());
+    {
+        exclusive_lock_guard lg(engine._tree_mutex, engine._stats);
+        if (engine._tree.size() == 0) {
+            // No other entry to count: the counters computed by the builder are final
+            std::swap(engine._tree, _tree);
+            created.clear();
+        }
+        for (const auto &path : created) {
+            engine._tree.insert(path);
+        }
+
+        std::unordered_set<std::string> directories;
+        for (const auto &path : created) {
+            directories.insert(path);
+            if (const auto parent = parent_of(path); !parent.empty()) {
+                directories.insert(parent.native());
+            }
+        }
+        for (const auto &directory : directories) {
+            if (const auto count = engine._tree.count(directory); count > 0) {
+                counts[engine._shard_index(directory)].emplace_back(directory, count);
+            }
+        }
+    }
+
+    for (std::size_t s = 0; s < counts.size(); s++) {
+        if (counts[s].empty()) {
+            continue;
+        }
+
+        auto &shard = *engine._shards[s];
+        std::vector<std::string> published;
+        exclusive_lock_guard lg(shard.mutex, engine._stats);
+        for (const auto &[directory, count] : counts[s]) {
+            if (const auto itm = shard.entries.find(directory);
+                itm != shard.entries.end() && update_count(itm->second, count)) {
+                published.push_back(directory);
+            }
+        }
+        engine._publish(shard, published);
+    }
+
+    _entries.clear();
+    _rules.clear();
+    _patterns            = PatternIndex();
+    _tree                = DirectoryTree();
+    _graph               = DependencyGraph();
+    _store_all_in_memory = false;
+
+    auto next = engine._settle(unknown);
+    ready.insert(ready.end(), next.begin(), next.end());
+    engine._cascade(std::move(ready));
+}
@@ -0,0 +1,104 @@
+#include "capiocl/commits.h"
+#include "capiocl/hash.h"
+
+/// @brief Shard selected by @p hash. Uses the high bits, the low ones index the Bloom filter
+static std::size_t shard_of(const std::uint64_t hash) {
+    return static_cast<std::size_t>(hash >> 58) % capiocl::monitor::CommitSet::SHARDS;
+}
+
+capiocl::monitor::CommitSet::CommitSet(const bool compact, const std::size_t bloom_bits) {
+    this->configure(compact, bloom_bits);
+}
+
+void capiocl::monitor::CommitSet::configure(const bool compact, const std::size_t bloom_bits) {
+    this->compact = compact;
+    this->shards  = std::make_unique<Shard[]>(SHARDS);
+    this->count   = 0;
+
+    if (bloom_bits == 0) {
+        this->bloom      = nullptr;
+        this->bloom_mask = 0;
+        return;
+    }
+
+    std::uint64_t bits = 64;
+    while (bits < bloom_bits) {
+        bits <<= 1;
+    }
+    const auto words = static_cast<std::size_t>(bits / 64);
+    this->bloom      = std::make_unique<std::atomic<std::uint64_t>[]>(words);
+    for (std::size_t i = 0; i < words; i++) {
+        this->bloom[i].store(0, std::memory_order_relaxed);
+    }
+    this->bloom_mask = bits - 1;
+}
+
+std::uint64_t capiocl::monitor::CommitSet::hash(const std::string &path) {
+    // FNV-1a, finalized so that the high bits used to select shards are well distributed
+    return hashing::mix(hashing::fnv1a(path));
+}
+
+void capiocl::monitor::CommitSet::bloomInsert(const std::uint64_t hash) {
+    // Double hashing: the i-th bit is h1 + i * h2, with h2 odd so that all bits differ
+    const std::uint64_t step = hashing::mix(hash) | 1;
+    for (std::size_t i = 0; i < BLOOM_HASHES; i++) {
+        const auto bit = (hash + i * step) & bloom_mask;
+        bloom[bit / 64].fetch_or(std::uint64_t{1} << (bit % 64), std::memory_order_release);
+    }
+}
+
+bool capiocl::monitor::CommitSet::bloomContains(const std::uint64_t hash) const {
+    const std::uint64_t step = hashing::mix(hash) | 1;
+    for (std::size_t i = 0; i < BLOOM_HASHES; i++) {
+        const auto bit = (hash + i * step) & bloom_mask;
+        if ((bloom[bit / 64].load(std::memory_order_acquire) & (std::uint64_t{1} << (bit % 64))) ==
+            0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool capiocl::monitor::CommitSet::insert(const std::string &path) {
+    const auto h = hash(path);
+    auto &shard  = shards[shard_of(h)];
+
+    bool inserted;
+    {
+        std::lock_guard lg(shard.lock);
+        if (compact) {
+            inserted = shard.hashes.insert(h).second;
+        } else {
+            inserted = shard.paths.insert(path).second;
+        }
+    }
+
+    // The bits are set once the path is in its shard, so that a lookup passing the filter finds it
+    if (bloom != nullptr) {
+        bloomInsert(h);
+    }
+    if (inserted) {
+        count.fetch_add(1, std::memory_order_relaxed);
+    }
+    return inserted;
+}
+
+bool capiocl::monitor::CommitSet::contains(const std::string &path) const {
+    const auto h = hash(path);
+    if (bloom != nullptr && !bloomContains(h)) {
+        return false;
+    }
+
+    const auto &shard = shards[shard_of(h)];
+    std::lock_guard lg(shard.lock);
+    if (compact) {
+        return shard.hashes.find(h) != shard.hashes.end();
+    }
+    return shard.paths.find(path) != shard.paths.end();
+}
+
+std::size_t capiocl::monitor::CommitSet::size() const {
+    return count.load(std::memory_order_relaxed);
+}
+
+bool capiocl::monitor::CommitSet::isCompact() const { return compact; }
@@ -0,0 +1,150 @@
+#include <jsoncons/json.hpp>
+#include <stdexcept>
+
+#include "capiocl/delta.h"
+#include "capiocl/engine.h"
+
+/// @brief Names of the operations in JSON, indexed by Delta::OPERATION
+static constexpr const char *OPERATIONS[] = {"set", "unset", "add", "remove", "erase"};
+
+/// @brief Names of the fields in JSON, indexed by Delta::FIELD. Same keys as CapioCLEntry::toJson()
+static constexpr const char *FIELDS[] = {"commit_rule",
+                                         "fire_rule",
+                                         "commit_on_close_count",
+                                         "directory_children_count",
+                                         "permanent",
+                                         "excluded",
+                                         "store_in_memory",
+                                         "is_file",
+                                         "producers",
+                                         "consumers",
+                                         "file_dependencies"};
+
+/// @brief Find @p name in @p names
+template <typename T, std::size_t N> static T lookup(const char *const (&names)[N],
+                                                     const std::string &name) {
+    for (std::size_t i = 0; i < N; i++) {
+        if (name == names[i]) {
+            return static_cast<T>(i);
+        }
+    }
+    throw std::invalid_argument("Delta: unknown keyword " + name);
+}
+
+capiocl::engine::Delta capiocl::engine::Delta::set(const std::string &path, const FIELD field,
+                                                   const std::string &keyword) {
+    Delta delta;
+    delta.path      = path;
+    delta.operation = SET;
+    delta.field     = field;
+    delta.value     = keyword;
+    return delta;
+}
+
+capiocl::engine::Delta capiocl::engine::Delta::set(const std::string &path, const FIELD field,
+                                                   const long number) {
+    Delta delta;
+    delta.path      = path;
+    delta.operation = SET;
+    delta.field     = field;
+    delta.number    = number;
+    return delta;
+}
+
+capiocl::engine::Delta capiocl::engine::Delta::unset(const std::string &path, const FIELD field) {
+    Delta delta;
+    delta.path      = path;
+    delta.operation = UNSET;
+    delta.field     = field;
+    return delta;
+}
+
+capiocl::engine::Delta capiocl::engine::Delta::add(const std::string &path, const FIELD field,
+                                                   const std::string &value) {
+    Delta delta;
+    delta.path      = path;
+    delta.operation = ADD;
+    delta.field     = field;
+    delta.value     = value;
+    return delta;
+}
+
+capiocl::engine::Delta capiocl::engine::Delta::remove(const std::string &path, const FIELD field,
+                                                      const std::string &value) {
+    auto delta      = add(path, field, value);
+    delta.operation = REMOVE;
+    return delta;
+}
+
+capiocl::engine::Delta capiocl::engine::Delta::erase(const std::string &path) {
+    Delta delta;
+    delta.path      = path;
+    delta.operation = ERASE;
+    return delta;
+}
+
+std::vector<capiocl::engine::Delta>
+capiocl::engine::Delta::fromEntry(const std::string &path, const CapioCLEntry &entry) {
+    std::vector<Delta> deltas = {
+        set(path, COMMIT_RULE, commitRules::toString(entry.commit_rule)),
+        set(path, FIRE_RULE, fireRules::toString(entry.fire_rule)),
+        set(path, COMMIT_ON_CLOSE_COUNT, entry.commit_on_close_count),
+        set(path, PERMANENT, entry.permanent),
+        set(path, EXCLUDED, entry.excluded),
+        set(path, STORE_IN_MEMORY, entry.store_in_memory),
+        set(path, IS_FILE, entry.is_file),
+    };
+    // Counts that are updated automatically are left to the receiving Engine
+    if (!entry.enable_directory_count_update) {
+        deltas.push_back(set(path, DIRECTORY_FILE_COUNT, entry.directory_children_count));
+    }
+    for (const auto &producer : entry.producers) {
+        deltas.push_back(add(path, PRODUCER, producer));
+    }
+    for (const auto &consumer : entry.consumers) {
+        deltas.push_back(add(path, CONSUMER, consumer));
+    }
+    for (const auto &dependency : entry.file_dependencies) {
+        deltas.push_back(add(path, DEPENDENCY, dependency));
+    }
+    return deltas;
+}
+
+capiocl::engine::Delta capiocl::engine::Delta::fromJson(const std::string &in) {
+    jsoncons::json j = jsoncons::json::parse(in);
+    Delta delta;
+    delta.version   = j.get_value_or<std::uint64_t>("version", 0);
+    delta.path      = j.get_value_or<std::string, std::string>("path", "");
+    delta.operation = lookup<OPERATION>(
+        OPERATIONS, j.get_value_or<std::string, std::string>("operation", ""));
+    delta.field     = lookup<FIELD>(FIELDS, j.get_value_or<std::string, std::string>("field", ""));
+    delta.value     = j.get_value_or<std::string, std::string>("value", "");
+    delta.number    = j.get_value_or<long>("number", 0);
+    return delta;
+}
+
+std::string capiocl::engine::Delta::toJson() const {
+    jsoncons::json j;
+    j["version"]   = version;
+    j["path"]      = path;
+    j["operation"] = OPERATIONS[operation];
+    j["field"]     = FIELDS[field];
+    j["value"]     = value;
+    j["number"]    = number;
+    return j.to_string();
+}
+
+bool capiocl::engine::Delta::isList() const {
+    return field == PRODUCER || field == CONSUMER || field == DEPENDENCY;
+}
+
+std::string capiocl::engine::Delta::key() const {
+    if (operation == ERASE) {
+        return path + '\n';
+    }
+    auto key = path + '\n' + FIELDS[field];
+    if (this->isList()) {
+        key += '\n' + value;
+    }
+    return key;
+}
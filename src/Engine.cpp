@@ -1,29 +1,14 @@
 #include <algorithm>
-#include <fnmatch.h>
 #include <memory>
 #include <sstream>
+#include <utility>
 
 #include "capiocl.hpp"
 #include "capiocl/configuration.h"
 #include "capiocl/engine.h"
 #include "capiocl/monitor.h"
 #include "capiocl/printer.h"
-
-/// @brief Class to implement a shared mutex lock guard
-template <typename SharedMutex> class shared_lock_guard {
-  public:
-    /// @brief Constructor: acquire semaphore shared
-    explicit shared_lock_guard(SharedMutex &m) : mutex_(m) { mutex_.lock_shared(); }
-    /// @brief Destructor: release resources
-    ~shared_lock_guard() { mutex_.unlock_shared(); }
-
-    shared_lock_guard(const shared_lock_guard &)            = delete;
-    shared_lock_guard &operator=(const shared_lock_guard &) = delete;
-
-  private:
-    /// @brief Reference to mutex
-    SharedMutex &mutex_;
-};
+#include "capiocl/snapshot.h"
 
 void capiocl::engine::Engine::print() const {
 
@@ -69,7 +54,7 @@ void capiocl::engine::Engine::print() const {
     printer::print(printer::CLI_LEVEL_JSON, line);
 
     // Iterate over _locations
-    for (auto &itm : _capio_cl_entries) {
+    for (auto &itm : _entries()) {
         std::string color_preamble =
             itm.second.store_in_memory ? "\033[38;5;034m" : "\033[38;5;172m";
         std::string color_post = "\033[0m";
@@ -87,8 +72,8 @@ void capiocl::engine::Engine::print() const {
         base_line << name_trunc << color_post << std::setfill(' ');
         base_line << std::setw(20 - name_trunc.length()) << "| ";
 
-        auto producers = itm.second.producers;
-        auto consumers = itm.second.consumers;
+        auto producers = itm.second.producers.names();
+        auto consumers = itm.second.consumers.names();
         auto rowCount  = std::max(producers.size(), consumers.size());
 
         std::string n_files = std::to_string(itm.second.directory_children_count);
@@ -121,7 +106,8 @@ void capiocl::engine::Engine::print() const {
             }
 
             if (i == 0) {
-                std::string commit_rule = itm.second.commit_rule, fire_rule = itm.second.fire_rule;
+                std::string commit_rule = commitRules::toString(itm.second.commit_rule),
+                            fire_rule   = fireRules::toString(itm.second.fire_rule);
                 bool exclude = itm.second.excluded, permanent = itm.second.permanent;
 
                 line << " " << commit_rule << std::setfill(' ');
@@ -156,487 +142,1726 @@ capiocl::engine::Engine::Engine(const bool use_default_settings) {
         this->workflow_name = CAPIO_CL_DEFAULT_WF_NAME;
     }
 
+    this->_reshard(std::stoul(configuration::defaults::DEFAULT_ENGINE_SHARDS.v));
+    _patterns.setStats(&_stats);
+
     if (use_default_settings) {
         this->useDefaultConfiguration();
     }
 }
 
-void capiocl::engine::Engine::_newFile(const std::filesystem::path &path) const {
-    if (path.empty()) {
+std::size_t capiocl::engine::Engine::_shard_index(const std::string &path) const {
+    return std::hash<std::string>{}(path) % _shards.size();
+}
+
+capiocl::engine::Engine::EntryShard &
+capiocl::engine::Engine::_shard(const std::string &path) const {
+    return *_shards[this->_shard_index(path)];
+}
+
+void capiocl::engine::Engine::_reshard(const std::size_t count) {
+    if (count == _shards.size()) {
         return;
     }
 
-    if (_capio_cl_entries.find(path) == _capio_cl_entries.end()) {
-        std::string commit = commitRules::ON_TERMINATION;
-        std::string fire   = fireRules::UPDATE;
+    // Entries are moved to new nodes: start from a generation no existing handle can hold
+    std::uint64_t generation = 0;
+    for (const auto &shard : _shards) {
+        generation = std::max(generation, shard->generation + 1);
+    }
 
-        std::string matchKey;
-        size_t matchSize = 0;
-        for (const auto &[filename, data] : _capio_cl_entries) {
-            if (const bool match = fnmatch(filename.c_str(), path.c_str(), FNM_NOESCAPE) == 0;
-                match && filename.length() > matchSize) {
-                matchSize = filename.length();
-                matchKey  = filename;
-            }
+    auto old_shards = std::move(_shards);
+    _shards.clear();
+    for (std::size_t i = 0; i < count; i++) {
+        _shards.emplace_back(std::make_unique<EntryShard>());
+        _shards.back()->generation = generation;
+    }
+    for (auto &shard : old_shards) {
+        for (auto &[path, entry] : shard->entries) {
+            _shard(path).entries.emplace(path, std::move(entry));
+        }
+        for (const auto &[path, count] : shard->closes) {
+            _shard(path).closes.try_emplace(path, count.load());
+        }
+        for (const auto &[path, count] : shard->files) {
+            _shard(path).files.try_emplace(path, count.load());
+        }
+        for (auto &[path, files] : shard->observed) {
+            _shard(path).observed.emplace(path, std::move(files));
         }
+    }
+    this->_set_snapshot_reads(_snapshot_reads);
+}
 
-        CapioCLEntry entry;
-        entry.commit_rule = commit;
-        entry.fire_rule   = fire;
+void capiocl::engine::Engine::_publish(EntryShard &shard, const std::string &path) const {
+    shard.changes++;
+    if (!_snapshot_reads) {
+        return;
+    }
+
+    // Unchanged entries are shared with the previous snapshot, only the map itself is copied
+    auto snapshot = std::make_shared<EntrySnapshot>(*std::atomic_load(&shard.snapshot));
+    if (const auto itm = shard.entries.find(path); itm != shard.entries.end()) {
+        (*snapshot)[path] = std::make_shared<const CapioCLEntry>(itm->second);
+    } else {
+        snapshot->erase(path);
+    }
+    std::atomic_store(&shard.snapshot, std::shared_ptr<const EntrySnapshot>(std::move(snapshot)));
+}
 
-        if (matchSize > 0) {
-            const auto &data = _capio_cl_entries.at(matchKey);
+void capiocl::engine::Engine::_publish(EntryShard &shard,
+                                       const std::vector<std::string> &paths) const {
+    if (paths.empty()) {
+        return;
+    }
+    shard.changes++;
+    if (!_snapshot_reads) {
+        return;
+    }
 
-            // Duplicate CapioCLEntry object and register it to new resolved path
-            // This is achieved by not using & operator
-            entry = data;
-            if (store_all_in_memory) {
-                entry.store_in_memory = true;
-            } else {
-                entry.store_in_memory = data.store_in_memory;
-            }
+    auto snapshot = std::make_shared<EntrySnapshot>(*std::atomic_load(&shard.snapshot));
+    for (const auto &path : paths) {
+        if (const auto itm = shard.entries.find(path); itm != shard.entries.end()) {
+            (*snapshot)[path] = std::make_shared<const CapioCLEntry>(itm->second);
         } else {
-            entry.store_in_memory = store_all_in_memory;
+            snapshot->erase(path);
         }
-        _capio_cl_entries.emplace(path, std::move(entry));
-        this->compute_directory_entry_count(path);
     }
+    std::atomic_store(&shard.snapshot, std::shared_ptr<const EntrySnapshot>(std::move(snapshot)));
 }
 
-void capiocl::engine::Engine::compute_directory_entry_count(
-    const std::filesystem::path &path) const {
-    if (const auto parent = path.parent_path(); !parent.empty()) {
-        if (const auto &entry = _capio_cl_entries.find(parent); entry != _capio_cl_entries.end()) {
-            if (entry->second.enable_directory_count_update) {
-                entry->second.directory_children_count++;
-                entry->second.is_file = false;
-            } else {
-                return;
-            }
-        }
-    } else {
+void capiocl::engine::Engine::_publish_rules() const {
+    _rules_changes++;
+    if (!_snapshot_reads) {
         return;
     }
-}
 
-bool capiocl::engine::Engine::contains(const std::filesystem::path &file) const {
-    shared_lock_guard slg(_shared_mutex);
-    return std::any_of(_capio_cl_entries.begin(), _capio_cl_entries.end(), [&](auto const &entry) {
-        return fnmatch(entry.first.c_str(), file.c_str(), FNM_NOESCAPE) == 0;
-    });
+    auto snapshot = std::make_shared<RulesSnapshot>();
+    for (const auto &[pattern, entry] : _rules) {
+        snapshot->rules.emplace(pattern, std::make_shared<const CapioCLEntry>(entry));
+        snapshot->patterns.insert(pattern);
+    }
+    std::atomic_store(&_rules_snapshot, std::shared_ptr<const RulesSnapshot>(std::move(snapshot)));
 }
 
-size_t capiocl::engine::Engine::size() const {
-    shared_lock_guard slg(_shared_mutex);
-    return this->_capio_cl_entries.size();
+template <typename Map>
+std::vector<std::pair<std::uint32_t, std::uint64_t>>
+capiocl::engine::Engine::_digest(const Map &entries) {
+    std::vector<std::pair<std::uint32_t, std::uint64_t>> digest;
+    digest.reserve(entries.size());
+    for (const auto &[path, entry] : entries) {
+        digest.emplace_back(MerkleTree::bucket(path), MerkleTree::leaf(path, entry.hash()));
+    }
+    std::sort(digest.begin(), digest.end());
+
+    // Sum the hashes of each bucket into its first element
+    std::size_t last = 0;
+    for (std::size_t i = 1; i < digest.size(); i++) {
+        if (digest[i].first == digest[last].first) {
+            digest[last].second += digest[i].second;
+        } else {
+            digest[++last] = digest[i];
+        }
+    }
+    digest.resize(std::min(digest.size(), last + 1));
+    return digest;
 }
 
-void capiocl::engine::Engine::add(std::filesystem::path &path, std::vector<std::string> &producers,
-                                  std::vector<std::string> &consumers,
-                                  const std::string &commit_rule, const std::string &fire_rule,
-                                  bool permanent, bool exclude,
-                                  std::vector<std::filesystem::path> &dependencies) {
+void capiocl::engine::Engine::_set_snapshot_reads(const bool enabled) {
+    _snapshot_reads = enabled;
 
-    if (path.empty()) {
-        return;
+    for (auto &shard : _shards) {
+        std::shared_ptr<EntrySnapshot> snapshot;
+        if (enabled) {
+            snapshot = std::make_shared<EntrySnapshot>();
+            for (const auto &[path, entry] : shard->entries) {
+                snapshot->emplace(path, std::make_shared<const CapioCLEntry>(entry));
+            }
+        }
+        std::atomic_store(&shard->snapshot, std::shared_ptr<const EntrySnapshot>(snapshot));
     }
-    std::lock_guard lg(_shared_mutex);
-    this->_newFile(path);
-
-    CapioCLEntry &entry     = _capio_cl_entries.at(path);
-    entry.producers         = producers;
-    entry.consumers         = consumers;
-    entry.commit_rule       = commit_rule;
-    entry.fire_rule         = fire_rule;
-    entry.permanent         = permanent;
-    entry.excluded          = exclude;
-    entry.file_dependencies = dependencies;
-}
-void capiocl::engine::Engine::add(const std::filesystem::path &path,
-                                  const CapioCLEntry &entry) const {
-
-    std::lock_guard lg(_shared_mutex);
 
-    if (_capio_cl_entries.find(path) == _capio_cl_entries.end()) {
-        _capio_cl_entries[path] = entry;
+    if (enabled) {
+        this->_publish_rules();
     } else {
-        _capio_cl_entries[path] += entry;
+        std::atomic_store(&_rules_snapshot, std::shared_ptr<const RulesSnapshot>());
     }
 }
 
-void capiocl::engine::Engine::newFile(const std::filesystem::path &path) const {
-    std::lock_guard lg(_shared_mutex);
-    this->_newFile(path);
+bool capiocl::engine::Engine::_materializes() const {
+    return _materialize_reads && !_snapshot_reads;
 }
 
-long capiocl::engine::Engine::getDirectoryFileCount(const std::filesystem::path &path) const {
+template <typename F> bool capiocl::engine::Engine::_find(const std::string &path, F &&fn) const {
+    const auto lookup = [&] {
+        if (_snapshot_reads) {
+            const auto find = [&](const EntrySnapshot &snapshot) {
+                if (const auto itm = snapshot.find(path); itm != snapshot.end()) {
+                    fn(*itm->second);
+                    return true;
+                }
+                return false;
+            };
 
-    if (path.empty()) {
-        return 0;
-    }
-    {
-        shared_lock_guard slg(_shared_mutex);
-        if (const auto itm = _capio_cl_entries.find(path); itm != _capio_cl_entries.end()) {
-            return itm->second.directory_children_count;
+            if (PatternIndex::isPattern(path)) {
+                return find(std::atomic_load(&_rules_snapshot)->rules);
+            }
+            return find(*std::atomic_load(&_shard(path).snapshot));
         }
+
+        if (PatternIndex::isPattern(path)) {
+            shared_lock_guard slg(_rules_mutex, _stats);
+            if (const auto itm = _rules.find(path); itm != _rules.end()) {
+                fn(std::as_const(itm->second));
+                return true;
+            }
+            return false;
+        }
+
+        const auto &shard = _shard(path);
+        shared_lock_guard slg(shard.mutex, _stats);
+        if (const auto itm = shard.entries.find(path); itm != shard.entries.end()) {
+            fn(itm->second);
+            return true;
+        }
+        return false;
+    };
+
+    auto found = lookup();
+    if (!found && this->_fault(path)) {
+        found = lookup();
     }
-    this->_newFile(path);
-    return getDirectoryFileCount(path);
+    _stats.add(found ? StatsCollector::LOOKUP_HITS : StatsCollector::LOOKUP_MISSES);
+    return found;
 }
 
-void capiocl::engine::Engine::addProducer(const std::filesystem::path &path,
-                                          std::string &producer) {
-
-    if (path.empty()) {
-        return;
+template <typename F>
+bool capiocl::engine::Engine::_find(const EntryHandle &handle, F &&fn) const {
+    if (handle.empty()) {
+        return false;
     }
 
-    {
-        std::lock_guard lg(_shared_mutex);
+    if (handle._shard == EntryHandle::RULES) {
+        shared_lock_guard slg(_rules_mutex, _stats);
+        if (handle._generation != _rules_generation) {
+            return false;
+        }
+        fn(*handle._entry);
+        return true;
+    }
 
-        producer.erase(remove_if(producer.begin(), producer.end(), isspace), producer.end());
+    if (handle._shard >= _shards.size()) {
+        return false;
+    }
+    const auto &shard = *_shards[handle._shard];
+    shared_lock_guard slg(shard.mutex, _stats);
+    if (handle._generation != shard.generation) {
+        return false;
+    }
+    fn(*handle._entry);
+    return true;
+}
 
-        if (const auto itm = _capio_cl_entries.find(path); itm != _capio_cl_entries.end()) {
-            auto &vec = itm->second.producers;
-            if (std::find(vec.begin(), vec.end(), producer) == vec.end()) {
-                vec.emplace_back(producer);
-                return;
-            } else {
-                return;
-            }
+template <typename F>
+bool capiocl::engine::Engine::_modify(const std::string &path, F &&fn) const {
+    if (PatternIndex::isPattern(path)) {
+        exclusive_lock_guard lg(_rules_mutex, _stats);
+        if (const auto itm = _rules.find(path); itm != _rules.end()) {
+            fn(itm->second);
+            this->_publish_rules();
+            return true;
         }
+        return false;
     }
 
-    this->newFile(path);
-    this->addProducer(path, producer);
+    const auto modify = [&] {
+        auto &shard = _shard(path);
+        exclusive_lock_guard lg(shard.mutex, _stats);
+        if (const auto itm = shard.entries.find(path); itm != shard.entries.end()) {
+            fn(itm->second);
+            this->_publish(shard, path);
+            return true;
+        }
+        return false;
+    };
+    return modify() || (this->_fault(path) && modify());
 }
 
-void capiocl::engine::Engine::addConsumer(const std::filesystem::path &path,
-                                          std::string &consumer) {
-    if (path.empty()) {
+template <typename F>
+void capiocl::engine::Engine::_read(const std::filesystem::path &path, F &&fn) const {
+    StatsCollector::Timer timer(_stats, StatsCollector::QUERY);
+    if (this->_find(path, fn)) {
         return;
     }
 
-    {
-        std::lock_guard lg(_shared_mutex);
-        consumer.erase(remove_if(consumer.begin(), consumer.end(), isspace), consumer.end());
-        if (const auto itm = _capio_cl_entries.find(path); itm != _capio_cl_entries.end()) {
-            auto &vec = itm->second.consumers;
-            if (std::find(vec.begin(), vec.end(), consumer) == vec.end()) {
-                vec.emplace_back(consumer);
-            }
+    if (this->_materializes()) {
+        this->_newFile(path);
+        this->_find(path, fn);
+        return;
+    }
+
+    _avoided_entries.fetch_add(1, std::memory_order_relaxed);
+    const auto answer = [&](const CapioCLEntry *rule) {
+        // The rule itself is the default entry, unless the storage policy must be overridden
+        if (rule != nullptr && (rule->store_in_memory || !store_all_in_memory)) {
+            fn(*rule);
             return;
         }
-    }
+        CapioCLEntry entry;
+        entry.store_in_memory = store_all_in_memory;
+        if (rule != nullptr) {
+            entry                 = *rule;
+            entry.store_in_memory = true;
+        }
+        fn(std::as_const(entry));
+    };
 
-    this->newFile(path);
-    this->addConsumer(path, consumer);
+    if (_snapshot_reads) {
+        const auto snapshot = std::atomic_load(&_rules_snapshot);
+        const auto matchKey = snapshot->patterns.longestMatch(path);
+        answer(matchKey == nullptr ? nullptr : snapshot->rules.at(*matchKey).get());
+        return;
+    }
+    shared_lock_guard slg(_rules_mutex, _stats);
+    const auto matchKey = _patterns.longestMatch(path);
+    answer(matchKey == nullptr ? nullptr : &_rules.at(*matchKey));
 }
 
-void capiocl::engine::Engine::addFileDependency(const std::filesystem::path &path,
-                                                std::filesystem::path &file_dependency) {
-    if (path.empty()) {
-        return;
+template <typename F>
+void capiocl::engine::Engine::_write(const std::filesystem::path &path, F &&fn) const {
+    StatsCollector::Timer timer(_stats, StatsCollector::UPDATE);
+    if (!this->_modify(path, fn)) {
+        this->_newFile(path);
+        this->_modify(path, fn);
     }
+}
 
+template <typename F> void capiocl::engine::Engine::_for_each(F &&fn) const {
+    this->_drain();
     {
-        std::lock_guard lg(_shared_mutex);
-        if (const auto itm = _capio_cl_entries.find(path); itm != _capio_cl_entries.end()) {
-            auto &vec = itm->second.file_dependencies;
-            if (std::find(vec.begin(), vec.end(), file_dependency) == vec.end()) {
-                vec.emplace_back(file_dependency);
-            }
-            return;
+        shared_lock_guard slg(_rules_mutex, _stats);
+        for (const auto &[path, entry] : _rules) {
+            fn(path, entry);
+        }
+    }
+    for (const auto &shard : _shards) {
+        shared_lock_guard slg(shard->mutex, _stats);
+        for (const auto &[path, entry] : shard->entries) {
+            fn(path, entry);
         }
     }
-    this->newFile(path);
-    this->setCommitRule(path, commitRules::ON_FILE);
-    this->addFileDependency(path, file_dependency);
 }
 
-void capiocl::engine::Engine::setCommitRule(const std::filesystem::path &path,
-                                            const std::string &commit_rule) {
-    if (path.empty()) {
-        return;
+bool capiocl::engine::Engine::_insert(const std::string &path, CapioCLEntry entry) const {
+    if (PatternIndex::isPattern(path)) {
+        exclusive_lock_guard lg(_rules_mutex, _stats);
+        if (!_rules.try_emplace(path, std::move(entry)).second) {
+            return false;
+        }
+        _patterns.insert(path);
+        this->_publish_rules();
+        return true;
     }
 
-    const auto commit = commitRules::sanitize(commit_rule);
-    {
-        std::lock_guard lg(_shared_mutex);
-        if (const auto itm = _capio_cl_entries.find(path); itm != _capio_cl_entries.end()) {
-            itm->second.commit_rule = commit;
-            return;
+    auto &shard = _shard(path);
+    exclusive_lock_guard lg(shard.mutex, _stats);
+    if (!shard.entries.try_emplace(path, std::move(entry)).second) {
+        return false;
+    }
+    this->_publish(shard, path);
+    return true;
+}
+
+template <typename F>
+bool capiocl::engine::Engine::_any_rule(const std::string &path, F &&pred) const {
+    if (_snapshot_reads) {
+        const auto snapshot = std::atomic_load(&_rules_snapshot);
+        for (const auto id : snapshot->patterns.match(path)) {
+            if (pred(*snapshot->rules.at(snapshot->patterns.pattern(id)))) {
+                return true;
+            }
         }
+        return false;
     }
-    {
-        std::lock_guard lg(_shared_mutex);
-        this->_newFile(path);
+
+    shared_lock_guard slg(_rules_mutex, _stats);
+    for (const auto id : _patterns.match(path)) {
+        if (pred(std::as_const(_rules.at(_patterns.pattern(id))))) {
+            return true;
+        }
     }
-    this->setCommitRule(path, commit);
+    return false;
 }
 
-std::string capiocl::engine::Engine::getCommitRule(const std::filesystem::path &path) const {
-    if (path.empty()) {
-        return commitRules::ON_TERMINATION;
-    }
+std::unordered_map<std::string, capiocl::engine::CapioCLEntry>
+capiocl::engine::Engine::_entries() const {
+    std::unordered_map<std::string, CapioCLEntry> entries;
+    _for_each([&](const std::string &path, const CapioCLEntry &entry) { entries[path] = entry; });
+    return entries;
+}
 
-    {
-        shared_lock_guard slg(_shared_mutex);
+capiocl::engine::CapioCLEntry
+capiocl::engine::Engine::_template(const std::filesystem::path &path) const {
+    return _template(path, _rules, _patterns, store_all_in_memory);
+}
+
+capiocl::engine::CapioCLEntry
+capiocl::engine::Engine::_template(const std::filesystem::path &path,
+                                   const std::unordered_map<std::string, CapioCLEntry> &rules,
+                                   const PatternIndex &patterns, const bool store_all_in_memory) {
+    CapioCLEntry entry;
+    entry.commit_rule = commitRules::COMMIT_RULE::ON_TERMINATION;
+    entry.fire_rule   = fireRules::FIRE_RULE::UPDATE;
+
+    if (const auto matchKey = patterns.longestMatch(path); matchKey != nullptr) {
+        const auto &data = rules.at(*matchKey);
 
-        if (const auto itm = _capio_cl_entries.find(path); itm != _capio_cl_entries.end()) {
-            return itm->second.commit_rule;
+        // Duplicate CapioCLEntry object and register it to new resolved path
+        // This is achieved by not using & operator
+        entry = data;
+        if (store_all_in_memory) {
+            entry.store_in_memory = true;
+        } else {
+            entry.store_in_memory = data.store_in_memory;
         }
+    } else {
+        entry.store_in_memory = store_all_in_memory;
+    }
+    return entry;
+}
+
+void capiocl::engine::Engine::_newFile(const std::filesystem::path &path) const {
+    if (path.empty() || this->_find(path, [](const CapioCLEntry &) {})) {
+        return;
     }
 
+    CapioCLEntry entry;
     {
-        std::lock_guard lg(_shared_mutex);
+        shared_lock_guard slg(_rules_mutex, _stats);
+        entry = this->_template(path);
+    }
+
+    const auto dependencies = entry.file_dependencies;
+    if (this->_insert(path, std::move(entry))) {
+        _stats.add(StatsCollector::MATERIALIZATIONS);
+        this->compute_directory_entry_count(path);
+        this->_inherit(path, dependencies);
+    }
+}
+
+void capiocl::engine::Engine::_missed(const std::filesystem::path &path) const {
+    if (this->_materializes()) {
         this->_newFile(path);
+    } else if (!path.empty() && !this->_find(path, [](const CapioCLEntry &) {})) {
+        _avoided_entries.fetch_add(1, std::memory_order_relaxed);
     }
-    return getCommitRule(path);
 }
 
-std::string capiocl::engine::Engine::getFireRule(const std::filesystem::path &path) const {
-    if (path.empty()) {
-        return fireRules::NO_UPDATE;
+bool capiocl::engine::Engine::_fault(const std::string &path) const {
+    if (_image == nullptr || PatternIndex::isPattern(path)) {
+        return false;
     }
 
-    {
-        shared_lock_guard slg(_shared_mutex);
+    const auto position = _image->find(path);
+    if (position == snapshot::Image::NONE) {
+        return false;
+    }
+    this->_claim(position);
+    return true;
+}
 
-        if (const auto itm = _capio_cl_entries.find(path); itm != _capio_cl_entries.end()) {
-            return itm->second.fire_rule;
-        }
+void capiocl::engine::Engine::_claim(const std::size_t position) const {
+    // A claimed record is in its shard, or is being moved there under the shard lock
+    if (_image->claimed(position)) {
+        return;
     }
 
-    {
-        std::lock_guard lg(_shared_mutex);
-        this->_newFile(path);
+    const std::string path(_image->path(position));
+    auto entry = _image->entry(position);
+    auto &shard = _shard(path);
+    exclusive_lock_guard lg(shard.mutex, _stats);
+    if (!_image->claim(position)) {
+        return;
     }
-    return getFireRule(path);
+    if (store_all_in_memory) {
+        entry.store_in_memory = true;
+    }
+    if (const auto [itm, inserted] = shard.entries.try_emplace(path, std::move(entry)); !inserted) {
+        itm->second += entry;
+    }
+    this->_publish(shard, path);
 }
 
-void capiocl::engine::Engine::setFireRule(const std::filesystem::path &path,
-                                          const std::string &fire_rule) {
-    if (path.empty()) {
+void capiocl::engine::Engine::_drain() const {
+    if (_image == nullptr || _image->unclaimed() == 0) {
+        return;
+    }
+    for (auto position = _image->rules(); position < _image->size(); position++) {
+        this->_claim(position);
+    }
+}
+
+void capiocl::engine::Engine::_load_tree() const {
+    if (!_tree_pending.load(std::memory_order_acquire)) {
         return;
     }
 
-    const auto fire = fireRules::sanitize(fire_rule);
+    std::lock_guard lg(_tree_mutex);
+    if (_tree_pending.load(std::memory_order_relaxed)) {
+        for (auto position = _image->rules(); position < _image->size(); position++) {
+            _tree.insert(std::string(_image->path(position)));
+        }
+        _tree_pending.store(false, std::memory_order_release);
+    }
+}
+
+void capiocl::engine::Engine::_load_graph() const {
+    if (!_graph_pending.load(std::memory_order_acquire)) {
+        return;
+    }
 
+    std::vector<std::string> ready, unknown;
     {
-        std::lock_guard lg(_shared_mutex);
-        if (const auto itm = _capio_cl_entries.find(path); itm != _capio_cl_entries.end()) {
-            itm->second.fire_rule = fire;
+        std::lock_guard lg(_graph_mutex);
+        if (!_graph_pending.load(std::memory_order_relaxed)) {
             return;
         }
-        this->_newFile(path);
+        for (auto position = _image->rules(); position < _image->size(); position++) {
+            const auto dependencies = _image->dependencies(position);
+            if (dependencies.empty()) {
+                continue;
+            }
+            try {
+                if (std::string target(_image->path(position));
+                    _graph.add(target, {dependencies.begin(), dependencies.end()})) {
+                    ready.push_back(std::move(target));
+                }
+            } catch (const std::invalid_argument &e) {
+                printer::print(printer::CLI_LEVEL_WARNING, e.what());
+            }
+        }
+        unknown = _graph.takeUnknown();
+        _graph_pending.store(false, std::memory_order_release);
     }
 
-    setFireRule(path, fire);
+    // Dependencies may have been committed by a previous run, before the snapshot was opened
+    auto next = this->_settle(unknown);
+    ready.insert(ready.end(), next.begin(), next.end());
+    this->_cascade(std::move(ready));
 }
 
-bool capiocl::engine::Engine::isFirable(const std::filesystem::path &path) const {
-    if (path.empty()) {
-        return true;
+void capiocl::engine::Engine::compute_directory_entry_count(
+    const std::filesystem::path &path) const {
+    if (PatternIndex::isPattern(path.native())) {
+        return;
+    }
+
+    this->_load_tree();
+    DirectoryTree::Counters counters;
+    {
+        std::lock_guard lg(_tree_mutex);
+        counters = _tree.insert(path);
+    }
+
+    // Counters only grow while entries are added: concurrent updates of the same directory may
+    // be applied in any order, as long as the largest value is kept
+    const auto update = [](const std::size_t count) {
+        return [count = static_cast<long>(count)](CapioCLEntry &entry) {
+            if (entry.enable_directory_count_update) {
+                entry.directory_children_count = std::max(entry.directory_children_count, count);
+                entry.is_file                  = false;
+            }
+        };
+    };
+
+    if (counters.children > 0) {
+        this->_modify(path, update(counters.children));
+    }
+    if (const auto parent = path.parent_path(); !parent.empty() && parent != path) {
+        this->_modify(parent, update(counters.siblings));
+    }
+}
+
+bool capiocl::engine::Engine::_link(const std::filesystem::path &path,
+                                    const std::vector<std::filesystem::path> &dependencies,
+                                    const bool replace) const {
+    if (PatternIndex::isPattern(path.native())) {
+        return false;
     }
 
+    this->_load_graph();
+    bool ready = false;
+    std::vector<std::string> unknown;
     {
-        shared_lock_guard slg(_shared_mutex);
-        if (const auto itm = _capio_cl_entries.find(path); itm != _capio_cl_entries.end()) {
-            return itm->second.fire_rule == fireRules::NO_UPDATE;
+        std::lock_guard lg(_graph_mutex);
+        ready   = replace ? _graph.set(path, dependencies) : _graph.add(path, dependencies);
+        unknown = _graph.takeUnknown();
+    }
+
+    // Dependencies new to the graph have @p path as only dependent, so they can only unblock it
+    const auto next = this->_settle(unknown);
+    return ready || std::find(next.begin(), next.end(), path.native()) != next.end();
+}
+
+void capiocl::engine::Engine::_inherit(
+    const std::filesystem::path &path,
+    const std::vector<std::filesystem::path> &dependencies) const {
+    if (dependencies.empty()) {
+        return;
+    }
+
+    try {
+        // The dependencies may have been committed before the entry was created
+        if (this->_link(path, dependencies, false)) {
+            this->_cascade({path.native()});
         }
+    } catch (const std::invalid_argument &e) {
+        printer::print(printer::CLI_LEVEL_WARNING, e.what());
     }
+}
+
+bool capiocl::engine::Engine::contains(const std::filesystem::path &file) const {
+    return this->_find(file, [](const CapioCLEntry &) {}) ||
+           this->_any_rule(file, [](const CapioCLEntry &) { return true; });
+}
 
+size_t capiocl::engine::Engine::size() const {
+    size_t size = 0;
     {
-        std::lock_guard lg(_shared_mutex);
-        this->_newFile(path);
+        shared_lock_guard slg(_rules_mutex, _stats);
+        size += _rules.size();
+    }
+    for (const auto &shard : _shards) {
+        shared_lock_guard slg(shard->mutex, _stats);
+        size += shard->entries.size();
     }
-    return isFirable(path);
+    return size + (_image == nullptr ? 0 : _image->unclaimed());
 }
 
-void capiocl::engine::Engine::setPermanent(const std::filesystem::path &path, bool value) {
+void capiocl::engine::Engine::add(std::filesystem::path &path, std::vector<std::string> &producers,
+                                  std::vector<std::string> &consumers,
+                                  const std::string &commit_rule, const std::string &fire_rule,
+                                  bool permanent, bool exclude,
+                                  std::vector<std::filesystem::path> &dependencies) {
+
     if (path.empty()) {
         return;
     }
 
+    const auto commit = commitRules::fromString(commit_rule);
+    const auto fire   = fireRules::fromString(fire_rule);
+    this->_newFile(path);
+    const bool ready = this->_link(path, dependencies, true);
+    this->_write(path, [&](CapioCLEntry &entry) {
+        entry.producers         = producers;
+        entry.consumers         = consumers;
+        entry.commit_rule       = commit;
+        entry.fire_rule         = fire;
+        entry.permanent         = permanent;
+        entry.excluded          = exclude;
+        entry.file_dependencies = dependencies;
+    });
+    if (ready) {
+        this->_cascade({path.native()});
+    }
+}
+void capiocl::engine::Engine::add(const std::filesystem::path &path,
+                                  const CapioCLEntry &entry) const {
+
+    const bool ready = this->_link(path, entry.file_dependencies, false);
+
+    const auto cascade = [&] {
+        if (ready) {
+            this->_cascade({path.native()});
+        }
+    };
+    const auto record = [&](const CapioCLEntry &itm) {
+        for (auto &delta : Delta::fromEntry(path, itm)) {
+            this->_record(std::move(delta));
+        }
+    };
+    const auto merge = [&](CapioCLEntry &itm) {
+        CapioCLEntry previous = itm;
+        itm += entry;
+        if (previous != itm) {
+            record(itm);
+        }
+    };
+    if (this->_modify(path, merge)) {
+        cascade();
+        return;
+    }
+    if (this->_insert(path, entry)) {
+        record(entry);
+        this->compute_directory_entry_count(path);
+    } else {
+        this->_modify(path, merge);
+    }
+    cascade();
+}
+
+void capiocl::engine::Engine::_observe(const std::filesystem::path &path) const {
+    const auto parent = path.parent_path();
+    if (parent.empty() || parent == path) {
+        return;
+    }
+
+    long threshold = 0;
+    this->_find(parent, [&](const CapioCLEntry &entry) {
+        if (entry.commit_rule == commitRules::COMMIT_RULE::ON_N_FILES &&
+            !entry.enable_directory_count_update) {
+            threshold = std::max(entry.directory_children_count, 1L);
+        }
+    });
+    if (threshold == 0) {
+        return;
+    }
+
+    auto &shard = _shard(parent.native());
+    {
+        std::lock_guard lg(shard.observed_mutex);
+        if (!shard.observed[parent.native()].insert(path.native()).second) {
+            return;
+        }
+    }
+
+    // Same as notifyClose(): the counter of the directory is created once, then incremented
+    // while holding the lock shared
+    long files = 0;
+    {
+        shared_lock_guard slg(shard.files_mutex);
+        if (const auto itm = shard.files.find(parent.native()); itm != shard.files.end()) {
+            files = itm->second.fetch_add(1, std::memory_order_relaxed) + 1;
+        }
+    }
+    if (files == 0) {
+        std::lock_guard lg(shard.files_mutex);
+        files = shard.files.try_emplace(parent.native(), 0).first->second.fetch_add(1) + 1;
+    }
+
+    if (files == threshold) {
+        this->setCommitted(parent);
+    }
+}
+
+void capiocl::engine::Engine::_unobserve(const std::filesystem::path &path) const {
+    // The files counted in a removed directory are counted again if it is created anew
+    {
+        auto &shard = _shard(path.native());
+        std::lock_guard lg(shard.observed_mutex);
+        shard.observed.erase(path.native());
+    }
+
+    const auto parent = path.parent_path();
+    if (parent.empty() || parent == path) {
+        return;
+    }
+
+    auto &shard  = _shard(parent.native());
+    bool counted = false;
+    {
+        std::lock_guard lg(shard.observed_mutex);
+        if (const auto itm = shard.observed.find(parent.native()); itm != shard.observed.end()) {
+            counted = itm->second.erase(path.native()) > 0;
+            if (itm->second.empty()) {
+                shard.observed.erase(itm);
+            }
+        }
+    }
+    if (counted) {
+        shared_lock_guard slg(shard.files_mutex);
+        if (const auto itm = shard.files.find(parent.native()); itm != shard.files.end()) {
+            itm->second.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+std::uint64_t capiocl::engine::Engine::_record(Delta delta) const {
+    std::lock_guard lg(_changes_mutex);
+    delta.version = ++_version;
+    auto key      = delta.key();
+    if (delta.operation == Delta::ERASE) {
+        // Peers replaying the log must not recreate the entry from the changes before its removal
+        for (auto itm = _latest.lower_bound(key);
+             itm != _latest.end() && itm->first.compare(0, key.size(), key) == 0;) {
+            _changes.erase(itm->second);
+            itm = _latest.erase(itm);
+        }
+    }
+    if (const auto itm = _latest.find(key); itm != _latest.end()) {
+        _changes.erase(itm->second);
+        itm->second = delta.version;
+    } else {
+        _latest.emplace(std::move(key), delta.version);
+    }
+    return _changes.emplace(delta.version, std::move(delta)).first->first;
+}
+
+void capiocl::engine::Engine::newFile(const std::filesystem::path &path) const {
+    StatsCollector::Timer timer(_stats, StatsCollector::NEW_FILE);
+    if (path.empty()) {
+        return;
+    }
+
+    this->_newFile(path);
+    this->_observe(path);
+}
+
+long capiocl::engine::Engine::getDirectoryFileCount(const std::filesystem::path &path) const {
+
+    if (path.empty()) {
+        return 0;
+    }
+
+    long count = 0;
+    this->_read(path, [&](const CapioCLEntry &entry) { count = entry.directory_children_count; });
+    return count;
+}
+
+long capiocl::engine::Engine::getDirectoryFileCount(const EntryHandle &handle) const {
+    long count = 0;
+    if (!this->_find(handle, [&](const CapioCLEntry &entry) {
+            count = entry.directory_children_count;
+        })) {
+        return this->getDirectoryFileCount(handle.path());
+    }
+    return count;
+}
+
+void capiocl::engine::Engine::addProducer(const std::filesystem::path &path,
+                                          std::string &producer) {
+
+    if (path.empty()) {
+        return;
+    }
+
+    producer.erase(remove_if(producer.begin(), producer.end(), isspace), producer.end());
+    const auto app = AppInterner::intern(producer);
+    this->_write(path, [app](CapioCLEntry &entry) { entry.producers.insert(app); });
+}
+
+void capiocl::engine::Engine::addConsumer(const std::filesystem::path &path,
+                                          std::string &consumer) {
+    if (path.empty()) {
+        return;
+    }
+
+    consumer.erase(remove_if(consumer.begin(), consumer.end(), isspace), consumer.end());
+    const auto app = AppInterner::intern(consumer);
+    this->_write(path, [app](CapioCLEntry &entry) { entry.consumers.insert(app); });
+}
+
+void capiocl::engine::Engine::addFileDependency(const std::filesystem::path &path,
+                                                std::filesystem::path &file_dependency) {
+    if (path.empty()) {
+        return;
+    }
+
+    if (!this->_find(path, [](const CapioCLEntry &) {})) {
+        this->_newFile(path);
+        this->setCommitRule(path, commitRules::COMMIT_RULE::ON_FILE);
+    }
+
+    const bool ready = this->_link(path, {file_dependency}, false);
+    this->_modify(path, [&](CapioCLEntry &entry) {
+        auto &vec = entry.file_dependencies;
+        if (std::find(vec.begin(), vec.end(), file_dependency) == vec.end()) {
+            vec.emplace_back(file_dependency);
+        }
+    });
+    if (ready) {
+        this->_cascade({path.native()});
+    }
+}
+
+void capiocl::engine::Engine::setCommitRule(const std::filesystem::path &path,
+                                            const std::string &commit_rule) {
+    if (path.empty()) {
+        return;
+    }
+
+    this->setCommitRule(path, commitRules::fromString(commit_rule));
+}
+
+void capiocl::engine::Engine::setCommitRule(const std::filesystem::path &path,
+                                            const commitRules::COMMIT_RULE commit_rule) {
+    if (path.empty()) {
+        return;
+    }
+
+    this->_write(path, [&](CapioCLEntry &entry) { entry.commit_rule = commit_rule; });
+}
+
+std::string capiocl::engine::Engine::getCommitRule(const std::filesystem::path &path) const {
+    return commitRules::toString(this->getCommitRuleType(path));
+}
+
+std::string capiocl::engine::Engine::getCommitRule(const EntryHandle &handle) const {
+    return commitRules::toString(this->getCommitRuleType(handle));
+}
+
+capiocl::commitRules::COMMIT_RULE
+capiocl::engine::Engine::getCommitRuleType(const std::filesystem::path &path) const {
+    if (path.empty()) {
+        return commitRules::COMMIT_RULE::ON_TERMINATION;
+    }
+
+    auto commit_rule = commitRules::COMMIT_RULE::ON_TERMINATION;
+    this->_read(path, [&](const CapioCLEntry &entry) { commit_rule = entry.commit_rule; });
+    return commit_rule;
+}
+
+capiocl::commitRules::COMMIT_RULE
+capiocl::engine::Engine::getCommitRuleType(const EntryHandle &handle) const {
+    auto commit_rule = commitRules::COMMIT_RULE::ON_TERMINATION;
+    if (!this->_find(handle, [&](const CapioCLEntry &entry) { commit_rule = entry.commit_rule; })) {
+        return this->getCommitRuleType(handle.path());
+    }
+    return commit_rule;
+}
+
+std::string capiocl::engine::Engine::getFireRule(const std::filesystem::path &path) const {
+    return fireRules::toString(this->getFireRuleType(path));
+}
+
+std::string capiocl::engine::Engine::getFireRule(const EntryHandle &handle) const {
+    return fireRules::toString(this->getFireRuleType(handle));
+}
+
+capiocl::fireRules::FIRE_RULE
+capiocl::engine::Engine::getFireRuleType(const std::filesystem::path &path) const {
+    if (path.empty()) {
+        return fireRules::FIRE_RULE::NO_UPDATE;
+    }
+
+    auto fire_rule = fireRules::FIRE_RULE::UPDATE;
+    this->_read(path, [&](const CapioCLEntry &entry) { fire_rule = entry.fire_rule; });
+    return fire_rule;
+}
+
+capiocl::fireRules::FIRE_RULE
+capiocl::engine::Engine::getFireRuleType(const EntryHandle &handle) const {
+    auto fire_rule = fireRules::FIRE_RULE::UPDATE;
+    if (!this->_find(handle, [&](const CapioCLEntry &entry) { fire_rule = entry.fire_rule; })) {
+        return this->getFireRuleType(handle.path());
+    }
+    return fire_rule;
+}
+
+void capiocl::engine::Engine::setFireRule(const std::filesystem::path &path,
+                                          const std::string &fire_rule) {
+    if (path.empty()) {
+        return;
+    }
+
+    this->setFireRule(path, fireRules::fromString(fire_rule));
+}
+
+void capiocl::engine::Engine::setFireRule(const std::filesystem::path &path,
+                                          const fireRules::FIRE_RULE fire_rule) {
+    if (path.empty()) {
+        return;
+    }
+
+    this->_write(path, [&](CapioCLEntry &entry) { entry.fire_rule = fire_rule; });
+}
+
+bool capiocl::engine::Engine::isFirable(const std::filesystem::path &path) const {
+    if (path.empty()) {
+        return true;
+    }
+
+    bool firable = false;
+    this->_read(path, [&](const CapioCLEntry &entry) {
+        firable = entry.fire_rule == fireRules::FIRE_RULE::NO_UPDATE;
+    });
+    return firable;
+}
+
+bool capiocl::engine::Engine::isFirable(const EntryHandle &handle) const {
+    bool firable = false;
+    if (!this->_find(handle, [&](const CapioCLEntry &entry) {
+            firable = entry.fire_rule == fireRules::FIRE_RULE::NO_UPDATE;
+        })) {
+        return this->isFirable(handle.path());
+    }
+    return firable;
+}
+
+void capiocl::engine::Engine::setPermanent(const std::filesystem::path &path, bool value) {
+    if (path.empty()) {
+        return;
+    }
+
+    this->_write(path, [&](CapioCLEntry &entry) { entry.permanent = value; });
+}
+
+bool capiocl::engine::Engine::isPermanent(const std::filesystem::path &path) const {
+    if (path.empty()) {
+        return true;
+    }
+
+    bool permanent = false;
+    this->_read(path, [&](const CapioCLEntry &entry) { permanent = entry.permanent; });
+    return permanent;
+}
+
+bool capiocl::engine::Engine::isPermanent(const EntryHandle &handle) const {
+    bool permanent = false;
+    if (!this->_find(handle, [&](const CapioCLEntry &entry) { permanent = entry.permanent; })) {
+        return this->isPermanent(handle.path());
+    }
+    return permanent;
+}
+
+bool capiocl::engine::Engine::isCommitted(const std::filesystem::path &path) const {
+    return monitor.isCommitted(path);
+}
+
+void capiocl::engine::Engine::setCommitted(const std::filesystem::path &path) const {
+    StatsCollector::Timer timer(_stats, StatsCollector::SET_COMMITTED);
+    monitor.setCommitted(path);
+    this->_observe(path);
+
+    this->_load_graph();
+    std::vector<std::string> ready;
+    {
+        std::lock_guard lg(_graph_mutex);
+        ready = _graph.commit(path);
+    }
+    this->_cascade(std::move(ready));
+}
+
+void capiocl::engine::Engine::_cascade(std::vector<std::string> ready) const {
+    // Commit the dependents whose dependencies are all committed, then their own dependents
+    while (!ready.empty()) {
+        const auto target = std::move(ready.back());
+        ready.pop_back();
+
+        bool on_file = false;
+        this->_find(target, [&](const CapioCLEntry &entry) {
+            on_file = entry.commit_rule == commitRules::COMMIT_RULE::ON_FILE;
+        });
+        if (!on_file) {
+            continue;
+        }
+
+        monitor.setCommitted(target);
+        this->_observe(target);
+        std::lock_guard lg(_graph_mutex);
+        const auto next = _graph.commit(target);
+        ready.insert(ready.end(), next.begin(), next.end());
+    }
+}
+
+std::vector<std::string>
+capiocl::engine::Engine::_settle(const std::vector<std::string> &unknown) const {
+    std::vector<std::string> ready;
+    for (const auto &path : unknown) {
+        if (monitor.query(path, true)) {
+            std::lock_guard lg(_graph_mutex);
+            const auto next = _graph.commit(path);
+            ready.insert(ready.end(), next.begin(), next.end());
+        }
+    }
+    return ready;
+}
+
+bool capiocl::engine::Engine::waitForCommit(const std::filesystem::path &path,
+                                            const std::chrono::milliseconds timeout) const {
+    return monitor.waitForCommit(path, timeout);
+}
+
+std::string
+capiocl::engine::Engine::waitForAnyCommit(const std::vector<std::filesystem::path> &paths,
+                                          const std::chrono::milliseconds timeout) const {
+    return monitor.waitForAnyCommit(paths, timeout);
+}
+
+std::future<bool>
+capiocl::engine::Engine::isCommittedAsync(const std::filesystem::path &path) const {
+    return monitor.isCommittedAsync(path);
+}
+
+void capiocl::engine::Engine::onCommitted(
+    const std::filesystem::path &path, std::function<void(const std::string &)> callback) const {
+    monitor.onCommitted(path, std::move(callback));
+}
+
+bool capiocl::engine::Engine::notifyClose(const std::filesystem::path &path) const {
+    StatsCollector::Timer timer(_stats, StatsCollector::NOTIFY_CLOSE);
+    if (path.empty()) {
+        return false;
+    }
+
+    long threshold = 0;
+    this->_read(path, [&](const CapioCLEntry &entry) {
+        if (entry.commit_rule == commitRules::COMMIT_RULE::ON_CLOSE) {
+            threshold = std::max(entry.commit_on_close_count, 1L);
+        }
+    });
+    if (threshold == 0) {
+        return false;
+    }
+
+    auto &shard = _shard(path.native());
+    long closes = 0;
+    {
+        shared_lock_guard slg(shard.closes_mutex);
+        if (const auto itm = shard.closes.find(path.native()); itm != shard.closes.end()) {
+            closes = itm->second.fetch_add(1, std::memory_order_relaxed) + 1;
+        }
+    }
+    if (closes == 0) {
+        // First close of the file: the counter has to be created
+        std::lock_guard lg(shard.closes_mutex);
+        closes = shard.closes.try_emplace(path.native(), 0).first->second.fetch_add(1) + 1;
+    }
+
+    // Only the close reaching the threshold commits, later ones find a larger value
+    if (closes != threshold) {
+        return false;
+    }
+    this->setCommitted(path);
+    return true;
+}
+
+long capiocl::engine::Engine::getCloseCount(const std::filesystem::path &path) const {
+    const auto &shard = _shard(path.native());
+    shared_lock_guard slg(shard.closes_mutex);
+    const auto itm = shard.closes.find(path.native());
+    return itm == shard.closes.end() ? 0 : itm->second.load();
+}
+
+long capiocl::engine::Engine::getObservedFileCount(const std::filesystem::path &path) const {
+    const auto &shard = _shard(path.native());
+    shared_lock_guard slg(shard.files_mutex);
+    const auto itm = shard.files.find(path.native());
+    return itm == shard.files.end() ? 0 : itm->second.load();
+}
+
+std::vector<std::string> capiocl::engine::Engine::getPaths() const {
+    std::vector<std::string> paths;
+    _for_each([&](const std::string &path, const CapioCLEntry &) { paths.push_back(path); });
+    return paths;
+}
+
+void capiocl::engine::Engine::setExclude(const std::filesystem::path &path, const bool value) {
+    if (path.empty()) {
+        return;
+    }
+
+    this->_write(path, [&](CapioCLEntry &entry) { entry.excluded = value; });
+}
+
+void capiocl::engine::Engine::setDirectory(const std::filesystem::path &path) {
+    if (path.empty()) {
+        return;
+    }
+
+    this->_write(path, [](CapioCLEntry &entry) { entry.is_file = false; });
+}
+
+void capiocl::engine::Engine::setFile(const std::filesystem::path &path) {
+    if (path.empty()) {
+        return;
+    }
+
+    this->_write(path, [](CapioCLEntry &entry) { entry.is_file = true; });
+}
+
+bool capiocl::engine::Engine::isFile(const std::filesystem::path &path) const {
+    if (path.empty()) {
+        return true;
+    }
+
+    bool is_file = true;
+    this->_read(path, [&](const CapioCLEntry &entry) { is_file = entry.is_file; });
+    return is_file;
+}
+
+bool capiocl::engine::Engine::isFile(const EntryHandle &handle) const {
+    bool is_file = true;
+    if (!this->_find(handle, [&](const CapioCLEntry &entry) { is_file = entry.is_file; })) {
+        return this->isFile(handle.path());
+    }
+    return is_file;
+}
+
+bool capiocl::engine::Engine::isDirectory(const std::filesystem::path &path) const {
+    if (path.empty()) {
+        return true;
+    }
+    return !isFile(path);
+}
+
+bool capiocl::engine::Engine::isDirectory(const EntryHandle &handle) const {
+    if (handle.empty()) {
+        return true;
+    }
+    return !isFile(handle);
+}
+
+void capiocl::engine::Engine::setCommitedCloseNumber(const std::filesystem::path &path,
+                                                     const long num) {
+    if (path.empty()) {
+        return;
+    }
+
+    this->_write(path, [&](CapioCLEntry &entry) { entry.commit_on_close_count = num; });
+}
+
+void capiocl::engine::Engine::setDirectoryFileCount(const std::filesystem::path &path,
+                                                    const long num) {
+    if (path.empty()) {
+        return;
+    }
+
+    this->_write(path, [&](CapioCLEntry &entry) {
+        entry.directory_children_count      = num;
+        entry.enable_directory_count_update = false;
+        entry.is_file                       = false;
+    });
+}
+
+std::vector<std::string>
+capiocl::engine::Engine::getChildren(const std::filesystem::path &path) const {
+    this->_load_tree();
+    shared_lock_guard slg(_tree_mutex);
+    return _tree.children(path);
+}
+
+void capiocl::engine::Engine::remove(const std::filesystem::path &path) const {
+    StatsCollector::Timer timer(_stats, StatsCollector::REMOVE);
+    this->_remove(path);
+}
+
+std::uint64_t capiocl::engine::Engine::_remove(const std::filesystem::path &path) const {
+    if (PatternIndex::isPattern(path.native())) {
+        exclusive_lock_guard lg(_rules_mutex, _stats);
+        if (_rules.erase(path) > 0) {
+            _patterns.erase(path);
+            _rules_generation++;
+            this->_publish_rules();
+        }
+        return 0;
+    }
+
+    // The record of the snapshot, if any, must not be moved into the shard after the removal
+    this->_fault(path);
+    this->_load_tree();
+    this->_load_graph();
+    this->_unobserve(path);
+    std::uint64_t version = 0;
+    {
+        auto &shard = _shard(path);
+        exclusive_lock_guard lg(shard.mutex, _stats);
+        if (shard.entries.erase(path) == 0) {
+            return 0;
+        }
+        shard.generation++;
+        this->_publish(shard, path);
+        version = this->_record(Delta::erase(path));
+    }
+
+    {
+        auto &shard = _shard(path);
+        std::lock_guard lg(shard.closes_mutex);
+        shard.closes.erase(path);
+    }
+
+    {
+        auto &shard = _shard(path);
+        std::lock_guard lg(shard.files_mutex);
+        shard.files.erase(path);
+    }
+
+    {
+        std::lock_guard lg(_tree_mutex);
+        _tree.erase(path);
+    }
+
+    {
+        std::lock_guard lg(_graph_mutex);
+        _graph.erase(path);
+    }
+    return version;
+}
+
+capiocl::engine::EntryHandle
+capiocl::engine::Engine::resolve(const std::filesystem::path &path) const {
+    EntryHandle handle;
+    if (path.empty()) {
+        return handle;
+    }
+    handle._path = path;
+
+    const auto bind = [&] {
+        if (PatternIndex::isPattern(handle._path)) {
+            shared_lock_guard slg(_rules_mutex, _stats);
+            if (const auto itm = _rules.find(handle._path); itm != _rules.end()) {
+                handle._entry      = &itm->second;
+                handle._shard      = EntryHandle::RULES;
+                handle._generation = _rules_generation;
+            }
+            return;
+        }
+
+        const auto index  = this->_shard_index(handle._path);
+        const auto &shard = *_shards[index];
+        shared_lock_guard slg(shard.mutex, _stats);
+        if (const auto itm = shard.entries.find(handle._path); itm != shard.entries.end()) {
+            handle._entry      = &itm->second;
+            handle._shard      = static_cast<std::uint32_t>(index);
+            handle._generation = shard.generation;
+        }
+    };
+
+    bind();
+    if (handle.empty()) {
+        this->_newFile(path);
+        bind();
+    }
+    return handle;
+}
+
+/// @brief Extract the attributes returned by Engine::queryBatch() from an entry
+static capiocl::engine::EntryAttributes attributes_of(const capiocl::engine::CapioCLEntry &entry) {
+    capiocl::engine::EntryAttributes attributes;
+    attributes.commit_on_close_count   = entry.commit_on_close_count;
+    attributes.file_dependencies_count = entry.file_dependencies.size();
+    attributes.commit_rule             = entry.commit_rule;
+    attributes.fire_rule               = entry.fire_rule;
+    attributes.permanent               = entry.permanent;
+    attributes.excluded                = entry.excluded;
+    attributes.is_file                 = entry.is_file;
+    attributes.store_in_memory         = entry.store_in_memory;
+    return attributes;
+}
+
+std::vector<capiocl::engine::EntryAttributes>
+capiocl::engine::Engine::queryBatch(const std::vector<std::filesystem::path> &paths) const {
+    StatsCollector::Timer timer(_stats, StatsCollector::QUERY_BATCH);
+    std::vector<EntryAttributes> attributes(paths.size());
+
+    // Positions within paths of the literal paths stored by each shard
+    std::vector<std::vector<std::size_t>> groups(_shards.size());
+    for (std::size_t i = 0; i < paths.size(); i++) {
+        if (paths[i].empty()) {
+            continue;
+        }
+        if (PatternIndex::isPattern(paths[i].native())) {
+            // Glob rules are not sharded and rarely queried: resolve them one by one
+            this->_read(paths[i], [&](const CapioCLEntry &entry) {
+                attributes[i] = attributes_of(entry);
+            });
+            continue;
+        }
+        this->_fault(paths[i].native());
+        groups[this->_shard_index(paths[i].native())].push_back(i);
+    }
+
+    // Fill the attributes of the entries that exist, returning the positions of the missing ones
+    const auto read_groups = [&] {
+        std::vector<std::vector<std::size_t>> missing(groups.size());
+        for (std::size_t s = 0; s < groups.size(); s++) {
+            if (groups[s].empty()) {
+                continue;
+            }
+
+            const auto read = [&](const auto &lookup) {
+                for (const auto i : groups[s]) {
+                    if (const CapioCLEntry *entry = lookup(paths[i].native()); entry != nullptr) {
+                        attributes[i] = attributes_of(*entry);
+                    } else {
+                        missing[s].push_back(i);
+                    }
+                }
+            };
+
+            const auto &shard = *_shards[s];
+            if (_snapshot_reads) {
+                const auto snapshot = std::atomic_load(&shard.snapshot);
+                read([&](const std::string &path) -> const CapioCLEntry * {
+                    const auto itm = snapshot->find(path);
+                    return itm == snapshot->end() ? nullptr : itm->second.get();
+                });
+            } else {
+                shared_lock_guard slg(shard.mutex, _stats);
+                read([&](const std::string &path) -> const CapioCLEntry * {
+                    const auto itm = shard.entries.find(path);
+                    return itm == shard.entries.end() ? nullptr : &itm->second;
+                });
+            }
+        }
+        return missing;
+    };
+
+    auto missing = read_groups();
+    std::size_t lookups = 0, misses = 0;
+    for (std::size_t s = 0; s < groups.size(); s++) {
+        lookups += groups[s].size();
+        misses += missing[s].size();
+    }
+    _stats.add(StatsCollector::LOOKUP_HITS, lookups - misses);
+    _stats.add(StatsCollector::LOOKUP_MISSES, misses);
+    if (std::all_of(missing.begin(), missing.end(), [](const auto &m) { return m.empty(); })) {
+        return attributes;
+    }
+
+    // Build the default entries of all the missing paths under a single lock on the rules
+    std::vector<std::vector<CapioCLEntry>> templates(missing.size());
     {
-        std::lock_guard lg(_shared_mutex);
-        if (const auto itm = _capio_cl_entries.find(path); itm != _capio_cl_entries.end()) {
-            itm->second.permanent = value;
-            return;
+        shared_lock_guard slg(_rules_mutex, _stats);
+        for (std::size_t s = 0; s < missing.size(); s++) {
+            for (const auto i : missing[s]) {
+                templates[s].push_back(this->_template(paths[i]));
+                if (!this->_materializes()) {
+                    attributes[i] = attributes_of(templates[s].back());
+                    _avoided_entries.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
         }
-        this->_newFile(path);
     }
-    setPermanent(path, value);
-}
 
-bool capiocl::engine::Engine::isPermanent(const std::filesystem::path &path) const {
-    if (path.empty()) {
-        return true;
+    if (!this->_materializes()) {
+        return attributes;
     }
 
-    {
-        shared_lock_guard slg(_shared_mutex);
-        if (const auto itm = _capio_cl_entries.find(path); itm != _capio_cl_entries.end()) {
-            return itm->second.permanent;
+    std::vector<std::filesystem::path> created;
+    std::vector<std::pair<std::filesystem::path, std::vector<std::filesystem::path>>> inherited;
+    for (std::size_t s = 0; s < missing.size(); s++) {
+        if (missing[s].empty()) {
+            continue;
         }
-    }
 
-    {
-        std::lock_guard lg(_shared_mutex);
-        this->_newFile(path);
+        auto &shard = *_shards[s];
+        std::vector<std::string> inserted;
+        exclusive_lock_guard lg(shard.mutex, _stats);
+        for (std::size_t k = 0; k < missing[s].size(); k++) {
+            const auto &path = paths[missing[s][k]];
+            const auto [itm, emplaced] =
+                shard.entries.try_emplace(path.native(), std::move(templates[s][k]));
+            if (emplaced) {
+                inserted.push_back(path.native());
+                created.push_back(path);
+                if (!itm->second.file_dependencies.empty()) {
+                    inherited.emplace_back(path, itm->second.file_dependencies);
+                }
+            }
+        }
+        this->_publish(shard, inserted);
     }
-    return isPermanent(path);
-}
+    _stats.add(StatsCollector::MATERIALIZATIONS, created.size());
 
-bool capiocl::engine::Engine::isCommitted(const std::filesystem::path &path) const {
-    return monitor.isCommitted(path);
-}
+    for (const auto &path : created) {
+        this->compute_directory_entry_count(path);
+    }
+    for (const auto &[path, dependencies] : inherited) {
+        this->_inherit(path, dependencies);
+    }
 
-void capiocl::engine::Engine::setCommitted(const std::filesystem::path &path) const {
-    monitor.setCommitted(path);
+    // Creating entries may have turned some of the queried paths into directories
+    read_groups();
+    return attributes;
 }
 
-std::vector<std::string> capiocl::engine::Engine::getPaths() const {
-    shared_lock_guard slg(_shared_mutex);
-
-    std::vector<std::string> paths;
-    for (const auto &[k, v] : _capio_cl_entries) {
-        paths.push_back(k);
-    }
-    return paths;
+std::uint64_t capiocl::engine::Engine::getAvoidedEntries() const {
+    return _avoided_entries.load(std::memory_order_relaxed);
 }
 
-void capiocl::engine::Engine::setExclude(const std::filesystem::path &path, const bool value) {
-    if (path.empty()) {
-        return;
-    }
+capiocl::engine::EngineStats capiocl::engine::Engine::stats() const {
+    auto stats = _stats.snapshot();
     {
-        std::lock_guard lg(_shared_mutex);
-        if (const auto itm = _capio_cl_entries.find(path); itm != _capio_cl_entries.end()) {
-            itm->second.excluded = value;
-            return;
-        }
-        this->_newFile(path);
-    }
-    setExclude(path, value);
+        shared_lock_guard slg(_rules_mutex);
+        stats.patterns = _rules.size();
+    }
+    for (const auto &shard : _shards) {
+        shared_lock_guard slg(shard->mutex);
+        stats.entries += shard->entries.size();
+    }
+    stats.entries += _image == nullptr ? 0 : _image->unclaimed();
+    stats.messages_sent   = monitor.messagesSent();
+    stats.datagrams_sent  = monitor.datagramsSent();
+    stats.batches_flushed = monitor.batchesFlushed();
+    return stats;
 }
 
-void capiocl::engine::Engine::setDirectory(const std::filesystem::path &path) {
-    if (path.empty()) {
-        return;
-    }
+std::uint64_t capiocl::engine::Engine::apply(const Delta &delta) const {
+    if (delta.operation != Delta::ERASE &&
+        delta.isList() != (delta.operation == Delta::ADD || delta.operation == Delta::REMOVE)) {
+        throw std::invalid_argument("Delta: operation does not apply to the field of " +
+                                    delta.path);
+    }
+    if (delta.path.empty()) {
+        return this->getVersion();
+    }
+    if (delta.operation == Delta::ERASE) {
+        const auto version = this->_remove(delta.path);
+        return version == 0 ? this->getVersion() : version;
+    }
+
+    // Values depending on the rules, the interner, the tree or the graph are resolved before the
+    // entry is locked: scalar fields are copied from `value`
+    const std::filesystem::path path = delta.path;
+    CapioCLEntry value;
+    AppId app  = 0;
+    bool ready = false;
+    if (delta.operation == Delta::UNSET) {
+        {
+            shared_lock_guard slg(_rules_mutex, _stats);
+            value = this->_template(path);
+        }
+        if (delta.field == Delta::DIRECTORY_FILE_COUNT && value.enable_directory_count_update &&
+            !PatternIndex::isPattern(delta.path)) {
+            this->_load_tree();
+            shared_lock_guard slg(_tree_mutex);
+            value.directory_children_count = std::max(value.directory_children_count,
+                                                      static_cast<long>(_tree.count(path)));
+        }
+    } else if (delta.operation == Delta::SET) {
+        value.commit_on_close_count         = delta.number;
+        value.directory_children_count      = delta.number;
+        value.enable_directory_count_update = false;
+        value.store_in_memory               = delta.number != 0;
+        value.permanent                     = delta.number != 0;
+        value.excluded                      = delta.number != 0;
+        value.is_file                       = delta.field != Delta::DIRECTORY_FILE_COUNT &&
+                                              delta.number != 0;
+        if (delta.field == Delta::COMMIT_RULE) {
+            value.commit_rule = commitRules::fromString(delta.value);
+        } else if (delta.field == Delta::FIRE_RULE) {
+            value.fire_rule = fireRules::fromString(delta.value);
+        }
+    } else if (delta.field == Delta::DEPENDENCY) {
+        this->_load_graph();
+        if (delta.operation == Delta::ADD) {
+            ready = this->_link(path, {delta.value}, false);
+        }
+    } else if (delta.operation == Delta::ADD) {
+        std::string name = delta.value;
+        name.erase(remove_if(name.begin(), name.end(), isspace), name.end());
+        app = AppInterner::intern(name);
+    } else {
+        app = AppInterner::find(delta.value);
+    }
+
+    const auto change = [&](CapioCLEntry &entry) {
+        const bool adding = delta.operation == Delta::ADD;
+        switch (delta.field) {
+        case Delta::COMMIT_RULE:
+            return std::exchange(entry.commit_rule, value.commit_rule) != value.commit_rule;
+        case Delta::FIRE_RULE:
+            return std::exchange(entry.fire_rule, value.fire_rule) != value.fire_rule;
+        case Delta::COMMIT_ON_CLOSE_COUNT:
+            return std::exchange(entry.commit_on_close_count, value.commit_on_close_count) !=
+                   value.commit_on_close_count;
+        case Delta::DIRECTORY_FILE_COUNT: {
+            const bool changed =
+                entry.directory_children_count != value.directory_children_count ||
+                entry.enable_directory_count_update != value.enable_directory_count_update ||
+                entry.is_file != value.is_file;
+            entry.directory_children_count      = value.directory_children_count;
+            entry.enable_directory_count_update = value.enable_directory_count_update;
+            entry.is_file                       = value.is_file;
+            return changed;
+        }
+        case Delta::PERMANENT: {
+            const bool changed = entry.permanent != value.permanent;
+            entry.permanent    = value.permanent;
+            return changed;
+        }
+        case Delta::EXCLUDED: {
+            const bool changed = entry.excluded != value.excluded;
+            entry.excluded     = value.excluded;
+            return changed;
+        }
+        case Delta::STORE_IN_MEMORY: {
+            const bool changed    = entry.store_in_memory != value.store_in_memory;
+            entry.store_in_memory = value.store_in_memory;
+            return changed;
+        }
+        case Delta::IS_FILE: {
+            const bool changed = entry.is_file != value.is_file;
+            entry.is_file      = value.is_file;
+            return changed;
+        }
+        case Delta::PRODUCER:
+            return adding ? entry.producers.insert(app) : entry.producers.erase(app);
+        case Delta::CONSUMER:
+            return adding ? entry.consumers.insert(app) : entry.consumers.erase(app);
+        case Delta::DEPENDENCY: {
+            auto &deps     = entry.file_dependencies;
+            const auto itm = std::find(deps.begin(), deps.end(), delta.value);
+            if (adding == (itm != deps.end())) {
+                return false;
+            }
+            if (adding) {
+                deps.emplace_back(delta.value);
+            } else {
+                deps.erase(itm);
+                // The graph was loaded above, so linking does not need the lock of any entry
+                ready = this->_link(path, deps, true);
+            }
+            return true;
+        }
+        }
+        return false;
+    };
 
-    {
-        std::lock_guard lg(_shared_mutex);
-        if (const auto itm = _capio_cl_entries.find(path); itm != _capio_cl_entries.end()) {
-            itm->second.is_file = false;
-            return;
+    std::uint64_t version = 0;
+    this->_write(path, [&](CapioCLEntry &entry) {
+        if (change(entry)) {
+            version = this->_record(delta);
         }
-        this->_newFile(path);
+    });
+    if (ready) {
+        this->_cascade({path.native()});
     }
-    setDirectory(path);
+    return version == 0 ? this->getVersion() : version;
 }
 
-void capiocl::engine::Engine::setFile(const std::filesystem::path &path) {
-    if (path.empty()) {
-        return;
+std::vector<capiocl::engine::Delta>
+capiocl::engine::Engine::changesSince(const std::uint64_t version) const {
+    std::lock_guard lg(_changes_mutex);
+    std::vector<Delta> changes;
+    for (auto itm = _changes.upper_bound(version); itm != _changes.end(); ++itm) {
+        changes.push_back(itm->second);
     }
+    return changes;
+}
 
-    {
-        std::lock_guard lg(_shared_mutex);
-        if (const auto itm = _capio_cl_entries.find(path); itm != _capio_cl_entries.end()) {
-            itm->second.is_file = true;
-            return;
-        }
-        this->_newFile(path);
-    }
-    setFile(path);
+std::uint64_t capiocl::engine::Engine::getVersion() const {
+    std::lock_guard lg(_changes_mutex);
+    return _version;
 }
 
-bool capiocl::engine::Engine::isFile(const std::filesystem::path &path) const {
-    if (path.empty()) {
-        return true;
-    }
+capiocl::engine::MerkleTree capiocl::engine::Engine::fingerprint() const {
+    this->_drain();
 
-    {
-        shared_lock_guard slg(_shared_mutex);
-        if (const auto itm = _capio_cl_entries.find(path); itm != _capio_cl_entries.end()) {
-            return itm->second.is_file;
+    std::vector<std::uint64_t> leaves(MerkleTree::LEAVES, 0);
+    const auto add = [&leaves](const std::vector<std::pair<std::uint32_t, std::uint64_t>> &digest) {
+        for (const auto &[bucket, hash] : digest) {
+            leaves[bucket] += hash;
         }
-    }
+    };
 
     {
-        std::lock_guard lg(_shared_mutex);
-        this->_newFile(path);
+        shared_lock_guard slg(_rules_mutex, _stats);
+        std::lock_guard lg(_rules_digest_mutex);
+        if (_rules_digest_changes != _rules_changes) {
+            _rules_digest         = _digest(_rules);
+            _rules_digest_changes = _rules_changes;
+        }
+        add(_rules_digest);
+    }
+    for (const auto &shard : _shards) {
+        shared_lock_guard slg(shard->mutex, _stats);
+        std::lock_guard lg(shard->digest_mutex);
+        if (shard->digest_changes != shard->changes) {
+            shard->digest         = _digest(shard->entries);
+            shard->digest_changes = shard->changes;
+        }
+        add(shard->digest);
     }
-    return isPermanent(path);
+    return MerkleTree(leaves);
 }
 
-bool capiocl::engine::Engine::isDirectory(const std::filesystem::path &path) const {
-    if (path.empty()) {
-        return true;
-    }
-    return !isFile(path);
+std::vector<std::string>
+capiocl::engine::Engine::getBucketPaths(const std::size_t bucket) const {
+    std::vector<std::string> paths;
+    _for_each([&](const std::string &path, const CapioCLEntry &) {
+        if (MerkleTree::bucket(path) == bucket) {
+            paths.push_back(path);
+        }
+    });
+    return paths;
 }
 
-void capiocl::engine::Engine::setCommitedCloseNumber(const std::filesystem::path &path,
-                                                     const long num) {
-    if (path.empty()) {
-        return;
-    }
+void capiocl::engine::Engine::saveSnapshot(const std::filesystem::path &path) const {
+    std::vector<std::pair<std::string, CapioCLEntry>> rules, entries;
+    _for_each([&](const std::string &name, const CapioCLEntry &entry) {
+        (PatternIndex::isPattern(name) ? rules : entries).emplace_back(name, entry);
+    });
 
+    // Sorted records make the file independent of the sharding and of the insertion order
+    const auto by_path = [](const auto &lhs, const auto &rhs) { return lhs.first < rhs.first; };
+    std::sort(rules.begin(), rules.end(), by_path);
+    std::sort(entries.begin(), entries.end(), by_path);
+
+    bool store_all;
+    std::string name;
     {
-        std::lock_guard lg(_shared_mutex);
-        if (const auto itm = _capio_cl_entries.find(path); itm != _capio_cl_entries.end()) {
-            itm->second.commit_on_close_count = num;
-            return;
-        }
-        this->_newFile(path);
+        shared_lock_guard slg(_rules_mutex, _stats);
+        store_all = store_all_in_memory;
+        name      = workflow_name;
     }
-    setCommitedCloseNumber(path, num);
+    snapshot::Image::save(path, name, store_all, rules, entries);
 }
 
-void capiocl::engine::Engine::setDirectoryFileCount(const std::filesystem::path &path,
-                                                    const long num) {
-    if (path.empty()) {
-        return;
-    }
+void capiocl::engine::Engine::openSnapshot(const std::filesystem::path &path) {
+    auto image = std::make_shared<const snapshot::Image>(path);
 
-    const auto paths = getPaths();
-    for (const auto &file_paths : paths) {
-        this->setDirectory(file_paths);
-    }
+    // Entries of a previously opened snapshot are moved into the shards before it is released
+    this->_drain();
+    this->_load_tree();
+    this->_load_graph();
 
     {
-        std::lock_guard lg(_shared_mutex);
-        if (const auto itm = _capio_cl_entries.find(path); itm != _capio_cl_entries.end()) {
-            itm->second.directory_children_count      = num;
-            itm->second.enable_directory_count_update = false;
-            return;
+        exclusive_lock_guard lg(_rules_mutex, _stats);
+        workflow_name       = image->workflowName();
+        store_all_in_memory = store_all_in_memory || image->storeAllInMemory();
+        for (std::size_t position = 0; position < image->rules(); position++) {
+            const std::string pattern(image->path(position));
+            if (auto [itm, inserted] = _rules.try_emplace(pattern, image->entry(position));
+                inserted) {
+                _patterns.insert(pattern);
+            } else {
+                itm->second += image->entry(position);
+            }
         }
-        this->_newFile(path);
+        this->_publish_rules();
     }
-    this->setDirectoryFileCount(path, num);
-}
 
-void capiocl::engine::Engine::remove(const std::filesystem::path &path) const {
-    std::lock_guard lg(_shared_mutex);
+    _image = std::move(image);
+    _tree_pending.store(_image->size() > _image->rules(), std::memory_order_release);
+    _graph_pending.store(_image->size() > _image->rules(), std::memory_order_release);
 
-    if (const auto itm = _capio_cl_entries.find(path); itm == _capio_cl_entries.end()) {
-        return;
+    // Entries already in the Engine are merged with their records right away, so that the
+    // records left in the snapshot are exactly the paths the shards do not have
+    std::vector<std::size_t> existing;
+    for (const auto &shard : _shards) {
+        shared_lock_guard slg(shard->mutex, _stats);
+        for (const auto &[name, entry] : shard->entries) {
+            if (const auto position = _image->find(name); position != snapshot::Image::NONE) {
+                existing.push_back(position);
+            }
+        }
     }
-    _capio_cl_entries.erase(path);
+    for (const auto position : existing) {
+        this->_claim(position);
+    }
+}
+
+bool capiocl::engine::Engine::isValid(const EntryHandle &handle) const {
+    return this->_find(handle, [](const CapioCLEntry &) {});
 }
 
 std::vector<std::string>
 capiocl::engine::Engine::getConsumers(const std::filesystem::path &path) const {
-    std::lock_guard lg(_shared_mutex);
+    std::vector<std::string> consumers;
+    this->_find(path, [&](const CapioCLEntry &entry) { consumers = entry.consumers.names(); });
+    return consumers;
+}
 
-    if (const auto itm = _capio_cl_entries.find(path); itm != _capio_cl_entries.end()) {
-        return itm->second.consumers;
+std::vector<std::string>
+capiocl::engine::Engine::getConsumers(const EntryHandle &handle) const {
+    std::vector<std::string> consumers;
+    if (!this->_find(handle,
+                     [&](const CapioCLEntry &entry) { consumers = entry.consumers.names(); })) {
+        return this->getConsumers(handle.path());
     }
-    return {};
+    return consumers;
 }
 
 bool capiocl::engine::Engine::isConsumer(const std::filesystem::path &path,
@@ -645,45 +1870,56 @@ bool capiocl::engine::Engine::isConsumer(const std::filesystem::path &path,
         return true;
     }
 
-    {
-        shared_lock_guard slg(_shared_mutex);
+    // An application that was never interned cannot appear in any entry
+    if (const auto app = AppInterner::find(app_name); app != AppInterner::NONE) {
+        const auto has_app = [app](const CapioCLEntry &entry) {
+            return entry.consumers.contains(app);
+        };
 
-        for (const auto &[pattern, entry] : _capio_cl_entries) {
-            if (fnmatch(pattern.c_str(), path.c_str(), FNM_NOESCAPE) == 0) {
-                const auto &consumers = entry.consumers;
-                if (std::find(consumers.begin(), consumers.end(), app_name) != consumers.end()) {
-                    return true;
-                }
-            }
+        bool found = false;
+        this->_find(path, [&](const CapioCLEntry &entry) { found = has_app(entry); });
+        if (found || this->_any_rule(path, has_app)) {
+            return true;
         }
     }
-    {
-        std::lock_guard lg(_shared_mutex);
-        this->_newFile(path);
-    }
 
+    this->_missed(path);
     return false;
 }
 
+bool capiocl::engine::Engine::isConsumer(const EntryHandle &handle,
+                                         const std::string &app_name) const {
+    const auto app     = AppInterner::find(app_name);
+    const auto has_app = [app](const CapioCLEntry &entry) {
+        return app != AppInterner::NONE && entry.consumers.contains(app);
+    };
+
+    bool found = false;
+    if (!this->_find(handle, [&](const CapioCLEntry &entry) { found = has_app(entry); })) {
+        return this->isConsumer(handle.path(), app_name);
+    }
+    return found || this->_any_rule(handle.path(), has_app);
+}
+
 std::vector<std::string>
 capiocl::engine::Engine::getProducers(const std::filesystem::path &path) const {
     if (path.empty()) {
         return {};
     }
 
-    {
-        shared_lock_guard slg(_shared_mutex);
-
-        if (const auto itm = _capio_cl_entries.find(path); itm != _capio_cl_entries.end()) {
-            return itm->second.producers;
-        }
-    }
+    std::vector<std::string> producers;
+    this->_read(path, [&](const CapioCLEntry &entry) { producers = entry.producers.names(); });
+    return producers;
+}
 
-    {
-        std::lock_guard lg(_shared_mutex);
-        this->_newFile(path);
+std::vector<std::string>
+capiocl::engine::Engine::getProducers(const EntryHandle &handle) const {
+    std::vector<std::string> producers;
+    if (!this->_find(handle,
+                     [&](const CapioCLEntry &entry) { producers = entry.producers.names(); })) {
+        return this->getProducers(handle.path());
     }
-    return getProducers(path);
+    return producers;
 }
 
 bool capiocl::engine::Engine::isProducer(const std::filesystem::path &path,
@@ -691,26 +1927,38 @@ bool capiocl::engine::Engine::isProducer(const std::filesystem::path &path,
     if (path.empty()) {
         return true;
     }
-    {
-        shared_lock_guard slg(_shared_mutex);
 
-        for (const auto &[pattern, entry] : _capio_cl_entries) {
-            if (fnmatch(pattern.c_str(), path.c_str(), FNM_NOESCAPE) == 0) {
-                const auto &producers = entry.producers;
-                if (std::find(producers.begin(), producers.end(), app_name) != producers.end()) {
-                    return true;
-                }
-            }
+    // An application that was never interned cannot appear in any entry
+    if (const auto app = AppInterner::find(app_name); app != AppInterner::NONE) {
+        const auto has_app = [app](const CapioCLEntry &entry) {
+            return entry.producers.contains(app);
+        };
+
+        bool found = false;
+        this->_find(path, [&](const CapioCLEntry &entry) { found = has_app(entry); });
+        if (found || this->_any_rule(path, has_app)) {
+            return true;
         }
     }
 
-    {
-        std::lock_guard lg(_shared_mutex);
-        this->_newFile(path);
-    }
+    this->_missed(path);
     return false;
 }
 
+bool capiocl::engine::Engine::isProducer(const EntryHandle &handle,
+                                         const std::string &app_name) const {
+    const auto app     = AppInterner::find(app_name);
+    const auto has_app = [app](const CapioCLEntry &entry) {
+        return app != AppInterner::NONE && entry.producers.contains(app);
+    };
+
+    bool found = false;
+    if (!this->_find(handle, [&](const CapioCLEntry &entry) { found = has_app(entry); })) {
+        return this->isProducer(handle.path(), app_name);
+    }
+    return found || this->_any_rule(handle.path(), has_app);
+}
+
 void capiocl::engine::Engine::setFileDeps(const std::filesystem::path &path,
                                           const std::vector<std::filesystem::path> &dependencies) {
     if (path.empty()) {
@@ -721,20 +1969,17 @@ void capiocl::engine::Engine::setFileDeps(const std::filesystem::path &path,
         return;
     }
 
+    // The entry is created first, so that the dependencies it inherits are replaced as well
+    this->_newFile(path);
+    const bool ready = this->_link(path, dependencies, true);
     for (const auto &itm : dependencies) {
-        newFile(itm);
+        this->_newFile(itm);
     }
 
-    {
-        std::lock_guard lg(_shared_mutex);
-
-        if (const auto itm = _capio_cl_entries.find(path); itm != _capio_cl_entries.end()) {
-            itm->second.file_dependencies = dependencies;
-            return;
-        }
-        this->_newFile(path);
+    this->_write(path, [&](CapioCLEntry &entry) { entry.file_dependencies = dependencies; });
+    if (ready) {
+        this->_cascade({path.native()});
     }
-    setFileDeps(path, dependencies);
 }
 
 long capiocl::engine::Engine::getCommitCloseCount(const std::filesystem::path &path) const {
@@ -742,28 +1987,43 @@ long capiocl::engine::Engine::getCommitCloseCount(const std::filesystem::path &p
         return 0;
     }
 
-    {
-        shared_lock_guard slg(_shared_mutex);
+    long count = 0;
+    this->_read(path, [&](const CapioCLEntry &entry) { count = entry.commit_on_close_count; });
+    return count;
+}
 
-        if (const auto itm = _capio_cl_entries.find(path); itm != _capio_cl_entries.end()) {
-            return itm->second.commit_on_close_count;
-        }
-    }
-    {
-        std::lock_guard lg(_shared_mutex);
-        this->_newFile(path);
+long capiocl::engine::Engine::getCommitCloseCount(const EntryHandle &handle) const {
+    long count = 0;
+    if (!this->_find(handle, [&](const CapioCLEntry &entry) {
+            count = entry.commit_on_close_count;
+        })) {
+        return this->getCommitCloseCount(handle.path());
     }
-    return getCommitCloseCount(path);
+    return count;
 }
 
 std::vector<std::filesystem::path>
 capiocl::engine::Engine::getCommitOnFileDependencies(const std::filesystem::path &path) const {
-    shared_lock_guard slg(_shared_mutex);
+    std::vector<std::filesystem::path> dependencies;
+    this->_find(path, [&](const CapioCLEntry &entry) { dependencies = entry.file_dependencies; });
+    return dependencies;
+}
 
-    if (const auto itm = _capio_cl_entries.find(path); itm != _capio_cl_entries.end()) {
-        return itm->second.file_dependencies;
+std::vector<std::filesystem::path>
+capiocl::engine::Engine::getCommitOnFileDependencies(const EntryHandle &handle) const {
+    std::vector<std::filesystem::path> dependencies;
+    if (!this->_find(handle,
+                     [&](const CapioCLEntry &entry) { dependencies = entry.file_dependencies; })) {
+        return this->getCommitOnFileDependencies(handle.path());
     }
-    return {};
+    return dependencies;
+}
+
+std::vector<std::string>
+capiocl::engine::Engine::getFileDependents(const std::filesystem::path &path) const {
+    this->_load_graph();
+    std::lock_guard lg(_graph_mutex);
+    return _graph.dependents(path);
 }
 
 void capiocl::engine::Engine::setStoreFileInMemory(const std::filesystem::path &path) {
@@ -771,21 +2031,12 @@ void capiocl::engine::Engine::setStoreFileInMemory(const std::filesystem::path &
         return;
     }
 
-    {
-        std::lock_guard lg(_shared_mutex);
-
-        if (const auto itm = _capio_cl_entries.find(path); itm != _capio_cl_entries.end()) {
-            itm->second.store_in_memory = true;
-            return;
-        }
-        this->_newFile(path);
-    }
-    setStoreFileInMemory(path);
+    this->_write(path, [](CapioCLEntry &entry) { entry.store_in_memory = true; });
 }
 
 void capiocl::engine::Engine::setAllStoreInMemory() {
     {
-        std::lock_guard lg(_shared_mutex);
+        exclusive_lock_guard lg(_rules_mutex, _stats);
         this->store_all_in_memory = true;
     }
 
@@ -796,12 +2047,12 @@ void capiocl::engine::Engine::setAllStoreInMemory() {
 }
 
 void capiocl::engine::Engine::setWorkflowName(const std::string &name) {
-    std::lock_guard lg(_shared_mutex);
+    exclusive_lock_guard lg(_rules_mutex, _stats);
     this->workflow_name = name;
 }
 
 const std::string &capiocl::engine::Engine::getWorkflowName() const {
-    shared_lock_guard slg(_shared_mutex);
+    shared_lock_guard slg(_rules_mutex, _stats);
     return this->workflow_name;
 }
 
@@ -809,15 +2060,8 @@ void capiocl::engine::Engine::setStoreFileInFileSystem(const std::filesystem::pa
     if (path.empty()) {
         return;
     }
-    {
-        std::lock_guard lg(_shared_mutex);
-        if (const auto itm = _capio_cl_entries.find(path); itm != _capio_cl_entries.end()) {
-            itm->second.store_in_memory = false;
-            return;
-        }
-        this->_newFile(path);
-    }
-    setStoreFileInFileSystem(path);
+
+    this->_write(path, [](CapioCLEntry &entry) { entry.store_in_memory = false; });
 }
 
 bool capiocl::engine::Engine::isStoredInMemory(const std::filesystem::path &path) const {
@@ -825,30 +2069,28 @@ bool capiocl::engine::Engine::isStoredInMemory(const std::filesystem::path &path
         return true;
     }
 
-    {
-        shared_lock_guard slg(_shared_mutex);
-        if (const auto itm = _capio_cl_entries.find(path); itm != _capio_cl_entries.end()) {
-            return itm->second.store_in_memory;
-        }
-    }
+    bool in_memory = false;
+    this->_read(path, [&](const CapioCLEntry &entry) { in_memory = entry.store_in_memory; });
+    return in_memory;
+}
 
-    {
-        std::lock_guard lg(_shared_mutex);
-        this->_newFile(path);
+bool capiocl::engine::Engine::isStoredInMemory(const EntryHandle &handle) const {
+    bool in_memory = false;
+    if (!this->_find(handle,
+                     [&](const CapioCLEntry &entry) { in_memory = entry.store_in_memory; })) {
+        return this->isStoredInMemory(handle.path());
     }
-    return isStoredInMemory(path);
+    return in_memory;
 }
 
 std::vector<std::string> capiocl::engine::Engine::getFileToStoreInMemory() const {
     std::vector<std::string> files;
 
-    shared_lock_guard slg(_shared_mutex);
-
-    for (const auto &[path, file] : _capio_cl_entries) {
+    _for_each([&](const std::string &path, const CapioCLEntry &file) {
         if (file.store_in_memory) {
             files.push_back(path);
         }
-    }
+    });
 
     return files;
 }
@@ -858,6 +2100,11 @@ capiocl::engine::Engine::getHomeNode(const std::filesystem::path &path) const {
     return monitor.getHomeNode(path);
 }
 
+std::future<std::set<std::string>>
+capiocl::engine::Engine::getHomeNodeAsync(const std::filesystem::path &path) const {
+    return monitor.getHomeNodeAsync(path);
+}
+
 void capiocl::engine::Engine::setHomeNode(const std::filesystem::path &path) const {
     monitor.setHomeNode(path);
 }
@@ -866,43 +2113,72 @@ bool capiocl::engine::Engine::isExcluded(const std::filesystem::path &path) cons
     if (path.empty()) {
         return true;
     }
-    {
-        shared_lock_guard slg(_shared_mutex);
-        if (const auto itm = _capio_cl_entries.find(path); itm != _capio_cl_entries.end()) {
-            return itm->second.excluded;
-        }
-    }
 
-    {
-        std::lock_guard lg(_shared_mutex);
-        this->_newFile(path);
+    bool excluded = false;
+    this->_read(path, [&](const CapioCLEntry &entry) { excluded = entry.excluded; });
+    return excluded;
+}
+
+bool capiocl::engine::Engine::isExcluded(const EntryHandle &handle) const {
+    bool excluded = false;
+    if (!this->_find(handle, [&](const CapioCLEntry &entry) { excluded = entry.excluded; })) {
+        return this->isExcluded(handle.path());
     }
-    return isExcluded(path);
+    return excluded;
 }
 
 bool capiocl::engine::Engine::operator==(const Engine &other) const {
-    const auto &other_entries = other._capio_cl_entries;
-
-    if (this->_capio_cl_entries.size() != other_entries.size()) {
+    if (this == &other) {
+        return true;
+    }
+    // Engines with different content have different trees, usually cached by both
+    if (this->fingerprint() != other.fingerprint()) {
         return false;
     }
 
-    for (auto &[this_path, this_itm] : this->_capio_cl_entries) {
-        if (other_entries.find(this_path) == other_entries.end()) {
-            return false;
-        }
-
-        if (auto other_itm = other_entries.at(this_path); this_itm != other_itm) {
-            return false;
+    std::size_t count = 0;
+    bool equal        = true;
+    this->_for_each([&](const std::string &path, const CapioCLEntry &entry) {
+        count++;
+        if (equal && !other._find(path, [&](const CapioCLEntry &itm) { equal = itm == entry; })) {
+            equal = false;
         }
-    }
-    return true;
+    });
+    return equal && count == other.size();
 }
 void capiocl::engine::Engine::loadConfiguration(const std::string &path) {
     configuration.load(path);
 
     std::string multicast_monitor_enabled, fs_monitor_enabled;
 
+    int shards;
+    try {
+        configuration.getParameter("engine.shards", &shards);
+    } catch (...) {
+        shards = std::stoi(configuration::defaults::DEFAULT_ENGINE_SHARDS.v);
+    }
+    if (shards < 1) {
+        throw configuration::CapioClConfigurationException(
+            "engine.shards must be greater than zero");
+    }
+    this->_reshard(shards);
+
+    std::string snapshot_reads;
+    try {
+        configuration.getParameter("engine.snapshot_reads", &snapshot_reads);
+    } catch (...) {
+        snapshot_reads = configuration::defaults::DEFAULT_ENGINE_SNAPSHOT_READS.v;
+    }
+    this->_set_snapshot_reads(snapshot_reads == "true");
+
+    std::string materialize_reads;
+    try {
+        configuration.getParameter("engine.materialize_reads", &materialize_reads);
+    } catch (...) {
+        materialize_reads = configuration::defaults::DEFAULT_ENGINE_MATERIALIZE_READS.v;
+    }
+    this->_materialize_reads = materialize_reads == "true";
+
     try {
         configuration.getParameter("monitor.mcast.enabled", &multicast_monitor_enabled);
     } catch (...) {
@@ -930,6 +2206,15 @@ void capiocl::engine::Engine::loadConfiguration(const std::string &path) {
 void capiocl::engine::Engine::useDefaultConfiguration() {
     configuration.loadDefaults();
 
+    int shards;
+    std::string snapshot_reads, materialize_reads;
+    configuration.getParameter("engine.shards", &shards);
+    configuration.getParameter("engine.snapshot_reads", &snapshot_reads);
+    configuration.getParameter("engine.materialize_reads", &materialize_reads);
+    this->_reshard(shards);
+    this->_set_snapshot_reads(snapshot_reads == "true");
+    this->_materialize_reads = materialize_reads == "true";
+
     // TODO: add a vector with registered instances of backends to avoid multiple instantiations
     monitor.registerMonitorBackend(new monitor::MulticastMonitor(configuration));
     monitor.registerMonitorBackend(new monitor::FileSystemMonitor());
@@ -957,8 +2242,12 @@ capiocl::engine::CapioCLEntry capiocl::engine::CapioCLEntry::fromJson(const std:
         }
     }
 
-    entry.commit_rule = j.get_value_or<std::string>("commit_rule", entry.commit_rule);
-    entry.fire_rule   = j.get_value_or<std::string>("fire_rule", entry.fire_rule);
+    if (j.contains("commit_rule")) {
+        entry.commit_rule = commitRules::fromString(j["commit_rule"].as<std::string>());
+    }
+    if (j.contains("fire_rule")) {
+        entry.fire_rule = fireRules::fromString(j["fire_rule"].as<std::string>());
+    }
     entry.directory_children_count =
         j.get_value_or<long>("directory_children_count", entry.directory_children_count);
     entry.commit_on_close_count =
@@ -975,8 +2264,8 @@ capiocl::engine::CapioCLEntry capiocl::engine::CapioCLEntry::fromJson(const std:
 
 std::string capiocl::engine::CapioCLEntry::toJson() const {
     jsoncons::json j;
-    j["producers"] = producers;
-    j["consumers"] = consumers;
+    j["producers"] = producers.names();
+    j["consumers"] = consumers.names();
 
     jsoncons::json deps = jsoncons::json::array();
     for (const auto &p : file_dependencies) {
@@ -984,8 +2273,8 @@ std::string capiocl::engine::CapioCLEntry::toJson() const {
     }
     j["file_dependencies"] = deps;
 
-    j["commit_rule"]                   = commit_rule;
-    j["fire_rule"]                     = fire_rule;
+    j["commit_rule"]                   = commitRules::toString(commit_rule);
+    j["fire_rule"]                     = fireRules::toString(fire_rule);
     j["directory_children_count"]      = directory_children_count;
     j["commit_on_close_count"]         = commit_on_close_count;
     j["enable_directory_count_update"] = enable_directory_count_update;
@@ -998,18 +2287,24 @@ std::string capiocl::engine::CapioCLEntry::toJson() const {
 }
 
 capiocl::engine::CapioCLEntry &capiocl::engine::CapioCLEntry::operator+=(const CapioCLEntry &rhs) {
-    auto merge_vec = [](std::vector<std::string> &dest, const std::vector<std::string> &src) {
-        dest.insert(dest.end(), src.begin(), src.end());
-    };
+    this->producers |= rhs.producers;
+    this->consumers |= rhs.consumers;
 
-    merge_vec(this->producers, rhs.producers);
-    merge_vec(this->consumers, rhs.consumers);
-
-    this->file_dependencies.insert(this->file_dependencies.end(), rhs.file_dependencies.begin(),
-                                   rhs.file_dependencies.end());
+    for (const auto &dependency : rhs.file_dependencies) {
+        if (std::find(file_dependencies.begin(), file_dependencies.end(), dependency) ==
+            file_dependencies.end()) {
+            this->file_dependencies.push_back(dependency);
+        }
+    }
 
-    this->directory_children_count += rhs.directory_children_count;
-    this->commit_on_close_count += rhs.commit_on_close_count;
+    // Counts updated automatically only grow, the ones set explicitly replace the current one
+    if (!rhs.enable_directory_count_update) {
+        this->directory_children_count = rhs.directory_children_count;
+    } else if (this->enable_directory_count_update) {
+        this->directory_children_count =
+            std::max(this->directory_children_count, rhs.directory_children_count);
+    }
+    this->commit_on_close_count = rhs.commit_on_close_count;
 
     this->enable_directory_count_update &= rhs.enable_directory_count_update;
     this->store_in_memory |= rhs.store_in_memory;
@@ -1029,7 +2324,35 @@ capiocl::engine::CapioCLEntry capiocl::engine::CapioCLEntry::operator+(const Cap
     return result;
 }
 
-bool capiocl::engine::CapioCLEntry::operator==(const CapioCLEntry &other) {
+std::uint64_t capiocl::engine::CapioCLEntry::hash() const {
+    // The hashes of the elements of a list are summed, so that their order does not matter
+    std::uint64_t producers_hash = 0, consumers_hash = 0, dependencies_hash = 0;
+    for (const auto &name : producers) {
+        producers_hash += MerkleTree::combine(1, MerkleTree::hash(name));
+    }
+    for (const auto &name : consumers) {
+        consumers_hash += MerkleTree::combine(2, MerkleTree::hash(name));
+    }
+    for (const auto &dependency : file_dependencies) {
+        dependencies_hash += MerkleTree::combine(3, MerkleTree::hash(dependency.native()));
+    }
+
+    const std::uint64_t flags = std::uint64_t(enable_directory_count_update) |
+                                std::uint64_t(store_in_memory) << 1 |
+                                std::uint64_t(permanent) << 2 | std::uint64_t(excluded) << 3 |
+                                std::uint64_t(is_file) << 4;
+    std::uint64_t hash = 0;
+    for (const std::uint64_t value :
+         {static_cast<std::uint64_t>(commit_rule), static_cast<std::uint64_t>(fire_rule),
+          static_cast<std::uint64_t>(commit_on_close_count),
+          static_cast<std::uint64_t>(directory_children_count), flags, producers_hash,
+          consumers_hash, dependencies_hash}) {
+        hash = MerkleTree::combine(hash, value);
+    }
+    return hash;
+}
+
+bool capiocl::engine::CapioCLEntry::operator==(const CapioCLEntry &other) const {
 
     if (this->commit_rule != other.commit_rule || this->fire_rule != other.fire_rule ||
         this->permanent != other.permanent || this->excluded != other.excluded ||
@@ -1041,44 +2364,33 @@ bool capiocl::engine::CapioCLEntry::operator==(const CapioCLEntry &other) {
         return false;
     }
 
-    const auto this_producer = this->producers;
-    auto other_producer      = other.producers;
-    if (this_producer.size() != other_producer.size()) {
+    if (this->producers != other.producers || this->consumers != other.consumers) {
         return false;
     }
-    for (const auto &entry : this_producer) {
-        if (std::find(other_producer.begin(), other_producer.end(), entry) ==
-            other_producer.end()) {
-            return false;
-        }
-    }
 
-    const auto this_consumer = this->consumers;
-    auto other_consumer      = other.consumers;
-    if (this_consumer.size() != other_consumer.size()) {
+    if (this->file_dependencies.size() != other.file_dependencies.size()) {
         return false;
     }
-    for (const auto &entry : this_consumer) {
-        if (std::find(other_consumer.begin(), other_consumer.end(), entry) ==
-            other_consumer.end()) {
-            return false;
-        }
+    if (this->file_dependencies == other.file_dependencies) {
+        return true;
     }
 
-    const auto this_deps = this->file_dependencies;
-    auto other_deps      = other.file_dependencies;
-    if (this_deps.size() != other_deps.size()) {
-        return false;
-    }
-    for (const auto &entry : this_deps) {
-        if (std::find(other_deps.begin(), other_deps.end(), entry) == other_deps.end()) {
-            return false;
+    // Dependencies may be listed in any order: compare them sorted, without copying the paths
+    const auto sorted = [](const std::vector<std::filesystem::path> &dependencies) {
+        std::vector<const std::filesystem::path *> pointers;
+        pointers.reserve(dependencies.size());
+        for (const auto &dependency : dependencies) {
+            pointers.push_back(&dependency);
         }
-    }
-
-    return true;
+        std::sort(pointers.begin(), pointers.end(),
+                  [](const auto *lhs, const auto *rhs) { return *lhs < *rhs; });
+        return pointers;
+    };
+    const auto these = sorted(this->file_dependencies), others = sorted(other.file_dependencies);
+    return std::equal(these.begin(), these.end(), others.begin(),
+                      [](const auto *lhs, const auto *rhs) { return *lhs == *rhs; });
 }
 
-bool capiocl::engine::CapioCLEntry::operator!=(const CapioCLEntry &other) {
+bool capiocl::engine::CapioCLEntry::operator!=(const CapioCLEntry &other) const {
     return !(*this == other);
 }
\ No newline at end of file
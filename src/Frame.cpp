@@ -0,0 +1,127 @@
+#include <algorithm>
+#include <cstring>
+
+#include "capiocl/frame.h"
+
+/// @brief Number of bytes of @p value encoded as a LEB128 varint
+static std::size_t varint_size(std::size_t value) {
+    std::size_t size = 1;
+    while (value >= 0x80) {
+        value >>= 7;
+        size++;
+    }
+    return size;
+}
+
+/// @brief Append @p value to @p out as a LEB128 varint
+static void put_varint(std::string &out, std::size_t value) {
+    while (value >= 0x80) {
+        out += static_cast<char>((value & 0x7f) | 0x80);
+        value >>= 7;
+    }
+    out += static_cast<char>(value);
+}
+
+/**
+ * @brief Read a LEB128 varint from @p data, advancing @p offset
+ * @return false if the datagram ends before the varint, or if the varint is too long
+ */
+static bool get_varint(const char *data, const std::size_t length, std::size_t &offset,
+                       std::size_t &value) {
+    value = 0;
+    for (unsigned shift = 0; offset < length && shift < 64; shift += 7) {
+        const auto byte = static_cast<unsigned char>(data[offset++]);
+        value |= static_cast<std::size_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+capiocl::monitor::MessageFrame::MessageFrame(const std::size_t max_size,
+                                             const bool prefix_compression)
+    : max_size(max_size), prefix_compression(prefix_compression) {}
+
+bool capiocl::monitor::MessageFrame::add(const char command, const std::string &payload) {
+    std::size_t shared = 0;
+    if (prefix_compression) {
+        const auto limit = std::min(previous.size(), payload.size());
+        while (shared < limit && previous[shared] == payload[shared]) {
+            shared++;
+        }
+    }
+
+    const auto suffix = payload.size() - shared;
+    const auto record = 1 + varint_size(shared) + varint_size(suffix) + suffix;
+    if (count == 0) {
+        buffer.clear();
+        buffer += MAGIC;
+        buffer += VERSION;
+        plain.clear();
+        plain += command;
+        plain += ' ';
+        plain += payload;
+    } else if (buffer.size() + record > max_size) {
+        return false;
+    }
+
+    buffer += command;
+    put_varint(buffer, shared);
+    put_varint(buffer, suffix);
+    buffer.append(payload, shared, suffix);
+    previous = payload;
+    count++;
+    return true;
+}
+
+std::size_t capiocl::monitor::MessageFrame::size() const { return count; }
+
+std::string capiocl::monitor::MessageFrame::take() {
+    std::string datagram;
+    if (count == 1) {
+        datagram.swap(plain);
+    } else if (count > 1) {
+        datagram.swap(buffer);
+    }
+    buffer.clear();
+    plain.clear();
+    previous.clear();
+    count = 0;
+    return datagram;
+}
+
+std::vector<capiocl::monitor::MessageFrame::Record>
+capiocl::monitor::MessageFrame::decode(const char *data, const std::size_t length) {
+    std::vector<Record> records;
+    if (length < 2) {
+        return records;
+    }
+
+    if (data[0] != MAGIC || data[1] != VERSION) {
+        // Plain message: the payload ends at the end of the datagram or at the first NUL
+        const auto payload = data + 2;
+        records.push_back({data[0], std::string(payload, strnlen(payload, length - 2))});
+        return records;
+    }
+
+    std::string previous;
+    std::size_t offset = 2;
+    while (offset < length) {
+        const char command = data[offset++];
+        std::size_t shared, suffix;
+        if (!get_varint(data, length, offset, shared) ||
+            !get_varint(data, length, offset, suffix) || shared > previous.size() ||
+            suffix > length - offset) {
+            break;
+        }
+
+        std::string payload(previous, 0, shared);
+        payload.append(data + offset, suffix);
+        offset += suffix;
+
+        previous = payload;
+        records.push_back({command, std::move(payload)});
+    }
+    return records;
+}
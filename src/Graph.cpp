@@ -0,0 +1,210 @@
+#include <stdexcept>
+
+#include "capiocl/graph.h"
+
+capiocl::engine::DependencyGraph::Node &
+capiocl::engine::DependencyGraph::node(const std::filesystem::path &path) {
+    const auto [itm, inserted] = nodes.try_emplace(path.native());
+    if (inserted) {
+        itm->second.path = &itm->first;
+    }
+    return itm->second;
+}
+
+bool capiocl::engine::DependencyGraph::unblocked(const Node &node) {
+    return !node.dependencies.empty() && node.pending == 0 && !node.committed;
+}
+
+void capiocl::engine::DependencyGraph::check(
+    const std::filesystem::path &target,
+    const std::vector<std::filesystem::path> &dependencies) const {
+    for (const auto &dependency : dependencies) {
+        if (dependency == target) {
+            throw std::invalid_argument("Circular dependency: " + target.string() +
+                                        " depends on itself");
+        }
+    }
+
+    const auto itm = nodes.find(target.native());
+    if (itm == nodes.end() || itm->second.dependents.empty()) {
+        return;
+    }
+
+    // A cycle is closed when a new dependency already depends, directly or not, on the target
+    std::unordered_set<const Node *> downstream = {&itm->second};
+    std::vector<const Node *> stack             = {&itm->second};
+    while (!stack.empty()) {
+        const auto current = stack.back();
+        stack.pop_back();
+        for (const auto dependent : current->dependents) {
+            if (downstream.insert(dependent).second) {
+                stack.push_back(dependent);
+            }
+        }
+    }
+
+    for (const auto &dependency : dependencies) {
+        if (const auto dep = nodes.find(dependency.native());
+            dep != nodes.end() && downstream.count(&dep->second) > 0) {
+            throw std::invalid_argument("Circular dependency: " + dependency.string() +
+                                        " depends on " + target.string());
+        }
+    }
+}
+
+bool capiocl::engine::DependencyGraph::link(Node &target, Node &dependency) {
+    if (!target.dependencies.insert(&dependency).second) {
+        return false;
+    }
+    if (dependency.dependents.empty() && !dependency.committed) {
+        unknown.push_back(*dependency.path);
+    }
+    dependency.dependents.insert(&target);
+    target.pending += dependency.committed ? 0 : 1;
+    return true;
+}
+
+void capiocl::engine::DependencyGraph::unlink(Node &target) {
+    for (const auto dependency : target.dependencies) {
+        dependency->dependents.erase(&target);
+        this->prune(dependency);
+    }
+    target.dependencies.clear();
+    target.pending = 0;
+}
+
+void capiocl::engine::DependencyGraph::prune(Node *node) {
+    if (node->dependencies.empty() && node->dependents.empty()) {
+        nodes.erase(*node->path);
+    }
+}
+
+bool capiocl::engine::DependencyGraph::add(
+    const std::filesystem::path &target, const std::vector<std::filesystem::path> &dependencies) {
+    if (dependencies.empty()) {
+        return false;
+    }
+    this->check(target, dependencies);
+
+    auto &node = this->node(target);
+    for (const auto &dependency : dependencies) {
+        this->link(node, this->node(dependency));
+    }
+    return unblocked(node);
+}
+
+std::vector<std::string> capiocl::engine::DependencyGraph::addAll(
+    const std::vector<std::pair<std::string, std::vector<std::filesystem::path>>> &links) {
+    // Edges added so far, removed again if a later target closes a cycle
+    std::vector<std::pair<Node *, Node *>> added;
+    try {
+        for (const auto &[target, dependencies] : links) {
+            if (dependencies.empty()) {
+                continue;
+            }
+            this->check(target, dependencies);
+
+            auto &node = this->node(target);
+            for (const auto &dependency : dependencies) {
+                auto &dep = this->node(dependency);
+                if (this->link(node, dep)) {
+                    added.emplace_back(&node, &dep);
+                }
+            }
+        }
+    } catch (const std::invalid_argument &) {
+        std::unordered_set<Node *> touched;
+        for (const auto &[node, dep] : added) {
+            node->dependencies.erase(dep);
+            dep->dependents.erase(node);
+            node->pending -= dep->committed ? 0 : 1;
+            touched.insert(node);
+            touched.insert(dep);
+        }
+        for (const auto node : touched) {
+            this->prune(node);
+        }
+        throw;
+    }
+
+    std::vector<std::string> ready;
+    for (const auto &[target, dependencies] : links) {
+        if (const auto itm = nodes.find(target); itm != nodes.end() && unblocked(itm->second)) {
+            ready.push_back(target);
+        }
+    }
+    return ready;
+}
+
+bool capiocl::engine::DependencyGraph::set(
+    const std::filesystem::path &target, const std::vector<std::filesystem::path> &dependencies) {
+    this->check(target, dependencies);
+
+    const auto itm = nodes.find(target.native());
+    if (itm == nodes.end()) {
+        return this->add(target, dependencies);
+    }
+
+    // Link the new dependencies before dropping the old ones, so that shared dependencies are not
+    // pruned and keep their commit state
+    auto &node = itm->second;
+    auto old   = std::move(node.dependencies);
+    node.dependencies.clear();
+    node.pending = 0;
+    for (const auto &dependency : dependencies) {
+        this->link(node, this->node(dependency));
+    }
+    for (const auto dependency : old) {
+        if (node.dependencies.count(dependency) == 0) {
+            dependency->dependents.erase(&node);
+            this->prune(dependency);
+        }
+    }
+    const bool target_ready = unblocked(node);
+    this->prune(&node);
+    return target_ready;
+}
+
+void capiocl::engine::DependencyGraph::erase(const std::filesystem::path &target) {
+    if (const auto itm = nodes.find(target.native()); itm != nodes.end()) {
+        auto &node = itm->second;
+        this->unlink(node);
+        this->prune(&node);
+    }
+}
+
+std::vector<std::string>
+capiocl::engine::DependencyGraph::commit(const std::filesystem::path &path) {
+    std::vector<std::string> ready;
+    const auto itm = nodes.find(path.native());
+    if (itm == nodes.end() || itm->second.committed) {
+        return ready;
+    }
+
+    auto &node     = itm->second;
+    node.committed = true;
+    for (const auto dependent : node.dependents) {
+        if (--dependent->pending == 0 && !dependent->committed) {
+            ready.push_back(*dependent->path);
+        }
+    }
+    return ready;
+}
+
+std::vector<std::string>
+capiocl::engine::DependencyGraph::dependents(const std::filesystem::path &path) const {
+    std::vector<std::string> dependents;
+    if (const auto itm = nodes.find(path.native()); itm != nodes.end()) {
+        dependents.reserve(itm->second.dependents.size());
+        for (const auto dependent : itm->second.dependents) {
+            dependents.push_back(*dependent->path);
+        }
+    }
+    return dependents;
+}
+
+std::vector<std::string> capiocl::engine::DependencyGraph::takeUnknown() {
+    return std::exchange(unknown, {});
+}
+
+std::size_t capiocl::engine::DependencyGraph::size() const { return nodes.size(); }
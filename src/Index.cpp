@@ -0,0 +1,252 @@
+#include <algorithm>
+#include <fnmatch.h>
+
+#include "capiocl/index.h"
+
+/**
+ * Split the leading literal components of @p path. Only components that are followed by a '/'
+ * are returned, as the last component of a path can never be a literal prefix directory.
+ * Splitting stops at the first component containing a wildcard. The callback also receives the
+ * length of the prefix consumed so far, trailing '/' included.
+ */
+template <typename F> static void for_each_literal_component(std::string_view path, F &&fn) {
+    std::size_t start = 0;
+    for (auto end = path.find('/'); end != std::string_view::npos; end = path.find('/', start)) {
+        const auto component = path.substr(start, end - start);
+        if (capiocl::engine::PatternIndex::isPattern(component) || !fn(component, end + 1)) {
+            return;
+        }
+        start = end + 1;
+    }
+}
+
+/// Remove @p id from the bucket @p key, dropping the bucket and its length once empty
+template <typename Buckets, typename Lengths, typename Id>
+static void bucket_erase(Buckets &buckets, Lengths &lengths, const std::string &key, Id id) {
+    auto &bucket = buckets[key];
+    bucket.erase(std::remove(bucket.begin(), bucket.end(), id), bucket.end());
+    if (bucket.empty()) {
+        buckets.erase(key);
+    }
+    if (--lengths[key.length()] == 0) {
+        lengths.erase(key.length());
+    }
+}
+
+bool capiocl::engine::PatternIndex::isPattern(std::string_view path) {
+    return path.find_first_of("*?[") != std::string_view::npos;
+}
+
+capiocl::engine::PatternIndex::Node *
+capiocl::engine::PatternIndex::node_for(std::string_view pattern, const bool create,
+                                        std::size_t &prefix_length) {
+    Node *node    = &root;
+    prefix_length = 0;
+    for_each_literal_component(pattern, [&](std::string_view component, std::size_t consumed) {
+        const std::string key(component);
+        auto itm = node->children.find(key);
+        if (itm == node->children.end()) {
+            if (!create) {
+                node = nullptr;
+                return false;
+            }
+            itm = node->children.emplace(key, std::make_unique<Node>()).first;
+        }
+        node          = itm->second.get();
+        prefix_length = consumed;
+        return true;
+    });
+    return node;
+}
+
+template <typename F>
+void capiocl::engine::PatternIndex::visit(const std::string &path, F &&fn) const {
+    const std::string_view view(path);
+    std::uint64_t comparisons = 0;
+
+    // Probe the buckets of a node whose prefix covers the first prefix_length chars of path.
+    // Returns false when fn asked to stop the visit.
+    const auto visit_node = [&](const Node &node, const std::size_t prefix_length) {
+        const auto remaining = view.length() - prefix_length;
+
+        for (const auto &[length, _] : node.head_lengths) {
+            if (length > remaining) {
+                break;
+            }
+            comparisons++;
+            const auto bucket = node.heads.find(std::string(view.substr(prefix_length, length)));
+            if (bucket == node.heads.end()) {
+                continue;
+            }
+            for (const auto id : bucket->second) {
+                const auto &tail = compiled[id]->tail;
+                if (length + tail.length() <= remaining &&
+                    view.substr(view.length() - tail.length()) == tail && !fn(id)) {
+                    return false;
+                }
+            }
+        }
+
+        for (const auto &[length, _] : node.tail_lengths) {
+            if (length > remaining) {
+                break;
+            }
+            comparisons++;
+            const auto bucket = node.tails.find(std::string(view.substr(view.length() - length)));
+            if (bucket == node.tails.end()) {
+                continue;
+            }
+            for (const auto id : bucket->second) {
+                if (!fn(id)) {
+                    return false;
+                }
+            }
+        }
+
+        comparisons += node.generic.size();
+        for (const auto id : node.generic) {
+            if (fnmatch(compiled[id]->pattern.c_str(), path.c_str(), FNM_NOESCAPE) == 0 &&
+                !fn(id)) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    const Node *node  = &root;
+    std::size_t start = 0;
+    for (auto more = visit_node(*node, 0); more;) {
+        const auto end = view.find('/', start);
+        if (end == std::string_view::npos) {
+            break;
+        }
+        const auto itm = node->children.find(std::string(view.substr(start, end - start)));
+        if (itm == node->children.end()) {
+            break;
+        }
+        node  = itm->second.get();
+        start = end + 1;
+        more  = visit_node(*node, start);
+    }
+
+    if (stats != nullptr) {
+        stats->add(StatsCollector::GLOB_COMPARISONS, comparisons);
+    }
+}
+
+bool capiocl::engine::PatternIndex::insert(const std::string &pattern) {
+    if (ids.find(pattern) != ids.end()) {
+        return false;
+    }
+
+    auto compiled_pattern     = std::make_unique<CompiledPattern>();
+    compiled_pattern->pattern = pattern;
+
+    std::size_t prefix_length;
+    Node *node             = node_for(pattern, true, prefix_length);
+    compiled_pattern->node = node;
+
+    // Runs of '*' are equivalent to a single one, as '/' is not matched specially
+    std::string remainder = pattern.substr(prefix_length);
+    remainder.erase(std::unique(remainder.begin(), remainder.end(),
+                                [](char a, char b) { return a == '*' && b == '*'; }),
+                    remainder.end());
+
+    if (const auto star = remainder.find('*');
+        star != std::string::npos && remainder.find_first_of("?[") == std::string::npos &&
+        remainder.find('*', star + 1) == std::string::npos) {
+        compiled_pattern->head = remainder.substr(0, star);
+        compiled_pattern->tail = remainder.substr(star + 1);
+        compiled_pattern->kind = compiled_pattern->head.empty() ? TAIL : HEAD;
+    }
+
+    PatternId id;
+    if (free_ids.empty()) {
+        id = static_cast<PatternId>(compiled.size());
+        compiled.emplace_back();
+    } else {
+        id = free_ids.back();
+        free_ids.pop_back();
+    }
+
+    if (compiled_pattern->kind == HEAD) {
+        node->heads[compiled_pattern->head].push_back(id);
+        node->head_lengths[compiled_pattern->head.length()]++;
+    } else if (compiled_pattern->kind == TAIL) {
+        node->tails[compiled_pattern->tail].push_back(id);
+        node->tail_lengths[compiled_pattern->tail.length()]++;
+    } else {
+        node->generic.push_back(id);
+    }
+
+    compiled[id] = std::move(compiled_pattern);
+    ids.emplace(pattern, id);
+    return true;
+}
+
+bool capiocl::engine::PatternIndex::erase(const std::string &pattern) {
+    const auto itm = ids.find(pattern);
+    if (itm == ids.end()) {
+        return false;
+    }
+
+    const auto id                           = itm->second;
+    const CompiledPattern &compiled_pattern = *compiled[id];
+    Node *node                              = compiled_pattern.node;
+
+    if (compiled_pattern.kind == HEAD) {
+        bucket_erase(node->heads, node->head_lengths, compiled_pattern.head, id);
+    } else if (compiled_pattern.kind == TAIL) {
+        bucket_erase(node->tails, node->tail_lengths, compiled_pattern.tail, id);
+    } else {
+        node->generic.erase(std::remove(node->generic.begin(), node->generic.end(), id),
+                            node->generic.end());
+    }
+
+    compiled[id].reset();
+    free_ids.push_back(id);
+    ids.erase(itm);
+    return true;
+}
+
+std::size_t capiocl::engine::PatternIndex::size() const { return ids.size(); }
+
+const std::string &capiocl::engine::PatternIndex::pattern(const PatternId id) const {
+    return compiled.at(id)->pattern;
+}
+
+const std::string *capiocl::engine::PatternIndex::longestMatch(const std::string &path) const {
+    const std::string *match = nullptr;
+    visit(path, [&](const PatternId id) {
+        const auto &pattern = compiled[id]->pattern;
+        if (match == nullptr || pattern.length() > match->length() ||
+            (pattern.length() == match->length() && pattern < *match)) {
+            match = &pattern;
+        }
+        return true;
+    });
+    return match;
+}
+
+bool capiocl::engine::PatternIndex::matchesAny(const std::string &path) const {
+    bool found = false;
+    visit(path, [&](PatternId) {
+        found = true;
+        return false;
+    });
+    return found;
+}
+
+std::vector<capiocl::engine::PatternIndex::PatternId>
+capiocl::engine::PatternIndex::match(const std::string &path) const {
+    std::vector<PatternId> result;
+    visit(path, [&](const PatternId id) {
+        result.push_back(id);
+        return true;
+    });
+    return result;
+}
+
+void capiocl::engine::PatternIndex::setStats(const StatsCollector *collector) {
+    stats = collector;
+}
@@ -0,0 +1,106 @@
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+#include "capiocl/hash.h"
+#include "capiocl/merkle.h"
+
+/// @brief Position of the first node of @p level within the level order of the nodes
+static constexpr std::size_t level_offset(const std::size_t level) {
+    std::size_t offset = 0, width = 1;
+    for (std::size_t i = 0; i < level; i++) {
+        offset += width;
+        width *= capiocl::engine::MerkleTree::FANOUT;
+    }
+    return offset;
+}
+
+/// @brief Number of nodes of @p level
+static constexpr std::size_t level_width(const std::size_t level) {
+    std::size_t width = 1;
+    for (std::size_t i = 0; i < level; i++) {
+        width *= capiocl::engine::MerkleTree::FANOUT;
+    }
+    return width;
+}
+
+capiocl::engine::MerkleTree::MerkleTree() : nodes(level_offset(DEPTH + 1), 0) {}
+
+capiocl::engine::MerkleTree::MerkleTree(const std::vector<std::uint64_t> &leaves)
+    : nodes(level_offset(DEPTH + 1), 0) {
+    if (leaves.size() != LEAVES) {
+        throw std::invalid_argument("MerkleTree: expected " + std::to_string(LEAVES) + " leaves");
+    }
+
+    std::copy(leaves.begin(), leaves.end(), nodes.begin() + level_offset(DEPTH));
+    for (std::size_t level = DEPTH; level-- > 0;) {
+        const auto parents  = level_offset(level);
+        const auto children = level_offset(level + 1);
+        for (std::size_t i = 0; i < level_width(level); i++) {
+            std::uint64_t hash = 0;
+            bool empty         = true;
+            for (std::size_t c = 0; c < FANOUT; c++) {
+                const auto child = nodes[children + i * FANOUT + c];
+                hash             = combine(hash, child);
+                empty            = empty && child == 0;
+            }
+            nodes[parents + i] = empty ? 0 : hash;
+        }
+    }
+}
+
+std::uint64_t capiocl::engine::MerkleTree::hash(const std::string_view value) {
+    return hashing::fnv1a(value);
+}
+
+std::uint64_t capiocl::engine::MerkleTree::combine(const std::uint64_t seed,
+                                                   const std::uint64_t value) {
+    return hashing::mix(seed + 0x9e3779b97f4a7c15ULL + hashing::mix(value));
+}
+
+std::size_t capiocl::engine::MerkleTree::bucket(const std::string_view path) {
+    auto end = path.find_last_of('/');
+    if (end == 0) {
+        end = 1;
+    } else if (end == std::string_view::npos) {
+        end = 0;
+    }
+    return hashing::mix(hash(path.substr(0, end))) % LEAVES;
+}
+
+std::uint64_t capiocl::engine::MerkleTree::leaf(const std::string_view path,
+                                                const std::uint64_t entry_hash) {
+    return combine(hash(path), entry_hash);
+}
+
+std::uint64_t capiocl::engine::MerkleTree::node(const std::size_t level,
+                                                const std::size_t index) const {
+    if (level > DEPTH || index >= level_width(level)) {
+        throw std::out_of_range("MerkleTree: no node " + std::to_string(index) + " at level " +
+                                std::to_string(level));
+    }
+    return nodes[level_offset(level) + index];
+}
+
+std::vector<std::size_t> capiocl::engine::MerkleTree::diff(const MerkleTree &other) const {
+    std::vector<std::size_t> buckets;
+    std::vector<std::size_t> frontier = {0};
+    for (std::size_t level = 0; level <= DEPTH && !frontier.empty(); level++) {
+        const auto offset = level_offset(level);
+        std::vector<std::size_t> next;
+        for (const auto index : frontier) {
+            if (nodes[offset + index] == other.nodes[offset + index]) {
+                continue;
+            }
+            if (level == DEPTH) {
+                buckets.push_back(index);
+                continue;
+            }
+            for (std::size_t c = 0; c < FANOUT; c++) {
+                next.push_back(index * FANOUT + c);
+            }
+        }
+        frontier = std::move(next);
+    }
+    return buckets;
+}
@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include "capiocl/monitor.h"
 #include "capiocl.hpp"
 #include "capiocl/printer.h"
@@ -6,6 +8,192 @@ capiocl::monitor::MonitorException::MonitorException(const std::string &msg) : m
     printer::print(printer::CLI_LEVEL_ERROR, msg);
 }
 
+std::string capiocl::monitor::WaitList::wait(
+    const std::vector<std::string> &paths, const std::chrono::steady_clock::time_point deadline,
+    const std::chrono::milliseconds recheck, const std::function<std::string()> &check) const {
+    Waiter waiter;
+    std::string notified;
+
+    std::unique_lock ul(lock);
+    for (const auto &path : paths) {
+        slots[path].push_back(&waiter);
+    }
+
+    while (!waiter.notified) {
+        ul.unlock();
+        notified = check();
+        ul.lock();
+
+        const auto now = std::chrono::steady_clock::now();
+        if (!notified.empty() || now >= deadline) {
+            break;
+        }
+        waiter.cv.wait_until(ul, std::min(deadline, now + recheck),
+                             [&waiter] { return waiter.notified; });
+    }
+    if (notified.empty() && waiter.notified) {
+        notified = std::move(waiter.path);
+    }
+
+    for (const auto &path : paths) {
+        if (const auto itm = slots.find(path); itm != slots.end()) {
+            auto &slot = itm->second;
+            slot.erase(std::remove(slot.begin(), slot.end(), &waiter), slot.end());
+            if (slot.empty()) {
+                slots.erase(itm);
+            }
+        }
+    }
+    return notified;
+}
+
+std::uint64_t capiocl::monitor::WaitList::subscribe(const std::string &path,
+                                                     Callback callback) const {
+    std::lock_guard lg(lock);
+    const auto id = next_id++;
+    callbacks[path].emplace_back(id, std::move(callback));
+    return id;
+}
+
+void capiocl::monitor::WaitList::expire(const std::string &path, const std::uint64_t id) const {
+    Callback callback;
+    {
+        std::lock_guard lg(lock);
+        const auto itm = callbacks.find(path);
+        if (itm == callbacks.end()) {
+            return;
+        }
+
+        auto &slot     = itm->second;
+        const auto pos = std::find_if(slot.begin(), slot.end(),
+                                      [id](const auto &entry) { return entry.first == id; });
+        if (pos == slot.end()) {
+            return;
+        }
+        callback = std::move(pos->second);
+        slot.erase(pos);
+        if (slot.empty()) {
+            callbacks.erase(itm);
+        }
+    }
+    callback("");
+}
+
+std::vector<std::string> capiocl::monitor::WaitList::subscribed() const {
+    std::vector<std::string> paths;
+    std::lock_guard lg(lock);
+    paths.reserve(callbacks.size());
+    for (const auto &[path, slot] : callbacks) {
+        paths.push_back(path);
+    }
+    return paths;
+}
+
+void capiocl::monitor::WaitList::notify(const std::string &path) const {
+    std::vector<std::pair<std::uint64_t, Callback>> ready;
+    {
+        std::lock_guard lg(lock);
+        if (const auto itm = slots.find(path); itm != slots.end()) {
+            for (const auto waiter : itm->second) {
+                if (!waiter->notified) {
+                    waiter->notified = true;
+                    waiter->path     = path;
+                    waiter->cv.notify_one();
+                }
+            }
+        }
+        if (const auto itm = callbacks.find(path); itm != callbacks.end()) {
+            ready = std::move(itm->second);
+            callbacks.erase(itm);
+        }
+    }
+
+    // Callbacks run without the lock, so that they may register new ones
+    for (const auto &[id, callback] : ready) {
+        callback(path);
+    }
+}
+
+void capiocl::monitor::Monitor::watch() const {
+    auto last_check = std::chrono::steady_clock::now();
+    const auto recheck = std::chrono::milliseconds(WAIT_RECHECK_INTERVAL);
+
+    std::unique_lock ul(watcher_lock);
+    while (!stop_watcher) {
+        if (polled_backends > 0) {
+            auto next = last_check + recheck;
+            if (!expirations.empty()) {
+                next = std::min(next, expirations.front().deadline);
+            }
+            watcher_cv.wait_until(ul, next);
+        } else if (!expirations.empty()) {
+            watcher_cv.wait_until(ul, expirations.front().deadline);
+        } else {
+            watcher_cv.wait(ul);
+        }
+        if (stop_watcher) {
+            break;
+        }
+
+        const auto now = std::chrono::steady_clock::now();
+        std::vector<Expiration> expired;
+        while (!expirations.empty() && expirations.front().deadline <= now) {
+            std::pop_heap(expirations.begin(), expirations.end());
+            expired.push_back(std::move(expirations.back()));
+            expirations.pop_back();
+        }
+        const bool poll = polled_backends > 0;
+        ul.unlock();
+
+        for (const auto &expiration : expired) {
+            if (!expiration.requery) {
+                expiration.list->expire(expiration.path, expiration.id);
+            } else if (this->query(expiration.path, true)) {
+                // The answer to the first query may have been lost: ask once more
+                expiration.list->notify(expiration.path);
+            }
+        }
+
+        // Commits are not notified by all the backends, such as the tokens of FileSystemMonitor
+        // written by other processes: look for the ones awaited by callbacks
+        if (poll && now >= last_check + recheck) {
+            last_check = now;
+            for (const auto &path : commit_waiters.subscribed()) {
+                if (this->query(path, false)) {
+                    commit_waiters.notify(path);
+                }
+            }
+        }
+        ul.lock();
+    }
+}
+
+void capiocl::monitor::Monitor::schedule(const Expiration *expiration) const {
+    std::lock_guard lg(watcher_lock);
+    if (!watcher.joinable()) {
+        watcher = std::thread(&Monitor::watch, this);
+    }
+    if (expiration != nullptr) {
+        expirations.push_back(*expiration);
+        std::push_heap(expirations.begin(), expirations.end());
+        watcher_cv.notify_one();
+    }
+}
+
+std::chrono::milliseconds capiocl::monitor::Monitor::queryTimeout() const {
+    std::chrono::milliseconds timeout(0);
+    for (const auto &interface : interfaces) {
+        timeout = std::max(timeout, interface->queryTimeout());
+    }
+    return timeout;
+}
+
+bool capiocl::monitor::Monitor::query(const std::string &path, const bool all) const {
+    return std::any_of(interfaces.begin(), interfaces.end(), [&](const auto &interface) {
+        return (all || !interface->notifiesCommits()) && interface->queryCommitted(path);
+    });
+}
+
 bool capiocl::monitor::Monitor::isCommitted(const std::filesystem::path &path) const {
     return std::any_of(interfaces.begin(), interfaces.end(),
                        [&path](const auto &interface) { return interface->isCommitted(path); });
@@ -14,14 +202,90 @@ bool capiocl::monitor::Monitor::isCommitted(const std::filesystem::path &path) c
 void capiocl::monitor::Monitor::setCommitted(std::filesystem::path path) const {
     std::for_each(interfaces.begin(), interfaces.end(),
                   [&path](const auto &interface) { interface->setCommitted(path); });
+    commit_waiters.notify(path);
+}
+
+bool capiocl::monitor::Monitor::waitForCommit(const std::filesystem::path &path,
+                                              const std::chrono::milliseconds timeout) const {
+    return !this->waitForAnyCommit({path}, timeout).empty();
+}
+
+std::string
+capiocl::monitor::Monitor::waitForAnyCommit(const std::vector<std::filesystem::path> &paths,
+                                            const std::chrono::milliseconds timeout) const {
+    std::vector<std::string> keys(paths.begin(), paths.end());
+
+    // Backends notifying their commits are queried on the first check, and once more when their
+    // query expires in case its answer was lost. The others are queried on every check
+    auto requery_at = std::chrono::steady_clock::now() + this->queryTimeout();
+    bool all        = true;
+    const auto check = [&]() -> std::string {
+        if (!all && std::chrono::steady_clock::now() >= requery_at) {
+            all        = true;
+            requery_at = std::chrono::steady_clock::time_point::max();
+        }
+        for (const auto &path : keys) {
+            if (this->query(path, all)) {
+                return path;
+            }
+        }
+        all = false;
+        return "";
+    };
+
+    return commit_waiters.wait(keys, std::chrono::steady_clock::now() + timeout,
+                               std::chrono::milliseconds(WAIT_RECHECK_INTERVAL), check);
+}
+
+std::future<bool>
+capiocl::monitor::Monitor::isCommittedAsync(const std::filesystem::path &path) const {
+    const auto promise = std::make_shared<std::promise<bool>>();
+    auto future        = promise->get_future();
+
+    // Subscribe before querying the backends, so that an answer received meanwhile is not lost
+    const auto id = commit_waiters.subscribe(
+        path, [promise](const std::string &committed) { promise->set_value(!committed.empty()); });
+    if (this->query(path, true)) {
+        commit_waiters.notify(path);
+    } else if (const auto timeout = this->queryTimeout(); timeout.count() == 0) {
+        commit_waiters.expire(path, id);
+    } else {
+        const Expiration expiration = {std::chrono::steady_clock::now() + timeout, &commit_waiters,
+                                       path, id};
+        this->schedule(&expiration);
+    }
+    return future;
+}
+
+void capiocl::monitor::Monitor::onCommitted(const std::filesystem::path &path,
+                                            WaitList::Callback callback) const {
+    commit_waiters.subscribe(path, std::move(callback));
+    if (this->query(path, true)) {
+        commit_waiters.notify(path);
+    } else if (const auto timeout = this->queryTimeout(); timeout.count() > 0) {
+        // Later commits are notified by the backends, or found by the watcher polling the others
+        Expiration requery = {std::chrono::steady_clock::now() + timeout, &commit_waiters, path, 0};
+        requery.requery    = true;
+        this->schedule(&requery);
+    } else {
+        this->schedule(nullptr);
+    }
 }
 
 void capiocl::monitor::Monitor::registerMonitorBackend(const MonitorInterface *interface) {
+    interface->commit_waiters    = &commit_waiters;
+    interface->home_node_waiters = &home_node_waiters;
+    if (!interface->notifiesCommits()) {
+        std::lock_guard lg(watcher_lock);
+        polled_backends++;
+        watcher_cv.notify_one();
+    }
     interfaces.emplace_back(interface);
 }
 void capiocl::monitor::Monitor::setHomeNode(const std::filesystem::path &path) const {
     std::for_each(interfaces.begin(), interfaces.end(),
                   [&path](const auto &interface) { interface->setHomeNode(path); });
+    home_node_waiters.notify(path);
 }
 
 std::set<std::string>
@@ -37,7 +301,74 @@ capiocl::monitor::Monitor::getHomeNode(const std::filesystem::path &path) const
     return home_nodes;
 }
 
+std::future<std::set<std::string>>
+capiocl::monitor::Monitor::getHomeNodeAsync(const std::filesystem::path &path) const {
+    const auto query = [this, path] {
+        std::set<std::string> home_nodes;
+        for (const auto &interface : interfaces) {
+            if (const auto &node = interface->queryHomeNode(path); node != NO_HOME_NODE) {
+                home_nodes.insert(node);
+            }
+        }
+        return home_nodes;
+    };
+
+    const auto promise = std::make_shared<std::promise<std::set<std::string>>>();
+    auto future        = promise->get_future();
+
+    const auto id = home_node_waiters.subscribe(
+        path, [promise, query](const std::string &) { promise->set_value(query()); });
+    if (!query().empty()) {
+        home_node_waiters.notify(path);
+    } else if (const auto timeout = this->queryTimeout(); timeout.count() == 0) {
+        home_node_waiters.expire(path, id);
+    } else {
+        const Expiration expiration = {std::chrono::steady_clock::now() + timeout,
+                                       &home_node_waiters, path, id};
+        this->schedule(&expiration);
+    }
+    return future;
+}
+
+std::uint64_t capiocl::monitor::Monitor::messagesSent() const {
+    std::uint64_t sent = 0;
+    for (const auto &interface : interfaces) {
+        sent += interface->messagesSent();
+    }
+    return sent;
+}
+
+std::uint64_t capiocl::monitor::Monitor::datagramsSent() const {
+    std::uint64_t datagrams = 0;
+    for (const auto &interface : interfaces) {
+        datagrams += interface->datagramsSent();
+    }
+    return datagrams;
+}
+
+std::uint64_t capiocl::monitor::Monitor::batchesFlushed() const {
+    std::uint64_t batches = 0;
+    for (const auto &interface : interfaces) {
+        batches += interface->batchesFlushed();
+    }
+    return batches;
+}
+
 capiocl::monitor::Monitor::~Monitor() {
+    {
+        std::lock_guard lg(watcher_lock);
+        stop_watcher = true;
+    }
+    watcher_cv.notify_one();
+    if (watcher.joinable()) {
+        watcher.join();
+    }
+
+    // Backends still running stop notifying before any of them is deleted
+    for (const auto &interface : interfaces) {
+        interface->commit_waiters    = nullptr;
+        interface->home_node_waiters = nullptr;
+    }
     for (const auto &interface : interfaces) {
         delete interface;
     }
@@ -1,5 +1,6 @@
 #include <filesystem>
 #include <fstream>
+#include <stdexcept>
 
 #include "capiocl.hpp"
 #include "capiocl/engine.h"
@@ -69,11 +70,16 @@ capiocl::engine::Engine *capiocl::parser::Parser::parse(const std::filesystem::p
     printer::print(printer::CLI_LEVEL_INFO,
                    "Parsing CAPIO-CL config file for version: " + capio_cl_release);
 
-    if (capio_cl_release == CAPIO_CL_VERSION::V1) {
-        return available_parsers::parse_v1(source, resolve_prefix, store_only_in_memory);
-    } else if (capio_cl_release == CAPIO_CL_VERSION::V1_1) {
-        return available_parsers::parse_v1_1(source, resolve_prefix, store_only_in_memory);
-    } else {
-        throw ParserException("Invalid CAPIO-CL specification version!");
+    try {
+        if (capio_cl_release == CAPIO_CL_VERSION::V1) {
+            return available_parsers::parse_v1(source, resolve_prefix, store_only_in_memory);
+        } else if (capio_cl_release == CAPIO_CL_VERSION::V1_1) {
+            return available_parsers::parse_v1_1(source, resolve_prefix, store_only_in_memory);
+        }
+    } catch (const std::invalid_argument &e) {
+        // Raised by the Engine on rules it cannot accept, such as circular file dependencies
+        printer::print(printer::CLI_LEVEL_ERROR, e.what());
+        throw ParserException("Invalid CAPIO-CL configuration: " + std::string(e.what()));
     }
+    throw ParserException("Invalid CAPIO-CL specification version!");
 }
\ No newline at end of file
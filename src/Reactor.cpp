@@ -0,0 +1,206 @@
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#else
+#include <poll.h>
+#endif
+
+#include "capiocl/monitor.h"
+#include "capiocl/reactor.h"
+
+capiocl::monitor::Reactor::Reactor() {
+#ifdef __linux__
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    wake_fd  = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    // LCOV_EXCL_START
+    if (epoll_fd < 0 || wake_fd < 0) {
+        throw MonitorException(std::string("reactor setup failed: ") + strerror(errno));
+    }
+    // LCOV_EXCL_STOP
+    wake_read_fd = wake_fd;
+
+    epoll_event event{};
+    event.events  = EPOLLIN;
+    event.data.fd = wake_read_fd;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wake_read_fd, &event);
+#else
+    int fds[2];
+    // LCOV_EXCL_START
+    if (pipe(fds) < 0) {
+        throw MonitorException(std::string("reactor setup failed: ") + strerror(errno));
+    }
+    // LCOV_EXCL_STOP
+    wake_read_fd = fds[0];
+    wake_fd      = fds[1];
+    fcntl(wake_read_fd, F_SETFL, O_NONBLOCK);
+    fcntl(wake_fd, F_SETFL, O_NONBLOCK);
+#endif
+
+    loop = std::thread(&Reactor::run, this);
+}
+
+capiocl::monitor::Reactor::~Reactor() {
+    {
+        std::lock_guard lg(lock);
+        stop = true;
+    }
+    this->wake();
+    if (loop.joinable()) {
+        loop.join();
+    }
+
+    close(wake_fd);
+    if (wake_read_fd != wake_fd) {
+        close(wake_read_fd);
+    }
+    if (epoll_fd >= 0) {
+        close(epoll_fd);
+    }
+}
+
+std::shared_ptr<capiocl::monitor::Reactor> capiocl::monitor::Reactor::instance() {
+    static std::mutex instance_lock;
+    static std::weak_ptr<Reactor> current;
+
+    std::lock_guard lg(instance_lock);
+    auto reactor = current.lock();
+    if (reactor == nullptr) {
+        reactor = std::make_shared<Reactor>();
+        current = reactor;
+    }
+    return reactor;
+}
+
+void capiocl::monitor::Reactor::wake() const {
+#ifdef __linux__
+    constexpr std::uint64_t one = 1;
+    [[maybe_unused]] const auto written = write(wake_fd, &one, sizeof(one));
+#else
+    constexpr char one = 1;
+    [[maybe_unused]] const auto written = write(wake_fd, &one, sizeof(one));
+#endif
+}
+
+void capiocl::monitor::Reactor::add(const int fd, Handler handler) {
+    std::lock_guard lg(lock);
+    handlers[fd] = std::make_shared<Handler>(std::move(handler));
+#ifdef __linux__
+    epoll_event event{};
+    event.events  = EPOLLIN;
+    event.data.fd = fd;
+    // LCOV_EXCL_START
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) < 0) {
+        handlers.erase(fd);
+        throw MonitorException(std::string("epoll_ctl() failed: ") + strerror(errno));
+    }
+    // LCOV_EXCL_STOP
+#else
+    // The loop rebuilds its set of descriptors when woken
+    this->wake();
+#endif
+}
+
+void capiocl::monitor::Reactor::remove(const int fd) {
+    std::unique_lock ul(lock);
+    handlers.erase(fd);
+#ifdef __linux__
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+#else
+    this->wake();
+#endif
+
+    // A handler removing its own socket cannot wait for itself
+    if (std::this_thread::get_id() != loop.get_id()) {
+        handler_done.wait(ul, [this, fd] { return running != fd; });
+    }
+}
+
+void capiocl::monitor::Reactor::dispatch(const int fd) {
+    std::shared_ptr<Handler> handler;
+    {
+        std::lock_guard lg(lock);
+        const auto itm = handlers.find(fd);
+        if (stop || itm == handlers.end()) {
+            return;
+        }
+        handler = itm->second;
+        running = fd;
+    }
+
+    (*handler)(fd);
+
+    {
+        std::lock_guard lg(lock);
+        running = -1;
+    }
+    handler_done.notify_all();
+}
+
+void capiocl::monitor::Reactor::run() {
+    char drain[64];
+
+#ifdef __linux__
+    std::array<epoll_event, 64> events{};
+    while (true) {
+        const int ready = epoll_wait(epoll_fd, events.data(), events.size(), -1);
+        // LCOV_EXCL_START
+        if (ready < 0 && errno != EINTR) {
+            return;
+        }
+        // LCOV_EXCL_STOP
+
+        for (int i = 0; i < ready; i++) {
+            if (const int fd = events[i].data.fd; fd == wake_read_fd) {
+                while (read(wake_read_fd, drain, sizeof(drain)) > 0) {
+                }
+            } else {
+                this->dispatch(fd);
+            }
+        }
+
+        std::lock_guard lg(lock);
+        if (stop) {
+            return;
+        }
+    }
+#else
+    std::vector<pollfd> fds;
+    while (true) {
+        fds.clear();
+        fds.push_back({wake_read_fd, POLLIN, 0});
+        {
+            std::lock_guard lg(lock);
+            if (stop) {
+                return;
+            }
+            for (const auto &[fd, handler] : handlers) {
+                fds.push_back({fd, POLLIN, 0});
+            }
+        }
+
+        // LCOV_EXCL_START
+        if (poll(fds.data(), fds.size(), -1) < 0 && errno != EINTR) {
+            return;
+        }
+        // LCOV_EXCL_STOP
+
+        if (fds[0].revents != 0) {
+            while (read(wake_read_fd, drain, sizeof(drain)) > 0) {
+            }
+        }
+        for (std::size_t i = 1; i < fds.size(); i++) {
+            if (fds[i].revents != 0) {
+                this->dispatch(fds[i].fd);
+            }
+        }
+    }
+#endif
+}
@@ -0,0 +1,36 @@
+#include <algorithm>
+#include <vector>
+
+#include "capiocl/rtt.h"
+
+capiocl::monitor::RttEstimator::RttEstimator(const unsigned percentile, const unsigned factor,
+                                             const std::chrono::microseconds floor,
+                                             const std::chrono::microseconds ceiling)
+    : percentile(std::clamp(percentile, 1U, 100U)), factor(std::max(factor, 1U)),
+      floor(std::min(floor, ceiling)), ceiling(ceiling), current(ceiling.count()) {}
+
+void capiocl::monitor::RttEstimator::record(const std::chrono::microseconds rtt) {
+    std::lock_guard lg(lock);
+    samples[recorded % WINDOW] = rtt.count();
+    recorded++;
+    if (recorded < MIN_SAMPLES) {
+        return;
+    }
+
+    std::vector<std::int64_t> window(samples.begin(),
+                                     samples.begin() + std::min(recorded, WINDOW));
+    const auto rank = (window.size() * percentile + 99) / 100 - 1;
+    std::nth_element(window.begin(), window.begin() + rank, window.end());
+
+    const auto timeout = std::clamp(window[rank] * factor, floor.count(), ceiling.count());
+    current.store(timeout, std::memory_order_relaxed);
+}
+
+std::chrono::microseconds capiocl::monitor::RttEstimator::timeout() const {
+    return std::chrono::microseconds(current.load(std::memory_order_relaxed));
+}
+
+std::size_t capiocl::monitor::RttEstimator::size() {
+    std::lock_guard lg(lock);
+    return recorded;
+}
@@ -0,0 +1,173 @@
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cstring>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "capiocl/frame.h"
+#include "capiocl/monitor.h"
+#include "capiocl/sender.h"
+
+capiocl::monitor::MulticastSender::MulticastSender(const std::size_t batch_size,
+                                                   const std::chrono::microseconds max_delay,
+                                                   const std::size_t max_datagram,
+                                                   const bool prefix_compression)
+    : batch_size(std::max<std::size_t>(batch_size, 1)), max_delay(max_delay),
+      max_datagram(max_datagram), prefix_compression(prefix_compression) {
+    socket_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    // LCOV_EXCL_START
+    if (socket_fd < 0) {
+        throw MonitorException(std::string("socket() failed: ") + strerror(errno));
+    }
+    // LCOV_EXCL_STOP
+
+    flusher = std::thread(&MulticastSender::run, this);
+}
+
+capiocl::monitor::MulticastSender::~MulticastSender() {
+    {
+        std::lock_guard lg(lock);
+        stop = true;
+    }
+    cv.notify_one();
+    if (flusher.joinable()) {
+        flusher.join();
+    }
+    close(socket_fd);
+}
+
+void capiocl::monitor::MulticastSender::send(const std::string &ip_addr, const int ip_port,
+                                             const char command, std::string payload) {
+    Message message{};
+    message.destination.sin_family      = AF_INET;
+    message.destination.sin_addr.s_addr = inet_addr(ip_addr.c_str());
+    message.destination.sin_port        = htons(ip_port);
+    message.command                     = command;
+    message.payload                     = std::move(payload);
+
+    std::lock_guard lg(lock);
+    if (pending.empty()) {
+        oldest = std::chrono::steady_clock::now();
+    }
+    pending_bytes += message.payload.size() + 3;
+    pending.push_back(std::move(message));
+
+    // The flusher sleeps until the first message, then until the batch is full or too old
+    if (pending.size() == 1 || pending_bytes >= batch_size * max_datagram) {
+        cv.notify_one();
+    }
+}
+
+void capiocl::monitor::MulticastSender::run() {
+    std::vector<Message> batch;
+    std::unique_lock ul(lock);
+    while (true) {
+        cv.wait(ul, [this] { return stop || !pending.empty(); });
+        if (pending.empty()) {
+            return;
+        }
+
+        // Give the following messages the chance to join the batch of the first one
+        if (max_delay.count() > 0) {
+            cv.wait_until(ul, oldest + max_delay,
+                          [this] { return stop || pending_bytes >= batch_size * max_datagram; });
+        }
+
+        batch.swap(pending);
+        pending_bytes = 0;
+        ul.unlock();
+        sendBatches(pack(batch));
+        batch.clear();
+        ul.lock();
+    }
+}
+
+std::vector<capiocl::monitor::MulticastSender::Datagram>
+capiocl::monitor::MulticastSender::pack(std::vector<Message> &messages) const {
+    // Group the messages by destination. The sort is stable, so that each destination receives
+    // its messages in the order they were sent
+    const auto key = [](const Message &message) {
+        return (static_cast<std::uint64_t>(message.destination.sin_addr.s_addr) << 16) |
+               message.destination.sin_port;
+    };
+    std::stable_sort(messages.begin(), messages.end(),
+                     [&key](const Message &a, const Message &b) { return key(a) < key(b); });
+
+    std::vector<Datagram> datagrams;
+    MessageFrame frame(max_datagram, prefix_compression);
+    for (std::size_t i = 0; i < messages.size(); i++) {
+        const auto &message = messages[i];
+        if (!frame.add(message.command, message.payload)) {
+            const auto count = frame.size();
+            datagrams.push_back({message.destination, frame.take(), count});
+            frame.add(message.command, message.payload);
+        }
+        if (i + 1 == messages.size() || key(messages[i + 1]) != key(message)) {
+            const auto count = frame.size();
+            datagrams.push_back({message.destination, frame.take(), count});
+        }
+    }
+    return datagrams;
+}
+
+void capiocl::monitor::MulticastSender::sendBatches(const std::vector<Datagram> &datagrams) {
+#ifdef __linux__
+    std::vector<mmsghdr> headers(std::min(datagrams.size(), batch_size));
+    std::vector<iovec> buffers(headers.size());
+
+    for (std::size_t first = 0; first < datagrams.size(); first += headers.size()) {
+        const auto count = std::min(headers.size(), datagrams.size() - first);
+        for (std::size_t i = 0; i < count; i++) {
+            const auto &datagram = datagrams[first + i];
+            buffers[i].iov_base  = const_cast<char *>(datagram.content.data());
+            buffers[i].iov_len   = datagram.content.size();
+
+            headers[i]                     = {};
+            headers[i].msg_hdr.msg_name    = const_cast<sockaddr_in *>(&datagram.destination);
+            headers[i].msg_hdr.msg_namelen = sizeof(datagram.destination);
+            headers[i].msg_hdr.msg_iov     = &buffers[i];
+            headers[i].msg_hdr.msg_iovlen  = 1;
+        }
+
+        // sendmmsg() stops at the first datagram it fails to send: skip it and send the others
+        std::size_t sent = 0;
+        while (sent < count) {
+            const int result = sendmmsg(socket_fd, headers.data() + sent, count - sent, 0);
+            batches_flushed.fetch_add(1, std::memory_order_relaxed);
+            if (result <= 0) {
+                sent++; // LCOV_EXCL_LINE
+                continue;
+            }
+            for (int j = 0; j < result; j++) {
+                messages_sent.fetch_add(datagrams[first + sent + j].messages,
+                                        std::memory_order_relaxed);
+            }
+            datagrams_sent.fetch_add(result, std::memory_order_relaxed);
+            sent += result;
+        }
+    }
+#else
+    // Without sendmmsg() each datagram costs a system call, but still uses the same socket
+    for (const auto &datagram : datagrams) {
+        if (sendto(socket_fd, datagram.content.data(), datagram.content.size(), 0,
+                   reinterpret_cast<const sockaddr *>(&datagram.destination),
+                   sizeof(datagram.destination)) >= 0) {
+            messages_sent.fetch_add(datagram.messages, std::memory_order_relaxed);
+            datagrams_sent.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    batches_flushed.fetch_add(1, std::memory_order_relaxed);
+#endif
+}
+
+std::uint64_t capiocl::monitor::MulticastSender::messagesSent() const {
+    return messages_sent.load(std::memory_order_relaxed);
+}
+
+std::uint64_t capiocl::monitor::MulticastSender::datagramsSent() const {
+    return datagrams_sent.load(std::memory_order_relaxed);
+}
+
+std::uint64_t capiocl::monitor::MulticastSender::batchesFlushed() const {
+    return batches_flushed.load(std::memory_order_relaxed);
+}
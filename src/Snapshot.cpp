@@ -0,0 +1,383 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <type_traits>
+#include <unistd.h>
+#include <unordered_map>
+
+#include "capiocl/hash.h"
+#include "capiocl/printer.h"
+#include "capiocl/snapshot.h"
+
+/// @brief Magic bytes at the start of every snapshot file
+static constexpr char MAGIC[8] = {'C', 'A', 'P', 'I', 'O', 'C', 'L', 'S'};
+
+/// @brief Value of Header::byte_order, read back unchanged only on machines of the same order
+static constexpr std::uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+/// @brief Bits of Record::flags
+enum RECORD_FLAGS : std::uint8_t {
+    ENABLE_DIRECTORY_COUNT_UPDATE = 1 << 0,
+    STORE_IN_MEMORY               = 1 << 1,
+    PERMANENT                     = 1 << 2,
+    EXCLUDED                      = 1 << 3,
+    IS_FILE                       = 1 << 4,
+};
+
+/// @brief Bits of Header::flags
+enum HEADER_FLAGS : std::uint32_t { STORE_ALL_IN_MEMORY = 1 << 0 };
+
+struct capiocl::snapshot::Image::StringRef {
+    /// @brief Offset of the string within the pool
+    std::uint32_t offset;
+    /// @brief Length of the string
+    std::uint32_t length;
+};
+
+struct capiocl::snapshot::Image::Header {
+    /// @brief Always #MAGIC
+    char magic[8];
+    /// @brief Version of the format
+    std::uint32_t version;
+    /// @brief Always #BYTE_ORDER_MARK
+    std::uint32_t byte_order;
+    /// @brief Size of the whole file
+    std::uint64_t file_size;
+    /// @brief Offset and size of the string pool
+    std::uint64_t strings_offset, strings_size;
+    /// @brief Offset and number of the list references
+    std::uint64_t lists_offset, lists_count;
+    /// @brief Offset and number of the records
+    std::uint64_t records_offset, records_count;
+    /// @brief Offset and number of the hash index buckets, a power of two
+    std::uint64_t buckets_offset, buckets_count;
+    /// @brief Number of records of glob rules, at the start of the records
+    std::uint64_t rules_count;
+    /// @brief Name of the workflow
+    StringRef workflow_name;
+    /// @brief HEADER_FLAGS
+    std::uint32_t flags;
+    /// @brief Padding, always zero
+    std::uint32_t reserved;
+};
+
+struct capiocl::snapshot::Image::Record {
+    /// @brief Path or glob pattern
+    StringRef path;
+    /// @brief Expected number of files in the directory
+    std::int64_t directory_children_count;
+    /// @brief Expected close count
+    std::int64_t commit_on_close_count;
+    /// @brief First reference and number of the producers
+    std::uint32_t producers, producers_count;
+    /// @brief First reference and number of the consumers
+    std::uint32_t consumers, consumers_count;
+    /// @brief First reference and number of the Commit on File dependencies
+    std::uint32_t dependencies, dependencies_count;
+    /// @brief Commit rule, as the value of commitRules::COMMIT_RULE
+    std::uint8_t commit_rule;
+    /// @brief Fire rule, as the value of fireRules::FIRE_RULE
+    std::uint8_t fire_rule;
+    /// @brief RECORD_FLAGS
+    std::uint8_t flags;
+    /// @brief Padding, always zero
+    std::uint8_t reserved[5];
+};
+
+/// @brief Round @p value up to a multiple of 8
+static std::uint64_t align8(const std::uint64_t value) { return (value + 7) & ~std::uint64_t(7); }
+
+capiocl::snapshot::SnapshotException::SnapshotException(const std::string &msg) : message(msg) {
+    printer::print(printer::CLI_LEVEL_ERROR, msg);
+}
+
+void capiocl::snapshot::Image::save(
+    const std::filesystem::path &path, const std::string &workflow_name,
+    const bool store_all_in_memory,
+    const std::vector<std::pair<std::string, engine::CapioCLEntry>> &rules,
+    const std::vector<std::pair<std::string, engine::CapioCLEntry>> &entries) {
+    static_assert(std::is_trivially_copyable_v<Header> && std::is_trivially_copyable_v<Record>,
+                  "Snapshot sections are written and mapped as they are");
+
+    const auto records_count = rules.size() + entries.size();
+    if (records_count >= UINT32_MAX) {
+        throw SnapshotException("Too many entries for a CAPIO-CL snapshot: " +
+                                std::to_string(records_count));
+    }
+
+    // Strings are stored once, however many records refer to them
+    std::string pool;
+    std::unordered_map<std::string, StringRef> interned;
+    const auto intern = [&](const std::string &value) {
+        if (const auto itm = interned.find(value); itm != interned.end()) {
+            return itm->second;
+        }
+        if (pool.size() + value.size() > UINT32_MAX) {
+            throw SnapshotException("String pool of CAPIO-CL snapshot exceeds 4GB");
+        }
+        const StringRef ref{static_cast<std::uint32_t>(pool.size()),
+                            static_cast<std::uint32_t>(value.size())};
+        pool += value;
+        return interned.emplace(value, ref).first->second;
+    };
+
+    std::vector<StringRef> lists;
+    const auto append = [&](const auto &values, std::uint32_t &first, std::uint32_t &count) {
+        first = static_cast<std::uint32_t>(lists.size());
+        count = 0;
+        for (const auto &value : values) {
+            lists.push_back(intern(std::string(value)));
+            count++;
+        }
+    };
+
+    std::vector<Record> records;
+    records.reserve(records_count);
+    for (const auto *table : {&rules, &entries}) {
+        for (const auto &[name, entry] : *table) {
+            Record record{};
+            record.path                     = intern(name);
+            record.directory_children_count = entry.directory_children_count;
+            record.commit_on_close_count    = entry.commit_on_close_count;
+            append(entry.producers, record.producers, record.producers_count);
+            append(entry.consumers, record.consumers, record.consumers_count);
+            append(entry.file_dependencies, record.dependencies, record.dependencies_count);
+            record.commit_rule = static_cast<std::uint8_t>(entry.commit_rule);
+            record.fire_rule   = static_cast<std::uint8_t>(entry.fire_rule);
+            record.flags       = static_cast<std::uint8_t>(
+                (entry.enable_directory_count_update ? ENABLE_DIRECTORY_COUNT_UPDATE : 0) |
+                (entry.store_in_memory ? STORE_IN_MEMORY : 0) | (entry.permanent ? PERMANENT : 0) |
+                (entry.excluded ? EXCLUDED : 0) | (entry.is_file ? IS_FILE : 0));
+            records.push_back(record);
+        }
+    }
+
+    // Open addressing with linear probing, at most half full
+    std::uint64_t buckets_count = 1;
+    while (buckets_count < 2 * entries.size()) {
+        buckets_count <<= 1;
+    }
+    std::vector<std::uint32_t> buckets(buckets_count, 0);
+    for (std::size_t i = rules.size(); i < records.size(); i++) {
+        auto bucket = hashing::fnv1a(entries[i - rules.size()].first) & (buckets_count - 1);
+        while (buckets[bucket] != 0) {
+            bucket = (bucket + 1) & (buckets_count - 1);
+        }
+        buckets[bucket] = static_cast<std::uint32_t>(i + 1);
+    }
+
+    Header header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version        = VERSION;
+    header.byte_order     = BYTE_ORDER_MARK;
+    header.workflow_name  = intern(workflow_name);
+    header.flags          = store_all_in_memory ? std::uint32_t(STORE_ALL_IN_MEMORY) : 0;
+    header.rules_count    = rules.size();
+    header.strings_offset = align8(sizeof(Header));
+    header.strings_size   = pool.size();
+    header.lists_offset   = align8(header.strings_offset + header.strings_size);
+    header.lists_count    = lists.size();
+    header.records_offset = align8(header.lists_offset + lists.size() * sizeof(StringRef));
+    header.records_count  = records.size();
+    header.buckets_offset = align8(header.records_offset + records.size() * sizeof(Record));
+    header.buckets_count  = buckets_count;
+    header.file_size      = header.buckets_offset + buckets_count * sizeof(std::uint32_t);
+
+    // Processes that mapped a previous snapshot keep their pages: replace the file, not its content
+    auto temporary = path;
+    temporary += ".tmp" + std::to_string(getpid());
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        const auto section = [&](const std::uint64_t offset, const void *data,
+                                 const std::size_t size) {
+            out.seekp(static_cast<std::streamoff>(offset));
+            out.write(static_cast<const char *>(data), static_cast<std::streamsize>(size));
+        };
+        section(0, &header, sizeof(header));
+        section(header.strings_offset, pool.data(), pool.size());
+        section(header.lists_offset, lists.data(), lists.size() * sizeof(StringRef));
+        section(header.records_offset, records.data(), records.size() * sizeof(Record));
+        section(header.buckets_offset, buckets.data(), buckets.size() * sizeof(std::uint32_t));
+        out.close();
+        if (!out) {
+            std::filesystem::remove(temporary);
+            throw SnapshotException("Unable to write CAPIO-CL snapshot: " + path.string());
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporary, path, error);
+    if (error) {
+        std::filesystem::remove(temporary);
+        throw SnapshotException("Unable to write CAPIO-CL snapshot: " + path.string() + ": " +
+                                error.message());
+    }
+}
+
+capiocl::snapshot::Image::Image(const std::filesystem::path &path) {
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw SnapshotException("Unable to open CAPIO-CL snapshot: " + path.string() + ": " +
+                                std::strerror(errno));
+    }
+
+    struct stat st {};
+    if (fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < sizeof(Header)) {
+        close(fd);
+        throw SnapshotException("Not a CAPIO-CL snapshot: " + path.string());
+    }
+
+    length    = static_cast<std::size_t>(st.st_size);
+    void *map = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        throw SnapshotException("Unable to map CAPIO-CL snapshot: " + path.string() + ": " +
+                                std::strerror(errno));
+    }
+    base   = static_cast<const char *>(map);
+    header = reinterpret_cast<const Header *>(base);
+
+    // Check that every section lies within the file, without reading the sections themselves
+    const auto within = [&](const std::uint64_t offset, const std::uint64_t count,
+                            const std::size_t size) {
+        return offset % 8 == 0 && offset <= length && count <= (length - offset) / size;
+    };
+    if (std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0 || header->version != VERSION ||
+        header->byte_order != BYTE_ORDER_MARK || header->file_size != length ||
+        !within(header->strings_offset, header->strings_size, 1) ||
+        !within(header->lists_offset, header->lists_count, sizeof(StringRef)) ||
+        !within(header->records_offset, header->records_count, sizeof(Record)) ||
+        !within(header->buckets_offset, header->buckets_count, sizeof(std::uint32_t)) ||
+        header->records_count >= UINT32_MAX || header->rules_count > header->records_count ||
+        header->buckets_count == 0 || (header->buckets_count & (header->buckets_count - 1)) != 0) {
+        munmap(map, length);
+        throw SnapshotException("Not a CAPIO-CL snapshot, or saved by another version or "
+                                "architecture: " +
+                                path.string());
+    }
+
+    strings = base + header->strings_offset;
+    lists   = reinterpret_cast<const StringRef *>(base + header->lists_offset);
+    records = reinterpret_cast<const Record *>(base + header->records_offset);
+    buckets = reinterpret_cast<const std::uint32_t *>(base + header->buckets_offset);
+
+    const auto literals = header->records_count - header->rules_count;
+    claims              = std::vector<std::atomic<std::uint64_t>>((literals + 63) / 64);
+    unclaimed_count     = literals;
+}
+
+capiocl::snapshot::Image::~Image() { munmap(const_cast<char *>(base), length); }
+
+std::string_view capiocl::snapshot::Image::string(const StringRef &ref) const {
+    if (ref.offset > header->strings_size || ref.length > header->strings_size - ref.offset) {
+        throw SnapshotException("Corrupted CAPIO-CL snapshot: string out of the pool");
+    }
+    return {strings + ref.offset, ref.length};
+}
+
+std::vector<std::string_view> capiocl::snapshot::Image::list(const std::uint32_t first,
+                                                            const std::uint32_t count) const {
+    if (first > header->lists_count || count > header->lists_count - first) {
+        throw SnapshotException("Corrupted CAPIO-CL snapshot: list out of the references");
+    }
+
+    std::vector<std::string_view> values;
+    values.reserve(count);
+    for (std::uint32_t i = 0; i < count; i++) {
+        values.push_back(this->string(lists[first + i]));
+    }
+    return values;
+}
+
+std::string_view capiocl::snapshot::Image::workflowName() const {
+    return this->string(header->workflow_name);
+}
+
+bool capiocl::snapshot::Image::storeAllInMemory() const {
+    return (header->flags & STORE_ALL_IN_MEMORY) != 0;
+}
+
+std::size_t capiocl::snapshot::Image::rules() const { return header->rules_count; }
+
+std::size_t capiocl::snapshot::Image::size() const { return header->records_count; }
+
+std::size_t capiocl::snapshot::Image::find(const std::string_view path) const {
+    const auto mask = header->buckets_count - 1;
+    auto bucket     = hashing::fnv1a(path) & mask;
+    for (std::uint64_t probes = 0; probes <= mask; probes++) {
+        const auto slot = buckets[bucket];
+        if (slot == 0) {
+            return NONE;
+        }
+        if (const std::size_t position = slot - 1;
+            position >= header->rules_count && position < header->records_count &&
+            this->path(position) == path) {
+            return position;
+        }
+        bucket = (bucket + 1) & mask;
+    }
+    return NONE;
+}
+
+std::string_view capiocl::snapshot::Image::path(const std::size_t position) const {
+    return this->string(records[position].path);
+}
+
+capiocl::engine::CapioCLEntry capiocl::snapshot::Image::entry(const std::size_t position) const {
+    const auto &record = records[position];
+    if (record.commit_rule > static_cast<std::uint8_t>(commitRules::COMMIT_RULE::ON_TERMINATION) ||
+        record.fire_rule > static_cast<std::uint8_t>(fireRules::FIRE_RULE::UPDATE)) {
+        throw SnapshotException("Corrupted CAPIO-CL snapshot: unknown rule of " +
+                                std::string(this->path(position)));
+    }
+
+    engine::CapioCLEntry entry;
+    for (const auto name : this->list(record.producers, record.producers_count)) {
+        entry.producers.insert(std::string(name));
+    }
+    for (const auto name : this->list(record.consumers, record.consumers_count)) {
+        entry.consumers.insert(std::string(name));
+    }
+    for (const auto dependency : this->list(record.dependencies, record.dependencies_count)) {
+        entry.file_dependencies.emplace_back(dependency);
+    }
+    entry.directory_children_count      = record.directory_children_count;
+    entry.commit_on_close_count         = record.commit_on_close_count;
+    entry.commit_rule                   = static_cast<commitRules::COMMIT_RULE>(record.commit_rule);
+    entry.fire_rule                     = static_cast<fireRules::FIRE_RULE>(record.fire_rule);
+    entry.enable_directory_count_update = (record.flags & ENABLE_DIRECTORY_COUNT_UPDATE) != 0;
+    entry.store_in_memory               = (record.flags & STORE_IN_MEMORY) != 0;
+    entry.permanent                     = (record.flags & PERMANENT) != 0;
+    entry.excluded                      = (record.flags & EXCLUDED) != 0;
+    entry.is_file                       = (record.flags & IS_FILE) != 0;
+    return entry;
+}
+
+std::vector<std::string_view>
+capiocl::snapshot::Image::dependencies(const std::size_t position) const {
+    return this->list(records[position].dependencies, records[position].dependencies_count);
+}
+
+bool capiocl::snapshot::Image::claimed(const std::size_t position) const {
+    const auto literal = position - header->rules_count;
+    const auto bit     = std::uint64_t(1) << (literal % 64);
+    return (claims[literal / 64].load(std::memory_order_acquire) & bit) != 0;
+}
+
+bool capiocl::snapshot::Image::claim(const std::size_t position) const {
+    const auto literal = position - header->rules_count;
+    const auto bit     = std::uint64_t(1) << (literal % 64);
+    if ((claims[literal / 64].fetch_or(bit, std::memory_order_acq_rel) & bit) != 0) {
+        return false;
+    }
+    unclaimed_count.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+std::size_t capiocl::snapshot::Image::unclaimed() const {
+    return unclaimed_count.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,125 @@
+#include <algorithm>
+
+#include "capiocl/stats.h"
+
+double capiocl::engine::LatencyHistogram::mean() const {
+    return count == 0 ? 0 : static_cast<double>(total_ns) / static_cast<double>(count);
+}
+
+std::uint64_t capiocl::engine::LatencyHistogram::percentile(const double p) const {
+    if (count == 0) {
+        return 0;
+    }
+
+    // Rank of the percentile among the calls, starting from 1
+    const auto rank = std::max<std::uint64_t>(
+        1, static_cast<std::uint64_t>(p / 100.0 * static_cast<double>(count) + 0.5));
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < BUCKETS; i++) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            return std::uint64_t(1) << (i + 1);
+        }
+    }
+    return std::uint64_t(1) << BUCKETS;
+}
+
+double capiocl::engine::EngineStats::hitRatio() const {
+    const auto lookups = lookup_hits + lookup_misses;
+    return lookups == 0 ? 0 : static_cast<double>(lookup_hits) / static_cast<double>(lookups);
+}
+
+const char *capiocl::engine::StatsCollector::name(const METHOD method) {
+    switch (method) {
+    case NEW_FILE:
+        return "newFile";
+    case QUERY:
+        return "query";
+    case UPDATE:
+        return "update";
+    case REMOVE:
+        return "remove";
+    case QUERY_BATCH:
+        return "queryBatch";
+    case SET_COMMITTED:
+        return "setCommitted";
+    case NOTIFY_CLOSE:
+        return "notifyClose";
+    default:
+        return "";
+    }
+}
+
+#ifdef CAPIO_CL_ENABLE_STATS
+
+capiocl::engine::StatsCollector::Slot &capiocl::engine::StatsCollector::slot() const {
+    // Threads are assigned slots round robin, the first time they record a statistic
+    static std::atomic<std::size_t> next_slot = 0;
+    thread_local const std::size_t index = next_slot.fetch_add(1, std::memory_order_relaxed);
+    return slots[index % SLOTS];
+}
+
+void capiocl::engine::StatsCollector::record(
+    const METHOD method, const std::chrono::steady_clock::duration latency) const {
+    const auto ns = static_cast<std::uint64_t>(
+        std::max<std::int64_t>(0, std::chrono::nanoseconds(latency).count()));
+
+    // Index of the highest bit set, so that bucket i holds [2^i, 2^(i+1)) nanoseconds
+    std::size_t bucket = 0;
+    for (auto value = ns; value > 1 && bucket + 1 < LatencyHistogram::BUCKETS; value >>= 1) {
+        bucket++;
+    }
+
+    auto &target = slot();
+    target.buckets[method][bucket].fetch_add(1, std::memory_order_relaxed);
+    target.total_ns[method].fetch_add(ns, std::memory_order_relaxed);
+}
+
+void capiocl::engine::StatsCollector::wait(
+    const std::chrono::steady_clock::duration duration) const {
+    this->add(LOCK_WAIT_NS,
+              static_cast<std::uint64_t>(std::chrono::nanoseconds(duration).count()));
+}
+
+capiocl::engine::EngineStats capiocl::engine::StatsCollector::snapshot() const {
+    EngineStats stats;
+    stats.enabled = true;
+
+    std::array<std::uint64_t, COUNTERS> counters{};
+    std::array<LatencyHistogram, METHODS> histograms{};
+    for (const auto &slot : slots) {
+        for (std::size_t c = 0; c < COUNTERS; c++) {
+            counters[c] += slot.counters[c].load(std::memory_order_relaxed);
+        }
+        for (std::size_t m = 0; m < METHODS; m++) {
+            for (std::size_t b = 0; b < LatencyHistogram::BUCKETS; b++) {
+                const auto calls = slot.buckets[m][b].load(std::memory_order_relaxed);
+                histograms[m].buckets[b] += calls;
+                histograms[m].count += calls;
+            }
+            histograms[m].total_ns += slot.total_ns[m].load(std::memory_order_relaxed);
+        }
+    }
+
+    stats.materializations = counters[MATERIALIZATIONS];
+    stats.glob_comparisons = counters[GLOB_COMPARISONS];
+    stats.lookup_hits      = counters[LOOKUP_HITS];
+    stats.lookup_misses    = counters[LOOKUP_MISSES];
+    stats.exclusive_locks  = counters[EXCLUSIVE_LOCKS];
+    stats.shared_locks     = counters[SHARED_LOCKS];
+    stats.lock_wait_ns     = counters[LOCK_WAIT_NS];
+    for (std::size_t m = 0; m < METHODS; m++) {
+        stats.latencies.emplace(name(static_cast<METHOD>(m)), histograms[m]);
+    }
+    return stats;
+}
+
+#else
+
+void capiocl::engine::StatsCollector::record(METHOD, std::chrono::steady_clock::duration) const {}
+
+void capiocl::engine::StatsCollector::wait(std::chrono::steady_clock::duration) const {}
+
+capiocl::engine::EngineStats capiocl::engine::StatsCollector::snapshot() const { return {}; }
+
+#endif
@@ -0,0 +1,83 @@
+#include "capiocl/tree.h"
+
+/// Get the parent directory of @p path, or an empty path if @p path has none
+static std::filesystem::path parent_of(const std::filesystem::path &path) {
+    auto parent = path.parent_path();
+    // The root directory is its own parent
+    if (parent == path) {
+        parent.clear();
+    }
+    return parent;
+}
+
+capiocl::engine::DirectoryTree::Node &
+capiocl::engine::DirectoryTree::node(const std::filesystem::path &path) {
+    const auto [itm, inserted] = nodes.try_emplace(path.native());
+    auto &node                 = itm->second;
+    if (inserted) {
+        node.path = &itm->first;
+        if (const auto parent = parent_of(path); !parent.empty()) {
+            node.parent = &this->node(parent);
+            node.parent->children.insert(&node);
+        }
+    }
+    return node;
+}
+
+void capiocl::engine::DirectoryTree::prune(Node *node) {
+    while (node != nullptr && !node->present && node->children.empty()) {
+        const auto parent = node->parent;
+        if (parent != nullptr) {
+            parent->children.erase(node);
+        }
+        nodes.erase(*node->path);
+        node = parent;
+    }
+}
+
+capiocl::engine::DirectoryTree::Counters
+capiocl::engine::DirectoryTree::insert(const std::filesystem::path &path) {
+    auto &node = this->node(path);
+    if (!node.present) {
+        node.present = true;
+        if (node.parent != nullptr) {
+            node.parent->count++;
+        }
+    }
+    return {node.count, node.parent == nullptr ? 0 : node.parent->count};
+}
+
+void capiocl::engine::DirectoryTree::erase(const std::filesystem::path &path) {
+    const auto itm = nodes.find(path.native());
+    if (itm == nodes.end() || !itm->second.present) {
+        return;
+    }
+
+    auto &node   = itm->second;
+    node.present = false;
+    if (node.parent != nullptr) {
+        node.parent->count--;
+    }
+    this->prune(&node);
+}
+
+std::size_t capiocl::engine::DirectoryTree::count(const std::filesystem::path &path) const {
+    const auto itm = nodes.find(path.native());
+    return itm == nodes.end() ? 0 : itm->second.count;
+}
+
+std::vector<std::string>
+capiocl::engine::DirectoryTree::children(const std::filesystem::path &path) const {
+    std::vector<std::string> children;
+    if (const auto itm = nodes.find(path.native()); itm != nodes.end()) {
+        children.reserve(itm->second.count);
+        for (const auto child : itm->second.children) {
+            if (child->present) {
+                children.push_back(*child->path);
+            }
+        }
+    }
+    return children;
+}
+
+std::size_t capiocl::engine::DirectoryTree::size() const { return nodes.size(); }
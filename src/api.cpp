@@ -1,74 +1,45 @@
 #include <arpa/inet.h>
-#include <condition_variable>
 #include <iostream>
 #include <jsoncons/json.hpp>
-#include <mutex>
 #include <netinet/in.h>
 #include <signal.h>
 #include <sys/socket.h>
-#include <sys/time.h>
 #include <unistd.h>
 
 #include "capiocl/api.h"
 #include "capiocl/engine.h"
 #include "capiocl/printer.h"
 
-std::mutex _setupMtx;
-std::condition_variable _setupCv;
-bool thread_ready = false;
-
-/// @brief Main WebServer thread function
-void server(const std::string &address, const int port, capiocl::engine::Engine *engine,
-            std::atomic<bool> *terminate) {
-
-    constexpr int RECV_BUF_SIZE = 65535;
+/// @brief Size of the largest datagram received by the server
+constexpr int RECV_BUF_SIZE = 65535;
 
+void capiocl::api::CapioClApiServer::receive(const int socket) {
     const auto &wf_name = engine->getWorkflowName();
-
-    int fd = socket(AF_INET, SOCK_DGRAM, 0);
-
-    int reuse = 1;
-    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
-
-    sockaddr_in localAddr{};
-    localAddr.sin_family      = AF_INET;
-    localAddr.sin_port        = htons(port);
-    localAddr.sin_addr.s_addr = INADDR_ANY;
-
-    bind(fd, reinterpret_cast<sockaddr *>(&localAddr), sizeof(localAddr));
-
-    ip_mreq group{};
-    group.imr_multiaddr.s_addr = inet_addr(address.c_str());
-    group.imr_interface.s_addr = INADDR_ANY;
-    setsockopt(fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &group, sizeof(group));
-
-    char buffer[RECV_BUF_SIZE] = {0};
     sockaddr_in srcAddr{};
     socklen_t addrlen = sizeof(srcAddr);
 
-    // timeout of 1 second for termination
-    timeval tv{};
-    tv.tv_sec  = 0;
-    tv.tv_usec = 500;
-    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
-
-    thread_ready = true;
-    _setupCv.notify_all();
-
-    while (!*terminate) {
+    while (true) {
         // GCOVR_EXCL_START
-        ssize_t n = recvfrom(fd, buffer, RECV_BUF_SIZE - 1, 0,
+        ssize_t n = recvfrom(socket, buffer.data(), RECV_BUF_SIZE - 1, MSG_DONTWAIT,
                              reinterpret_cast<sockaddr *>(&srcAddr), &addrlen);
         // GCOVR_EXCL_STOP
 
-        if (n <= 0) {
-            continue;
+        if (n < 0) {
+            return;
         }
 
         buffer[n] = '\0';
 
         try {
-            auto data = jsoncons::json::parse(buffer); // GCOVR_EXCL_LINE
+            auto data = jsoncons::json::parse(buffer.data()); // GCOVR_EXCL_LINE
+            if (data.contains("delta")) {
+                const auto workflow_name = data.get_value_or<std::string, std::string>(
+                    "workflow_name", ""); // GCOVR_EXCL_LINE
+                if (workflow_name == wf_name) {
+                    engine->apply(capiocl::engine::Delta::fromJson(data.at("delta").to_string()));
+                }
+                continue;
+            }
             const auto path =
                 data.get_value_or<std::string, std::string>("path", ""); // GCOVR_EXCL_LINE
             if (path.empty()) {
@@ -95,15 +66,16 @@ void server(const std::string &address, const int port, capiocl::engine::Engine
         } catch (const jsoncons::json_exception &e) {
             capiocl::printer::print(capiocl::printer::CLI_LEVEL_ERROR,
                                     "APIServer: Received invalid json: " + std::string(e.what()));
+        } catch (const std::invalid_argument &e) {
+            capiocl::printer::print(capiocl::printer::CLI_LEVEL_ERROR,
+                                    "APIServer: Received invalid update: " + std::string(e.what()));
         }
     }
-
-    close(fd);
 }
 
 capiocl::api::CapioClApiServer::CapioClApiServer(engine::Engine *engine,
                                                  configuration::CapioClConfiguration &config)
-    : capiocl_configuration(config) {
+    : engine(engine), capiocl_configuration(config), buffer(RECV_BUF_SIZE) {
 
     std::string address;
     int port;
@@ -119,15 +91,31 @@ capiocl::api::CapioClApiServer::CapioClApiServer(engine::Engine *engine,
         port = std::stoi(configuration::defaults::DEFAULT_API_MULTICAST_PORT.v);
     }
 
-    _webApiThread = std::thread(server, address, port, engine, &_terminate);
+    socket_fd = socket(AF_INET, SOCK_DGRAM, 0);
+
+    int reuse = 1;
+    setsockopt(socket_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in localAddr{};
+    localAddr.sin_family      = AF_INET;
+    localAddr.sin_port        = htons(port);
+    localAddr.sin_addr.s_addr = INADDR_ANY;
+
+    bind(socket_fd, reinterpret_cast<sockaddr *>(&localAddr), sizeof(localAddr));
+
+    ip_mreq group{};
+    group.imr_multiaddr.s_addr = inet_addr(address.c_str());
+    group.imr_interface.s_addr = INADDR_ANY;
+    setsockopt(socket_fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &group, sizeof(group));
 
-    std::unique_lock lock(_setupMtx);
-    _setupCv.wait(lock, [] { return thread_ready; });
+    // The socket is ready to receive as soon as it is bound: updates are handled by the reactor
+    reactor = monitor::Reactor::instance();
+    reactor->add(socket_fd, [this](const int socket) { this->receive(socket); });
 
     printer::print(printer::CLI_LEVEL_INFO, "API server @ " + address + ":" + std::to_string(port));
 }
 
 capiocl::api::CapioClApiServer::~CapioClApiServer() {
-    _terminate = true;
-    _webApiThread.join();
+    reactor->remove(socket_fd);
+    close(socket_fd);
 }
@@ -42,8 +42,20 @@ void capiocl::configuration::CapioClConfiguration::loadDefaults() {
     this->set(defaults::DEFAULT_MONITOR_MCAST_DELAY);
     this->set(defaults::DEFAULT_MONITOR_FS_ENABLED);
     this->set(defaults::DEFAULT_MONITOR_MCAST_ENABLED);
+    this->set(defaults::DEFAULT_MONITOR_COMMITS_COMPACT);
+    this->set(defaults::DEFAULT_MONITOR_COMMITS_BLOOM_BITS);
+    this->set(defaults::DEFAULT_MONITOR_MCAST_BATCH_SIZE);
+    this->set(defaults::DEFAULT_MONITOR_MCAST_BATCH_DELAY);
+    this->set(defaults::DEFAULT_MONITOR_MCAST_BATCH_MTU);
+    this->set(defaults::DEFAULT_MONITOR_MCAST_BATCH_PREFIX);
+    this->set(defaults::DEFAULT_MONITOR_MCAST_TIMEOUT_PERCENTILE);
+    this->set(defaults::DEFAULT_MONITOR_MCAST_TIMEOUT_FACTOR);
+    this->set(defaults::DEFAULT_MONITOR_MCAST_TIMEOUT_MIN);
     this->set(defaults::DEFAULT_API_MULTICAST_PORT);
     this->set(defaults::DEFAULT_API_MULTICAST_IP);
+    this->set(defaults::DEFAULT_ENGINE_SHARDS);
+    this->set(defaults::DEFAULT_ENGINE_SNAPSHOT_READS);
+    this->set(defaults::DEFAULT_ENGINE_MATERIALIZE_READS);
 }
 
 void capiocl::configuration::CapioClConfiguration::set(const std::string &key, std::string value) {
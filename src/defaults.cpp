@@ -21,8 +21,43 @@ ConfigurationEntry capiocl::configuration::defaults::DEFAULT_MONITOR_MCAST_ENABL
 ConfigurationEntry capiocl::configuration::defaults::DEFAULT_MONITOR_FS_ENABLED{
     "monitor.filesystem.enabled", "true"};
 
+ConfigurationEntry capiocl::configuration::defaults::DEFAULT_MONITOR_COMMITS_COMPACT{
+    "monitor.commits.compact", "false"};
+
+ConfigurationEntry capiocl::configuration::defaults::DEFAULT_MONITOR_COMMITS_BLOOM_BITS{
+    "monitor.commits.bloom_bits", "8388608"};
+
+ConfigurationEntry capiocl::configuration::defaults::DEFAULT_MONITOR_MCAST_BATCH_SIZE{
+    "monitor.mcast.batch.size", "64"};
+
+ConfigurationEntry capiocl::configuration::defaults::DEFAULT_MONITOR_MCAST_BATCH_DELAY{
+    "monitor.mcast.batch.delay_us", "200"};
+
+ConfigurationEntry capiocl::configuration::defaults::DEFAULT_MONITOR_MCAST_BATCH_MTU{
+    "monitor.mcast.batch.mtu", "1472"};
+
+ConfigurationEntry capiocl::configuration::defaults::DEFAULT_MONITOR_MCAST_BATCH_PREFIX{
+    "monitor.mcast.batch.prefix_compression", "true"};
+
+ConfigurationEntry capiocl::configuration::defaults::DEFAULT_MONITOR_MCAST_TIMEOUT_PERCENTILE{
+    "monitor.mcast.timeout.percentile", "99"};
+
+ConfigurationEntry capiocl::configuration::defaults::DEFAULT_MONITOR_MCAST_TIMEOUT_FACTOR{
+    "monitor.mcast.timeout.factor", "3"};
+
+ConfigurationEntry capiocl::configuration::defaults::DEFAULT_MONITOR_MCAST_TIMEOUT_MIN{
+    "monitor.mcast.timeout.min_us", "1000"};
+
 ConfigurationEntry capiocl::configuration::defaults::DEFAULT_API_MULTICAST_IP{"dynamic_api.ip",
                                                                               "224.224.224.3"};
 
 ConfigurationEntry capiocl::configuration::defaults::DEFAULT_API_MULTICAST_PORT{"dynamic_api.port",
-                                                                                "11223"};
\ No newline at end of file
+                                                                                "11223"};
+
+ConfigurationEntry capiocl::configuration::defaults::DEFAULT_ENGINE_SHARDS{"engine.shards", "16"};
+
+ConfigurationEntry capiocl::configuration::defaults::DEFAULT_ENGINE_SNAPSHOT_READS{
+    "engine.snapshot_reads", "false"};
+
+ConfigurationEntry capiocl::configuration::defaults::DEFAULT_ENGINE_MATERIALIZE_READS{
+    "engine.materialize_reads", "true"};
\ No newline at end of file
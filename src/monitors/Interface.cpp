@@ -7,6 +7,10 @@ bool capiocl::monitor::MonitorInterface::isCommitted(const std::filesystem::path
     throw MonitorException(msg);
 }
 
+bool capiocl::monitor::MonitorInterface::queryCommitted(const std::filesystem::path &path) const {
+    return this->isCommitted(path);
+}
+
 void capiocl::monitor::MonitorInterface::setCommitted(const std::filesystem::path &path) const {
     std::string msg = "Attempted to use MonitorInterface as Monitor backend to set commit for: ";
     msg += path.string();
@@ -23,4 +27,21 @@ capiocl::monitor::MonitorInterface::getHomeNode(const std::filesystem::path &pat
     std::string msg = "Attempted to use MonitorInterface as Monitor backend to set commit for: ";
     msg += path.string();
     throw MonitorException(msg);
-}
\ No newline at end of file
+}
+
+const std::string &
+capiocl::monitor::MonitorInterface::queryHomeNode(const std::filesystem::path &path) const {
+    return this->getHomeNode(path);
+}
+
+std::chrono::milliseconds capiocl::monitor::MonitorInterface::queryTimeout() const {
+    return std::chrono::milliseconds(0);
+}
+
+bool capiocl::monitor::MonitorInterface::notifiesCommits() const { return false; }
+
+std::uint64_t capiocl::monitor::MonitorInterface::messagesSent() const { return 0; }
+
+std::uint64_t capiocl::monitor::MonitorInterface::datagramsSent() const { return 0; }
+
+std::uint64_t capiocl::monitor::MonitorInterface::batchesFlushed() const { return 0; }
@@ -1,30 +1,13 @@
 #include <arpa/inet.h>
 #include <netinet/in.h>
-#include <poll.h>
+#include <string_view>
 #include <sys/socket.h>
 
 #include "capiocl.hpp"
+#include "capiocl/frame.h"
 #include "capiocl/monitor.h"
 #include "capiocl/printer.h"
 
-static std::tuple<int, sockaddr_in> outgoing_socket_multicast(const std::string &address,
-                                                              const int port) {
-    sockaddr_in addr{};
-    addr.sin_family      = AF_INET;
-    addr.sin_addr.s_addr = inet_addr(address.c_str());
-    addr.sin_port        = htons(port);
-
-    const int transmission_socket = socket(AF_INET, SOCK_DGRAM, 0);
-    // LCOV_EXCL_START
-    if (transmission_socket < 0) {
-        throw capiocl::monitor::MonitorException(std::string("socket() failed: ") +
-                                                 strerror(errno));
-    }
-    // LCOV_EXCL_STOP
-
-    return {transmission_socket, addr};
-}
-
 static int incoming_socket_multicast(const std::string &address_ip, const int port,
                                      sockaddr_in &addr, socklen_t &addrlen) {
     constexpr int loopback   = 1; // enable reception of loopback messages
@@ -75,151 +58,128 @@ static int incoming_socket_multicast(const std::string &address_ip, const int po
     return _socket;
 }
 
-void capiocl::monitor::MulticastMonitor::commit_listener(std::vector<std::string> &committed_files,
-                                                         std::mutex &lock,
-                                                         const std::string &ip_addr,
-                                                         const int ip_port,
-                                                         const std::atomic<bool> *terminate) {
-    pthread_setcancelstate(PTHREAD_CANCEL_ASYNCHRONOUS, nullptr);
-    sockaddr_in addr_in = {};
-    socklen_t addr_len  = {};
-    const auto socket   = incoming_socket_multicast(ip_addr, ip_port, addr_in, addr_len);
-    const auto addr     = reinterpret_cast<sockaddr *>(&addr_in);
-    char incoming_message[MESSAGE_SIZE] = {0};
-
-    // Polling for non blocking
-    pollfd pfd = {};
-    pfd.fd     = socket;
-    pfd.events = POLLIN | POLLPRI;
-
-    do {
-        bzero(incoming_message, sizeof(incoming_message));
-
-        // TODO: migrate to epoll for linux and kqueue on MacOS
-        if (poll(&pfd, 1, MULTICAST_THREAD_POLL_INTERVAL) == 0) {
-            // No data from incoming socket. Continue, awaking thread ensuring pthread_cancel points
-            // can be reached
-            if (*terminate) {
-                close(socket);
-                return;
+void capiocl::monitor::MulticastMonitor::receive_commits(const int socket) const {
+    ssize_t length;
+    while ((length = recv(socket, incoming.data(), incoming.size(), MSG_DONTWAIT)) >= 0) {
+        // A datagram carries a single plain message or a frame of several ones
+        for (const auto &[command, path] : MessageFrame::decode(incoming.data(), length)) {
+            if (command == SET) {
+                // Received an advert for a committed file
+                _committed_files.insert(path);
+                // Wake the threads waiting for the file as soon as the advert is received
+                answer_query(commit_queries, path);
+                commit_replies.notify(path);
+                if (const auto list = commit_waiters.load(); list != nullptr) {
+                    list->notify(path);
+                }
+            } else if (command == GET && _committed_files.contains(path)) {
+                // Received a query for a committed file
+                _send_message(*sender, MULTICAST_COMMIT_ADDR, MULTICAST_COMMIT_PORT, path, SET);
             }
-
-            continue;
         }
+    }
+}
 
-        // LCOV_EXCL_START
-        if (recvfrom(socket, incoming_message, MESSAGE_SIZE, 0, addr, &addr_len) < 0) {
-            continue;
-        }
-        // LCOV_EXCL_STOP
-
-        const auto path = std::string(incoming_message).substr(2);
-
-        if (const char command = incoming_message[0]; command == SET) {
-            // Received an advert for a committed file
-            std::lock_guard lg(lock);
-            if (std::find(committed_files.begin(), committed_files.end(), path) ==
-                committed_files.end()) {
-                committed_files.emplace_back(path);
-            }
-        } else {
-            // Received a query for a committed file: message begins with capiocl::Monitor::REQUEST
-            std::lock_guard lg(lock);
-            if (std::find(committed_files.begin(), committed_files.end(), path) !=
-                committed_files.end()) {
-                _send_message(ip_addr, ip_port, path, SET);
+void capiocl::monitor::MulticastMonitor::receive_home_nodes(const int socket) const {
+    ssize_t length;
+    while ((length = recv(socket, incoming.data(), incoming.size(), MSG_DONTWAIT)) >= 0) {
+        for (const auto &[command, payload] : MessageFrame::decode(incoming.data(), length)) {
+            if (command == SET) {
+                // Received an advert for a home node: the payload is the path and the host name
+                const auto separator = payload.rfind(' ');
+                if (separator == std::string::npos) {
+                    continue;
+                }
+                const auto path = payload.substr(0, separator);
+                {
+                    // getHomeNode() returns a reference to the entry: repeated answers must not
+                    // rewrite it while a caller reads it
+                    std::lock_guard lg(home_node_lock);
+                    const auto host = std::string_view(payload).substr(separator + 1);
+                    if (auto &node = _home_nodes[path]; node != host) {
+                        node = host;
+                    }
+                }
+                answer_query(home_node_queries, path);
+                home_node_replies.notify(path);
+                if (const auto list = home_node_waiters.load(); list != nullptr) {
+                    list->notify(path);
+                }
+            } else if (command == GET) {
+                // Received a query for a home node: the payload is the path
+                std::lock_guard lg(home_node_lock);
+                if (const auto itm = _home_nodes.find(payload);
+                    itm != _home_nodes.end() && itm->second == _hostname) {
+                    _send_message(*sender, MULTICAST_HOME_NODE_ADDR, MULTICAST_HOME_NODE_PORT,
+                                  payload + " " + _hostname, SET);
+                }
             }
         }
-    } while (true);
+    }
 }
 
-void capiocl::monitor::MulticastMonitor::home_node_listener(
-    std::unordered_map<std::string, std::string> &home_nodes, std::mutex &lock,
-    const std::string &ip_addr, int ip_port, const std::atomic<bool> *terminate) {
-    pthread_setcancelstate(PTHREAD_CANCEL_ASYNCHRONOUS, nullptr);
+void capiocl::monitor::MulticastMonitor::_send_message(MulticastSender &sender,
+                                                       const std::string &ip_addr,
+                                                       const int ip_port, const std::string &path,
+                                                       const MESSAGE_COMMANDS action) {
+    sender.send(ip_addr, ip_port, static_cast<char>(action), path);
+}
 
-    char this_hostname[HOST_NAME_MAX] = {};
-    gethostname(this_hostname, HOST_NAME_MAX);
+void capiocl::monitor::MulticastMonitor::track_query(
+    PendingQueries &queries, const std::string &path,
+    const std::chrono::microseconds timeout) const {
+    // Bound the table when many callers give up before their query is dropped
+    constexpr std::size_t PENDING_LIMIT = 4096;
 
-    sockaddr_in addr_in = {};
-    socklen_t addr_len  = {};
-    const auto socket   = incoming_socket_multicast(ip_addr, ip_port, addr_in, addr_len);
-
-    const auto addr                     = reinterpret_cast<sockaddr *>(&addr_in);
-    char incoming_message[MESSAGE_SIZE] = {0};
-
-    do {
-        bzero(incoming_message, sizeof(incoming_message));
-
-        // Polling for non blocking
-        pollfd pfd = {};
-        pfd.fd     = socket;
-        pfd.events = POLLIN | POLLPRI;
-
-        // TODO: migrate to epoll for linux and kqueue on MacOS
-        if (poll(&pfd, 1, MULTICAST_THREAD_POLL_INTERVAL) == 0) {
-            // No data from incoming socket. Continue, awaking thread ensuring pthread_cancel points
-            // can be reached
-            if (*terminate) {
-                close(socket);
-                return;
-            }
+    const auto now      = std::chrono::steady_clock::now();
+    const auto deadline = now + timeout;
 
-            continue;
+    std::lock_guard lg(queries.lock);
+    if (queries.slots.size() >= PENDING_LIMIT) {
+        for (auto itm = queries.slots.begin(); itm != queries.slots.end();) {
+            itm = itm->second.deadline < now ? queries.slots.erase(itm) : std::next(itm);
         }
+    }
 
-        // LCOV_EXCL_START
-        if (recvfrom(socket, incoming_message, MESSAGE_SIZE, MSG_DONTWAIT, addr, &addr_len) < 0) {
-            continue;
-        }
-        // LCOV_EXCL_STOP
-
-        std::string incoming_message_str(incoming_message);
-        std::vector<std::string> tokens;
-        size_t start = 0, end = incoming_message_str.find(' ');
-
-        while (end != std::string::npos) {
-            if (end > start) {
-                tokens.push_back(incoming_message_str.substr(start, end - start));
-            }
-            start = end + 1;
-            end   = incoming_message_str.find(' ', start);
-        }
+    // An earlier query still awaited gets the answer first: timing it avoids underestimates
+    const auto [itm, inserted] =
+        queries.slots.try_emplace(path, PendingQueries::Query{now, deadline});
+    if (inserted) {
+        return;
+    }
+    if (itm->second.deadline < now) {
+        itm->second.sent = now;
+    }
+    itm->second.deadline = std::max(itm->second.deadline, deadline);
+}
 
-        if (start < incoming_message_str.length()) {
-            tokens.push_back(incoming_message_str.substr(start));
+void capiocl::monitor::MulticastMonitor::answer_query(PendingQueries &queries,
+                                                      const std::string &path) const {
+    const auto now = std::chrono::steady_clock::now();
+    PendingQueries::Query query;
+    {
+        std::lock_guard lg(queries.lock);
+        const auto itm = queries.slots.find(path);
+        if (itm == queries.slots.end()) {
+            return;
         }
-        const auto &path = tokens[1];
-        if (tokens[0].c_str()[0] == SET) {
-
-            // Received an advert for a committed file
-            std::lock_guard lg(lock);
-
-            const auto &home_node = tokens[2];
-            home_nodes[path]      = home_node;
-        } else {
-            // Received a query for a home node, Message begins with capiocl::Monitor::REQUEST
-            std::lock_guard lg(lock);
-
-            if (home_nodes.find(path) == home_nodes.end()) {
-                continue;
-            }
+        query = itm->second;
+        queries.slots.erase(itm);
+    }
 
-            if (home_nodes[path] == this_hostname) {
-                _send_message(ip_addr, ip_port, path + " " + this_hostname, SET);
-            }
-        }
-    } while (true);
+    if (now <= query.deadline) {
+        rtt->record(std::chrono::duration_cast<std::chrono::microseconds>(now - query.sent));
+    }
 }
 
-void capiocl::monitor::MulticastMonitor::_send_message(const std::string &ip_addr,
-                                                       const int ip_port, const std::string &path,
-                                                       const MESSAGE_COMMANDS action) {
-    char message[MESSAGE_SIZE] = {0};
-    snprintf(message, sizeof(message), "%c %s", action, path.c_str());
-    auto [out_s, addr] = outgoing_socket_multicast(ip_addr, ip_port);
-    sendto(out_s, message, strlen(message), 0, reinterpret_cast<sockaddr *>(&addr), sizeof(addr));
-    close(out_s);
+void capiocl::monitor::MulticastMonitor::expire_query(PendingQueries &queries,
+                                                      const std::string &path) {
+    std::lock_guard lg(queries.lock);
+    // Another caller may still wait for an answer to the same query
+    if (const auto itm = queries.slots.find(path);
+        itm != queries.slots.end() && itm->second.deadline <= std::chrono::steady_clock::now()) {
+        queries.slots.erase(itm);
+    }
 }
 
 capiocl::monitor::MulticastMonitor::MulticastMonitor(
@@ -230,61 +190,155 @@ capiocl::monitor::MulticastMonitor::MulticastMonitor(
     config.getParameter("monitor.mcast.homenode.port", &MULTICAST_HOME_NODE_PORT);
     config.getParameter("monitor.mcast.delay_ms", &MULTICAST_DELAY_MILLIS);
 
-    commit_thread =
-        std::thread(&commit_listener, std::ref(_committed_files), std::ref(committed_lock),
-                    MULTICAST_COMMIT_ADDR, MULTICAST_COMMIT_PORT, &this->terminate);
+    std::string compact_commits;
+    int bloom_bits;
+    try {
+        config.getParameter("monitor.commits.compact", &compact_commits);
+    } catch (...) {
+        compact_commits = configuration::defaults::DEFAULT_MONITOR_COMMITS_COMPACT.v;
+    }
+    try {
+        config.getParameter("monitor.commits.bloom_bits", &bloom_bits);
+    } catch (...) {
+        bloom_bits = std::stoi(configuration::defaults::DEFAULT_MONITOR_COMMITS_BLOOM_BITS.v);
+    }
+    if (bloom_bits < 0) {
+        throw configuration::CapioClConfigurationException(
+            "monitor.commits.bloom_bits must not be negative");
+    }
+    _committed_files.configure(compact_commits == "true", bloom_bits);
 
-    home_node_thread =
-        std::thread(&home_node_listener, std::ref(_home_nodes), std::ref(home_node_lock),
-                    MULTICAST_HOME_NODE_ADDR, MULTICAST_HOME_NODE_PORT, &this->terminate);
+    int batch_size, batch_delay;
+    try {
+        config.getParameter("monitor.mcast.batch.size", &batch_size);
+    } catch (...) {
+        batch_size = std::stoi(configuration::defaults::DEFAULT_MONITOR_MCAST_BATCH_SIZE.v);
+    }
+    try {
+        config.getParameter("monitor.mcast.batch.delay_us", &batch_delay);
+    } catch (...) {
+        batch_delay = std::stoi(configuration::defaults::DEFAULT_MONITOR_MCAST_BATCH_DELAY.v);
+    }
+    if (batch_size < 1 || batch_delay < 0) {
+        throw configuration::CapioClConfigurationException(
+            "monitor.mcast.batch.size must be positive and monitor.mcast.batch.delay_us must not "
+            "be negative");
+    }
+    int max_datagram;
+    std::string prefix_compression;
+    try {
+        config.getParameter("monitor.mcast.batch.mtu", &max_datagram);
+    } catch (...) {
+        max_datagram = std::stoi(configuration::defaults::DEFAULT_MONITOR_MCAST_BATCH_MTU.v);
+    }
+    try {
+        config.getParameter("monitor.mcast.batch.prefix_compression", &prefix_compression);
+    } catch (...) {
+        prefix_compression = configuration::defaults::DEFAULT_MONITOR_MCAST_BATCH_PREFIX.v;
+    }
+    if (max_datagram < 1 || max_datagram > MESSAGE_SIZE) {
+        throw configuration::CapioClConfigurationException(
+            "monitor.mcast.batch.mtu must be between 1 and " + std::to_string(MESSAGE_SIZE));
+    }
+    sender = std::make_unique<MulticastSender>(batch_size, std::chrono::microseconds(batch_delay),
+                                               max_datagram, prefix_compression == "true");
+
+    int percentile, factor, min_timeout;
+    try {
+        config.getParameter("monitor.mcast.timeout.percentile", &percentile);
+    } catch (...) {
+        percentile = std::stoi(configuration::defaults::DEFAULT_MONITOR_MCAST_TIMEOUT_PERCENTILE.v);
+    }
+    try {
+        config.getParameter("monitor.mcast.timeout.factor", &factor);
+    } catch (...) {
+        factor = std::stoi(configuration::defaults::DEFAULT_MONITOR_MCAST_TIMEOUT_FACTOR.v);
+    }
+    try {
+        config.getParameter("monitor.mcast.timeout.min_us", &min_timeout);
+    } catch (...) {
+        min_timeout = std::stoi(configuration::defaults::DEFAULT_MONITOR_MCAST_TIMEOUT_MIN.v);
+    }
+    if (percentile < 1 || percentile > 100 || factor < 1 || min_timeout < 0) {
+        throw configuration::CapioClConfigurationException(
+            "monitor.mcast.timeout.percentile must be between 1 and 100, "
+            "monitor.mcast.timeout.factor must be positive and monitor.mcast.timeout.min_us must "
+            "not be negative");
+    }
+    rtt = std::make_unique<RttEstimator>(percentile, factor, std::chrono::microseconds(min_timeout),
+                                         std::chrono::milliseconds(MULTICAST_DELAY_MILLIS));
 
     gethostname(_hostname, HOST_NAME_MAX);
-}
+    incoming.resize(MESSAGE_SIZE);
 
-capiocl::monitor::MulticastMonitor::~MulticastMonitor() {
+    sockaddr_in addr_in = {};
+    socklen_t addr_len  = {};
+    commit_socket = incoming_socket_multicast(MULTICAST_COMMIT_ADDR, MULTICAST_COMMIT_PORT, addr_in,
+                                              addr_len);
+    // LCOV_EXCL_START
+    try {
+        home_node_socket = incoming_socket_multicast(MULTICAST_HOME_NODE_ADDR,
+                                                     MULTICAST_HOME_NODE_PORT, addr_in, addr_len);
+    } catch (...) {
+        close(commit_socket);
+        throw;
+    }
+    // LCOV_EXCL_STOP
 
-    terminate = true;
+    reactor = Reactor::instance();
+    reactor->add(commit_socket, [this](const int socket) { this->receive_commits(socket); });
+    reactor->add(home_node_socket, [this](const int socket) { this->receive_home_nodes(socket); });
+}
 
-    if (commit_thread.joinable()) {
-        commit_thread.join();
-    }
-    if (home_node_thread.joinable()) {
-        home_node_thread.join();
-    }
+capiocl::monitor::MulticastMonitor::~MulticastMonitor() {
+    // Once removed, the handlers are not running and will not run again
+    reactor->remove(commit_socket);
+    reactor->remove(home_node_socket);
+    close(commit_socket);
+    close(home_node_socket);
 }
 
 bool capiocl::monitor::MulticastMonitor::isCommitted(const std::filesystem::path &path) const {
-
-    {
-        const std::lock_guard lg(committed_lock);
-        if (std::find(_committed_files.begin(), _committed_files.end(), path) !=
-            _committed_files.end()) {
-            return true;
-        }
+    if (_committed_files.contains(path)) {
+        return true;
     }
 
-    _send_message(MULTICAST_COMMIT_ADDR, MULTICAST_COMMIT_PORT, path, GET);
-    std::this_thread::sleep_for(std::chrono::milliseconds(MULTICAST_DELAY_MILLIS));
+    // receive_commits() wakes this thread as soon as the answer is received
+    const auto timeout = rtt->timeout();
+    track_query(commit_queries, path, timeout);
+    _send_message(*sender, MULTICAST_COMMIT_ADDR, MULTICAST_COMMIT_PORT, path, GET);
+    commit_replies.wait({path}, std::chrono::steady_clock::now() + timeout,
+                        std::chrono::ceil<std::chrono::milliseconds>(timeout), [this, &path] {
+                            return _committed_files.contains(path) ? path.string() : "";
+                        });
+
+    if (_committed_files.contains(path)) {
+        return true;
+    }
+    expire_query(commit_queries, path);
+    return false;
+}
 
-    {
-        const std::lock_guard lg(committed_lock);
-        return std::find(_committed_files.begin(), _committed_files.end(), path) !=
-               _committed_files.end();
+bool capiocl::monitor::MulticastMonitor::queryCommitted(const std::filesystem::path &path) const {
+    if (_committed_files.contains(path)) {
+        return true;
     }
+
+    // The answer, if any, is notified by receive_commits()
+    track_query(commit_queries, path, this->queryTimeout());
+    _send_message(*sender, MULTICAST_COMMIT_ADDR, MULTICAST_COMMIT_PORT, path, GET);
+    return false;
 }
 
 void capiocl::monitor::MulticastMonitor::setCommitted(const std::filesystem::path &path) const {
-    _send_message(MULTICAST_COMMIT_ADDR, MULTICAST_COMMIT_PORT, std::filesystem::path(path), SET);
-    std::lock_guard lg(committed_lock);
-    const auto position = std::find(_committed_files.begin(), _committed_files.end(), path);
-    if (position == _committed_files.end()) {
-        _committed_files.emplace_back(path);
-    }
+    _send_message(*sender, MULTICAST_COMMIT_ADDR, MULTICAST_COMMIT_PORT,
+                  std::filesystem::path(path), SET);
+    _committed_files.insert(path);
 }
 
 void capiocl::monitor::MulticastMonitor::setHomeNode(const std::filesystem::path &path) const {
     const std::string message = path.string() + " " + _hostname;
-    _send_message(MULTICAST_HOME_NODE_ADDR, MULTICAST_HOME_NODE_PORT, message, SET);
+    _send_message(*sender, MULTICAST_HOME_NODE_ADDR, MULTICAST_HOME_NODE_PORT, message, SET);
 
     std::lock_guard lg(home_node_lock);
     _home_nodes[path] = _hostname;
@@ -300,13 +354,60 @@ capiocl::monitor::MulticastMonitor::getHomeNode(const std::filesystem::path &pat
         }
     }
 
-    _send_message(MULTICAST_HOME_NODE_ADDR, MULTICAST_HOME_NODE_PORT, path.string(), GET);
-    std::this_thread::sleep_for(std::chrono::milliseconds(MULTICAST_DELAY_MILLIS));
+    // receive_home_nodes() wakes this thread as soon as the answer is received
+    const auto timeout = rtt->timeout();
+    track_query(home_node_queries, path, timeout);
+    _send_message(*sender, MULTICAST_HOME_NODE_ADDR, MULTICAST_HOME_NODE_PORT, path.string(),
+                  GET);
+    home_node_replies.wait({path}, std::chrono::steady_clock::now() + timeout,
+                           std::chrono::ceil<std::chrono::milliseconds>(timeout), [this, &path] {
+                               const std::lock_guard lg(home_node_lock);
+                               return _home_nodes.count(path) > 0 ? path.string() : "";
+                           });
 
-    const std::lock_guard lg(home_node_lock);
-    if (const auto itm = _home_nodes.find(path); itm != _home_nodes.end()) {
-        return itm->second;
-    } else {
-        return NO_HOME_NODE;
+    {
+        const std::lock_guard lg(home_node_lock);
+        if (const auto itm = _home_nodes.find(path); itm != _home_nodes.end()) {
+            return itm->second;
+        }
+    }
+    expire_query(home_node_queries, path);
+    return NO_HOME_NODE;
+}
+
+const std::string &
+capiocl::monitor::MulticastMonitor::queryHomeNode(const std::filesystem::path &path) const {
+    {
+        const std::lock_guard lg(home_node_lock);
+        if (const auto itm = _home_nodes.find(path); itm != _home_nodes.end()) {
+            return itm->second;
+        }
     }
+
+    // The answer, if any, is notified by receive_home_nodes()
+    track_query(home_node_queries, path, this->queryTimeout());
+    _send_message(*sender, MULTICAST_HOME_NODE_ADDR, MULTICAST_HOME_NODE_PORT, path.string(),
+                  GET);
+    return NO_HOME_NODE;
+}
+
+std::chrono::milliseconds capiocl::monitor::MulticastMonitor::queryTimeout() const {
+    return std::chrono::ceil<std::chrono::milliseconds>(rtt->timeout());
+}
+
+bool capiocl::monitor::MulticastMonitor::notifiesCommits() const {
+    // Adverts received after the query are notified by receive_commits()
+    return true;
+}
+
+std::uint64_t capiocl::monitor::MulticastMonitor::messagesSent() const {
+    return sender->messagesSent();
+}
+
+std::uint64_t capiocl::monitor::MulticastMonitor::datagramsSent() const {
+    return sender->datagramsSent();
+}
+
+std::uint64_t capiocl::monitor::MulticastMonitor::batchesFlushed() const {
+    return sender->batchesFlushed();
 }
\ No newline at end of file
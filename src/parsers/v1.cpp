@@ -2,6 +2,7 @@
 
 #include "capio_cl_json_schemas.hpp"
 #include "capiocl.hpp"
+#include "capiocl/builder.h"
 #include "capiocl/engine.h"
 #include "capiocl/parser.h"
 #include "capiocl/printer.h"
@@ -26,6 +27,9 @@ capiocl::parser::Parser::available_parsers::parse_v1(const std::filesystem::path
     engine->setWorkflowName(workflow_name);
     printer::print(printer::CLI_LEVEL_JSON, "Parsing configuration for workflow: " + workflow_name);
 
+    // Entries are collected without locking the Engine, and published once parsing is complete
+    engine::EngineBuilder builder;
+
     // ---- IO_Graph ----
     for (const auto &app : doc["IO_Graph"].array_range()) {
         std::string app_name = app["name"].as<std::string>();
@@ -35,16 +39,16 @@ capiocl::parser::Parser::available_parsers::parse_v1(const std::filesystem::path
         printer::print(printer::CLI_LEVEL_JSON, "Parsing input_stream for app " + app_name);
         for (const auto &itm : app["input_stream"].array_range()) {
             auto file_path = resolve(itm.as<std::string>(), resolve_prefix);
-            engine->newFile(file_path);
-            engine->addConsumer(file_path, app_name);
+            builder.newFile(file_path);
+            builder.addConsumer(file_path, app_name);
         }
 
         // ---- output_stream ----
         printer::print(printer::CLI_LEVEL_JSON, "Parsing output_stream for app " + app_name);
         for (const auto &itm : app["output_stream"].array_range()) {
             auto file_path = resolve(itm.as<std::string>(), resolve_prefix);
-            engine->newFile(file_path);
-            engine->addProducer(file_path, app_name);
+            builder.newFile(file_path);
+            builder.addProducer(file_path, app_name);
         }
 
         // ---- streaming ----
@@ -117,18 +121,18 @@ capiocl::parser::Parser::available_parsers::parse_v1(const std::filesystem::path
 
                 for (auto &path : streaming_names) {
                     if (n_files != 0) {
-                        engine->setDirectoryFileCount(path, n_files);
+                        builder.setDirectoryFileCount(path, n_files);
                     }
                     if (is_file) {
-                        engine->setFile(path);
+                        builder.setFile(path);
                     } else {
-                        engine->setDirectory(path);
+                        builder.setDirectory(path);
                     }
 
-                    engine->setCommitRule(path, commit_rule);
-                    engine->setFireRule(path, fire_rule);
-                    engine->setCommitedCloseNumber(path, n_close);
-                    engine->setFileDeps(path, file_deps);
+                    builder.setCommitRule(path, commit_rule);
+                    builder.setFireRule(path, fire_rule);
+                    builder.setCommitedCloseNumber(path, n_close);
+                    builder.setFileDeps(path, file_deps);
                 }
             }
         }
@@ -138,8 +142,8 @@ capiocl::parser::Parser::available_parsers::parse_v1(const std::filesystem::path
     if (doc.contains("permanent")) {
         for (const auto &item : doc["permanent"].array_range()) {
             std::filesystem::path path = resolve(item.as<std::string>(), resolve_prefix);
-            engine->newFile(path);
-            engine->setPermanent(path, true);
+            builder.newFile(path);
+            builder.setPermanent(path, true);
         }
     }
 
@@ -147,8 +151,8 @@ capiocl::parser::Parser::available_parsers::parse_v1(const std::filesystem::path
     if (doc.contains("exclude")) {
         for (const auto &item : doc["exclude"].array_range()) {
             std::filesystem::path path = resolve(item.as<std::string>(), resolve_prefix);
-            engine->newFile(path);
-            engine->setExclude(path, true);
+            builder.newFile(path);
+            builder.setExclude(path, true);
         }
     }
 
@@ -159,7 +163,7 @@ capiocl::parser::Parser::available_parsers::parse_v1(const std::filesystem::path
         if (storage.contains("memory")) {
             for (const auto &f : storage["memory"].array_range()) {
                 std::string file_str = f.as<std::string>();
-                engine->setStoreFileInMemory(file_str);
+                builder.setStoreFileInMemory(file_str);
             }
         } else {
             printer::print(printer::CLI_LEVEL_INFO, "No MEM storage section found");
@@ -168,7 +172,7 @@ capiocl::parser::Parser::available_parsers::parse_v1(const std::filesystem::path
         if (storage.contains("fs")) {
             for (const auto &f : storage["fs"].array_range()) {
                 std::string file_str = f.as<std::string>();
-                engine->setStoreFileInFileSystem(file_str);
+                builder.setStoreFileInFileSystem(file_str);
             }
         } else {
             printer::print(printer::CLI_LEVEL_INFO, "No FS storage section found");
@@ -180,8 +184,9 @@ capiocl::parser::Parser::available_parsers::parse_v1(const std::filesystem::path
     // ---- Store only in memory ----
     if (store_only_in_memory) {
         printer::print(printer::CLI_LEVEL_INFO, "Storing all files in memory");
-        engine->setAllStoreInMemory();
+        builder.setAllStoreInMemory();
     }
 
+    builder.publish(*engine);
     return engine;
 }
\ No newline at end of file
@@ -10,7 +10,7 @@ void capiocl::serializer::Serializer::available_serializers::serialize_v1(
     jsoncons::json doc;
     doc["name"] = engine.getWorkflowName();
 
-    const auto files = engine._capio_cl_entries;
+    const auto files = engine._entries();
 
     std::unordered_map<std::string, std::vector<std::string>> app_inputs;
     std::unordered_map<std::string, std::vector<std::string>> app_outputs;
@@ -48,14 +48,14 @@ void capiocl::serializer::Serializer::available_serializers::serialize_v1(
             const auto &entry = files.at(path);
 
             jsoncons::json streaming_item = jsoncons::json::object();
-            std::string committed         = entry.commit_rule;
+            std::string committed         = commitRules::toString(entry.commit_rule);
             const char *name_kind         = entry.is_file ? "name" : "dirname";
             streaming_item[name_kind]     = jsoncons::json::array({path}); // LCOV_EXCL_LINE
 
             if (entry.commit_on_close_count > 0) {
-                if (entry.commit_rule == commitRules::ON_CLOSE) {
+                if (entry.commit_rule == commitRules::COMMIT_RULE::ON_CLOSE) {
                     const auto close_count      = std::to_string(entry.commit_on_close_count);
-                    streaming_item["committed"] = entry.commit_rule + ":" + close_count;
+                    streaming_item["committed"] = committed + ":" + close_count;
                 } else {
                     const auto msg = "Commit rule is not ON_CLOSE but close count > 0";
                     printer::print(printer::CLI_LEVEL_WARNING, msg);
@@ -64,7 +64,7 @@ void capiocl::serializer::Serializer::available_serializers::serialize_v1(
                                                   std::to_string(entry.commit_on_close_count);
                 }
             } else {
-                streaming_item["committed"] = entry.commit_rule;
+                streaming_item["committed"] = committed;
             }
 
             if (!entry.is_file) {
@@ -79,7 +79,7 @@ void capiocl::serializer::Serializer::available_serializers::serialize_v1(
             }
             streaming_item["file_deps"] = file_deps_str;
 
-            streaming_item["mode"] = entry.fire_rule;
+            streaming_item["mode"] = fireRules::toString(entry.fire_rule);
 
             streaming.push_back(streaming_item);
         }
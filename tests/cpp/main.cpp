@@ -22,8 +22,15 @@ template <typename T> std::string demangled_name(const T &obj) {
 #include "capiocl/serializer.h"
 
 #include "test_apis.hpp"
+#include "test_apps.hpp"
+#include "test_builder.hpp"
 #include "test_configuration.hpp"
 #include "test_engine.hpp"
 #include "test_exceptions.hpp"
+#include "test_graph.hpp"
+#include "test_index.hpp"
+#include "test_merkle.hpp"
 #include "test_monitor.hpp"
-#include "test_serialize_deserialize.hpp"
\ No newline at end of file
+#include "test_serialize_deserialize.hpp"
+#include "test_snapshot.hpp"
+#include "test_tree.hpp"
\ No newline at end of file
@@ -59,7 +59,7 @@ TEST(WEBSERVER_SUITE_NAME, TestSerializationDeserializationCapioCLRule) {
     EXPECT_EQ(def_rule, entry.toJson());
 
     entry.commit_on_close_count         = 10;
-    entry.commit_rule                   = "on_close";
+    entry.commit_rule                   = capiocl::commitRules::COMMIT_RULE::ON_CLOSE;
     entry.consumers                     = {"aaaaa"};
     entry.producers                     = {"bbbbb"};
     entry.directory_children_count      = 12;
@@ -116,9 +116,9 @@ TEST(WEBSERVER_SUITE_NAME, TestWebServerAPIS) {
                       stoi(capiocl::configuration::defaults::DEFAULT_API_MULTICAST_PORT.v)));
 
     capiocl::engine::CapioCLEntry entry;
-    entry.commit_rule           = "on_file";
+    entry.commit_rule           = capiocl::commitRules::COMMIT_RULE::ON_FILE;
     entry.commit_on_close_count = 10;
-    entry.fire_rule             = "no_update";
+    entry.fire_rule             = capiocl::fireRules::FIRE_RULE::NO_UPDATE;
 
     EXPECT_TRUE(sendMulticast(
         R"({ "path" : "file.txt","workflow_name" : "notMyWorkflow", "CapioClEntry":)" +
@@ -140,9 +140,53 @@ TEST(WEBSERVER_SUITE_NAME, TestWebServerAPIS) {
     }
 
     EXPECT_TRUE(engine.contains("file.txt"));
-    EXPECT_EQ(engine.getCommitRule("file.txt"), entry.commit_rule);
+    EXPECT_EQ(engine.getCommitRuleType("file.txt"), entry.commit_rule);
     EXPECT_EQ(engine.getCommitCloseCount("file.txt"), entry.commit_on_close_count);
-    EXPECT_EQ(engine.getFireRule("file.txt"), entry.fire_rule);
+    EXPECT_EQ(engine.getFireRuleType("file.txt"), entry.fire_rule);
+
+    // Sending the same entry again does not change it
+    EXPECT_TRUE(
+        sendMulticast(request, capiocl::configuration::defaults::DEFAULT_API_MULTICAST_IP.v,
+                      stoi(capiocl::configuration::defaults::DEFAULT_API_MULTICAST_PORT.v)));
+
+    std::string delta = R"({"workflow_name" : ")";
+    delta += capiocl::CAPIO_CL_DEFAULT_WF_NAME;
+    delta += R"(", "delta":)" +
+             capiocl::engine::Delta::add("file.txt", capiocl::engine::Delta::PRODUCER, "writer")
+                 .toJson() +
+             "}";
+    EXPECT_TRUE(
+        sendMulticast(delta, capiocl::configuration::defaults::DEFAULT_API_MULTICAST_IP.v,
+                      stoi(capiocl::configuration::defaults::DEFAULT_API_MULTICAST_PORT.v)));
+
+    while (!engine.isProducer("file.txt", "writer")) {
+        sleep(1);
+    }
+    EXPECT_EQ(engine.getCommitCloseCount("file.txt"), entry.commit_on_close_count);
+}
+
+TEST(WEBSERVER_SUITE_NAME, TestSerializationDeserializationDelta) {
+    const auto delta =
+        capiocl::engine::Delta::set("/a/b", capiocl::engine::Delta::COMMIT_ON_CLOSE_COUNT, 3);
+    EXPECT_EQ(delta.toJson(), "{\"field\":\"commit_on_close_count\",\"number\":3,"
+                              "\"operation\":\"set\",\"path\":\"/a/b\",\"value\":\"\","
+                              "\"version\":0}");
+
+    const auto parsed = capiocl::engine::Delta::fromJson(delta.toJson());
+    EXPECT_EQ(parsed.path, delta.path);
+    EXPECT_EQ(parsed.operation, delta.operation);
+    EXPECT_EQ(parsed.field, delta.field);
+    EXPECT_EQ(parsed.number, delta.number);
+    EXPECT_EQ(parsed.key(), delta.key());
+
+    const auto removal =
+        capiocl::engine::Delta::fromJson(R"({"path": "/a/b", "operation": "remove", )"
+                                         R"("field": "producers", "value": "app"})");
+    EXPECT_EQ(removal.operation, capiocl::engine::Delta::REMOVE);
+    EXPECT_EQ(removal.field, capiocl::engine::Delta::PRODUCER);
+    EXPECT_EQ(removal.value, "app");
+    EXPECT_NE(removal.key(), capiocl::engine::Delta::add("/a/b", removal.field, "other").key());
+    EXPECT_EQ(removal.key(), capiocl::engine::Delta::add("/a/b", removal.field, "app").key());
 }
 
 #endif // CAPIO_CL_TEST_APIS_HPP
@@ -0,0 +1,90 @@
+#ifndef CAPIO_CL_TEST_APPS_HPP
+#define CAPIO_CL_TEST_APPS_HPP
+
+#define APPS_SUITE_NAME testAppSet
+
+#include <thread>
+
+#include "capiocl/apps.h"
+
+TEST(APPS_SUITE_NAME, testInterner) {
+    using capiocl::engine::AppInterner;
+
+    const auto id = AppInterner::intern("test_interner_app");
+    EXPECT_EQ(AppInterner::intern("test_interner_app"), id);
+    EXPECT_EQ(AppInterner::find("test_interner_app"), id);
+    EXPECT_EQ(AppInterner::name(id), "test_interner_app");
+    EXPECT_EQ(AppInterner::find("test_interner_never_seen"), AppInterner::NONE);
+
+    // Names interned concurrently get one identifier each, visible to all the readers
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([] {
+            for (int i = 0; i < 100; i++) {
+                const auto name = "test_interner_shared_" + std::to_string(i);
+                const auto id   = AppInterner::intern(name);
+                EXPECT_EQ(AppInterner::find(name), id);
+                EXPECT_EQ(AppInterner::name(id), name);
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(AppInterner::name(AppInterner::find("test_interner_shared_99")),
+              "test_interner_shared_99");
+}
+
+TEST(APPS_SUITE_NAME, testInsertContains) {
+    capiocl::engine::AppSet set;
+    EXPECT_TRUE(set.empty());
+    EXPECT_TRUE(set.insert("A"));
+    EXPECT_FALSE(set.insert("A"));
+    EXPECT_TRUE(set.insert("B"));
+    EXPECT_EQ(set.size(), 2);
+    EXPECT_TRUE(set.contains("A"));
+    EXPECT_TRUE(set.contains(capiocl::engine::AppInterner::find("B")));
+    EXPECT_FALSE(set.contains("C"));
+    EXPECT_FALSE(set.contains("test_contains_never_seen"));
+
+    const auto names = set.names();
+    EXPECT_EQ(names.size(), 2);
+    EXPECT_TRUE(std::find(names.begin(), names.end(), "A") != names.end());
+    EXPECT_TRUE(std::find(names.begin(), names.end(), "B") != names.end());
+
+    EXPECT_TRUE(set.erase("A"));
+    EXPECT_FALSE(set.erase("A"));
+    EXPECT_FALSE(set.erase("test_erase_never_seen"));
+    EXPECT_FALSE(set.contains("A"));
+    EXPECT_EQ(set.size(), 1);
+}
+
+TEST(APPS_SUITE_NAME, testOverflow) {
+    capiocl::engine::AppSet set, copy;
+    for (int i = 0; i < 100; i++) {
+        set.insert("test_overflow_app_" + std::to_string(i));
+    }
+    EXPECT_EQ(set.size(), 100);
+
+    std::size_t count = 0;
+    for (const auto &name : set) {
+        EXPECT_TRUE(set.contains(name));
+        count++;
+    }
+    EXPECT_EQ(count, 100);
+
+    copy = set;
+    EXPECT_TRUE(copy == set);
+    copy.insert("test_overflow_app_extra");
+    EXPECT_TRUE(copy != set);
+
+    capiocl::engine::AppSet merged = {"test_overflow_app_extra"};
+    merged |= set;
+    EXPECT_TRUE(merged == copy);
+
+    EXPECT_TRUE(merged.erase("test_overflow_app_extra"));
+    EXPECT_TRUE(merged == set);
+    EXPECT_FALSE(merged.erase("test_overflow_app_extra"));
+}
+
+#endif // CAPIO_CL_TEST_APPS_HPP
@@ -0,0 +1,173 @@
+#ifndef CAPIO_CL_TEST_BUILDER_HPP
+#define CAPIO_CL_TEST_BUILDER_HPP
+
+#define BUILDER_SUITE_NAME testEngineBuilder
+
+#include "capiocl/builder.h"
+
+/// Issue the same sequence of calls the parsers do, on either an Engine or an EngineBuilder
+template <typename T> void fill_workflow(T &target) {
+    for (int i = 0; i < 50; i++) {
+        const auto file = "/wf/out/file" + std::to_string(i) + ".dat";
+        std::string producer = " writer ", consumer = "reader";
+        target.newFile(file);
+        target.addProducer(file, producer);
+        target.addConsumer(file, consumer);
+    }
+    target.setCommitRule("/wf/out/*.dat", capiocl::commitRules::ON_CLOSE);
+    target.setCommitedCloseNumber("/wf/out/*.dat", 3);
+    target.newFile("/wf/out/late.dat");
+
+    target.setDirectory("/wf/out");
+    target.setCommitRule("/wf/out", capiocl::commitRules::ON_N_FILES);
+    target.setFireRule("/wf/out", capiocl::fireRules::NO_UPDATE);
+    target.setDirectoryFileCount("/wf/fixed", 10);
+    target.newFile("/wf/fixed/a");
+
+    target.setFileDeps("/wf/final", {"/wf/out/file0.dat", "/wf/extra"});
+    target.setFileDeps("/wf/none", {});
+    std::filesystem::path dependency = "/wf/extra";
+    target.addFileDependency("/wf/other", dependency);
+    target.newFile("/wf/perm");
+    target.setPermanent("/wf/perm", true);
+    target.setExclude("/wf/tmp", true);
+    target.setStoreFileInMemory("/wf/out/file1.dat");
+    target.setStoreFileInFileSystem("/wf/out/file1.dat");
+    target.setStoreFileInMemory("/wf/out/file2.dat");
+    target.setFile("/wf/out/file3.dat");
+    target.newFile("/wf");
+}
+
+TEST(BUILDER_SUITE_NAME, testSameAsEngine) {
+    capiocl::engine::Engine expected, engine;
+    fill_workflow(expected);
+
+    capiocl::engine::EngineBuilder builder;
+    fill_workflow(builder);
+    EXPECT_EQ(builder.size(), expected.size());
+    EXPECT_EQ(engine.size(), 0);
+
+    builder.publish(engine);
+    EXPECT_EQ(builder.size(), 0);
+    EXPECT_TRUE(engine == expected);
+
+    for (const auto &path : expected.getPaths()) {
+        EXPECT_EQ(engine.getDirectoryFileCount(path), expected.getDirectoryFileCount(path));
+        EXPECT_EQ(engine.isFile(path), expected.isFile(path));
+        EXPECT_EQ(engine.isStoredInMemory(path), expected.isStoredInMemory(path));
+        EXPECT_EQ(engine.getCommitRuleType(path), expected.getCommitRuleType(path));
+    }
+    EXPECT_EQ(engine.getDirectoryFileCount("/wf/out"), 51);
+    EXPECT_EQ(engine.getDirectoryFileCount("/wf/fixed"), 10);
+    EXPECT_TRUE(engine.isProducer("/wf/out/file7.dat", "writer"));
+    EXPECT_EQ(engine.getCommitCloseCount("/wf/out/late.dat"), 3);
+    EXPECT_EQ(engine.getCommitRuleType("/wf/other"), capiocl::commitRules::COMMIT_RULE::ON_FILE);
+    EXPECT_FALSE(engine.contains("/wf/none"));
+
+    // Rules published by the builder apply to the entries created later by the Engine
+    EXPECT_EQ(engine.getCommitCloseCount("/wf/out/after.dat"), 3);
+    EXPECT_EQ(engine.getChildren("/wf/out").size(), 52);
+}
+
+TEST(BUILDER_SUITE_NAME, testPublishMerges) {
+    capiocl::engine::Engine engine;
+    engine.newFile("/m/dir/a");
+    engine.newFile("/m/dir");
+    std::string producer = "first";
+    engine.addProducer("/m/dir/a", producer);
+    engine.setCommitRule("/m/*.log", capiocl::commitRules::ON_CLOSE);
+
+    capiocl::engine::EngineBuilder builder;
+    builder.addProducer("/m/dir/a", "second");
+    builder.newFile("/m/dir/b");
+    builder.newFile("/m/dir/c");
+    builder.setPermanent("/m/*.log", true);
+    builder.publish(engine);
+
+    EXPECT_TRUE(engine.isProducer("/m/dir/a", "first"));
+    EXPECT_TRUE(engine.isProducer("/m/dir/a", "second"));
+    EXPECT_TRUE(engine.isPermanent("/m/x.log"));
+
+    // Children published by the builder are counted along with the ones already in the Engine
+    EXPECT_EQ(engine.getDirectoryFileCount("/m/dir"), 3);
+    EXPECT_TRUE(engine.isDirectory("/m/dir"));
+    EXPECT_EQ(engine.getChildren("/m/dir").size(), 3);
+
+    // Publishing an empty builder leaves the Engine untouched
+    const auto size = engine.size();
+    builder.publish(engine);
+    EXPECT_EQ(engine.size(), size);
+}
+
+TEST(BUILDER_SUITE_NAME, testStoreAllInMemory) {
+    capiocl::engine::Engine engine;
+    engine.newFile("/s/existing");
+
+    capiocl::engine::EngineBuilder builder;
+    builder.newFile("/s/before");
+    builder.setAllStoreInMemory();
+    builder.newFile("/s/after");
+    builder.publish(engine);
+
+    EXPECT_TRUE(engine.isStoredInMemory("/s/existing"));
+    EXPECT_TRUE(engine.isStoredInMemory("/s/before"));
+    EXPECT_TRUE(engine.isStoredInMemory("/s/after"));
+    EXPECT_TRUE(engine.isStoredInMemory("/s/new"));
+}
+
+TEST(BUILDER_SUITE_NAME, testFileDependencies) {
+    capiocl::engine::EngineBuilder builder;
+    builder.setCommitRule("/d/b", capiocl::commitRules::ON_FILE);
+    builder.setFileDeps("/d/b", {"/d/a"});
+    builder.addFileDependency("/d/c", "/d/b");
+    EXPECT_THROW(builder.setFileDeps("/d/a", {"/d/c"}), std::invalid_argument);
+    EXPECT_THROW(builder.addFileDependency("/d/a", "/d/a"), std::invalid_argument);
+
+    capiocl::engine::Engine engine;
+    builder.publish(engine);
+    EXPECT_EQ(engine.getFileDependents("/d/a"), std::vector<std::string>{"/d/b"});
+    EXPECT_EQ(engine.getFileDependents("/d/b"), std::vector<std::string>{"/d/c"});
+    EXPECT_THROW(engine.setFileDeps("/d/a", {"/d/c"}), std::invalid_argument);
+
+    // Dependencies published into an Engine that already has some are merged, and checked
+    builder.setFileDeps("/d/e", {"/d/c"});
+    builder.publish(engine);
+    EXPECT_EQ(engine.getFileDependents("/d/c"), std::vector<std::string>{"/d/e"});
+
+    builder.setFileDeps("/d/a", {"/d/e"});
+    for (int i = 0; i < 50; i++) {
+        builder.setFileDeps("/d/n" + std::to_string(i), {"/d/n"});
+    }
+    EXPECT_THROW(builder.publish(engine), std::invalid_argument);
+    EXPECT_TRUE(engine.getCommitOnFileDependencies("/d/a").empty());
+    EXPECT_TRUE(engine.getFileDependents("/d/n").empty());
+    EXPECT_EQ(engine.getFileDependents("/d/c"), std::vector<std::string>{"/d/e"});
+}
+
+TEST(BUILDER_SUITE_NAME, testDependenciesCommittedFirst) {
+    const auto base = std::filesystem::temp_directory_path() /
+                      ("capiocl_builder_committed_" + std::to_string(getpid()));
+
+    // Published targets whose dependencies are already committed are committed, and so are their
+    // own dependents, whether the Engine had dependencies before or not
+    for (const bool linked : {false, true}) {
+        const auto dir = base / (linked ? "linked" : "empty");
+        capiocl::engine::Engine engine;
+        if (linked) {
+            engine.setFileDeps(dir / "other", {dir / "unrelated"});
+        }
+        engine.setCommitted(dir / "d");
+
+        capiocl::engine::EngineBuilder builder;
+        builder.setCommitRule(dir / "t", capiocl::commitRules::ON_FILE);
+        builder.setFileDeps(dir / "t", {dir / "d"});
+        builder.setCommitRule(dir / "u", capiocl::commitRules::ON_FILE);
+        builder.setFileDeps(dir / "u", {dir / "t"});
+        builder.publish(engine);
+        EXPECT_TRUE(engine.isCommitted(dir / "t"));
+        EXPECT_TRUE(engine.isCommitted(dir / "u"));
+    }
+    std::filesystem::remove_all(base);
+}
+
+#endif // CAPIO_CL_TEST_BUILDER_HPP
@@ -58,4 +58,58 @@ TEST(CONFIGURATION_SUITE_NAME, testNoBackendLoadedWithExplicitNoLoadOption) {
     EXPECT_TRUE("false" == value);
 }
 
+TEST(CONFIGURATION_SUITE_NAME, testEngineShards) {
+    capiocl::configuration::CapioClConfiguration config;
+    config.load("/tmp/capio_cl_tomls/sample4.toml");
+
+    int shards;
+    config.getParameter("engine.shards", &shards);
+    EXPECT_EQ(shards, 4);
+
+    capiocl::engine::Engine engine(false);
+    for (int i = 0; i < 100; i++) {
+        engine.newFile("/tmp/file" + std::to_string(i));
+    }
+    engine.newFile("/tmp/*.dat");
+    engine.setCommitRule("/tmp/file42", capiocl::commitRules::ON_CLOSE);
+
+    engine.loadConfiguration("/tmp/capio_cl_tomls/sample4.toml");
+    EXPECT_EQ(engine.size(), 101);
+    EXPECT_TRUE(engine.contains("/tmp/file0"));
+    EXPECT_TRUE(engine.contains("/tmp/other.dat"));
+    EXPECT_EQ(engine.getCommitRule("/tmp/file42"), capiocl::commitRules::ON_CLOSE);
+}
+
+TEST(CONFIGURATION_SUITE_NAME, testMaterializeReads) {
+    capiocl::engine::Engine engine(false);
+    engine.loadConfiguration("/tmp/capio_cl_tomls/sample6.toml");
+
+    std::string producer = "producer";
+    engine.setCommitRule("/scratch/*", capiocl::commitRules::ON_CLOSE);
+    engine.addProducer("/scratch/*", producer);
+    engine.setFireRule("/scratch/kept", capiocl::fireRules::NO_UPDATE);
+    const auto size = engine.size();
+
+    for (int i = 0; i < 100; i++) {
+        const auto path = "/scratch/file" + std::to_string(i);
+        EXPECT_EQ(engine.getCommitRule(path), capiocl::commitRules::ON_CLOSE);
+        EXPECT_TRUE(engine.isProducer(path, producer));
+        EXPECT_FALSE(engine.isConsumer(path, producer));
+        EXPECT_FALSE(engine.isFirable(path));
+    }
+    EXPECT_EQ(engine.getCommitRule("/other"), capiocl::commitRules::ON_TERMINATION);
+    EXPECT_EQ(engine.queryBatch({"/scratch/a", "/scratch/kept"})[1].fire_rule,
+              capiocl::fireRules::FIRE_RULE::NO_UPDATE);
+    EXPECT_TRUE(engine.isFirable("/scratch/kept"));
+
+    EXPECT_EQ(engine.size(), size);
+    EXPECT_EQ(engine.getAvoidedEntries(), 100 * 3 + 1 + 1);
+    EXPECT_FALSE(engine.isDirectory("/scratch"));
+
+    // Entries are still created by methods that modify them
+    engine.setPermanent("/scratch/file0", true);
+    EXPECT_EQ(engine.size(), size + 1);
+    EXPECT_EQ(engine.getCommitRule("/scratch/file0"), capiocl::commitRules::ON_CLOSE);
+}
+
 #endif // CAPIO_CL_TEST_CONFIGURATION_HPP
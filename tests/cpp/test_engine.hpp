@@ -3,6 +3,8 @@
 
 #define ENGINE_SUITE_NAME testEngine
 
+#include <unistd.h>
+
 TEST(ENGINE_SUITE_NAME, testInstantiation) {
     capiocl::engine::Engine engine;
     EXPECT_EQ(engine.size(), 0);
@@ -439,6 +441,37 @@ TEST(ENGINE_SUITE_NAME, testComputeDirectoryFileCount) {
     EXPECT_EQ(e.getDirectoryFileCount("a/b/r"), 1);
 }
 
+TEST(ENGINE_SUITE_NAME, testDirectoryTree) {
+    capiocl::engine::Engine e;
+    e.newFile("/x/y/z/f1");
+    e.newFile("/x/y/z/f2");
+    e.newFile("/x/y/g");
+    e.newFile("/x/y/*.dat");
+
+    // Directories created after their files count the files already known
+    e.newFile("/x/y/z");
+    EXPECT_TRUE(e.isDirectory("/x/y/z"));
+    EXPECT_EQ(e.getDirectoryFileCount("/x/y/z"), 2);
+    EXPECT_EQ(e.getDirectoryFileCount("/x/y"), 2);
+    EXPECT_EQ(e.getDirectoryFileCount("/x"), 1);
+
+    auto children = e.getChildren("/x/y/z");
+    std::sort(children.begin(), children.end());
+    EXPECT_EQ(children, (std::vector<std::string>{"/x/y/z/f1", "/x/y/z/f2"}));
+    EXPECT_TRUE(e.getChildren("/x/y/z/f1").empty());
+    EXPECT_TRUE(e.getChildren("/nowhere").empty());
+
+    e.remove("/x/y/z/f1");
+    EXPECT_EQ(e.getChildren("/x/y/z"), std::vector<std::string>{"/x/y/z/f2"});
+
+    // Only the target of setDirectoryFileCount() becomes a directory
+    e.setDirectoryFileCount("/x/y/z", 7);
+    EXPECT_TRUE(e.isDirectory("/x/y/z"));
+    EXPECT_EQ(e.getDirectoryFileCount("/x/y/z"), 7);
+    EXPECT_TRUE(e.isFile("/x/y/z/f2"));
+    EXPECT_TRUE(e.isFile("/x/y/g"));
+}
+
 TEST(ENGINE_SUITE_NAME, testEqualDifferentOperator) {
     capiocl::engine::Engine engine1, engine2;
 
@@ -644,16 +677,16 @@ TEST(ENGINE_SUITE_NAME, TestEngineAddCapioClRule) {
     engine.newFile("/test1");
 
     capiocl::engine::CapioCLEntry entry, entry1;
-    entry.commit_rule  = "on_file";
-    entry1.commit_rule = "on_commit";
+    entry.commit_rule  = capiocl::commitRules::COMMIT_RULE::ON_FILE;
+    entry1.commit_rule = capiocl::commitRules::COMMIT_RULE::ON_CLOSE;
 
     engine.add("/test1", entry);
 
-    EXPECT_EQ(entry.commit_rule, engine.getCommitRule("/test1"));
+    EXPECT_EQ(entry.commit_rule, engine.getCommitRuleType("/test1"));
 
     engine.add("/test2", entry);
 
-    EXPECT_EQ(entry.commit_rule, engine.getCommitRule("/test2"));
+    EXPECT_EQ(entry.commit_rule, engine.getCommitRuleType("/test2"));
 
     const auto new_entry = entry + entry1;
     EXPECT_TRUE(entry1 == new_entry);
@@ -662,4 +695,611 @@ TEST(ENGINE_SUITE_NAME, TestEngineAddCapioClRule) {
     // TODO: test all entries of capioCL rule
 }
 
+TEST(ENGINE_SUITE_NAME, TestTypedRules) {
+    capiocl::engine::Engine engine;
+
+    EXPECT_LE(sizeof(capiocl::engine::CapioCLEntry), 64);
+
+    engine.setCommitRule("/typed/*", capiocl::commitRules::COMMIT_RULE::ON_N_FILES);
+    engine.setFireRule("/typed/*", capiocl::fireRules::FIRE_RULE::NO_UPDATE);
+    EXPECT_EQ(engine.getCommitRuleType("/typed/a"), capiocl::commitRules::COMMIT_RULE::ON_N_FILES);
+    EXPECT_EQ(engine.getCommitRule("/typed/a"), capiocl::commitRules::ON_N_FILES);
+    EXPECT_EQ(engine.getFireRuleType("/typed/a"), capiocl::fireRules::FIRE_RULE::NO_UPDATE);
+    EXPECT_TRUE(engine.isFirable("/typed/a"));
+
+    engine.setCommitRule("/typed/b", capiocl::commitRules::ON_CLOSE);
+    EXPECT_EQ(engine.getCommitRuleType("/typed/b"), capiocl::commitRules::COMMIT_RULE::ON_CLOSE);
+
+    EXPECT_THROW(engine.setCommitRule("/typed/b", "on_commit"), std::invalid_argument);
+    EXPECT_THROW(engine.setFireRule("/typed/b", "stream"), std::invalid_argument);
+    EXPECT_THROW(capiocl::commitRules::fromString(""), std::invalid_argument);
+    EXPECT_EQ(engine.getCommitRuleType("/typed/b"), capiocl::commitRules::COMMIT_RULE::ON_CLOSE);
+
+    for (const auto rule : {capiocl::commitRules::ON_CLOSE, capiocl::commitRules::ON_FILE,
+                            capiocl::commitRules::ON_N_FILES,
+                            capiocl::commitRules::ON_TERMINATION}) {
+        EXPECT_STREQ(capiocl::commitRules::toString(capiocl::commitRules::fromString(rule)), rule);
+    }
+}
+
+TEST(ENGINE_SUITE_NAME, TestConcurrentAccess) {
+    capiocl::engine::Engine engine;
+    std::string producer_name = "producer";
+    engine.addProducer("/data/*.dat", producer_name);
+    engine.setCommitRule("/data/*.dat", capiocl::commitRules::ON_CLOSE);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; t++) {
+        threads.emplace_back([&engine, &producer_name, t] {
+            for (int i = 0; i < 200; i++) {
+                const auto path = "/data/" + std::to_string(t) + "_" + std::to_string(i) + ".dat";
+                EXPECT_TRUE(engine.isProducer(path, producer_name));
+                EXPECT_EQ(engine.getCommitRule(path), capiocl::commitRules::ON_CLOSE);
+                engine.setFireRule(path, capiocl::fireRules::NO_UPDATE);
+                EXPECT_TRUE(engine.isFirable(path));
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(engine.size(), 8 * 200 + 1);
+    // The directory is created after its files, which are found through the directory tree
+    EXPECT_EQ(engine.getDirectoryFileCount("/data"), 8 * 200);
+    EXPECT_EQ(engine.getChildren("/data").size(), 8 * 200);
+}
+
+TEST(ENGINE_SUITE_NAME, TestSnapshotReads) {
+    capiocl::engine::Engine engine(false);
+    engine.newFile("/data/before");
+    engine.loadConfiguration("/tmp/capio_cl_tomls/sample5.toml");
+
+    std::string producer_name = "producer";
+    EXPECT_TRUE(engine.contains("/data/before"));
+    engine.addProducer("/data/*.dat", producer_name);
+    engine.setCommitRule("/data/*.dat", capiocl::commitRules::ON_CLOSE);
+    EXPECT_TRUE(engine.contains("/data/x.dat"));
+    EXPECT_TRUE(engine.isProducer("/data/x.dat", producer_name));
+    EXPECT_EQ(engine.getCommitRule("/data/x.dat"), capiocl::commitRules::ON_CLOSE);
+
+    // Queries are answered from the rules instead of copying the shard snapshot to insert entries
+    const auto size = engine.size();
+    EXPECT_TRUE(engine.isProducer("/data/z.dat", producer_name));
+    EXPECT_EQ(engine.queryBatch({"/data/w.dat"})[0].commit_rule,
+              capiocl::commitRules::COMMIT_RULE::ON_CLOSE);
+    EXPECT_EQ(engine.size(), size);
+
+    engine.setFireRule("/data/x.dat", capiocl::fireRules::NO_UPDATE);
+    EXPECT_TRUE(engine.isFirable("/data/x.dat"));
+    engine.remove("/data/x.dat");
+    EXPECT_FALSE(engine.isFirable("/data/x.dat"));
+    engine.remove("/data/*.dat");
+    EXPECT_FALSE(engine.contains("/data/y.dat"));
+
+    std::atomic<bool> stop = false;
+    std::thread writer([&engine, &stop] {
+        for (int i = 0; !stop; i++) {
+            engine.setCommitRule("/data/shared", i % 2 == 0 ? capiocl::commitRules::ON_CLOSE
+                                                            : capiocl::commitRules::ON_FILE);
+        }
+    });
+
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; t++) {
+        readers.emplace_back([&engine] {
+            for (int i = 0; i < 1000; i++) {
+                const auto rule = engine.getCommitRule("/data/shared");
+                EXPECT_TRUE(rule == capiocl::commitRules::ON_CLOSE ||
+                            rule == capiocl::commitRules::ON_FILE ||
+                            rule == capiocl::commitRules::ON_TERMINATION);
+            }
+        });
+    }
+    for (auto &reader : readers) {
+        reader.join();
+    }
+    stop = true;
+    writer.join();
+}
+
+TEST(ENGINE_SUITE_NAME, TestEntryHandles) {
+    capiocl::engine::Engine engine;
+    std::string producer = "writer", consumer = "reader";
+
+    EXPECT_TRUE(engine.resolve("").empty());
+    EXPECT_FALSE(engine.isValid(engine.resolve("")));
+    EXPECT_TRUE(engine.isFirable(engine.resolve("")));
+
+    engine.addProducer("/out/*", producer);
+    engine.setCommitRule("/out/*", capiocl::commitRules::ON_CLOSE);
+    engine.setCommitedCloseNumber("/out/*", 3);
+
+    const auto handle = engine.resolve("/out/file.dat");
+    EXPECT_FALSE(handle.empty());
+    EXPECT_EQ(handle.path(), "/out/file.dat");
+    EXPECT_TRUE(engine.isValid(handle));
+    EXPECT_TRUE(engine.contains("/out/file.dat"));
+    EXPECT_EQ(engine.getCommitRule(handle), capiocl::commitRules::ON_CLOSE);
+    EXPECT_EQ(engine.getCommitCloseCount(handle), 3);
+    EXPECT_TRUE(engine.isProducer(handle, producer));
+    EXPECT_FALSE(engine.isConsumer(handle, consumer));
+    EXPECT_FALSE(engine.isFirable(handle));
+    EXPECT_TRUE(engine.isFile(handle));
+
+    // Inserts and updates do not invalidate the handle, which sees the new values
+    for (int i = 0; i < 1000; i++) {
+        engine.newFile("/out/other" + std::to_string(i));
+    }
+    engine.addConsumer("/out/file.dat", consumer);
+    engine.setFireRule("/out/file.dat", capiocl::fireRules::NO_UPDATE);
+    EXPECT_TRUE(engine.isValid(handle));
+    EXPECT_TRUE(engine.isConsumer(handle, consumer));
+    EXPECT_TRUE(engine.isFirable(handle));
+    EXPECT_EQ(engine.getConsumers(handle), std::vector<std::string>{consumer});
+
+    // After a removal the handle is stale, and queries resolve the path again
+    engine.remove("/out/file.dat");
+    EXPECT_FALSE(engine.isValid(handle));
+    EXPECT_FALSE(engine.isFirable(handle));
+    EXPECT_EQ(engine.getCommitRule(handle), capiocl::commitRules::ON_CLOSE);
+    EXPECT_TRUE(engine.contains("/out/file.dat"));
+
+    const auto rule = engine.resolve("/out/*");
+    EXPECT_TRUE(engine.isValid(rule));
+    engine.remove("/out/*");
+    EXPECT_FALSE(engine.isValid(rule));
+}
+
+TEST(ENGINE_SUITE_NAME, TestQueryBatch) {
+    capiocl::engine::Engine engine;
+
+    engine.setCommitRule("/batch/*.dat", capiocl::commitRules::ON_CLOSE);
+    engine.setCommitedCloseNumber("/batch/*.dat", 2);
+    engine.setFireRule("/batch/*.dat", capiocl::fireRules::NO_UPDATE);
+    engine.newFile("/batch/existing.dat");
+    engine.setPermanent("/batch/existing.dat", true);
+    engine.setFileDeps("/batch/deps", {"/batch/a", "/batch/b"});
+
+    std::vector<std::filesystem::path> paths = {"/batch",   "/batch/existing.dat", "",
+                                                "/batch/new.dat", "/batch/deps", "/batch/*.dat"};
+    for (int i = 0; i < 100; i++) {
+        paths.emplace_back("/batch/file" + std::to_string(i) + ".dat");
+    }
+
+    const auto attributes = engine.queryBatch(paths);
+    ASSERT_EQ(attributes.size(), paths.size());
+
+    EXPECT_FALSE(attributes[0].is_file);
+    EXPECT_TRUE(attributes[1].permanent);
+    EXPECT_EQ(attributes[1].commit_rule, capiocl::commitRules::COMMIT_RULE::ON_CLOSE);
+    EXPECT_EQ(attributes[2].commit_rule, capiocl::commitRules::COMMIT_RULE::ON_TERMINATION);
+    EXPECT_EQ(attributes[3].commit_on_close_count, 2);
+    EXPECT_EQ(attributes[3].fire_rule, capiocl::fireRules::FIRE_RULE::NO_UPDATE);
+    EXPECT_EQ(attributes[4].file_dependencies_count, 2);
+    EXPECT_EQ(attributes[5].commit_rule, capiocl::commitRules::COMMIT_RULE::ON_CLOSE);
+
+    // Missing entries are created, and match the single path queries
+    for (std::size_t i = 0; i < paths.size(); i++) {
+        if (paths[i].empty()) {
+            continue;
+        }
+        EXPECT_TRUE(engine.contains(paths[i]));
+        EXPECT_EQ(attributes[i].commit_rule, engine.getCommitRuleType(paths[i]));
+        EXPECT_EQ(attributes[i].fire_rule, engine.getFireRuleType(paths[i]));
+        EXPECT_EQ(attributes[i].commit_on_close_count, engine.getCommitCloseCount(paths[i]));
+        EXPECT_EQ(attributes[i].is_file, engine.isFile(paths[i]));
+        EXPECT_EQ(attributes[i].permanent, engine.isPermanent(paths[i]));
+    }
+    // Files created before "/batch" are counted as well, glob rules are not
+    EXPECT_EQ(engine.getDirectoryFileCount("/batch"), 105);
+}
+
+TEST(ENGINE_SUITE_NAME, TestFileDependencyCascade) {
+    capiocl::engine::Engine engine;
+    const auto base = std::filesystem::temp_directory_path() /
+                      ("capiocl_cascade_" + std::to_string(getpid()));
+
+    // A chain of Commit on File targets, each depending on the previous one
+    std::vector<std::filesystem::path> chain = {base / "0"};
+    for (int i = 1; i < 50; i++) {
+        chain.push_back(base / std::to_string(i));
+        engine.setCommitRule(chain.back(), capiocl::commitRules::ON_FILE);
+        engine.setFileDeps(chain.back(), {chain[i - 1]});
+    }
+    // A target waiting for two files, and a dependent that does not commit on file
+    engine.setCommitRule(base / "join", capiocl::commitRules::ON_FILE);
+    engine.setFileDeps(base / "join", {chain.back(), base / "other"});
+    engine.setFileDeps(base / "close", {chain[10]});
+
+    EXPECT_EQ(engine.getFileDependents(chain[0]),
+              std::vector<std::string>{chain[1].native()});
+    EXPECT_EQ(engine.getFileDependents(chain[10]).size(), 2);
+
+    // Dependencies closing a cycle are rejected, leaving the entry unchanged
+    EXPECT_THROW(engine.setFileDeps(chain[0], {chain[20]}), std::invalid_argument);
+    std::filesystem::path dependency = chain[5];
+    EXPECT_THROW(engine.addFileDependency(chain[5], dependency), std::invalid_argument);
+    EXPECT_TRUE(engine.getCommitOnFileDependencies(chain[0]).empty());
+    EXPECT_EQ(engine.getCommitOnFileDependencies(chain[5]), std::vector{chain[4]});
+
+    engine.setCommitted(chain[0]);
+    for (const auto &path : chain) {
+        EXPECT_TRUE(engine.isCommitted(path));
+    }
+    EXPECT_FALSE(engine.isCommitted(base / "close"));
+    EXPECT_FALSE(engine.isCommitted(base / "join"));
+
+    engine.setCommitted(base / "other");
+    EXPECT_TRUE(engine.isCommitted(base / "join"));
+    std::filesystem::remove_all(base);
+}
+
+TEST(ENGINE_SUITE_NAME, TestFileDependencyCommittedFirst) {
+    capiocl::engine::Engine engine;
+    const auto base = std::filesystem::temp_directory_path() /
+                      ("capiocl_committed_first_" + std::to_string(getpid()));
+
+    // Targets matching a glob rule inherit its dependency when they are first touched
+    engine.setCommitRule(base / "out" / "*", capiocl::commitRules::ON_FILE);
+    engine.setFileDeps(base / "out" / "*", {base / "input"});
+    engine.setCommitted(base / "input");
+
+    engine.newFile(base / "out" / "a");
+    EXPECT_TRUE(engine.isCommitted(base / "out" / "a"));
+    EXPECT_EQ(engine.getCommitRule(base / "out" / "b"), capiocl::commitRules::ON_FILE);
+    EXPECT_TRUE(engine.isCommitted(base / "out" / "b"));
+
+    // A target linked once its dependencies are all committed is committed right away, and so
+    // are its own dependents
+    engine.setCommitRule(base / "last", capiocl::commitRules::ON_FILE);
+    engine.setFileDeps(base / "last", {base / "join"});
+    engine.setCommitRule(base / "join", capiocl::commitRules::ON_FILE);
+    engine.setFileDeps(base / "join", {base / "input", base / "out" / "a"});
+    EXPECT_TRUE(engine.isCommitted(base / "join"));
+    EXPECT_TRUE(engine.isCommitted(base / "last"));
+    std::filesystem::remove_all(base);
+}
+
+TEST(ENGINE_SUITE_NAME, TestNotifyClose) {
+    capiocl::engine::Engine engine;
+    const auto base = std::filesystem::temp_directory_path() /
+                      ("capiocl_close_" + std::to_string(getpid()));
+
+    engine.setCommitRule(base / "three", capiocl::commitRules::ON_CLOSE);
+    engine.setCommitedCloseNumber(base / "three", 3);
+    EXPECT_FALSE(engine.notifyClose(base / "three"));
+    EXPECT_FALSE(engine.notifyClose(base / "three"));
+    EXPECT_FALSE(engine.isCommitted(base / "three"));
+    EXPECT_TRUE(engine.notifyClose(base / "three"));
+    EXPECT_TRUE(engine.isCommitted(base / "three"));
+    EXPECT_FALSE(engine.notifyClose(base / "three"));
+    EXPECT_EQ(engine.getCloseCount(base / "three"), 4);
+
+    // on_close without a counter commits on the first close, other rules never do
+    engine.setCommitRule(base / "once", capiocl::commitRules::ON_CLOSE);
+    EXPECT_TRUE(engine.notifyClose(base / "once"));
+    EXPECT_FALSE(engine.notifyClose(base / "end"));
+    EXPECT_FALSE(engine.isCommitted(base / "end"));
+    EXPECT_FALSE(engine.notifyClose(""));
+
+    // Commits triggered by closes cascade to the Commit on File dependents
+    engine.setCommitRule(base / "dependent", capiocl::commitRules::ON_FILE);
+    engine.setFileDeps(base / "dependent", {base / "last"});
+    engine.setCommitRule(base / "last", capiocl::commitRules::ON_CLOSE);
+    EXPECT_TRUE(engine.notifyClose(base / "last"));
+    EXPECT_TRUE(engine.isCommitted(base / "dependent"));
+
+    // Among concurrent closes, exactly one commits the file
+    engine.setCommitRule(base / "shared", capiocl::commitRules::ON_CLOSE);
+    engine.setCommitedCloseNumber(base / "shared", 100);
+    std::atomic<int> commits = 0;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; t++) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < 50; i++) {
+                commits += engine.notifyClose(base / "shared") ? 1 : 0;
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(commits.load(), 1);
+    EXPECT_EQ(engine.getCloseCount(base / "shared"), 400);
+
+    engine.remove(base / "three");
+    EXPECT_EQ(engine.getCloseCount(base / "three"), 0);
+    std::filesystem::remove_all(base);
+}
+
+TEST(ENGINE_SUITE_NAME, TestOnNFilesCommit) {
+    capiocl::engine::Engine engine;
+    const auto base = std::filesystem::temp_directory_path() /
+                      ("capiocl_n_files_" + std::to_string(getpid()));
+
+    engine.setCommitRule(base / "dir", capiocl::commitRules::ON_N_FILES);
+    engine.setDirectoryFileCount(base / "dir", 3);
+    engine.newFile(base / "dir" / "a");
+    engine.setCommitted(base / "dir" / "b");
+    EXPECT_FALSE(engine.isCommitted(base / "dir"));
+
+    // Each file is counted once, whether it is created, committed, or both
+    engine.setCommitted(base / "dir" / "a");
+    engine.newFile(base / "dir" / "b");
+    EXPECT_EQ(engine.getObservedFileCount(base / "dir"), 2);
+    EXPECT_FALSE(engine.isCommitted(base / "dir"));
+    engine.newFile(base / "dir" / "c");
+    EXPECT_EQ(engine.getObservedFileCount(base / "dir"), 3);
+    EXPECT_TRUE(engine.isCommitted(base / "dir"));
+
+    // Removed files are no longer counted, and a removed directory counts its files anew
+    engine.remove(base / "dir" / "c");
+    EXPECT_EQ(engine.getObservedFileCount(base / "dir"), 2);
+    engine.newFile(base / "dir" / "c");
+    EXPECT_EQ(engine.getObservedFileCount(base / "dir"), 3);
+    engine.remove(base / "dir");
+    engine.setCommitRule(base / "dir", capiocl::commitRules::ON_N_FILES);
+    engine.setDirectoryFileCount(base / "dir", 3);
+    for (const auto *name : {"a", "b", "c"}) {
+        engine.newFile(base / "dir" / name);
+    }
+    EXPECT_EQ(engine.getObservedFileCount(base / "dir"), 3);
+
+    // Directories without an explicit file count, or with another rule, are not counted
+    engine.setCommitRule(base / "auto", capiocl::commitRules::ON_N_FILES);
+    engine.newFile(base / "auto" / "a");
+    EXPECT_EQ(engine.getObservedFileCount(base / "auto"), 0);
+    EXPECT_FALSE(engine.isCommitted(base / "auto"));
+    engine.setDirectoryFileCount(base / "other", 1);
+    engine.newFile(base / "other" / "a");
+    EXPECT_FALSE(engine.isCommitted(base / "other"));
+
+    // A committed directory is counted in its own parent
+    engine.setCommitRule(base / "outer", capiocl::commitRules::ON_N_FILES);
+    engine.setDirectoryFileCount(base / "outer", 1);
+    engine.setCommitRule(base / "outer" / "inner", capiocl::commitRules::ON_N_FILES);
+    engine.setDirectoryFileCount(base / "outer" / "inner", 1);
+    engine.newFile(base / "outer" / "inner" / "a");
+    EXPECT_TRUE(engine.isCommitted(base / "outer" / "inner"));
+    EXPECT_TRUE(engine.isCommitted(base / "outer"));
+
+    // Concurrent creations and commits of the same files are counted once
+    engine.setCommitRule(base / "shared", capiocl::commitRules::ON_N_FILES);
+    engine.setDirectoryFileCount(base / "shared", 200);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; t++) {
+        threads.emplace_back([&, t] {
+            for (int i = 0; i < 200; i++) {
+                const auto file = base / "shared" / ("f" + std::to_string(i));
+                if ((i + t) % 2 == 0) {
+                    engine.newFile(file);
+                } else {
+                    engine.setCommitted(file);
+                }
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(engine.getObservedFileCount(base / "shared"), 200);
+    EXPECT_TRUE(engine.isCommitted(base / "shared"));
+
+    engine.remove(base / "dir");
+    EXPECT_EQ(engine.getObservedFileCount(base / "dir"), 0);
+    std::filesystem::remove_all(base);
+}
+
+TEST(ENGINE_SUITE_NAME, TestStats) {
+    capiocl::engine::Engine engine(false);
+    engine.setCommitRule("/stats/*.dat", capiocl::commitRules::ON_CLOSE);
+    engine.newFile("/stats/a.dat");
+    engine.newFile("/stats/b.txt");
+    EXPECT_EQ(engine.getCommitRule("/stats/a.dat"), capiocl::commitRules::ON_CLOSE);
+    EXPECT_EQ(engine.getCommitRule("/stats/c.dat"), capiocl::commitRules::ON_CLOSE);
+    engine.setPermanent("/stats/a.dat", true);
+    engine.queryBatch({"/stats/a.dat", "/stats/b.txt"});
+    engine.remove("/stats/b.txt");
+
+    // Sizes are reported even when statistics are compiled out
+    auto stats = engine.stats();
+    EXPECT_EQ(stats.patterns, 1);
+    EXPECT_EQ(stats.entries, engine.size() - 1);
+
+#ifdef CAPIO_CL_ENABLE_STATS
+    EXPECT_TRUE(stats.enabled);
+    EXPECT_GE(stats.materializations, 3);
+    EXPECT_GT(stats.glob_comparisons, 0);
+    EXPECT_GT(stats.lookup_hits, 0);
+    EXPECT_GT(stats.lookup_misses, 0);
+    EXPECT_GT(stats.hitRatio(), 0);
+    EXPECT_LT(stats.hitRatio(), 1);
+    EXPECT_GT(stats.exclusive_locks, 0);
+    EXPECT_GT(stats.shared_locks, 0);
+    for (const auto *method : {"newFile", "query", "update", "remove", "queryBatch"}) {
+        const auto &latency = stats.latencies.at(method);
+        EXPECT_GT(latency.count, 0) << method;
+        EXPECT_GT(latency.mean(), 0) << method;
+        EXPECT_GE(latency.percentile(99), latency.percentile(50)) << method;
+    }
+    EXPECT_EQ(stats.latencies.at("queryBatch").count, 1);
+    EXPECT_EQ(stats.latencies.at("remove").count, 1);
+
+    // Entries created and looked up by queryBatch() are counted like the others, and so are the
+    // locks taken by EngineBuilder::publish()
+    engine.queryBatch({"/stats/a.dat", "/stats/d.dat", "/stats/e.dat"});
+    auto batch = engine.stats();
+    EXPECT_GE(batch.materializations, stats.materializations + 2);
+    EXPECT_GE(batch.lookup_hits, stats.lookup_hits + 1);
+    EXPECT_GE(batch.lookup_misses, stats.lookup_misses + 2);
+    capiocl::engine::EngineBuilder builder;
+    builder.newFile("/stats/built");
+    builder.publish(engine);
+    EXPECT_GT(engine.stats().exclusive_locks, batch.exclusive_locks);
+
+    // Concurrent updates are all counted
+    const auto calls = stats.latencies.at("newFile").count;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; t++) {
+        threads.emplace_back([&engine, t] {
+            for (int i = 0; i < 100; i++) {
+                engine.newFile("/stats/t" + std::to_string(t) + "/" + std::to_string(i));
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    stats = engine.stats();
+    EXPECT_EQ(stats.latencies.at("newFile").count, calls + 800);
+    EXPECT_EQ(stats.entries, engine.size() - 1);
+#else
+    EXPECT_FALSE(stats.enabled);
+    EXPECT_TRUE(stats.latencies.empty());
+#endif
+}
+
+TEST(ENGINE_SUITE_NAME, TestDeltas) {
+    using capiocl::engine::Delta;
+    capiocl::engine::Engine engine;
+    engine.setCommitRule("/deltas/*", capiocl::commitRules::ON_CLOSE);
+    EXPECT_EQ(engine.getVersion(), 0);
+
+    // Applying a delta twice changes the entry and the version once
+    const auto first = engine.apply(Delta::add("/deltas/a", Delta::PRODUCER, "writer"));
+    EXPECT_EQ(first, 1);
+    EXPECT_EQ(engine.apply(Delta::add("/deltas/a", Delta::PRODUCER, "writer")), first);
+    EXPECT_EQ(engine.getProducers("/deltas/a"), std::vector<std::string>{"writer"});
+    engine.apply(Delta::set("/deltas/a", Delta::COMMIT_ON_CLOSE_COUNT, 4));
+    engine.apply(Delta::set("/deltas/a", Delta::COMMIT_ON_CLOSE_COUNT, 4));
+    EXPECT_EQ(engine.getCommitCloseCount("/deltas/a"), 4);
+    engine.apply(Delta::set("/deltas/a", Delta::COMMIT_RULE, capiocl::commitRules::ON_FILE));
+    engine.apply(Delta::add("/deltas/a", Delta::DEPENDENCY, "/deltas/b"));
+    engine.apply(Delta::add("/deltas/a", Delta::DEPENDENCY, "/deltas/b"));
+    engine.apply(Delta::set("/deltas/dir", Delta::DIRECTORY_FILE_COUNT, 3));
+    engine.apply(Delta::set("/deltas/a", Delta::PERMANENT, 1));
+    EXPECT_EQ(engine.getCommitOnFileDependencies("/deltas/a").size(), 1);
+    EXPECT_EQ(engine.getDirectoryFileCount("/deltas/dir"), 3);
+    EXPECT_TRUE(engine.isDirectory("/deltas/dir"));
+    EXPECT_EQ(engine.getVersion(), 6);
+
+    // A peer catches up from the changes, in one go or incrementally
+    capiocl::engine::Engine peer;
+    peer.setCommitRule("/deltas/*", capiocl::commitRules::ON_CLOSE);
+    for (const auto &delta : engine.changesSince(0)) {
+        peer.apply(delta);
+    }
+    EXPECT_TRUE(peer.isProducer("/deltas/a", "writer"));
+    EXPECT_EQ(peer.getCommitRule("/deltas/a"), capiocl::commitRules::ON_FILE);
+    EXPECT_EQ(peer.getFileDependents("/deltas/b"), std::vector<std::string>{"/deltas/a"});
+    EXPECT_TRUE(peer.isPermanent("/deltas/a"));
+    EXPECT_EQ(peer.getDirectoryFileCount("/deltas/dir"), 3);
+
+    const auto version = engine.getVersion();
+    engine.apply(Delta::remove("/deltas/a", Delta::PRODUCER, "writer"));
+    engine.apply(Delta::remove("/deltas/a", Delta::DEPENDENCY, "/deltas/b"));
+    engine.apply(Delta::unset("/deltas/a", Delta::COMMIT_RULE));
+    const auto changes = engine.changesSince(version);
+    ASSERT_EQ(changes.size(), 3);
+    EXPECT_EQ(changes.front().version, version + 1);
+    for (const auto &delta : changes) {
+        peer.apply(delta);
+    }
+    EXPECT_TRUE(peer.getProducers("/deltas/a").empty());
+    EXPECT_TRUE(peer.getCommitOnFileDependencies("/deltas/a").empty());
+    EXPECT_TRUE(peer.getFileDependents("/deltas/b").empty());
+    EXPECT_EQ(peer.getCommitRule("/deltas/a"), capiocl::commitRules::ON_CLOSE);
+
+    // Only the last change of a field is kept
+    for (long i = 0; i < 100; i++) {
+        engine.apply(Delta::set("/deltas/a", Delta::COMMIT_ON_CLOSE_COUNT, i));
+    }
+    EXPECT_EQ(engine.changesSince(version).size(), 4);
+    EXPECT_EQ(engine.changesSince(engine.getVersion()).size(), 0);
+
+    EXPECT_THROW(engine.apply(Delta::set("/deltas/a", Delta::PRODUCER, 1)), std::invalid_argument);
+    EXPECT_THROW(engine.apply(Delta::set("/deltas/a", Delta::COMMIT_RULE, "not_a_rule")),
+                 std::invalid_argument);
+    engine.apply(Delta::add("/deltas/a", Delta::DEPENDENCY, "/deltas/b"));
+    EXPECT_THROW(engine.apply(Delta::add("/deltas/b", Delta::DEPENDENCY, "/deltas/a")),
+                 std::invalid_argument);
+    EXPECT_THROW(Delta::fromJson(R"({"path": "/deltas/a", "operation": "merge"})"),
+                 std::invalid_argument);
+}
+
+TEST(ENGINE_SUITE_NAME, TestDeltaRemovals) {
+    using capiocl::engine::Delta;
+    capiocl::engine::Engine engine, before;
+    engine.apply(Delta::add("/removals/a", Delta::PRODUCER, "writer"));
+    engine.apply(Delta::set("/removals/a", Delta::PERMANENT, 1));
+    engine.apply(Delta::add("/removals/b", Delta::CONSUMER, "reader"));
+    for (const auto &delta : engine.changesSince(0)) {
+        before.apply(delta);
+    }
+    const auto version = engine.getVersion();
+
+    // The removal replaces the changes made to the entry before, so that peers replaying the log
+    // from the start do not recreate it
+    engine.remove("/removals/a");
+    EXPECT_FALSE(engine.contains("/removals/a"));
+    const auto changes = engine.changesSince(0);
+    ASSERT_EQ(changes.size(), 2);
+    EXPECT_EQ(changes.back().operation, Delta::ERASE);
+    EXPECT_EQ(changes.back().version, version + 1);
+
+    capiocl::engine::Engine peer;
+    for (const auto &delta : changes) {
+        peer.apply(delta);
+    }
+    EXPECT_FALSE(peer.contains("/removals/a"));
+    EXPECT_TRUE(peer.isConsumer("/removals/b", "reader"));
+
+    // Peers that applied the entry before remove it too
+    for (const auto &delta : engine.changesSince(version)) {
+        before.apply(delta);
+    }
+    EXPECT_FALSE(before.contains("/removals/a"));
+    EXPECT_TRUE(before.isConsumer("/removals/b", "reader"));
+
+    // Removing an entry that does not exist is not a change
+    const auto erased = engine.apply(Delta::erase("/removals/b"));
+    EXPECT_EQ(erased, version + 2);
+    EXPECT_EQ(engine.apply(Delta::erase("/removals/b")), erased);
+    engine.remove("/removals/b");
+    EXPECT_EQ(engine.getVersion(), erased);
+
+    // Entries created again after their removal are replayed after it
+    engine.apply(Delta::add("/removals/a", Delta::CONSUMER, "reader"));
+    for (const auto &delta : engine.changesSince(0)) {
+        peer.apply(delta);
+    }
+    EXPECT_TRUE(peer.isConsumer("/removals/a", "reader"));
+    EXPECT_FALSE(peer.isProducer("/removals/a", "writer"));
+    EXPECT_FALSE(peer.contains("/removals/b"));
+}
+
+TEST(ENGINE_SUITE_NAME, TestAddIsIdempotent) {
+    capiocl::engine::Engine engine;
+    capiocl::engine::CapioCLEntry entry;
+    entry.producers             = {"writer"};
+    entry.file_dependencies     = {"/idempotent/dep"};
+    entry.commit_on_close_count = 2;
+
+    engine.add("/idempotent/file", entry);
+    const auto version = engine.getVersion();
+    engine.add("/idempotent/file", entry);
+    EXPECT_EQ(engine.getVersion(), version);
+    EXPECT_EQ(engine.getProducers("/idempotent/file").size(), 1);
+    EXPECT_EQ(engine.getCommitOnFileDependencies("/idempotent/file").size(), 1);
+    EXPECT_EQ(engine.getCommitCloseCount("/idempotent/file"), 2);
+
+    capiocl::engine::Engine peer;
+    for (const auto &delta : engine.changesSince(0)) {
+        peer.apply(delta);
+    }
+    EXPECT_TRUE(peer.isProducer("/idempotent/file", "writer"));
+    EXPECT_EQ(peer.getCommitCloseCount("/idempotent/file"), 2);
+}
+
 #endif // CAPIO_CL_ENGINE_HPP
\ No newline at end of file
@@ -73,6 +73,7 @@ TEST(EXCEPTION_SUITE_NAME, testParserException) {
         "test22.json",
         "test23.json",
         "test25.json",
+        "test26.json",
     };
     for (const auto &version : CAPIO_CL_AVAIL_VERSIONS) {
         for (const auto &test : test_filenames) {
@@ -0,0 +1,92 @@
+#ifndef CAPIO_CL_TEST_GRAPH_HPP
+#define CAPIO_CL_TEST_GRAPH_HPP
+
+#define GRAPH_SUITE_NAME testDependencyGraph
+
+#include <algorithm>
+
+#include "capiocl/graph.h"
+
+TEST(GRAPH_SUITE_NAME, testCommitCascade) {
+    capiocl::engine::DependencyGraph graph;
+    graph.add("/b", {"/a"});
+    graph.add("/c", {"/a", "/b"});
+    graph.add("/c", {"/b"});
+    EXPECT_EQ(graph.size(), 3);
+
+    auto dependents = graph.dependents("/a");
+    std::sort(dependents.begin(), dependents.end());
+    EXPECT_EQ(dependents, (std::vector<std::string>{"/b", "/c"}));
+    EXPECT_TRUE(graph.dependents("/c").empty());
+
+    EXPECT_EQ(graph.commit("/a"), std::vector<std::string>{"/b"});
+    EXPECT_EQ(graph.commit("/b"), std::vector<std::string>{"/c"});
+    EXPECT_TRUE(graph.commit("/b").empty());
+    EXPECT_TRUE(graph.commit("/missing").empty());
+
+    // Dependencies committed before being linked are not waited for
+    graph.add("/d", {"/a", "/e"});
+    EXPECT_EQ(graph.commit("/e"), std::vector<std::string>{"/d"});
+
+    // Commits of paths not in the graph are not remembered: the files that become dependencies
+    // while not committed are returned once, for the caller to commit the ones committed before
+    graph.takeUnknown();
+    EXPECT_TRUE(graph.commit("/f").empty());
+    EXPECT_FALSE(graph.add("/g", {"/f"}));
+    EXPECT_FALSE(graph.add("/h", {"/f", "/i"}));
+    EXPECT_EQ(graph.takeUnknown(), (std::vector<std::string>{"/f", "/i"}));
+    EXPECT_TRUE(graph.takeUnknown().empty());
+    EXPECT_EQ(graph.commit("/f"), std::vector<std::string>{"/g"});
+    EXPECT_TRUE(graph.set("/h", {"/f", "/e"}));
+    EXPECT_TRUE(graph.takeUnknown().empty());
+    EXPECT_TRUE(graph.commit("/f").empty());
+}
+
+TEST(GRAPH_SUITE_NAME, testCycles) {
+    capiocl::engine::DependencyGraph graph;
+    graph.add("/a", {"/b"});
+    graph.add("/b", {"/c"});
+
+    EXPECT_THROW(graph.add("/c", {"/a"}), std::invalid_argument);
+    EXPECT_THROW(graph.add("/c", {"/x", "/b"}), std::invalid_argument);
+    EXPECT_THROW(graph.set("/a", {"/a"}), std::invalid_argument);
+
+    // A rejected update leaves the graph unchanged
+    EXPECT_EQ(graph.size(), 3);
+    EXPECT_EQ(graph.dependents("/c"), std::vector<std::string>{"/b"});
+    EXPECT_TRUE(graph.dependents("/x").empty());
+
+    // Diamonds are not cycles
+    graph.add("/d", {"/b", "/c"});
+    graph.add("/a", {"/d"});
+    EXPECT_EQ(graph.size(), 4);
+
+    // A batch closing a cycle is rolled back entirely, along with the links before the cycle
+    EXPECT_THROW(graph.addAll({{"/y", {"/x"}}, {"/c", {"/y", "/a"}}}), std::invalid_argument);
+    EXPECT_EQ(graph.size(), 4);
+    EXPECT_TRUE(graph.dependents("/x").empty());
+    EXPECT_TRUE(graph.dependents("/a").empty());
+    graph.commit("/c");
+    EXPECT_EQ(graph.addAll({{"/y", {"/c"}}, {"/z", {"/y"}}}), std::vector<std::string>{"/y"});
+}
+
+TEST(GRAPH_SUITE_NAME, testSetErase) {
+    capiocl::engine::DependencyGraph graph;
+    graph.set("/t", {"/a", "/b"});
+    graph.commit("/a");
+
+    // Replacing the dependencies keeps the commit state of the ones still in use
+    graph.set("/t", {"/a", "/c"});
+    EXPECT_TRUE(graph.dependents("/b").empty());
+    EXPECT_EQ(graph.size(), 3);
+    EXPECT_EQ(graph.commit("/c"), std::vector<std::string>{"/t"});
+
+    graph.erase("/t");
+    EXPECT_EQ(graph.size(), 0);
+
+    graph.set("/t", {"/a"});
+    graph.set("/t", {});
+    EXPECT_EQ(graph.size(), 0);
+}
+
+#endif // CAPIO_CL_TEST_GRAPH_HPP
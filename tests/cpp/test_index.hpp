@@ -0,0 +1,115 @@
+#ifndef CAPIO_CL_TEST_INDEX_HPP
+#define CAPIO_CL_TEST_INDEX_HPP
+
+#define INDEX_SUITE_NAME testPatternIndex
+
+#include <algorithm>
+
+#include "capiocl/index.h"
+
+TEST(INDEX_SUITE_NAME, testIsPattern) {
+    EXPECT_TRUE(capiocl::engine::PatternIndex::isPattern("test.*"));
+    EXPECT_TRUE(capiocl::engine::PatternIndex::isPattern("test.?"));
+    EXPECT_TRUE(capiocl::engine::PatternIndex::isPattern("test.[abc]"));
+    EXPECT_FALSE(capiocl::engine::PatternIndex::isPattern("/a/b/c.dat"));
+}
+
+TEST(INDEX_SUITE_NAME, testInsertErase) {
+    capiocl::engine::PatternIndex index;
+    EXPECT_TRUE(index.insert("/a/b/*"));
+    EXPECT_FALSE(index.insert("/a/b/*"));
+    EXPECT_TRUE(index.insert("*.dat"));
+    EXPECT_EQ(index.size(), 2);
+
+    EXPECT_TRUE(index.erase("/a/b/*"));
+    EXPECT_FALSE(index.erase("/a/b/*"));
+    EXPECT_FALSE(index.erase("/c/d/*"));
+    EXPECT_EQ(index.size(), 1);
+}
+
+TEST(INDEX_SUITE_NAME, testLongestMatch) {
+    capiocl::engine::PatternIndex index;
+    index.insert("/a/*");
+    index.insert("/a/b/*");
+    index.insert("/a/b/c.*");
+    index.insert("*.dat");
+
+    EXPECT_EQ(*index.longestMatch("/a/x"), "/a/*");
+    EXPECT_EQ(*index.longestMatch("/a/b/x"), "/a/b/*");
+    EXPECT_EQ(*index.longestMatch("/a/b/c.txt"), "/a/b/c.*");
+    EXPECT_EQ(*index.longestMatch("/a/b/c.d/e"), "/a/b/c.*");
+    EXPECT_EQ(*index.longestMatch("/z/file.dat"), "*.dat");
+    EXPECT_EQ(index.longestMatch("/z/file.txt"), nullptr);
+}
+
+TEST(INDEX_SUITE_NAME, testMatches) {
+    capiocl::engine::PatternIndex index;
+    index.insert("/a/*");
+    index.insert("/a/b/*");
+    index.insert("/b/*");
+    index.insert("*.dat");
+
+    EXPECT_EQ(index.match("/a/b/file.dat").size(), 3);
+    EXPECT_EQ(index.match("/b/file.txt").size(), 1);
+    EXPECT_TRUE(index.match("/c/file.txt").empty());
+    EXPECT_TRUE(index.matchesAny("/c/file.dat"));
+    EXPECT_FALSE(index.matchesAny("/c/file.txt"));
+}
+
+TEST(INDEX_SUITE_NAME, testCompiledShapes) {
+    capiocl::engine::PatternIndex index;
+    index.insert("/a/*.dat");
+    index.insert("/a/out_*");
+    index.insert("/a/out_*.log");
+    index.insert("/a/file_?.txt");
+    index.insert("/a/file_[0-9]*");
+    index.insert("/a/x**y");
+
+    const auto patterns_of = [&](const std::string &path) {
+        std::vector<std::string> result;
+        for (const auto id : index.match(path)) {
+            result.push_back(index.pattern(id));
+        }
+        std::sort(result.begin(), result.end());
+        return result;
+    };
+
+    EXPECT_EQ(patterns_of("/a/b.dat"), std::vector<std::string>({"/a/*.dat"}));
+    EXPECT_EQ(patterns_of("/a/out_1.log"), std::vector<std::string>({"/a/out_*", "/a/out_*.log"}));
+    EXPECT_EQ(patterns_of("/a/out_.log"), std::vector<std::string>({"/a/out_*", "/a/out_*.log"}));
+    EXPECT_EQ(patterns_of("/a/out_"), std::vector<std::string>({"/a/out_*"}));
+    EXPECT_EQ(patterns_of("/a/file_1.txt"),
+              std::vector<std::string>({"/a/file_?.txt", "/a/file_[0-9]*"}));
+    EXPECT_EQ(patterns_of("/a/xy"), std::vector<std::string>({"/a/x**y"}));
+    EXPECT_EQ(patterns_of("/a/x/y"), std::vector<std::string>({"/a/x**y"}));
+    EXPECT_TRUE(patterns_of("/a/x").empty());
+    EXPECT_TRUE(patterns_of("/b/out_1.log").empty());
+
+    // Overlapping head and tail must not match: "ab" is shorter than head "ab" + tail "b"
+    index.insert("/c/ab*b");
+    EXPECT_TRUE(index.match("/c/ab").empty());
+    EXPECT_EQ(index.match("/c/abb").size(), 1);
+}
+
+TEST(INDEX_SUITE_NAME, testIncrementalUpdates) {
+    capiocl::engine::PatternIndex index;
+    index.insert("/a/*.dat");
+    index.insert("/a/*.txt");
+    index.insert("/a/[ab]*");
+    EXPECT_EQ(index.match("/a/b.dat").size(), 2);
+
+    EXPECT_TRUE(index.erase("/a/*.dat"));
+    EXPECT_TRUE(index.erase("/a/[ab]*"));
+    EXPECT_TRUE(index.match("/a/b.dat").empty());
+    EXPECT_EQ(index.match("/a/b.txt").size(), 1);
+
+    // Identifiers of erased patterns are reused
+    index.insert("/a/b.*");
+    const auto ids = index.match("/a/b.dat");
+    ASSERT_EQ(ids.size(), 1);
+    EXPECT_LT(ids[0], 3);
+    EXPECT_EQ(index.pattern(ids[0]), "/a/b.*");
+    EXPECT_EQ(index.size(), 2);
+}
+
+#endif // CAPIO_CL_TEST_INDEX_HPP
@@ -0,0 +1,91 @@
+#ifndef CAPIO_CL_TEST_MERKLE_HPP
+#define CAPIO_CL_TEST_MERKLE_HPP
+
+#define MERKLE_SUITE_NAME testMerkleTree
+
+#include "capiocl/merkle.h"
+
+TEST(MERKLE_SUITE_NAME, testDiffFindsBuckets) {
+    capiocl::engine::MerkleTree empty;
+    EXPECT_EQ(empty.root(), 0);
+
+    std::vector<std::uint64_t> leaves(capiocl::engine::MerkleTree::LEAVES, 0);
+    leaves[7]    = 42;
+    leaves[4000] = 24;
+    const capiocl::engine::MerkleTree tree(leaves);
+    EXPECT_NE(tree.root(), 0);
+    EXPECT_EQ(tree.node(capiocl::engine::MerkleTree::DEPTH, 7), 42);
+    EXPECT_EQ(tree.node(1, 1), 0);
+    EXPECT_THROW(tree.node(1, capiocl::engine::MerkleTree::FANOUT), std::out_of_range);
+    EXPECT_EQ(tree.diff(empty), (std::vector<std::size_t>{7, 4000}));
+    EXPECT_TRUE(tree.diff(capiocl::engine::MerkleTree(leaves)).empty());
+    EXPECT_THROW(capiocl::engine::MerkleTree(std::vector<std::uint64_t>(3)),
+                 std::invalid_argument);
+
+    // Files of the same directory share a bucket
+    EXPECT_EQ(capiocl::engine::MerkleTree::bucket("/a/b/c"),
+              capiocl::engine::MerkleTree::bucket("/a/b/*.dat"));
+    EXPECT_EQ(capiocl::engine::MerkleTree::bucket("/a"), capiocl::engine::MerkleTree::bucket("/b"));
+}
+
+TEST(MERKLE_SUITE_NAME, testEngineFingerprint) {
+    capiocl::engine::Engine engine, other;
+    EXPECT_EQ(engine.fingerprint(), other.fingerprint());
+
+    // The fingerprint does not depend on the order of the updates
+    std::string first = "first", second = "second";
+    engine.addProducer("/fp/dir/a", first);
+    engine.addProducer("/fp/dir/a", second);
+    engine.setFileDeps("/fp/b", {"/fp/dir/a", "/fp/c"});
+    engine.setCommitRule("/fp/*.log", capiocl::commitRules::ON_CLOSE);
+    other.setCommitRule("/fp/*.log", capiocl::commitRules::ON_CLOSE);
+    other.newFile("/fp/c");
+    other.setFileDeps("/fp/b", {"/fp/c", "/fp/dir/a"});
+    other.addProducer("/fp/dir/a", second);
+    other.addProducer("/fp/dir/a", first);
+    EXPECT_EQ(engine.fingerprint().root(), other.fingerprint().root());
+    EXPECT_TRUE(engine == other);
+
+    // A change is found in the bucket of its directory
+    other.setPermanent("/fp/dir/a", true);
+    const auto tree = other.fingerprint();
+    EXPECT_NE(engine.fingerprint(), tree);
+    EXPECT_FALSE(engine == other);
+    const auto buckets = engine.fingerprint().diff(tree);
+    ASSERT_EQ(buckets.size(), 1);
+    EXPECT_EQ(buckets.front(), capiocl::engine::MerkleTree::bucket("/fp/dir/a"));
+    EXPECT_EQ(other.getBucketPaths(buckets.front()), std::vector<std::string>{"/fp/dir/a"});
+
+    // Reverting the change gives back the same root
+    other.setPermanent("/fp/dir/a", false);
+    EXPECT_EQ(engine.fingerprint(), other.fingerprint());
+    other.remove("/fp/c");
+    EXPECT_NE(engine.fingerprint(), other.fingerprint());
+    other.newFile("/fp/c");
+    EXPECT_EQ(engine.fingerprint(), other.fingerprint());
+}
+
+TEST(MERKLE_SUITE_NAME, testEntryHash) {
+    capiocl::engine::CapioCLEntry entry, other;
+    EXPECT_EQ(entry.hash(), other.hash());
+
+    entry.producers         = {"a", "b"};
+    entry.file_dependencies = {"/x", "/y"};
+    other.producers         = {"b", "a"};
+    other.file_dependencies = {"/y", "/x"};
+    EXPECT_EQ(entry.hash(), other.hash());
+    EXPECT_TRUE(entry == other);
+
+    // Moving an application from the producers to the consumers changes the hash
+    other.producers = {"a"};
+    other.consumers = {"b"};
+    EXPECT_NE(entry.hash(), other.hash());
+    EXPECT_FALSE(entry == other);
+
+    other                   = entry;
+    other.file_dependencies = {"/y", "/y"};
+    EXPECT_NE(entry.hash(), other.hash());
+    EXPECT_FALSE(entry == other);
+}
+
+#endif // CAPIO_CL_TEST_MERKLE_HPP
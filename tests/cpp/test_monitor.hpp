@@ -2,11 +2,18 @@
 #define CAPIO_CL_MONITOR_HPP
 
 #include <arpa/inet.h>
+#include <atomic>
+#include <fstream>
+#include <future>
 #include <netinet/in.h>
 #include <sys/socket.h>
 
 #define MONITOR_SUITE_NAME testMonitor
 
+#include "capiocl/frame.h"
+#include "capiocl/reactor.h"
+#include "capiocl/rtt.h"
+
 TEST(MONITOR_SUITE_NAME, testCommitCommunication) {
     std::thread t1([]() {
         const capiocl::engine::Engine e;
@@ -120,4 +127,358 @@ TEST(MONITOR_SUITE_NAME, testHomeNodeAfterInstanceTearDown) {
     EXPECT_NE(home_nodes.find(hostname), home_nodes.end());
 }
 
+TEST(MONITOR_SUITE_NAME, testWaitForCommit) {
+    const capiocl::engine::Engine producer;
+    const capiocl::engine::Engine consumer;
+    const auto file = "wait_" + std::to_string(getpid());
+
+    EXPECT_FALSE(consumer.waitForCommit(file, std::chrono::milliseconds(50)));
+
+    // The waiting thread is woken by the commit advert, well before the timeout
+    std::thread waiter([&] {
+        const auto start = std::chrono::steady_clock::now();
+        EXPECT_TRUE(consumer.waitForCommit(file, std::chrono::seconds(10)));
+        EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    producer.setCommitted(file);
+    waiter.join();
+
+    // Files already committed are returned without waiting
+    EXPECT_TRUE(consumer.waitForCommit(file, std::chrono::milliseconds(0)));
+    EXPECT_TRUE(producer.waitForCommit(file, std::chrono::milliseconds(0)));
+}
+
+TEST(MONITOR_SUITE_NAME, testWaitForAnyCommit) {
+    const capiocl::engine::Engine engine;
+    const auto base = "any_" + std::to_string(getpid());
+    const std::vector<std::filesystem::path> files = {base + "_a", base + "_b", base + "_c"};
+
+    EXPECT_EQ(engine.waitForAnyCommit(files, std::chrono::milliseconds(50)), "");
+    EXPECT_EQ(engine.waitForAnyCommit({}, std::chrono::milliseconds(0)), "");
+
+    std::thread waiter([&] {
+        EXPECT_EQ(engine.waitForAnyCommit(files, std::chrono::seconds(10)), base + "_b");
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    engine.setCommitted(base + "_b");
+    waiter.join();
+
+    EXPECT_EQ(engine.waitForAnyCommit(files, std::chrono::milliseconds(0)), base + "_b");
+}
+
+TEST(MONITOR_SUITE_NAME, testIsCommittedAsync) {
+    const auto file = "async_" + std::to_string(getpid());
+    const capiocl::engine::Engine producer;
+    producer.setCommitted(file);
+    EXPECT_TRUE(producer.isCommittedAsync(file).get());
+
+    // A new instance asks the other nodes, and gets the answer without blocking
+    const capiocl::engine::Engine consumer;
+    auto committed = consumer.isCommittedAsync(file);
+    EXPECT_TRUE(committed.get());
+
+    // Many outstanding queries are served at once, without a thread each
+    std::vector<std::future<bool>> queries;
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 1000; i++) {
+        queries.push_back(consumer.isCommittedAsync(file + "_missing_" + std::to_string(i)));
+    }
+    for (auto &query : queries) {
+        EXPECT_FALSE(query.get());
+    }
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(10));
+}
+
+TEST(MONITOR_SUITE_NAME, testOnCommitted) {
+    const auto file = "callback_" + std::to_string(getpid());
+    const capiocl::engine::Engine producer;
+    const capiocl::engine::Engine consumer;
+
+    std::promise<std::string> received;
+    consumer.onCommitted(file, [&received](const std::string &path) { received.set_value(path); });
+    producer.setCommitted(file);
+    auto future = received.get_future();
+    ASSERT_EQ(future.wait_for(std::chrono::seconds(10)), std::future_status::ready);
+    EXPECT_EQ(future.get(), file);
+
+    // Already committed files run the callback in the calling thread
+    bool called = false;
+    consumer.onCommitted(file, [&called](const std::string &) { called = true; });
+    EXPECT_TRUE(called);
+
+    // Commit tokens written by other processes are found by the watcher
+    const auto dir = std::filesystem::temp_directory_path() /
+                     ("capiocl_callback_" + std::to_string(getpid()));
+    std::filesystem::create_directories(dir);
+    std::promise<void> token;
+    consumer.onCommitted(dir / "file", [&token](const std::string &) { token.set_value(); });
+    std::ofstream(dir / ".file.commit").close();
+    EXPECT_EQ(token.get_future().wait_for(std::chrono::seconds(10)), std::future_status::ready);
+    std::filesystem::remove_all(dir);
+}
+
+TEST(MONITOR_SUITE_NAME, testGetHomeNodeAsync) {
+    char hostname[HOST_NAME_MAX] = {};
+    gethostname(hostname, HOST_NAME_MAX);
+    const auto file = "home_async_" + std::to_string(getpid());
+
+    const capiocl::engine::Engine e1;
+    e1.setHomeNode(file);
+    const capiocl::engine::Engine e2;
+    const auto home_nodes = e2.getHomeNodeAsync(file).get();
+    EXPECT_EQ(home_nodes.size(), 1);
+    EXPECT_NE(home_nodes.find(hostname), home_nodes.end());
+
+    EXPECT_TRUE(e2.getHomeNodeAsync(file + "_missing").get().empty());
+}
+
+TEST(MONITOR_SUITE_NAME, testBatchedMessages) {
+    const auto base = "batched_" + std::to_string(getpid()) + "_";
+    const capiocl::engine::Engine producer;
+    const capiocl::engine::Engine consumer;
+
+    for (int i = 0; i < 200; i++) {
+        producer.setCommitted(base + std::to_string(i));
+    }
+    EXPECT_TRUE(consumer.waitForCommit(base + "199", std::chrono::seconds(10)));
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    auto stats          = producer.stats();
+    while (stats.messages_sent < 200 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        stats = producer.stats();
+    }
+    EXPECT_GE(stats.messages_sent, 200);
+    EXPECT_GE(stats.batches_flushed, 1);
+    EXPECT_LE(stats.datagrams_sent, stats.messages_sent);
+    EXPECT_LE(stats.batches_flushed, stats.datagrams_sent);
+}
+
+TEST(MONITOR_SUITE_NAME, testMessageFrame) {
+    using capiocl::monitor::MessageFrame;
+
+    for (const bool compression : {false, true}) {
+        MessageFrame frame(1472, compression);
+        std::vector<std::string> paths;
+        while (true) {
+            paths.push_back("/workflow/output/file_" + std::to_string(paths.size()) + ".dat");
+            if (!frame.add(paths.size() % 2 == 0 ? '!' : '?', paths.back())) {
+                paths.pop_back();
+                break;
+            }
+        }
+        EXPECT_EQ(frame.size(), paths.size());
+
+        const auto datagram = frame.take();
+        EXPECT_LE(datagram.size(), 1472);
+        EXPECT_EQ(datagram[0], MessageFrame::MAGIC);
+        EXPECT_EQ(frame.size(), 0);
+
+        const auto records = MessageFrame::decode(datagram.data(), datagram.size());
+        ASSERT_EQ(records.size(), paths.size());
+        for (std::size_t i = 0; i < paths.size(); i++) {
+            EXPECT_EQ(records[i].command, (i + 1) % 2 == 0 ? '!' : '?');
+            EXPECT_EQ(records[i].payload, paths[i]);
+        }
+
+        // Decoding stops at a truncated record
+        EXPECT_EQ(MessageFrame::decode(datagram.data(), datagram.size() - 1).size(),
+                  paths.size() - 1);
+    }
+
+    // Prefix compression packs more paths sharing a directory in a datagram
+    MessageFrame plain(1472, false), compressed(1472, true);
+    const std::string dir = "/a/long/directory/shared/by/every/output/file/";
+    while (plain.add('!', dir + std::to_string(plain.size()))) {
+    }
+    while (compressed.add('!', dir + std::to_string(compressed.size()))) {
+    }
+    EXPECT_GT(compressed.size(), 2 * plain.size());
+
+    // A single message uses the plain format, and plain messages are decoded
+    MessageFrame single(1472, true);
+    EXPECT_TRUE(single.add('!', "/path/with space"));
+    EXPECT_EQ(single.take(), "! /path/with space");
+    const char message[] = "? /legacy\0\0\0";
+    const auto records   = MessageFrame::decode(message, sizeof(message));
+    ASSERT_EQ(records.size(), 1);
+    EXPECT_EQ(records[0].command, '?');
+    EXPECT_EQ(records[0].payload, "/legacy");
+    EXPECT_TRUE(MessageFrame::decode(message, 1).empty());
+
+    // Messages larger than a datagram are sent alone
+    MessageFrame small(16, true);
+    EXPECT_TRUE(small.add('!', std::string(100, 'x')));
+    EXPECT_FALSE(small.add('!', "y"));
+}
+
+TEST(MONITOR_SUITE_NAME, testCommitSet) {
+    for (const bool compact : {false, true}) {
+        capiocl::monitor::CommitSet set(compact, 1 << 16);
+        EXPECT_EQ(set.isCompact(), compact);
+
+        std::vector<std::thread> writers;
+        for (int t = 0; t < 4; t++) {
+            writers.emplace_back([&set, t] {
+                for (int i = 0; i < 1000; i++) {
+                    set.insert("/commits/" + std::to_string(t) + "/" + std::to_string(i));
+                }
+            });
+        }
+        for (auto &writer : writers) {
+            writer.join();
+        }
+
+        EXPECT_EQ(set.size(), 4000);
+        EXPECT_FALSE(set.insert("/commits/0/0"));
+        EXPECT_TRUE(set.insert("/commits/new"));
+        EXPECT_EQ(set.size(), 4001);
+        for (int i = 0; i < 1000; i++) {
+            EXPECT_TRUE(set.contains("/commits/3/" + std::to_string(i)));
+            EXPECT_FALSE(set.contains("/uncommitted/" + std::to_string(i)));
+        }
+    }
+
+    // Without the Bloom filter every lookup goes to the shards
+    capiocl::monitor::CommitSet unfiltered(false, 0);
+    EXPECT_FALSE(unfiltered.contains("a"));
+    EXPECT_TRUE(unfiltered.insert("a"));
+    EXPECT_TRUE(unfiltered.contains("a"));
+
+    unfiltered.configure(true, 64);
+    EXPECT_EQ(unfiltered.size(), 0);
+    EXPECT_FALSE(unfiltered.contains("a"));
+}
+
+TEST(MONITOR_SUITE_NAME, testReactor) {
+    const auto reactor = capiocl::monitor::Reactor::instance();
+    EXPECT_EQ(reactor, capiocl::monitor::Reactor::instance());
+
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_DGRAM, 0, fds), 0);
+
+    std::promise<std::string> received;
+    reactor->add(fds[0], [&received](const int socket) {
+        char buffer[16];
+        const auto n = recv(socket, buffer, sizeof(buffer), MSG_DONTWAIT);
+        received.set_value(std::string(buffer, n));
+    });
+
+    auto future = received.get_future();
+    ASSERT_EQ(send(fds[1], "ping", 4, 0), 4);
+    ASSERT_EQ(future.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    EXPECT_EQ(future.get(), "ping");
+
+    reactor->remove(fds[0]);
+    close(fds[0]);
+    close(fds[1]);
+
+    // Engines stop their listeners without waiting for a timeout
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 10; i++) {
+        const capiocl::engine::Engine e;
+    }
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(2));
+}
+
+TEST(MONITOR_SUITE_NAME, testRttEstimator) {
+    using namespace std::chrono_literals;
+    capiocl::monitor::RttEstimator rtt(90, 2, 100us, 10000us);
+
+    // The ceiling is used until enough round trip times are known
+    EXPECT_EQ(rtt.timeout(), 10000us);
+    for (std::size_t i = 1; i < capiocl::monitor::RttEstimator::MIN_SAMPLES; i++) {
+        rtt.record(200us);
+    }
+    EXPECT_EQ(rtt.timeout(), 10000us);
+
+    rtt.record(200us);
+    EXPECT_EQ(rtt.timeout(), 400us);
+
+    // Outliers beyond the percentile do not change the timeout
+    rtt.record(5000us);
+    EXPECT_EQ(rtt.timeout(), 400us);
+
+    // Slower answers fill the window and raise the timeout up to the ceiling
+    for (std::size_t i = 0; i < capiocl::monitor::RttEstimator::WINDOW; i++) {
+        rtt.record(8000us);
+    }
+    EXPECT_EQ(rtt.timeout(), 10000us);
+
+    for (std::size_t i = 0; i < capiocl::monitor::RttEstimator::WINDOW; i++) {
+        rtt.record(10us);
+    }
+    EXPECT_EQ(rtt.timeout(), 100us);
+    EXPECT_EQ(rtt.size(), 2 * capiocl::monitor::RttEstimator::WINDOW + 17);
+}
+
+TEST(MONITOR_SUITE_NAME, testQueryReturnsOnAnswer) {
+    const auto path = "early_" + std::to_string(getpid());
+    const capiocl::engine::Engine producer;
+    producer.setCommitted(path);
+    sleep(1);
+
+    // The answer of the producer wakes the query before the 300 ms delay expires
+    const capiocl::engine::Engine consumer;
+    const auto start = std::chrono::steady_clock::now();
+    EXPECT_TRUE(consumer.isCommitted(path));
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(250));
+}
+
+TEST(MONITOR_SUITE_NAME, testLateAdvertsAreNotRoundTrips) {
+    const auto base = "late_" + std::to_string(getpid()) + "_";
+    capiocl::configuration::CapioClConfiguration config;
+    config.loadDefaults();
+    const capiocl::monitor::MulticastMonitor producer(config);
+    for (int i = 0; i < 40; i++) {
+        producer.setCommitted(base + std::to_string(i));
+    }
+    sleep(1);
+
+    // The consumer missed the adverts, so that each query is answered by the producer
+    const capiocl::monitor::MulticastMonitor consumer(config);
+    for (int i = 0; i < 40; i++) {
+        EXPECT_TRUE(consumer.isCommitted(base + std::to_string(i)));
+    }
+    const auto timeout = consumer.queryTimeout();
+    EXPECT_LT(timeout, std::chrono::milliseconds(300));
+
+    // Files queried before being produced are committed after the query gave up
+    for (int i = 0; i < 8; i++) {
+        const auto path = base + "missing_" + std::to_string(i);
+        EXPECT_FALSE(consumer.isCommitted(path));
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        producer.setCommitted(path);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    EXPECT_LT(consumer.queryTimeout(), std::chrono::milliseconds(300));
+}
+
+TEST(MONITOR_SUITE_NAME, testCallbacksDoNotPollMulticast) {
+    const auto base = "unpolled_" + std::to_string(getpid()) + "_";
+    const capiocl::engine::Engine producer;
+    const capiocl::engine::Engine consumer;
+
+    std::atomic<int> called = 0;
+    for (int i = 0; i < 16; i++) {
+        consumer.onCommitted(base + std::to_string(i),
+                             [&called](const std::string &) { called++; });
+    }
+
+    // Once the single re-query of each callback expired, waiting sends no more queries
+    sleep(1);
+    const auto sent = consumer.stats().messages_sent;
+    sleep(1);
+    EXPECT_EQ(consumer.stats().messages_sent, sent);
+
+    // Commits are still notified by the multicast adverts
+    producer.setCommitted(base + "0");
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (called == 0 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_EQ(called, 1);
+}
+
 #endif // CAPIO_CL_MONITOR_HPP
\ No newline at end of file
@@ -0,0 +1,159 @@
+#ifndef CAPIO_CL_TEST_SNAPSHOT_HPP
+#define CAPIO_CL_TEST_SNAPSHOT_HPP
+
+#define SNAPSHOT_SUITE_NAME testEngineSnapshot
+
+#include <fstream>
+#include <thread>
+
+#include "capiocl/snapshot.h"
+
+TEST(SNAPSHOT_SUITE_NAME, testRoundTrip) {
+    const auto file = std::filesystem::temp_directory_path() / "capio_cl_snapshot_round_trip";
+    capiocl::engine::Engine expected;
+    expected.setWorkflowName("snapshot_workflow");
+    std::string producer = "writer", consumer = "reader";
+    for (int i = 0; i < 50; i++) {
+        const auto path = "/wf/out/file" + std::to_string(i) + ".dat";
+        expected.newFile(path);
+        expected.addProducer(path, producer);
+        expected.addConsumer(path, consumer);
+    }
+    expected.setCommitRule("/wf/out/*.dat", capiocl::commitRules::ON_CLOSE);
+    expected.setCommitedCloseNumber("/wf/out/*.dat", 3);
+    expected.setDirectoryFileCount("/wf/fixed", 10);
+    expected.setFileDeps("/wf/final", {"/wf/out/file0.dat", "/wf/extra"});
+    expected.setPermanent("/wf/perm", true);
+    expected.setExclude("/wf/tmp", true);
+    expected.setStoreFileInMemory("/wf/out/file1.dat");
+    expected.saveSnapshot(file);
+
+    capiocl::engine::Engine engine;
+    engine.openSnapshot(file);
+    EXPECT_EQ(engine.getWorkflowName(), "snapshot_workflow");
+    EXPECT_EQ(engine.size(), expected.size());
+    EXPECT_EQ(engine.stats().entries, expected.stats().entries);
+
+    // Entries are decoded on their first lookup
+    EXPECT_TRUE(engine.isProducer("/wf/out/file7.dat", "writer"));
+    EXPECT_TRUE(engine.isConsumer("/wf/out/file7.dat", "reader"));
+    EXPECT_EQ(engine.getDirectoryFileCount("/wf/fixed"), 10);
+    EXPECT_TRUE(engine.isPermanent("/wf/perm"));
+    EXPECT_TRUE(engine.isExcluded("/wf/tmp"));
+    EXPECT_TRUE(engine.isStoredInMemory("/wf/out/file1.dat"));
+    EXPECT_FALSE(engine.isStoredInMemory("/wf/out/file2.dat"));
+    EXPECT_EQ(engine.getFileDependents("/wf/extra"), std::vector<std::string>{"/wf/final"});
+    EXPECT_EQ(engine.getChildren("/wf/out").size(), 50);
+    EXPECT_EQ(engine.size(), expected.size());
+
+    // Glob rules apply to the files created after the snapshot was opened
+    EXPECT_EQ(engine.getCommitCloseCount("/wf/out/new.dat"), 3);
+    EXPECT_EQ(engine.getDirectoryFileCount("/wf/out"), 51);
+    EXPECT_EQ(engine.getChildren("/wf/out").size(), 51);
+    // Queries created the entries of the new file and of its directory
+    expected.newFile("/wf/out/new.dat");
+    expected.newFile("/wf/out");
+    EXPECT_TRUE(engine == expected);
+
+    // Saving twice gives the same file, and a snapshot of a snapshot is the same Engine
+    const auto copy = std::filesystem::temp_directory_path() / "capio_cl_snapshot_copy";
+    expected.saveSnapshot(file);
+    engine.saveSnapshot(copy);
+    EXPECT_EQ(std::filesystem::file_size(file), std::filesystem::file_size(copy));
+    capiocl::engine::Engine reopened;
+    reopened.openSnapshot(copy);
+    EXPECT_TRUE(reopened == expected);
+
+    std::filesystem::remove(file);
+    std::filesystem::remove(copy);
+}
+
+TEST(SNAPSHOT_SUITE_NAME, testLazyEntries) {
+    const auto file = std::filesystem::temp_directory_path() / "capio_cl_snapshot_lazy";
+    {
+        capiocl::engine::Engine source;
+        for (int i = 0; i < 100; i++) {
+            source.newFile("/lazy/dir/f" + std::to_string(i));
+        }
+        source.saveSnapshot(file);
+    }
+
+    capiocl::engine::Engine engine(false);
+    engine.openSnapshot(file);
+    EXPECT_EQ(engine.size(), 100);
+    EXPECT_TRUE(engine.contains("/lazy/dir/f3"));
+    EXPECT_FALSE(engine.contains("/lazy/dir/missing"));
+
+    // Removed entries are not decoded again from the snapshot
+    engine.remove("/lazy/dir/f4");
+    EXPECT_FALSE(engine.contains("/lazy/dir/f4"));
+    EXPECT_EQ(engine.size(), 99);
+    EXPECT_EQ(engine.getChildren("/lazy/dir").size(), 99);
+
+    // Concurrent lookups of the same paths decode each entry once
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; t++) {
+        threads.emplace_back([&engine] {
+            for (int i = 0; i < 100; i++) {
+                engine.isFile("/lazy/dir/f" + std::to_string(i));
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(engine.size(), 100);
+    EXPECT_EQ(engine.getPaths().size(), 100);
+    std::filesystem::remove(file);
+}
+
+TEST(SNAPSHOT_SUITE_NAME, testMergeWithExistingEntries) {
+    const auto file = std::filesystem::temp_directory_path() / "capio_cl_snapshot_merge";
+    {
+        capiocl::engine::Engine source;
+        std::string producer = "from_snapshot";
+        source.addProducer("/merge/a", producer);
+        source.newFile("/merge/b");
+        source.setPermanent("/merge/*.log", true);
+        source.saveSnapshot(file);
+    }
+
+    capiocl::engine::Engine engine;
+    std::string producer = "from_engine";
+    engine.addProducer("/merge/a", producer);
+    engine.setExclude("/merge/*.log", true);
+    engine.openSnapshot(file);
+    EXPECT_TRUE(engine.isProducer("/merge/a", "from_engine"));
+    EXPECT_TRUE(engine.isProducer("/merge/a", "from_snapshot"));
+    EXPECT_TRUE(engine.isPermanent("/merge/x.log"));
+    EXPECT_EQ(engine.size(), 4);
+
+    // Publishing a builder merges with the entries still in the snapshot
+    capiocl::engine::EngineBuilder builder;
+    builder.addProducer("/merge/b", "from_builder");
+    builder.publish(engine);
+    EXPECT_TRUE(engine.isProducer("/merge/b", "from_builder"));
+    EXPECT_EQ(engine.size(), 4);
+    std::filesystem::remove(file);
+}
+
+TEST(SNAPSHOT_SUITE_NAME, testInvalidSnapshots) {
+    capiocl::engine::Engine engine;
+    EXPECT_THROW(engine.openSnapshot("/nonexistent/capio_cl_snapshot"),
+                 capiocl::snapshot::SnapshotException);
+    EXPECT_THROW(engine.saveSnapshot("/nonexistent/capio_cl_snapshot"),
+                 capiocl::snapshot::SnapshotException);
+
+    const auto file = std::filesystem::temp_directory_path() / "capio_cl_snapshot_invalid";
+    std::ofstream(file) << "{\"name\": \"not a snapshot\"}";
+    EXPECT_THROW(engine.openSnapshot(file), capiocl::snapshot::SnapshotException);
+
+    // A truncated snapshot is rejected before any section is read
+    engine.newFile("/invalid/a");
+    engine.saveSnapshot(file);
+    std::filesystem::resize_file(file, std::filesystem::file_size(file) - 4);
+    EXPECT_THROW(engine.openSnapshot(file), capiocl::snapshot::SnapshotException);
+    std::filesystem::remove(file);
+}
+
+#endif // CAPIO_CL_TEST_SNAPSHOT_HPP
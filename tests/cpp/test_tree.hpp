@@ -0,0 +1,68 @@
+#ifndef CAPIO_CL_TEST_TREE_HPP
+#define CAPIO_CL_TEST_TREE_HPP
+
+#define TREE_SUITE_NAME testDirectoryTree
+
+#include <algorithm>
+
+#include "capiocl/tree.h"
+
+TEST(TREE_SUITE_NAME, testInsertCounters) {
+    capiocl::engine::DirectoryTree tree;
+
+    auto counters = tree.insert("/a/b/c");
+    EXPECT_EQ(counters.children, 0);
+    EXPECT_EQ(counters.siblings, 1);
+    EXPECT_EQ(tree.size(), 4);
+
+    tree.insert("/a/b/d");
+    counters = tree.insert("/a/b");
+    EXPECT_EQ(counters.children, 2);
+    EXPECT_EQ(counters.siblings, 1);
+
+    // Inserting twice does not count the path twice
+    counters = tree.insert("/a/b/d");
+    EXPECT_EQ(counters.siblings, 2);
+    EXPECT_EQ(tree.count("/a/b"), 2);
+    EXPECT_EQ(tree.count("/a"), 1);
+    EXPECT_EQ(tree.count("/"), 0);
+    EXPECT_EQ(tree.count("/missing"), 0);
+
+    counters = tree.insert("relative");
+    EXPECT_EQ(counters.siblings, 0);
+}
+
+TEST(TREE_SUITE_NAME, testChildren) {
+    capiocl::engine::DirectoryTree tree;
+    tree.insert("/a/b/c");
+    tree.insert("/a/b/d");
+    tree.insert("/a/e");
+
+    auto children = tree.children("/a/b");
+    std::sort(children.begin(), children.end());
+    EXPECT_EQ(children, (std::vector<std::string>{"/a/b/c", "/a/b/d"}));
+
+    // Placeholder directories are not listed as children
+    EXPECT_EQ(tree.children("/a"), std::vector<std::string>{"/a/e"});
+    EXPECT_TRUE(tree.children("/a/b/c").empty());
+}
+
+TEST(TREE_SUITE_NAME, testErase) {
+    capiocl::engine::DirectoryTree tree;
+    tree.insert("/a/b/c");
+    tree.insert("/a/b/d");
+    EXPECT_EQ(tree.size(), 5);
+
+    tree.erase("/a/b/c");
+    tree.erase("/a/b/c");
+    tree.erase("/missing");
+    EXPECT_EQ(tree.count("/a/b"), 1);
+    EXPECT_EQ(tree.size(), 4);
+
+    // Once the last child is removed, placeholder ancestors are dropped
+    tree.erase("/a/b/d");
+    EXPECT_EQ(tree.count("/a/b"), 0);
+    EXPECT_EQ(tree.size(), 0);
+}
+
+#endif // CAPIO_CL_TEST_TREE_HPP
@@ -295,3 +295,199 @@ def test_insert_file_dependencies():
     engine.setFileDeps("test.txt", ["a", "b", "c"])
     deps = engine.getCommitOnFileDependencies("test.txt")
     assert deps == [PosixPath("a"), PosixPath("b"), PosixPath("c")]
+
+
+def test_entry_handles():
+    engine = py_capio_cl.Engine()
+    engine.setCommitRule("/out/*", py_capio_cl.commit_rules.ON_CLOSE)
+    handle = engine.resolve("/out/file.dat")
+    assert not handle.empty()
+    assert handle.path() == "/out/file.dat"
+    assert engine.isValid(handle)
+    assert engine.getCommitRule(handle) == py_capio_cl.commit_rules.ON_CLOSE
+    assert not engine.isFirable(handle)
+
+    engine.remove("/out/file.dat")
+    assert not engine.isValid(handle)
+    assert engine.getCommitRule(handle) == py_capio_cl.commit_rules.ON_CLOSE
+
+
+def test_query_batch():
+    engine = py_capio_cl.Engine()
+    engine.setCommitRule("/batch/*", py_capio_cl.commit_rules.ON_CLOSE)
+    engine.setPermanent("/batch/kept", True)
+    attributes = engine.queryBatch(["/batch/kept", "/batch/new"])
+    assert len(attributes) == 2
+    assert attributes[0].permanent
+    assert attributes[1].commit_rule == py_capio_cl.commit_rules.ON_CLOSE
+    assert attributes[1].is_file
+    assert engine.contains("/batch/new")
+
+
+def test_engine_builder():
+    engine = py_capio_cl.Engine()
+    builder = py_capio_cl.EngineBuilder()
+    builder.setCommitRule("/build/*", py_capio_cl.commit_rules.ON_CLOSE)
+    for i in range(10):
+        builder.addProducer(f"/build/file{i}", "writer")
+    builder.newFile("/build")
+    assert builder.size() == 12
+    assert engine.size() == 0
+
+    builder.publish(engine)
+    assert builder.size() == 0
+    assert engine.size() == 12
+    assert engine.isProducer("/build/file3", "writer")
+    assert engine.getCommitRule("/build/file3") == py_capio_cl.commit_rules.ON_CLOSE
+    assert engine.getDirectoryFileCount("/build") == 10
+    assert engine.isDirectory("/build")
+
+
+def test_file_dependency_cascade(tmp_path):
+    engine = py_capio_cl.Engine()
+    first, second, third = (str(tmp_path / name) for name in ("first", "second", "third"))
+    engine.setCommitRule(second, py_capio_cl.commit_rules.ON_FILE)
+    engine.setFileDeps(second, [first])
+    engine.setCommitRule(third, py_capio_cl.commit_rules.ON_FILE)
+    engine.setFileDeps(third, [second])
+    assert engine.getFileDependents(first) == [second]
+
+    caught = False
+    try:
+        engine.setFileDeps(first, [third])
+    except ValueError:
+        caught = True
+    assert caught
+
+    engine.setCommitted(first)
+    assert engine.isCommitted(second)
+    assert engine.isCommitted(third)
+
+
+def test_notify_close(tmp_path):
+    engine = py_capio_cl.Engine()
+    path = str(tmp_path / "closed")
+    engine.setCommitRule(path, py_capio_cl.commit_rules.ON_CLOSE)
+    engine.setCommittedCloseNumber(path, 2)
+    assert not engine.notifyClose(path)
+    assert not engine.isCommitted(path)
+    assert engine.notifyClose(path)
+    assert engine.isCommitted(path)
+    assert engine.getCloseCount(path) == 2
+
+
+def test_on_n_files_commit(tmp_path):
+    engine = py_capio_cl.Engine()
+    directory = str(tmp_path / "dir")
+    engine.setCommitRule(directory, py_capio_cl.commit_rules.ON_N_FILES)
+    engine.setDirectoryFileCount(directory, 2)
+    engine.newFile(str(tmp_path / "dir" / "a"))
+    engine.setCommitted(str(tmp_path / "dir" / "a"))
+    assert not engine.isCommitted(directory)
+    engine.setCommitted(str(tmp_path / "dir" / "b"))
+    assert engine.isCommitted(directory)
+    assert engine.getObservedFileCount(directory) == 2
+
+
+def test_wait_for_commit(tmp_path):
+    engine = py_capio_cl.Engine()
+    first, second = str(tmp_path / "first"), str(tmp_path / "second")
+    assert not engine.waitForCommit(first, 0.05)
+    assert engine.waitForAnyCommit([first, second], 0.05) == ""
+    engine.setCommitted(second)
+    assert engine.waitForCommit(second, 0.05)
+    assert engine.waitForAnyCommit([first, second], 1) == second
+
+
+def test_on_committed(tmp_path):
+    engine = py_capio_cl.Engine()
+    path = str(tmp_path / "watched")
+    received = []
+    engine.onCommitted(path, received.append)
+    engine.setCommitted(path)
+    assert received == [path]
+
+    engine.onCommitted(path, received.append)
+    assert received == [path, path]
+
+
+def test_stats():
+    engine = py_capio_cl.Engine()
+    engine.setCommitRule("/stats/*.dat", py_capio_cl.commit_rules.ON_CLOSE)
+    engine.newFile("/stats/a.dat")
+    assert engine.getCommitRule("/stats/a.dat") == py_capio_cl.commit_rules.ON_CLOSE
+    stats = engine.stats()
+    assert stats.patterns >= 1
+    assert stats.entries >= 1
+    assert stats.messages_sent >= stats.datagrams_sent >= 0
+    assert stats.batches_flushed >= 0
+    if stats.enabled:
+        assert stats.materializations >= 1
+        assert 0 < stats.hitRatio() <= 1
+        latency = stats.latencies["newFile"]
+        assert latency.count >= 1
+        assert latency.percentile(99) >= latency.percentile(50) > 0
+
+
+def test_deltas():
+    Delta = py_capio_cl.Delta
+    engine = py_capio_cl.Engine()
+    version = engine.apply(Delta.add("/delta/a", Delta.FIELD.PRODUCER, "writer"))
+    assert engine.apply(Delta.add("/delta/a", Delta.FIELD.PRODUCER, "writer")) == version
+    engine.apply(Delta.set("/delta/a", Delta.FIELD.COMMIT_RULE,
+                           py_capio_cl.commit_rules.ON_CLOSE))
+    engine.apply(Delta.set("/delta/a", Delta.FIELD.COMMIT_ON_CLOSE_COUNT, 2))
+    assert engine.getVersion() == 3
+
+    peer = py_capio_cl.Engine()
+    for delta in engine.changesSince(0):
+        peer.apply(Delta.fromJson(delta.toJson()))
+    assert peer.isProducer("/delta/a", "writer")
+    assert peer.getCommitCloseCount("/delta/a") == 2
+
+    engine.apply(Delta.remove("/delta/a", Delta.FIELD.PRODUCER, "writer"))
+    changes = engine.changesSince(3)
+    assert len(changes) == 1
+    assert changes[0].operation == Delta.OPERATION.REMOVE
+    assert not engine.isProducer("/delta/a", "writer")
+
+    engine.remove("/delta/a")
+    changes = engine.changesSince(0)
+    assert len(changes) == 1
+    assert changes[0].operation == Delta.OPERATION.ERASE
+    peer.apply(Delta.fromJson(changes[0].toJson()))
+    assert not peer.contains("/delta/a")
+
+
+def test_fingerprint():
+    engine = py_capio_cl.Engine()
+    other = py_capio_cl.Engine()
+    engine.newFile("/fp/a")
+    other.newFile("/fp/a")
+    assert engine.fingerprint() == other.fingerprint()
+
+    other.setPermanent("/fp/a", True)
+    assert engine.fingerprint().root() != other.fingerprint().root()
+    buckets = engine.fingerprint().diff(other.fingerprint())
+    assert buckets == [py_capio_cl.MerkleTree.bucket("/fp/a")]
+    assert other.getBucketPaths(buckets[0]) == ["/fp/a"]
+
+
+def test_snapshot(tmp_path):
+    engine = py_capio_cl.Engine()
+    engine.newFile("/snap/a")
+    engine.setCommitRule("/snap/*.dat", py_capio_cl.commit_rules.ON_CLOSE)
+    engine.saveSnapshot(str(tmp_path / "engine.snapshot"))
+
+    loaded = py_capio_cl.Engine()
+    loaded.openSnapshot(str(tmp_path / "engine.snapshot"))
+    assert loaded.contains("/snap/a")
+    assert loaded.getCommitRule("/snap/x.dat") == py_capio_cl.commit_rules.ON_CLOSE
+    assert loaded == engine
+
+    caught = False
+    try:
+        loaded.openSnapshot(str(tmp_path / "missing.snapshot"))
+    except py_capio_cl.SnapshotException:
+        caught = True
+    assert caught